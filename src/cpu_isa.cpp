@@ -4,6 +4,7 @@
 #include "qnes_bus.hpp"
 #include "qnes_c.hpp"
 #include "qnes_cpu.hpp"
+#include "qnes_decode_cache.hpp"
 
 namespace QNes {
 
@@ -35,57 +36,140 @@ struct ISA_detail {
     BVS,
   };
 
-  static QNES_FORCE_INLINE void ReadValueFromMem(Bus *mem_bus, u8 high_addr,
+  // Dispatch policy of the instruction granular core: a single call runs the
+  // instruction handler until the instruction completes and returns the number
+  // of cycles it took (not counting the opcode fetch). cycle_count advances
+  // before every cycle as in Step, a bus access sees the cycle it happens on.
+  template <typename CPU_T, typename INSTRUCTION>
+  struct InstructionDispatch {
+    static u8 Execute(CPU_T &cpu) {
+      u8 cycles = 0;
+      do {
+        ++cpu.cycle_count;
+        INSTRUCTION::Execute(cpu);
+        ++cycles;
+      } while (cpu.instruction_cycle != 0);
+      return cycles;
+    }
+  };
+
+  // Table policy marking the implemented opcodes, for code that expands every
+  // opcode value at compile time
+  template <typename CPU_T, typename INSTRUCTION>
+  struct ImplementedDispatch {
+    static constexpr bool Execute = true;
+  };
+
+  template <typename BUS>
+  static QNES_FORCE_INLINE void ReadValueFromMem(BUS *mem_bus, u8 high_addr,
                                                  u8 low_addr, u8 &reg) {
-    mem_bus->SetAddress(high_addr, low_addr);
-    reg = mem_bus->Read();
+    reg = mem_bus->Read(CombineToU16(high_addr, low_addr));
   }
 
-  static QNES_FORCE_INLINE void WriteValueToMem(Bus *mem_bus, u8 high_addr,
+  // Reads the program byte at PC. While the instruction runs from the decode
+  // cache, its operand bytes come from the cache entry instead of the bus.
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void ReadProgramByte(CPU_T &cpu, u8 &value) {
+    if (cpu.decoded != nullptr) {
+      const auto offset = static_cast<u16>(cpu.state.pc - cpu.decoded->pc - 1);
+      if (offset + 1 < cpu.decoded->length) {
+        value = cpu.decoded->operands[offset];
+        return;
+      }
+    }
+    ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
+                     value);
+  }
+
+  // Reads whose value the instruction throws away, they only matter for
+  // their side effects (see CPUCore::Accuracy)
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void DummyRead(CPU_T &cpu, u16 address) {
+    if (!cpu.SkipsDummyRead(address)) {
+      u8 dummy = 0;
+      ReadValueFromMem(cpu.bus, U16High(address), U16Low(address), dummy);
+    }
+  }
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void DummyReadProgramByte(CPU_T &cpu) {
+    if (!cpu.SkipsDummyRead(cpu.state.pc)) {
+      u8 dummy = 0;
+      ReadProgramByte(cpu, dummy);
+    }
+  }
+
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void WriteValueToMem(CPU_T &cpu, u8 high_addr,
                                                 u8 low_addr, u8 value) {
-    mem_bus->SetAddress(high_addr, low_addr);
-    mem_bus->Write(value);
+    const u16 address = CombineToU16(high_addr, low_addr);
+    cpu.bus->Write(address, value);
+    cpu.InvalidateDecodedWrite(address);
+  }
+
+  // Zero page accesses, straight to internal RAM when the bus guarantees it
+  // (see BasicCPU::ReadLowPage)
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void ReadZeroPage(CPU_T &cpu, u8 low_addr, u8 &reg) {
+    reg = cpu.ReadLowPage(low_addr);
+  }
+
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void DummyReadZeroPage(CPU_T &cpu, u8 low_addr) {
+    if (!cpu.SkipsDummyRead(low_addr)) {
+      u8 dummy = 0;
+      ReadZeroPage(cpu, low_addr, dummy);
+    }
   }
 
-  static QNES_FORCE_INLINE void SetZNFlags(CPU &cpu, u8 value) {
-    cpu.state.status.zero = (value == 0);
-    cpu.state.status.negative = (value & 0x80) != 0;
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void WriteZeroPage(CPU_T &cpu, u8 low_addr,
+                                              u8 value) {
+    cpu.WriteLowPage(low_addr, value);
+    cpu.InvalidateDecodedWrite(low_addr);
   }
 
-  static QNES_FORCE_INLINE void SetArithmeticOverflowFlag(CPU &cpu, u8 &value,
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void SetZNFlags(CPU_T &cpu, u8 value) {
+    cpu.flags.zero_result = value;
+    cpu.flags.negative_result = value;
+  }
+
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void SetArithmeticOverflowFlag(CPU_T &cpu,
+                                                          u8 &value,
                                                           u8 operand,
                                                           u8 result) {
-    cpu.state.status.overflow =
-        (~(value ^ operand) & (value ^ result) & 0x80) != 0;
+    cpu.flags.overflow_result =
+        static_cast<u8>(~(value ^ operand) & (value ^ result));
   }
 
-  template <BranchCondition CONDITION>
-  static QNES_FORCE_INLINE bool ExecuteCondition(CPU &cpu) {
+  template <BranchCondition CONDITION, typename CPU_T>
+  static QNES_FORCE_INLINE bool ExecuteCondition(CPU_T &cpu) {
     if constexpr (CONDITION == BranchCondition::BCC) {
-      return !cpu.state.status.carry;
+      return cpu.flags.carry == 0;
     } else if constexpr (CONDITION == BranchCondition::BCS) {
-      return cpu.state.status.carry;
+      return cpu.flags.carry != 0;
     } else if constexpr (CONDITION == BranchCondition::BEQ) {
-      return cpu.state.status.zero;
+      return cpu.flags.zero_result == 0;
     } else if constexpr (CONDITION == BranchCondition::BMI) {
-      return cpu.state.status.negative;
+      return (cpu.flags.negative_result & 0x80) != 0;
     } else if constexpr (CONDITION == BranchCondition::BNE) {
-      return !cpu.state.status.zero;
+      return cpu.flags.zero_result != 0;
     } else if constexpr (CONDITION == BranchCondition::BPL) {
-      return !cpu.state.status.negative;
+      return (cpu.flags.negative_result & 0x80) == 0;
     } else if constexpr (CONDITION == BranchCondition::BVC) {
-      return !cpu.state.status.overflow;
+      return (cpu.flags.overflow_result & 0x80) == 0;
     } else if constexpr (CONDITION == BranchCondition::BVS) {
-      return cpu.state.status.overflow;
+      return (cpu.flags.overflow_result & 0x80) != 0;
     } else {
       ASSERT(false, "Invalid branch condition");
       return false;
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void ExecuteOperation(CPU &cpu, u8 &reg,
-                                                 u8 operand [[maybe_unused]]) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void ExecuteOperation(
+      CPU_T &cpu, u8 &reg, u8 operand [[maybe_unused]]) {
     if constexpr (OP == Operation::AND) {
       reg = reg & operand;
       ISA_detail::SetZNFlags(cpu, reg);
@@ -96,14 +180,14 @@ struct ISA_detail {
       reg = reg | operand;
       ISA_detail::SetZNFlags(cpu, reg);
     } else if constexpr (OP == Operation::BIT) {
-      const u8 result = reg & operand;
-      cpu.state.status.zero = (result == 0);
-      cpu.state.status.negative = (operand & 0x80) != 0;
-      cpu.state.status.overflow = (operand & 0x40) != 0;
+      // Z comes from the result, N and V are bits 7 and 6 of the operand
+      cpu.flags.zero_result = reg & operand;
+      cpu.flags.negative_result = operand;
+      cpu.flags.overflow_result = static_cast<u8>(operand << 1);
     } else if constexpr (OP == Operation::ADC) {
       u8 reg_begore = reg;
-      u16 result = reg + operand + (cpu.state.status.carry ? 1 : 0);
-      cpu.state.status.carry = (result & 0x100) != 0;
+      u16 result = reg + operand + cpu.flags.carry;
+      cpu.flags.carry = static_cast<u8>(result >> 8);
       reg = U16Low(result);
       ISA_detail::SetZNFlags(cpu, reg);
       SetArithmeticOverflowFlag(cpu, reg_begore, operand, result);
@@ -112,13 +196,13 @@ struct ISA_detail {
       // so we can use the same code for both ADC and SBC
       u8 reg_begore = reg;
       u8 tmp_value = ~operand;
-      u16 result = reg + tmp_value + (cpu.state.status.carry ? 1 : 0);
-      cpu.state.status.carry = (result & 0x100) != 0;
+      u16 result = reg + tmp_value + cpu.flags.carry;
+      cpu.flags.carry = static_cast<u8>(result >> 8);
       reg = U16Low(result);
       ISA_detail::SetZNFlags(cpu, reg);
       SetArithmeticOverflowFlag(cpu, reg_begore, tmp_value, result);
     } else if constexpr (OP == Operation::CMP) {
-      cpu.state.status.carry = (reg >= operand) ? 1 : 0;
+      cpu.flags.carry = (reg >= operand) ? 1 : 0;
       u16 result = reg - operand;
       SetZNFlags(cpu, U16Low(result));
     } else if constexpr (OP == Operation::INC) {
@@ -128,21 +212,21 @@ struct ISA_detail {
       --reg;
       ISA_detail::SetZNFlags(cpu, reg);
     } else if constexpr (OP == Operation::SHIFT_LEFT) {
-      cpu.state.status.carry = (reg & 0x80) != 0;
+      cpu.flags.carry = reg >> 7;
       reg <<= 1;
       ISA_detail::SetZNFlags(cpu, reg);
     } else if constexpr (OP == Operation::SHIFT_RIGHT) {
-      cpu.state.status.carry = (reg & 0x01) != 0;
+      cpu.flags.carry = reg & 0x01;
       reg >>= 1;
       ISA_detail::SetZNFlags(cpu, reg);
     } else if constexpr (OP == Operation::ROTATE_LEFT) {
-      const bool carry = cpu.state.status.carry;
-      cpu.state.status.carry = (reg & 0x80) != 0;
+      const u8 carry = cpu.flags.carry;
+      cpu.flags.carry = reg >> 7;
       reg = (reg << 1) | carry;
       ISA_detail::SetZNFlags(cpu, reg);
     } else if constexpr (OP == Operation::ROTATE_RIGHT) {
-      const bool carry = cpu.state.status.carry;
-      cpu.state.status.carry = (reg & 0x01) != 0;
+      const u8 carry = cpu.flags.carry;
+      cpu.flags.carry = reg & 0x01;
       reg = (reg >> 1) | (carry << 7);
       ISA_detail::SetZNFlags(cpu, reg);
     } else {
@@ -150,26 +234,25 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void LoadMemoryToRegisterAbsolute(CPU &cpu,
-                                                             u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void LoadMemoryToRegisterAbsolute(CPU_T &cpu,
+                                                               u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address and form full address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adh);
+        ReadProgramByte(cpu, cpu.adh);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read value from the effective address into the accumulator
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -179,13 +262,13 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void LoadMemoryToRegisterImmediate(CPU &cpu,
-                                                              u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void LoadMemoryToRegisterImmediate(CPU_T &cpu,
+                                                                u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch immediate value
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         reg);
+        ReadProgramByte(cpu, reg);
         ++cpu.state.pc;
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
@@ -196,19 +279,19 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void LoadMemoryToRegisterZeroPage(CPU &cpu,
-                                                             u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void LoadMemoryToRegisterZeroPage(CPU_T &cpu,
+                                                               u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch zero page address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Read value from the zero page address into the register
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, reg);
+        ReadZeroPage(cpu, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -218,28 +301,27 @@ struct ISA_detail {
     }
   }
 
+  template <typename CPU_T>
   static QNES_FORCE_INLINE void LoadMemoryToRegisterZeroPageIndexed(
-      CPU &cpu, u8 &reg, u8 idx_reg) {
+      CPU_T &cpu, u8 &reg, u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch zero page address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Perform dummy read and add indexed register to address (high byte
         // stays zero)
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, dummy);
-        cpu.bus->adl = static_cast<u8>(
-            (static_cast<u16>(cpu.bus->adl) + idx_reg) & 0x00FF);
+        DummyReadZeroPage(cpu, cpu.adl);
+        cpu.adl = static_cast<u8>(
+            (static_cast<u16>(cpu.adl) + idx_reg) & 0x00FF);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read value from the zero page address into the register
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, reg);
+        ReadZeroPage(cpu, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -249,36 +331,38 @@ struct ISA_detail {
     }
   }
 
+  template <typename CPU_T>
   static QNES_FORCE_INLINE void LoadMemoryToRegisterAbsoluteIndexed(
-      CPU &cpu, u8 &reg, u8 idx_reg) {
+      CPU_T &cpu, u8 &reg, u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adh);
+        ReadProgramByte(cpu, cpu.adh);
         // Add index register to low byte to, if needed, trigger page crossing
         // in the next cycle
-        u16 tmp = static_cast<u16>(cpu.bus->adl) + static_cast<u16>(idx_reg);
-        cpu.bus->adl = static_cast<u8>(tmp & 0x00FF);
+        u16 tmp = static_cast<u16>(cpu.adl) + static_cast<u16>(idx_reg);
+        cpu.adl = static_cast<u8>(tmp & 0x00FF);
         cpu.page_crossed = (tmp & 0xFF00) != 0;
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Perform read, if page was crossed this is a dummy read
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
-        // Set Zero and Negative flags based on the value loaded
-        SetZNFlags(cpu, reg);
+        if (!cpu.page_crossed ||
+            !cpu.SkipsDummyRead(CombineToU16(cpu.adh, cpu.adl))) {
+          ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
+          // Set Zero and Negative flags based on the value loaded
+          SetZNFlags(cpu, reg);
+        }
         // Increment high byte if page crossed else finish instruction
         if (cpu.page_crossed) {
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
           ++cpu.instruction_cycle;
         } else {
           cpu.instruction_cycle = 0;
@@ -290,7 +374,7 @@ struct ISA_detail {
                "corossed)");
         cpu.page_crossed = false;
         // Read value from the effective address into the register
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -300,41 +384,40 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void LoadMemoryToRegisterXIndirect(CPU &cpu, u8 &reg,
-                                                              u8 idx_reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void LoadMemoryToRegisterXIndirect(CPU_T &cpu,
+                                                                u8 &reg,
+                                                                u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Read pointer address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->op_latch);
+        ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Perform dummy read and add X to pointer (zero page wraparound)
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, dummy);
+        DummyReadZeroPage(cpu, cpu.op_latch);
         // page bound wraparound is not handled
-        cpu.bus->op_latch = static_cast<u8>(
-            (static_cast<u16>(cpu.bus->op_latch) + idx_reg) & 0x00FF);
+        cpu.op_latch = static_cast<u8>(
+            (static_cast<u16>(cpu.op_latch) + idx_reg) & 0x00FF);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read effective address low byte
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, cpu.bus->adl);
+        ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Read effective address high byte
-        ReadValueFromMem(
-            cpu.bus, 0x00,
-            static_cast<u8>((static_cast<u16>(cpu.bus->op_latch) + 1) & 0x00FF),
-            cpu.bus->adh);
+        ReadZeroPage(
+            cpu, static_cast<u8>((static_cast<u16>(cpu.op_latch) + 1) & 0x00FF),
+            cpu.adh);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // Read value from the effective address into the register
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -344,42 +427,44 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void LoadMemoryToRegisterIndirectY(CPU &cpu,
-                                                              u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void LoadMemoryToRegisterIndirectY(CPU_T &cpu,
+                                                                u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Read pointer address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->op_latch);
+        ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Read effective address low byte
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, cpu.bus->adl);
+        ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read effective address high byte
-        ReadValueFromMem(
-            cpu.bus, 0x00,
-            static_cast<u8>((static_cast<u16>(cpu.bus->op_latch) + 1) & 0x00FF),
-            cpu.bus->adh);
+        ReadZeroPage(
+            cpu, static_cast<u8>((static_cast<u16>(cpu.op_latch) + 1) & 0x00FF),
+            cpu.adh);
         // Add Y to low byte to, if needed, trigger page crossing
         u16 tmp =
-            static_cast<u16>(cpu.bus->adl) + static_cast<u16>(cpu.state.y);
-        cpu.bus->adl = static_cast<u8>(tmp & 0x00FF);
+            static_cast<u16>(cpu.adl) + static_cast<u16>(cpu.state.y);
+        cpu.adl = static_cast<u8>(tmp & 0x00FF);
         cpu.page_crossed = (tmp & 0xFF00) != 0;
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Perform read, if page was crossed this is a dummy read
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
-        // Set Zero and Negative flags based on the value loaded
-        SetZNFlags(cpu, reg);
+        if (!cpu.page_crossed ||
+            !cpu.SkipsDummyRead(CombineToU16(cpu.adh, cpu.adl))) {
+          ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
+          // Set Zero and Negative flags based on the value loaded
+          SetZNFlags(cpu, reg);
+        }
         // Increment high byte if page crossed else finish instruction
         if (cpu.page_crossed) {
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
           ++cpu.instruction_cycle;
         } else {
           cpu.instruction_cycle = 0;
@@ -390,7 +475,7 @@ struct ISA_detail {
                "Unexpected cycle for LDA Indirect Y (page was not corossed)");
         cpu.page_crossed = false;
         // Read value from the effective address into the register
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl, reg);
         // Set Zero and Negative flags based on the value loaded
         SetZNFlags(cpu, reg);
         cpu.instruction_cycle = 0;
@@ -400,25 +485,24 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterAbsolute(CPU &cpu, u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterAbsolute(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adh);
+        ReadProgramByte(cpu, cpu.adh);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Write value to the effective address
-        WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        WriteValueToMem(cpu, cpu.adh, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -426,18 +510,18 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterZeroPage(CPU &cpu, u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterZeroPage(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch zero page address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Write value to the effective address
-        WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl, reg);
+        WriteZeroPage(cpu, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -445,27 +529,27 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterZeroPageIndexed(CPU &cpu, u8 &reg,
-                                                             u8 idx_reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterZeroPageIndexed(CPU_T &cpu,
+                                                               u8 &reg,
+                                                               u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch zero page address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Perform dummy read and add register to pointer (zero page wraparound)
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, dummy);
-        cpu.bus->adl =
-            U16Low(static_cast<u16>(cpu.bus->adl) + static_cast<u16>(idx_reg));
+        DummyReadZeroPage(cpu, cpu.adl);
+        cpu.adl =
+            U16Low(static_cast<u16>(cpu.adl) + static_cast<u16>(idx_reg));
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Write value to the zero page address
-        WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl, reg);
+        WriteZeroPage(cpu, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -473,24 +557,24 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterAbsoluteIndexed(CPU &cpu, u8 &reg,
-                                                             u8 idx_reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterAbsoluteIndexed(CPU_T &cpu,
+                                                               u8 &reg,
+                                                               u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch absolute address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adl);
+        ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->adh);
+        ReadProgramByte(cpu, cpu.adh);
         // Add index register to low byte to, if needed, trigger page crossing
         // in the next cycle
-        u16 tmp = static_cast<u16>(cpu.bus->adl) + static_cast<u16>(idx_reg);
-        cpu.bus->adl = U16Low(tmp);
+        u16 tmp = static_cast<u16>(cpu.adl) + static_cast<u16>(idx_reg);
+        cpu.adl = U16Low(tmp);
         cpu.page_crossed = (tmp & 0xFF00) != 0;
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
@@ -498,18 +582,17 @@ struct ISA_detail {
       case 3: {
         // Dummy read since page may have been crossed and the processor cannot
         // undo writes it always reads from the address first
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, dummy);
+        DummyRead(cpu, CombineToU16(cpu.adh, cpu.adl));
         // fix high byte if page crossed
         if (cpu.page_crossed) {
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
           cpu.page_crossed = false;
         }
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Write value to the effective address
-        WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        WriteValueToMem(cpu, cpu.adh, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -517,39 +600,37 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterXIndirect(CPU &cpu, u8 &reg,
-                                                       u8 idx_reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterXIndirect(CPU_T &cpu, u8 &reg,
+                                                         u8 idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Read pointer address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->op_latch);
+        ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Perform dummy read and add X to pointer (zero page wraparound)
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, dummy);
-        cpu.bus->op_latch =
-            U16Low(static_cast<u16>(cpu.bus->op_latch) + idx_reg);
+        DummyReadZeroPage(cpu, cpu.op_latch);
+        cpu.op_latch =
+            U16Low(static_cast<u16>(cpu.op_latch) + idx_reg);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read effective address low byte
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, cpu.bus->adl);
+        ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Read effective address high byte
-        ReadValueFromMem(cpu.bus, 0x00,
-                         U16Low((static_cast<u16>(cpu.bus->op_latch) + 1)),
-                         cpu.bus->adh);
+        ReadZeroPage(cpu, U16Low((static_cast<u16>(cpu.op_latch) + 1)),
+                     cpu.adh);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // Write value to the effective address
-        WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        WriteValueToMem(cpu, cpu.adh, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -557,48 +638,46 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void StoreRegisterIndirectY(CPU &cpu, u8 &reg) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void StoreRegisterIndirectY(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Read pointer address
-        ReadValueFromMem(cpu.bus, U16High(cpu.state.pc), U16Low(cpu.state.pc),
-                         cpu.bus->op_latch);
+        ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Read effective address low byte
-        ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, cpu.bus->adl);
+        ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read effective address high byte
-        ReadValueFromMem(cpu.bus, 0x00,
-                         U16Low((static_cast<u16>(cpu.bus->op_latch) + 1)),
-                         cpu.bus->adh);
+        ReadZeroPage(cpu, U16Low((static_cast<u16>(cpu.op_latch) + 1)),
+                     cpu.adh);
         // Add Y to effective address low byte, if needed, trigger page crossing
         // in the next cycle
         u16 tmp =
-            static_cast<u16>(cpu.bus->adl) + static_cast<u16>(cpu.state.y);
-        cpu.bus->adl = U16Low(tmp);
+            static_cast<u16>(cpu.adl) + static_cast<u16>(cpu.state.y);
+        cpu.adl = U16Low(tmp);
         cpu.page_crossed = (tmp & 0xFF00) != 0;
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Dummy read since page may have been crossed and the processor cannot
         // undo writes it always reads from the address first
-        u8 dummy = 0;
-        ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, dummy);
+        DummyRead(cpu, CombineToU16(cpu.adh, cpu.adl));
         // fix high byte if page crossed
         if (cpu.page_crossed) {
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
           cpu.page_crossed = false;
         }
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // Write value to the effective address
-        WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl, reg);
+        WriteValueToMem(cpu, cpu.adh, cpu.adl, reg);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -606,7 +685,9 @@ struct ISA_detail {
     }
   }
 
-  static QNES_FORCE_INLINE void TransferRegister(CPU &cpu, u8 &reg, u8 value) {
+  template <typename CPU_T>
+  static QNES_FORCE_INLINE void TransferRegister(CPU_T &cpu, u8 &reg,
+                                                 u8 value) {
     switch (cpu.instruction_cycle) {
       case 1: {
         reg = value;
@@ -614,17 +695,16 @@ struct ISA_detail {
         cpu.instruction_cycle = 0;
       } break;
       default:
-        ASSERT(false, "Invalid cycle")
-    };
+        ASSERT(false, "Invalid cycle");
+    }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationImmediate(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationImmediate(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         ++cpu.state.pc;
         cpu.instruction_cycle = 0;
       } break;
@@ -633,19 +713,17 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationZeroPage(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationZeroPage(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadZeroPage(cpu, cpu.adl, cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -653,32 +731,28 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationZeroPage_ReadModifyWrite(CPU &cpu) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationZeroPage_ReadModifyWrite(CPU_T &cpu) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        ISA_detail::ReadZeroPage(cpu, cpu.adl, cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // dummy write
-        ISA_detail::WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl,
-                                    cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, cpu.bus->op_latch,
-                                         cpu.bus->op_latch);
+        ISA_detail::WriteZeroPage(cpu, cpu.adl, cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, cpu.op_latch,
+                                         cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // final write
-        ISA_detail::WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl,
-                                    cpu.bus->op_latch);
+        ISA_detail::WriteZeroPage(cpu, cpu.adl, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -686,26 +760,23 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationZeroPageIndexed(CPU &cpu, u8 &reg,
-                                                         u8 &idx_reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationZeroPageIndexed(CPU_T &cpu, u8 &reg,
+                                                           u8 &idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        u8 dummy = 0;
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, dummy);
-        cpu.bus->adl = U16Low((static_cast<u16>(cpu.bus->adl) + idx_reg));
+        ISA_detail::DummyReadZeroPage(cpu, cpu.adl);
+        cpu.adl = U16Low((static_cast<u16>(cpu.adl) + idx_reg));
         ++cpu.instruction_cycle;
       } break;
       case 3: {
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadZeroPage(cpu, cpu.adl, cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -713,39 +784,34 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
+  template <Operation OP, typename CPU_T>
   static QNES_FORCE_INLINE void OperationZeroPageIndexed_ReadModifyWrite(
-      CPU &cpu, u8 &idx_reg) {
+      CPU_T &cpu, u8 &idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        u8 dummy = 0;
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl, dummy);
-        cpu.bus->adl = U16Low((static_cast<u16>(cpu.bus->adl) + idx_reg));
+        ISA_detail::DummyReadZeroPage(cpu, cpu.adl);
+        cpu.adl = U16Low((static_cast<u16>(cpu.adl) + idx_reg));
         ++cpu.instruction_cycle;
       } break;
       case 3: {
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        ISA_detail::ReadZeroPage(cpu, cpu.adl, cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // dummy write
-        ISA_detail::WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl,
-                                    cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, cpu.bus->op_latch,
-                                         cpu.bus->op_latch);
+        ISA_detail::WriteZeroPage(cpu, cpu.adl, cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, cpu.op_latch,
+                                         cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // final write
-        ISA_detail::WriteValueToMem(cpu.bus, 0x00, cpu.bus->adl,
-                                    cpu.bus->op_latch);
+        ISA_detail::WriteZeroPage(cpu, cpu.adl, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -753,25 +819,23 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationAbsolute(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationAbsolute(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adh);
+        ISA_detail::ReadProgramByte(cpu, cpu.adh);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -779,38 +843,36 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationAbsolute_ReadModifyWrite(CPU &cpu) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationAbsolute_ReadModifyWrite(CPU_T &cpu) {
     switch (cpu.instruction_cycle) {
       case 1: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adh);
+        ISA_detail::ReadProgramByte(cpu, cpu.adh);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // dummy write
-        ISA_detail::WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                    cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, cpu.bus->op_latch,
-                                         cpu.bus->op_latch);
+        ISA_detail::WriteValueToMem(cpu, cpu.adh, cpu.adl,
+                                    cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, cpu.op_latch,
+                                         cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // final write
-        ISA_detail::WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                    cpu.bus->op_latch);
+        ISA_detail::WriteValueToMem(cpu, cpu.adh, cpu.adl,
+                                    cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -818,24 +880,22 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationAbsoluteIndexed(CPU &cpu, u8 &reg,
-                                                         u8 &idx_reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationAbsoluteIndexed(CPU_T &cpu, u8 &reg,
+                                                           u8 &idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adh);
+        ISA_detail::ReadProgramByte(cpu, cpu.adh);
         // Add index register to low byte to, if needed, trigger page crossing
-        auto tmp = static_cast<u16>(cpu.bus->adl) + static_cast<u16>(idx_reg);
-        cpu.bus->adl = U16Low(tmp);
+        auto tmp = static_cast<u16>(cpu.adl) + static_cast<u16>(idx_reg);
+        cpu.adl = U16Low(tmp);
         cpu.page_crossed = U16High(tmp) != 0;
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
@@ -843,16 +903,19 @@ struct ISA_detail {
       case 3: {
         // Read value from the effective address into the register, if page was
         // crossed this is a dummy read
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        if (!cpu.page_crossed ||
+            !cpu.SkipsDummyRead(CombineToU16(cpu.adh, cpu.adl))) {
+          ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                       cpu.op_latch);
+        }
         if (cpu.page_crossed) {
           // page was crossed, increment high byte and set op_latch to 0
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
-          cpu.bus->op_latch = 0;
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
+          cpu.op_latch = 0;
           ++cpu.instruction_cycle;
         } else {
           // page was not crossed, execute logical operation and set flags
-          ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+          ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
           cpu.instruction_cycle = 0;
         }
       } break;
@@ -862,9 +925,9 @@ struct ISA_detail {
                "was not corossed)");
         cpu.page_crossed = false;
         // Read value from the effective address into the register
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -872,58 +935,55 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
+  template <Operation OP, typename CPU_T>
   static QNES_FORCE_INLINE void OperationAbsoluteIndexed_ReadModifyWrite(
-      CPU &cpu, u8 &idx_reg) {
+      CPU_T &cpu, u8 &idx_reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adl);
+        ISA_detail::ReadProgramByte(cpu, cpu.adl);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch high byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->adh);
+        ISA_detail::ReadProgramByte(cpu, cpu.adh);
         // Add index register to low byte to, if needed, trigger page crossing
-        auto tmp = static_cast<u16>(cpu.bus->adl) + static_cast<u16>(idx_reg);
-        cpu.bus->adl = U16Low(tmp);
+        auto tmp = static_cast<u16>(cpu.adl) + static_cast<u16>(idx_reg);
+        cpu.adl = U16Low(tmp);
         cpu.page_crossed = U16High(tmp) != 0;
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 3: {
-        // Read value from effective address (always happens regardless of page
-        // crossing)
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        // Dummy read of the effective address (always happens regardless of
+        // page crossing)
+        ISA_detail::DummyRead(cpu, CombineToU16(cpu.adh, cpu.adl));
         if (cpu.page_crossed) {
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
           cpu.page_crossed = false;
         }
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // reread value from effective address (now its correct)
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // dummy write
-        ISA_detail::WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                    cpu.bus->op_latch);
+        ISA_detail::WriteValueToMem(cpu, cpu.adh, cpu.adl,
+                                    cpu.op_latch);
         // Execute the operation (INC or DEC)
-        ISA_detail::ExecuteOperation<OP>(cpu, cpu.bus->op_latch,
-                                         cpu.bus->op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, cpu.op_latch,
+                                         cpu.op_latch);
         ++cpu.instruction_cycle;
       } break;
       case 6: {
         // Final write
-        ISA_detail::WriteValueToMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                    cpu.bus->op_latch);
+        ISA_detail::WriteValueToMem(cpu, cpu.adh, cpu.adl,
+                                    cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -931,46 +991,47 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationIndirectY(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationIndirectY(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch pointer address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->op_latch);
+        ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Fetch low byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch,
-                                     cpu.bus->adl);
+        ISA_detail::ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Fetch high byte of address
-        const u8 high_byte = U16Low(static_cast<u16>(cpu.bus->op_latch) + 1);
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, high_byte, cpu.bus->adh);
+        const u8 high_byte = U16Low(static_cast<u16>(cpu.op_latch) + 1);
+        ISA_detail::ReadZeroPage(cpu, high_byte, cpu.adh);
         // Add Y to low byte to, if needed, trigger page crossing
         u16 tmp =
-            static_cast<u16>(cpu.bus->adl) + static_cast<u16>(cpu.state.y);
-        cpu.bus->adl = U16Low(tmp);
+            static_cast<u16>(cpu.adl) + static_cast<u16>(cpu.state.y);
+        cpu.adl = U16Low(tmp);
         cpu.page_crossed = U16High(tmp) != 0;
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Read value from the effective address into the register, if page was
         // crossed this is a dummy read
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
+        if (!cpu.page_crossed ||
+            !cpu.SkipsDummyRead(CombineToU16(cpu.adh, cpu.adl))) {
+          ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                       cpu.op_latch);
+        }
         if (cpu.page_crossed) {
           // page was crossed, increment high byte and set op_latch to 0
-          cpu.bus->adh = static_cast<u8>(cpu.bus->adh + 1);
-          cpu.bus->op_latch = 0;
+          cpu.adh = static_cast<u8>(cpu.adh + 1);
+          cpu.op_latch = 0;
           ++cpu.instruction_cycle;
         } else {
           // page was not crossed, execute logical operation and set flags
-          ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+          ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
           cpu.instruction_cycle = 0;
         }
       } break;
@@ -980,9 +1041,9 @@ struct ISA_detail {
                "not corossed)");
         cpu.page_crossed = false;
         // Read value from the effective address into the register
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -990,41 +1051,38 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationXIndirect(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationXIndirect(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch low byte of address
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->op_latch);
+        ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
         ++cpu.state.pc;
         ++cpu.instruction_cycle;
       } break;
       case 2: {
         // Perform dummy read and add X to pointer (zero page wraparound)
-        u8 dummy = 0;
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch, dummy);
-        cpu.bus->op_latch =
-            U16Low(static_cast<u16>(cpu.bus->op_latch) + cpu.state.x);
+        ISA_detail::DummyReadZeroPage(cpu, cpu.op_latch);
+        cpu.op_latch =
+            U16Low(static_cast<u16>(cpu.op_latch) + cpu.state.x);
         ++cpu.instruction_cycle;
       } break;
       case 3: {
         // Read low byte of effective address
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.bus->op_latch,
-                                     cpu.bus->adl);
+        ISA_detail::ReadZeroPage(cpu, cpu.op_latch, cpu.adl);
         ++cpu.instruction_cycle;
       } break;
       case 4: {
         // Read high byte of effective address
-        const u8 high_byte = U16Low(static_cast<u16>(cpu.bus->op_latch) + 1);
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, high_byte, cpu.bus->adh);
+        const u8 high_byte = U16Low(static_cast<u16>(cpu.op_latch) + 1);
+        ISA_detail::ReadZeroPage(cpu, high_byte, cpu.adh);
         ++cpu.instruction_cycle;
       } break;
       case 5: {
         // Read value from the effective address into the register
-        ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                     cpu.bus->op_latch);
-        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.bus->op_latch);
+        ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                     cpu.op_latch);
+        ISA_detail::ExecuteOperation<OP>(cpu, reg, cpu.op_latch);
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -1032,8 +1090,8 @@ struct ISA_detail {
     }
   }
 
-  template <Operation OP>
-  static QNES_FORCE_INLINE void OperationImplied(CPU &cpu, u8 &reg) {
+  template <Operation OP, typename CPU_T>
+  static QNES_FORCE_INLINE void OperationImplied(CPU_T &cpu, u8 &reg) {
     switch (cpu.instruction_cycle) {
       case 1: {
         u8 void_operand = 0;
@@ -1045,13 +1103,12 @@ struct ISA_detail {
     }
   }
 
-  template <BranchCondition CONDITION>
-  static QNES_FORCE_INLINE void RelativeBranch(CPU &cpu) {
+  template <BranchCondition CONDITION, typename CPU_T>
+  static QNES_FORCE_INLINE void RelativeBranch(CPU_T &cpu) {
     switch (cpu.instruction_cycle) {
       case 1: {
         // Fetch operand
-        ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                     U16Low(cpu.state.pc), cpu.bus->op_latch);
+        ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
         // Evaluate branch condition
         if (!ISA_detail::ExecuteCondition<CONDITION>(cpu)) {
           // branch not taken - end instruction - next cycle will fetch the next
@@ -1064,16 +1121,18 @@ struct ISA_detail {
       } break;
       case 2: {
         // Fetch OPCODE for next instruction - dummy read
-        u8 dummy = 0;
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.state.pc, dummy);
+        ISA_detail::DummyRead(cpu, cpu.state.pc);
         // Add operand to PCL and check for page crossing
-        auto offset = static_cast<int8_t>(cpu.bus->op_latch);
+        auto offset = static_cast<int8_t>(cpu.op_latch);
         u16 new_pc = cpu.state.pc + static_cast<int16_t>(offset);
+        if (cpu.idle_loop_watch && new_pc < cpu.state.pc) {
+          cpu.ReportLoop(new_pc, cpu.state.pc);
+        }
         cpu.page_crossed = U16High(new_pc) != U16High(cpu.state.pc);
         cpu.state.pc = CombineToU16(U16High(cpu.state.pc), U16Low(new_pc));
         if (cpu.page_crossed) {
           ++cpu.instruction_cycle;
-          cpu.bus->op_latch = U16High(new_pc);
+          cpu.op_latch = U16High(new_pc);
         } else {
           cpu.instruction_cycle = 0;
         }
@@ -1083,10 +1142,9 @@ struct ISA_detail {
                "Unexpected cycle for Relative Branch (page was not crossed)");
         cpu.page_crossed = false;
         // Fetch OPCODE for next instruction - dummy read
-        u8 dummy = 0;
-        ISA_detail::ReadValueFromMem(cpu.bus, 0x00, cpu.state.pc, dummy);
+        ISA_detail::DummyRead(cpu, cpu.state.pc);
         // Fix high byte of PC
-        cpu.state.pc = CombineToU16(cpu.bus->op_latch, U16Low(cpu.state.pc));
+        cpu.state.pc = CombineToU16(cpu.op_latch, U16Low(cpu.state.pc));
         cpu.instruction_cycle = 0;
       } break;
       default:
@@ -1095,13 +1153,12 @@ struct ISA_detail {
   }
 };
 
-void ISA::PHA<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::PHA<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Dummy read of the next instruction byte
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.instruction_cycle;
     } break;
     case 2: {
@@ -1114,13 +1171,12 @@ void ISA::PHA<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::PLA<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::PLA<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Dummy read of the next instruction byte
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.instruction_cycle;
     } break;
     case 2: {
@@ -1139,18 +1195,17 @@ void ISA::PLA<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::PHP<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::PHP<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Dummy read of the next instruction byte
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.instruction_cycle;
     } break;
     case 2: {
       // Push processor status onto stack
-      auto status_to_push = cpu.state.status;
+      auto status_to_push = cpu.GetStatus();
       // The break flag is set to 1 when pushed to the stack
       status_to_push.break_command = 1;
       status_to_push.unused = 1;
@@ -1162,13 +1217,12 @@ void ISA::PHP<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::PLP<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::PLP<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Dummy read of the next instruction byte
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.instruction_cycle;
     } break;
     case 2: {
@@ -1177,8 +1231,9 @@ void ISA::PLP<AddressingMode::Implied>::Execute(CPU &cpu) {
     } break;
     case 3: {
       // Pull value into processor status
-      u8 status_value = cpu.ReadStackValue();
-      cpu.state.status.status = status_value;
+      CPUCore::StatusFlags status_value{};
+      status_value.status = cpu.ReadStackValue();
+      cpu.SetStatus(status_value);
       // The break flag is ignored when pulled from the stack
       cpu.state.status.break_command = 0;
       cpu.instruction_cycle = 0;
@@ -1188,7 +1243,8 @@ void ISA::PLP<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::TSX<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TSX<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       cpu.state.x = cpu.state.sp;
@@ -1200,7 +1256,8 @@ void ISA::TSX<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::TXS<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TXS<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       cpu.state.sp = cpu.state.x;
@@ -1211,538 +1268,660 @@ void ISA::TXS<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::LDA<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsolute(cpu, cpu.state.a);
 }
-void ISA::LDA<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterImmediate(cpu, cpu.state.a);
 }
-void ISA::LDA<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPage(cpu, cpu.state.a);
 }
-void ISA::LDA<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPageIndexed(cpu, cpu.state.a,
                                                   cpu.state.x);
 }
-void ISA::LDA<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsoluteIndexed(cpu, cpu.state.a,
                                                   cpu.state.x);
 }
-void ISA::LDA<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsoluteIndexed(cpu, cpu.state.a,
                                                   cpu.state.y);
 }
-void ISA::LDA<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterXIndirect(cpu, cpu.state.a, cpu.state.x);
 }
-void ISA::LDA<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDA<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterIndirectY(cpu, cpu.state.a);
 }
 
-void ISA::LDX<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDX<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsolute(cpu, cpu.state.x);
 }
-void ISA::LDX<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDX<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterImmediate(cpu, cpu.state.x);
 }
-void ISA::LDX<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDX<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPage(cpu, cpu.state.x);
 }
-void ISA::LDX<AddressingMode::ZeroPageY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDX<AddressingMode::ZeroPageY>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPageIndexed(cpu, cpu.state.x,
                                                   cpu.state.y);
 }
-void ISA::LDX<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDX<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsoluteIndexed(cpu, cpu.state.x,
                                                   cpu.state.y);
 }
 
-void ISA::LDY<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDY<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsolute(cpu, cpu.state.y);
 }
-void ISA::LDY<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDY<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterImmediate(cpu, cpu.state.y);
 }
-void ISA::LDY<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDY<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPage(cpu, cpu.state.y);
 }
-void ISA::LDY<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDY<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterZeroPageIndexed(cpu, cpu.state.y,
                                                   cpu.state.x);
 }
-void ISA::LDY<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LDY<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::LoadMemoryToRegisterAbsoluteIndexed(cpu, cpu.state.y,
                                                   cpu.state.x);
 }
 
-void ISA::STA<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterAbsolute(cpu, cpu.state.a);
 }
-void ISA::STA<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPage(cpu, cpu.state.a);
 }
-void ISA::STA<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPageIndexed(cpu, cpu.state.a, cpu.state.x);
 }
-void ISA::STA<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterAbsoluteIndexed(cpu, cpu.state.a, cpu.state.x);
 }
-void ISA::STA<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterAbsoluteIndexed(cpu, cpu.state.a, cpu.state.y);
 }
-void ISA::STA<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterXIndirect(cpu, cpu.state.a, cpu.state.x);
 }
-void ISA::STA<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STA<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterIndirectY(cpu, cpu.state.a);
 }
 
-void ISA::STX<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STX<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterAbsolute(cpu, cpu.state.x);
 }
-void ISA::STX<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STX<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPage(cpu, cpu.state.x);
 }
-void ISA::STX<AddressingMode::ZeroPageY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STX<AddressingMode::ZeroPageY>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPageIndexed(cpu, cpu.state.x, cpu.state.y);
 }
 
-void ISA::STY<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STY<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterAbsolute(cpu, cpu.state.y);
 }
-void ISA::STY<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STY<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPage(cpu, cpu.state.y);
 }
-void ISA::STY<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::STY<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::StoreRegisterZeroPageIndexed(cpu, cpu.state.y, cpu.state.x);
 }
 
-void ISA::TAX<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TAX<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::TransferRegister(cpu, cpu.state.x, cpu.state.a);
 }
-void ISA::TAY<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TAY<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::TransferRegister(cpu, cpu.state.y, cpu.state.a);
 }
-void ISA::TXA<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TXA<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::TransferRegister(cpu, cpu.state.a, cpu.state.x);
 }
-void ISA::TYA<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::TYA<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::TransferRegister(cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::AND<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::AND>(cpu, cpu.state.a);
 }
 
-void ISA::AND<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::AND>(cpu, cpu.state.a);
 }
 
-void ISA::AND<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::AND>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::AND<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::AND>(cpu, cpu.state.a);
 }
 
-void ISA::AND<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::AND>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::AND<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::AND>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::AND<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::AND>(cpu, cpu.state.a);
 }
 
-void ISA::AND<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::AND<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::AND>(cpu, cpu.state.a);
 }
 
-void ISA::EOR<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::EOR>(cpu, cpu.state.a);
 }
 
-void ISA::EOR<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::EOR>(cpu, cpu.state.a);
 }
 
-void ISA::EOR<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::EOR>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::EOR<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::EOR>(cpu, cpu.state.a);
 }
 
-void ISA::EOR<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::EOR>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::EOR<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::EOR>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::EOR<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::EOR>(cpu, cpu.state.a);
 }
 
-void ISA::EOR<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::EOR<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::EOR>(cpu, cpu.state.a);
 }
 
-void ISA::ORA<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::ORA>(cpu, cpu.state.a);
 }
 
-void ISA::ORA<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::ORA>(cpu, cpu.state.a);
 }
 
-void ISA::ORA<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::ORA>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::ORA<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::ORA>(cpu, cpu.state.a);
 }
 
-void ISA::ORA<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::ORA>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::ORA<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::ORA>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::ORA<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::ORA>(cpu, cpu.state.a);
 }
 
-void ISA::ORA<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ORA<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::ORA>(cpu, cpu.state.a);
 }
 
-void ISA::BIT<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BIT<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::BIT>(cpu, cpu.state.a);
 }
 
-void ISA::BIT<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BIT<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::BIT>(cpu, cpu.state.a);
 }
 
-void ISA::ADC<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::ADC>(cpu, cpu.state.a);
 }
 
-void ISA::ADC<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::ADC>(cpu, cpu.state.a);
 }
 
-void ISA::ADC<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::ADC>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::ADC<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::ADC>(cpu, cpu.state.a);
 }
 
-void ISA::ADC<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::ADC>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::ADC<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::ADC>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::ADC<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::ADC>(cpu, cpu.state.a);
 }
 
-void ISA::ADC<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ADC<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::ADC>(cpu, cpu.state.a);
 }
 
-void ISA::SBC<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::SBC>(cpu, cpu.state.a);
 }
 
-void ISA::SBC<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::SBC>(cpu, cpu.state.a);
 }
 
-void ISA::SBC<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::SBC>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::SBC<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::SBC>(cpu, cpu.state.a);
 }
 
-void ISA::SBC<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::SBC>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::SBC<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::SBC>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::SBC<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::SBC>(cpu, cpu.state.a);
 }
 
-void ISA::SBC<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SBC<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::SBC>(cpu, cpu.state.a);
 }
 
-void ISA::CMP<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::CMP>(cpu, cpu.state.a);
 }
 
-void ISA::CMP<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::CMP>(cpu, cpu.state.a);
 }
 
-void ISA::CMP<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed<ISA_detail::Operation::CMP>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::CMP<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::CMP>(cpu, cpu.state.a);
 }
 
-void ISA::CMP<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::CMP>(
       cpu, cpu.state.a, cpu.state.x);
 }
 
-void ISA::CMP<AddressingMode::AbsoluteY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::AbsoluteY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed<ISA_detail::Operation::CMP>(
       cpu, cpu.state.a, cpu.state.y);
 }
 
-void ISA::CMP<AddressingMode::XIndirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::XIndirect>::Execute(CPU_T &cpu) {
   ISA_detail::OperationXIndirect<ISA_detail::Operation::CMP>(cpu, cpu.state.a);
 }
 
-void ISA::CMP<AddressingMode::IndirectY>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CMP<AddressingMode::IndirectY>::Execute(CPU_T &cpu) {
   ISA_detail::OperationIndirectY<ISA_detail::Operation::CMP>(cpu, cpu.state.a);
 }
 
-void ISA::CPX<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPX<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::CMP>(cpu, cpu.state.x);
 }
 
-void ISA::CPX<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPX<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::CMP>(cpu, cpu.state.x);
 }
 
-void ISA::CPX<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPX<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::CMP>(cpu, cpu.state.x);
 }
 
-void ISA::CPY<AddressingMode::Immediate>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPY<AddressingMode::Immediate>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImmediate<ISA_detail::Operation::CMP>(cpu, cpu.state.y);
 }
 
-void ISA::CPY<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPY<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage<ISA_detail::Operation::CMP>(cpu, cpu.state.y);
 }
 
-void ISA::CPY<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CPY<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute<ISA_detail::Operation::CMP>(cpu, cpu.state.y);
 }
 
-void ISA::INC<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INC<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<ISA_detail::Operation::INC>(
       cpu);
 }
 
-void ISA::INC<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INC<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::INC>(cpu, cpu.state.x);
 }
 
-void ISA::INC<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INC<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<ISA_detail::Operation::INC>(
       cpu);
 }
 
-void ISA::INC<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INC<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::INC>(cpu, cpu.state.x);
 }
 
-void ISA::INX<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INX<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::INC>(cpu, cpu.state.x);
 }
 
-void ISA::INY<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::INY<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::INC>(cpu, cpu.state.y);
 }
 
-void ISA::DEC<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEC<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<ISA_detail::Operation::DEC>(
       cpu);
 }
 
-void ISA::DEC<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEC<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::DEC>(cpu, cpu.state.x);
 }
 
-void ISA::DEC<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEC<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<ISA_detail::Operation::DEC>(
       cpu);
 }
 
-void ISA::DEC<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEC<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::DEC>(cpu, cpu.state.x);
 }
 
-void ISA::DEX<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEX<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::DEC>(cpu, cpu.state.x);
 }
 
-void ISA::DEY<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::DEY<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::DEC>(cpu, cpu.state.y);
 }
 
-void ISA::ASL<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ASL<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::SHIFT_LEFT>(cpu,
                                                                   cpu.state.a);
 }
 
-void ISA::ASL<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ASL<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_LEFT>(cpu);
 }
 
-void ISA::ASL<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ASL<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_LEFT>(cpu, cpu.state.x);
 }
 
-void ISA::ASL<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ASL<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_LEFT>(cpu);
 }
 
-void ISA::ASL<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ASL<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_LEFT>(cpu, cpu.state.x);
 }
 
-void ISA::LSR<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LSR<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::SHIFT_RIGHT>(cpu,
                                                                    cpu.state.a);
 }
 
-void ISA::LSR<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LSR<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_RIGHT>(cpu);
 }
 
-void ISA::LSR<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LSR<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_RIGHT>(cpu, cpu.state.x);
 }
 
-void ISA::LSR<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LSR<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_RIGHT>(cpu);
 }
 
-void ISA::LSR<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::LSR<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::SHIFT_RIGHT>(cpu, cpu.state.x);
 }
 
-void ISA::ROL<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROL<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::ROTATE_LEFT>(cpu,
                                                                    cpu.state.a);
 }
 
-void ISA::ROL<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROL<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_LEFT>(cpu);
 }
 
-void ISA::ROL<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROL<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_LEFT>(cpu, cpu.state.x);
 }
 
-void ISA::ROL<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROL<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_LEFT>(cpu);
 }
 
-void ISA::ROL<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROL<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_LEFT>(cpu, cpu.state.x);
 }
 
-void ISA::ROR<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROR<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ISA_detail::OperationImplied<ISA_detail::Operation::ROTATE_RIGHT>(
       cpu, cpu.state.a);
 }
 
-void ISA::ROR<AddressingMode::ZeroPage>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROR<AddressingMode::ZeroPage>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPage_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_RIGHT>(cpu);
 }
 
-void ISA::ROR<AddressingMode::ZeroPageX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROR<AddressingMode::ZeroPageX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationZeroPageIndexed_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_RIGHT>(cpu, cpu.state.x);
 }
 
-void ISA::ROR<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROR<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsolute_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_RIGHT>(cpu);
 }
 
-void ISA::ROR<AddressingMode::AbsoluteX>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::ROR<AddressingMode::AbsoluteX>::Execute(CPU_T &cpu) {
   ISA_detail::OperationAbsoluteIndexed_ReadModifyWrite<
       ISA_detail::Operation::ROTATE_RIGHT>(cpu, cpu.state.x);
 }
 
-void ISA::JMP<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::JMP<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Fetch low byte of address
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->op_latch);
+      ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
     case 2: {
       // Fetch high byte of address
-      u16 address = cpu.bus->op_latch;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->op_latch);
-      address = (cpu.bus->op_latch << 8) | address;
+      u16 address = cpu.op_latch;
+      ISA_detail::ReadProgramByte(cpu, cpu.op_latch);
+      address = (cpu.op_latch << 8) | address;
       cpu.state.pc = address;
       cpu.instruction_cycle = 0;
     } break;
@@ -1751,34 +1930,33 @@ void ISA::JMP<AddressingMode::Absolute>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::JMP<AddressingMode::Indirect>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::JMP<AddressingMode::Indirect>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Fetch low byte of pointer
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->adl);
+      ISA_detail::ReadProgramByte(cpu, cpu.adl);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
     case 2: {
       // Fetch high byte of pointer
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->adh);
+      ISA_detail::ReadProgramByte(cpu, cpu.adh);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
     case 3: {
       // Fetch low byte of address
-      ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl,
-                                   cpu.bus->op_latch);
+      ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl,
+                                   cpu.op_latch);
       ++cpu.instruction_cycle;
     } break;
     case 4: {
       // Fetch high byte of address and set PC
-      u16 address = cpu.bus->op_latch;
-      ISA_detail::ReadValueFromMem(cpu.bus, cpu.bus->adh, cpu.bus->adl + 1,
-                                   cpu.bus->op_latch);
-      address = CombineToU16(cpu.bus->op_latch, address);
+      u16 address = cpu.op_latch;
+      ISA_detail::ReadValueFromMem(cpu.bus, cpu.adh, cpu.adl + 1,
+                                   cpu.op_latch);
+      address = CombineToU16(cpu.op_latch, address);
       cpu.state.pc = address;
       cpu.instruction_cycle = 0;
     } break;
@@ -1787,12 +1965,12 @@ void ISA::JMP<AddressingMode::Indirect>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::JSR<AddressingMode::Absolute>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::JSR<AddressingMode::Absolute>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Fetch low byte of address
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->adl);
+      ISA_detail::ReadProgramByte(cpu, cpu.adl);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
@@ -1812,9 +1990,8 @@ void ISA::JSR<AddressingMode::Absolute>::Execute(CPU &cpu) {
     } break;
     case 5: {
       // Fetch high byte of address and set PC
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), cpu.bus->adh);
-      u16 address = CombineToU16(cpu.bus->adh, cpu.bus->adl);
+      ISA_detail::ReadProgramByte(cpu, cpu.adh);
+      u16 address = CombineToU16(cpu.adh, cpu.adl);
       cpu.state.pc = address;
       cpu.instruction_cycle = 0;
     } break;
@@ -1823,13 +2000,12 @@ void ISA::JSR<AddressingMode::Absolute>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::RTS<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::RTS<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // Read next PC byte and throw it away
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.instruction_cycle;
     } break;
     case 2: {
@@ -1858,92 +2034,107 @@ void ISA::RTS<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::BCC<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BCC<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BCC>(cpu);
 }
 
-void ISA::BCS<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BCS<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BCS>(cpu);
 }
 
-void ISA::BEQ<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BEQ<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BEQ>(cpu);
 }
 
-void ISA::BMI<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BMI<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BMI>(cpu);
 }
 
-void ISA::BNE<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BNE<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BNE>(cpu);
 }
 
-void ISA::BPL<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BPL<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BPL>(cpu);
 }
 
-void ISA::BVC<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BVC<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BVC>(cpu);
 }
 
-void ISA::BVS<AddressingMode::Relative>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BVS<AddressingMode::Relative>::Execute(CPU_T &cpu) {
   ISA_detail::RelativeBranch<ISA_detail::BranchCondition::BVS>(cpu);
 }
 
-void ISA::CLC<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CLC<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
-  cpu.state.status.carry = false;
+  cpu.flags.carry = 0;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::CLD<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CLD<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
   cpu.state.status.decimal_mode = false;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::CLI<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CLI<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
   cpu.state.status.interrupt_disable = false;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::CLV<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::CLV<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
-  cpu.state.status.overflow = false;
+  cpu.flags.overflow_result = 0;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::SEC<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SEC<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
-  cpu.state.status.carry = true;
+  cpu.flags.carry = 1;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::SED<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SED<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
   cpu.state.status.decimal_mode = true;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::SEI<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::SEI<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
   cpu.state.status.interrupt_disable = true;
   cpu.instruction_cycle = 0;
 }
 
-void ISA::NOP<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::NOP<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   ASSERT(cpu.instruction_cycle == 1, "Invalid cycle");
   cpu.instruction_cycle = 0;
 }
 
-void ISA::RTI<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::RTI<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // dummy read
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
@@ -1954,7 +2145,9 @@ void ISA::RTI<AddressingMode::Implied>::Execute(CPU &cpu) {
     } break;
     case 3: {
       // pull status from stack, increment SP
-      cpu.state.status.status = cpu.ReadStackValue();
+      CPUCore::StatusFlags status{};
+      status.status = cpu.ReadStackValue();
+      cpu.SetStatus(status);
       cpu.IncrementSP();
       ++cpu.instruction_cycle;
     } break;
@@ -1974,13 +2167,12 @@ void ISA::RTI<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
-void ISA::BRK<AddressingMode::Implied>::Execute(CPU &cpu) {
+template <typename CPU_T>
+void ISA::BRK<AddressingMode::Implied>::Execute(CPU_T &cpu) {
   switch (cpu.instruction_cycle) {
     case 1: {
       // dummy read
-      u8 dummy = 0;
-      ISA_detail::ReadValueFromMem(cpu.bus, U16High(cpu.state.pc),
-                                   U16Low(cpu.state.pc), dummy);
+      ISA_detail::DummyReadProgramByte(cpu);
       ++cpu.state.pc;
       ++cpu.instruction_cycle;
     } break;
@@ -1998,7 +2190,7 @@ void ISA::BRK<AddressingMode::Implied>::Execute(CPU &cpu) {
       // Push status to stack - set B flag
       cpu.state.status.break_command = 1;
       cpu.state.status.unused = 1;
-      cpu.PushStack(cpu.state.status.status);
+      cpu.PushStack(cpu.GetStatus().status);
       cpu.state.status.interrupt_disable = 1;
       ++cpu.instruction_cycle;
     } break;
@@ -2021,4 +2213,92 @@ void ISA::BRK<AddressingMode::Implied>::Execute(CPU &cpu) {
   }
 }
 
+template <typename CPU_T>
+const std::array<ISA::InstructionFunc<CPU_T>, 256>
+    InstructionTables<CPU_T>::cycle =
+        MakeInstructionTable<ISA::InstructionFunc<CPU_T>, CPU_T,
+                             ISA::CycleDispatch>();
+
+template <typename CPU_T>
+const std::array<ISA::InstructionFastFunc<CPU_T>, 256>
+    InstructionTables<CPU_T>::fast =
+        MakeInstructionTable<ISA::InstructionFastFunc<CPU_T>, CPU_T,
+                             ISA_detail::InstructionDispatch>();
+
+#if QNES_HAS_COMPUTED_GOTO
+// Expands X once for every opcode value
+#define QNES_OPCODE_ROW(X, H)                                             \
+  X(0x##H##0) X(0x##H##1) X(0x##H##2) X(0x##H##3) X(0x##H##4) X(0x##H##5) \
+  X(0x##H##6) X(0x##H##7) X(0x##H##8) X(0x##H##9) X(0x##H##A) X(0x##H##B) \
+  X(0x##H##C) X(0x##H##D) X(0x##H##E) X(0x##H##F)
+#define QNES_FOR_EACH_OPCODE(X)                                               \
+  QNES_OPCODE_ROW(X, 0) QNES_OPCODE_ROW(X, 1) QNES_OPCODE_ROW(X, 2)           \
+  QNES_OPCODE_ROW(X, 3) QNES_OPCODE_ROW(X, 4) QNES_OPCODE_ROW(X, 5)           \
+  QNES_OPCODE_ROW(X, 6) QNES_OPCODE_ROW(X, 7) QNES_OPCODE_ROW(X, 8)           \
+  QNES_OPCODE_ROW(X, 9) QNES_OPCODE_ROW(X, A) QNES_OPCODE_ROW(X, B)           \
+  QNES_OPCODE_ROW(X, C) QNES_OPCODE_ROW(X, D) QNES_OPCODE_ROW(X, E)           \
+  QNES_OPCODE_ROW(X, F)
+
+template <typename CPU_T>
+void ISA::RunThreaded(CPU_T &cpu, u64 last_start_cycle) {
+  // Same handlers as InstructionTables::fast, but known at compile time so
+  // every label below calls (and usually inlines) its handler directly
+  static constexpr auto handlers =
+      MakeInstructionTable<ISA::InstructionFastFunc<CPU_T>, CPU_T,
+                           ISA_detail::InstructionDispatch>();
+  static constexpr auto implemented =
+      MakeInstructionTable<bool, CPU_T, ISA_detail::ImplementedDispatch>();
+
+#define QNES_THREADED_LABEL_ADDRESS(OPCODE) &&opcode_##OPCODE,
+  static const void *const labels[256] = {
+      QNES_FOR_EACH_OPCODE(QNES_THREADED_LABEL_ADDRESS)};
+#undef QNES_THREADED_LABEL_ADDRESS
+
+// Leaves the loop or fetches the next opcode and jumps to its handler. Every
+// handler gets its own copy of the indirect jump, so the branch predictor
+// learns opcode to opcode transitions instead of a single dispatch site.
+#define QNES_THREADED_DISPATCH()                                        \
+  if (cpu.exit_requested || cpu.cycle_count > last_start_cycle ||       \
+      !cpu.ReadyToFetchOpcode()) {                                      \
+    return;                                                             \
+  }                                                                     \
+  cpu.FetchOpcode();                                                    \
+  goto *labels[cpu.ir]
+
+#define QNES_THREADED_HANDLER(OPCODE)                            \
+  opcode_##OPCODE : {                                            \
+    if constexpr (implemented[OPCODE]) {                         \
+      handlers[OPCODE](cpu);                                     \
+      cpu.decoded = nullptr;                                     \
+    } else {                                                     \
+      ASSERT(false, "Invalid opcode");                           \
+      return;                                                    \
+    }                                                            \
+  }                                                              \
+  QNES_THREADED_DISPATCH();
+
+  QNES_THREADED_DISPATCH();
+  QNES_FOR_EACH_OPCODE(QNES_THREADED_HANDLER)
+
+#undef QNES_THREADED_HANDLER
+#undef QNES_THREADED_DISPATCH
+}
+
+#undef QNES_FOR_EACH_OPCODE
+#undef QNES_OPCODE_ROW
+
+#define QNES_INSTANTIATE_RUN_THREADED(BUS) \
+  template void ISA::RunThreaded(BasicCPU<BUS> &cpu, u64 last_start_cycle);
+#else
+#define QNES_INSTANTIATE_RUN_THREADED(BUS)
+#endif
+
+// Instantiating the tables instantiates every instruction handler for the bus
+#define QNES_INSTANTIATE_INSTRUCTION_TABLES(BUS)    \
+  template struct InstructionTables<BasicCPU<BUS>>; \
+  QNES_INSTANTIATE_RUN_THREADED(BUS)
+QNES_CPU_BUS_TYPES(QNES_INSTANTIATE_INSTRUCTION_TABLES)
+#undef QNES_INSTANTIATE_INSTRUCTION_TABLES
+#undef QNES_INSTANTIATE_RUN_THREADED
+
 }  // namespace QNes
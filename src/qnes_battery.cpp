@@ -0,0 +1,213 @@
+#include "qnes_battery.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QNES_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#else
+#define QNES_HAS_MMAP 0
+#include <filesystem>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace QNes {
+
+BatteryFile::BatteryFile(std::string path, Cartridge &cartridge, Mode mode)
+    : path(std::move(path)), cartridge(&cartridge), mode(mode) {}
+
+BatteryFile::~BatteryFile() {
+  if (writer.joinable()) {
+    {
+      const std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    // The writer saves what is still pending before it stops
+    wake.notify_all();
+    writer.join();
+  }
+#if QNES_HAS_MMAP
+  if (mapping != nullptr) {
+    munmap(mapping, mapping_size);
+  }
+#endif
+}
+
+std::unique_ptr<BatteryFile> BatteryFile::Open(const std::string &path,
+                                               Cartridge &cartridge,
+                                               Mode mode) {
+  PagedMemory *prg_ram = cartridge.GetPRGRAM();
+  if (!cartridge.GetHeader().battery || prg_ram == nullptr) {
+    return nullptr;
+  }
+#if !QNES_HAS_MMAP
+  mode = Mode::WRITE;
+#endif
+  std::unique_ptr<BatteryFile> battery(
+      new BatteryFile(path, cartridge, mode));
+
+  // A shorter file (an older dump of the board) fills the start of PRG-RAM
+  {
+    std::vector<u8> data(prg_ram->GetSize());
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char *>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+    prg_ram->InitializeFrom(
+        0, std::span<const u8>(data).first(static_cast<size_t>(
+               std::max<std::streamsize>(file.gcount(), 0))));
+  }
+
+#if QNES_HAS_MMAP
+  if (mode == Mode::MAPPED) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return nullptr;
+    }
+    const size_t size = prg_ram->GetSize();
+    // Only grown, the bytes of a larger file past PRG-RAM are left alone
+    struct stat status {};
+    if (fstat(fd, &status) != 0 ||
+        (status.st_size < static_cast<off_t>(size) &&
+         ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+      close(fd);
+      return nullptr;
+    }
+    void *mapping =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      return nullptr;
+    }
+    battery->mapping = static_cast<u8 *>(mapping);
+    battery->mapping_size = size;
+    for (u32 page = 0; page < prg_ram->GetPageCount(); ++page) {
+      std::copy_n(prg_ram->GetPage(page), PagedMemory::PAGE_SIZE,
+                  battery->mapping + page * PagedMemory::PAGE_SIZE);
+    }
+  }
+#endif
+
+  // What was loaded is saved already
+  battery->saved = cartridge.SnapshotPRGRAM();
+  if (battery->mode == Mode::WRITE) {
+    battery->writer = std::thread(&BatteryFile::RunWriter, battery.get());
+  }
+  return battery;
+}
+
+bool BatteryFile::IsDirty() const {
+  const PagedMemory &prg_ram = *cartridge->GetPRGRAM();
+  for (u32 page = 0; page < prg_ram.GetPageCount(); ++page) {
+    // Written pages were copied away from the snapshot
+    if (prg_ram.GetPage(page) != saved->GetPage(page)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BatteryFile::EndFrame() {
+  if (!IsDirty()) {
+    return false;
+  }
+  std::shared_ptr<const PagedMemory> snapshot = cartridge->SnapshotPRGRAM();
+  if (mode == Mode::MAPPED) {
+    for (u32 page = 0; page < snapshot->GetPageCount(); ++page) {
+      if (snapshot->GetPage(page) != saved->GetPage(page)) {
+        std::copy_n(snapshot->GetPage(page), PagedMemory::PAGE_SIZE,
+                    mapping + page * PagedMemory::PAGE_SIZE);
+      }
+    }
+  } else {
+    {
+      const std::lock_guard lock(mutex);
+      pending = snapshot;
+    }
+    wake.notify_all();
+  }
+  saved = std::move(snapshot);
+  ++save_count;
+  return true;
+}
+
+bool BatteryFile::Flush() {
+#if QNES_HAS_MMAP
+  if (mode == Mode::MAPPED) {
+    return msync(mapping, mapping_size, MS_SYNC) == 0;
+  }
+#endif
+  std::unique_lock lock(mutex);
+  wake.wait(lock,
+            [this] { return pending == nullptr && writing == nullptr; });
+  return !std::exchange(failed, false);
+}
+
+void BatteryFile::RunWriter() {
+  std::unique_lock lock(mutex);
+  while (true) {
+    wake.wait(lock, [this] { return pending != nullptr || stopping; });
+    if (pending == nullptr) {
+      return;
+    }
+    writing = std::exchange(pending, nullptr);
+    const PagedMemory &snapshot = *writing;
+    lock.unlock();
+    const bool written = WriteFile(snapshot);
+    lock.lock();
+    writing = nullptr;
+    failed |= !written;
+    wake.notify_all();
+  }
+}
+
+bool BatteryFile::WriteFile(const PagedMemory &snapshot) const {
+  std::vector<u8> data(snapshot.GetSize());
+  for (u32 page = 0; page < snapshot.GetPageCount(); ++page) {
+    std::copy_n(snapshot.GetPage(page), PagedMemory::PAGE_SIZE,
+                data.begin() + page * PagedMemory::PAGE_SIZE);
+  }
+  // The .sav file is replaced only by a complete file
+  const std::string temporary = path + ".tmp";
+#if QNES_HAS_MMAP
+  const int fd =
+      open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  bool written = true;
+  for (size_t offset = 0; written && offset < data.size();) {
+    const ssize_t result =
+        write(fd, data.data() + offset, data.size() - offset);
+    written = result > 0;
+    offset += written ? static_cast<size_t>(result) : 0;
+  }
+  written = written && fsync(fd) == 0;
+  written = close(fd) == 0 && written;
+  if (!written) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
+#else
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    if (!file.good()) {
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  return !error;
+#endif
+}
+
+}  // namespace QNes
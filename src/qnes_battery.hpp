@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "qnes_c.hpp"
+#include "qnes_mapper.hpp"
+#include "qnes_memory.hpp"
+
+namespace QNes {
+
+/**
+ * @brief Battery backed PRG-RAM kept in a .sav file
+ * @details EndFrame is called by the emulation thread between frames. It finds
+ * the PRG-RAM pages written since the last frame that was saved and, if there
+ * are any, takes a copy-on-write snapshot of PRG-RAM (see
+ * Cartridge::SnapshotPRGRAM). Neither costs more than a pointer per page, the
+ * emulation thread never touches the file:
+ *
+ * - Mode::WRITE hands the snapshot to a background thread that writes it to
+ *   a temporary file and renames it over the .sav file, so the file always
+ *   holds a whole frame. A snapshot that is still waiting when the next one
+ *   is taken is replaced by it.
+ * - Mode::MAPPED maps the .sav file shared into memory and copies the written
+ *   pages into the mapping, the OS writes them back. A shorter file is grown
+ *   to the size of PRG-RAM, a larger one is never cut. Platforms without mmap
+ *   use Mode::WRITE.
+ *
+ * The whole PRG-RAM is saved, the file is its image.
+ */
+class BatteryFile {
+ public:
+  enum class Mode : u8 {
+    WRITE,
+    MAPPED,
+  };
+
+  BatteryFile(const BatteryFile &) = delete;
+  BatteryFile &operator=(const BatteryFile &) = delete;
+  BatteryFile(BatteryFile &&) = delete;
+  BatteryFile &operator=(BatteryFile &&) = delete;
+  // Saves the last frame passed to EndFrame
+  ~BatteryFile();
+
+  // Loads the file into the PRG-RAM of cartridge when it exists. nullptr when
+  // the cartridge has no battery or (Mode::MAPPED) the file cannot be mapped.
+  // The cartridge has to outlive the BatteryFile.
+  [[nodiscard]] static std::unique_ptr<BatteryFile> Open(
+      const std::string &path, Cartridge &cartridge, Mode mode);
+
+  // Saves the PRG-RAM if it was written since the last saved frame, true
+  // when it was
+  bool EndFrame();
+  // Waits until the last frame passed to EndFrame is on disk, false when
+  // writing failed
+  bool Flush();
+
+  [[nodiscard]] Mode GetMode() const { return mode; }
+  // Frames saved since Open
+  [[nodiscard]] u64 GetSaveCount() const { return save_count; }
+
+ private:
+  BatteryFile(std::string path, Cartridge &cartridge, Mode mode);
+
+  // False when the snapshot is still the PRG-RAM
+  [[nodiscard]] bool IsDirty() const;
+  void RunWriter();
+  // Whole-file write and rename, on the writer thread
+  [[nodiscard]] bool WriteFile(const PagedMemory &snapshot) const;
+
+  std::string path;
+  Cartridge *cartridge = nullptr;
+  Mode mode = Mode::WRITE;
+  u64 save_count = 0;
+  // PRG-RAM as of the last saved frame, shared with the writer thread
+  std::shared_ptr<const PagedMemory> saved;
+
+  // Mode::MAPPED
+  u8 *mapping = nullptr;
+  size_t mapping_size = 0;
+
+  // Mode::WRITE, the writer thread and what it shares with EndFrame/Flush
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::shared_ptr<const PagedMemory> pending;  // guarded by mutex
+  // Snapshot being written, dropped under the mutex once it is on disk
+  std::shared_ptr<const PagedMemory> writing;  // guarded by mutex
+  bool failed = false;                         // guarded by mutex
+  bool stopping = false;                       // guarded by mutex
+  std::thread writer;
+};
+
+using BatteryFilePtr = std::unique_ptr<BatteryFile>;
+
+}  // namespace QNes
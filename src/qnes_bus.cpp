@@ -2,54 +2,272 @@
 
 namespace QNes {
 
-u8 NESBus::Read() {
-  if (addr < 0x2000) {
-    // Internal RAM (2 KB, mirrored)
-    // mask the address to 0x07FF effectively truncating the address to 11 bits
-    return memory->Read(addr & 0x07FF);
-  } else if (addr < 0x4000) {
-    ASSERT(ppu != nullptr, "PPU is not initialized");
-    // PPU registers (8 bytes mirrored)
-    // mask the address to 0x0007 effectively truncating the address to 3 bits
-    // NOTE: Only PPUSTATUS, OAMDATA, and PPUDATA registers are readable by the
-    // external bus
-    const u8 masked_addr = addr & 0x0007;
-    ASSERT(masked_addr == 2 || masked_addr == 4 || masked_addr == 7,
-           "Invalid PPU register read address");
-    return ppu->BusReadMappedRegister(masked_addr);
-  }
-  ASSERT(false, "Invalid address");
-  return 0;
-}
-
-void NESBus::Write(u8 value) {
-  if (addr < 0x2000) {
-    // Internal RAM (2 KB, mirrored)
-    // mask the address to 0x07FF effectively truncating the address to 11 bits
-    memory->Write(addr & 0x07FF, value);
-  } else if (addr < 0x4000) {
-    ASSERT(ppu != nullptr, "PPU is not initialized");
-    // PPU registers (8 bytes mirrored)
-    // mask the address to 0x0007 effectively truncating the address to 3 bits
-    // NOTE: Only PPUCONTROL, PPUMASK, OAMADDR, OAMDATA, PPUSCROLL, PPUADDRESS,
-    // PPUDATA registers are writable by the external bus
-    const u8 masked_addr = addr & 0x0007;
-    ASSERT(masked_addr == 0 || masked_addr == 1 || masked_addr == 3 ||
-               masked_addr == 4 || masked_addr == 5 || masked_addr == 6 ||
-               masked_addr == 7,
-           "Invalid PPU register write address");
-    ppu->BusWriteMappedRegister(masked_addr, value);
-  } else if (addr == 0x4014) {
-    // DO DMA transfer
-    ASSERT(false, "Invalid address");
+// Halt of an OAM DMA transfer: a cycle waiting for the write to finish, then
+// 256 read/write pairs (one more cycle to align the reads to even cycles)
+constexpr u16 OAM_DMA_CYCLES = 513;
+
+NESBus::NESBus(WorkRAM *memory, PPU *ppu) : memory(memory), ppu(ppu) {
+  Unmap(0x0000, 0x10000);
+  // Internal RAM (2 KB, mirrored up to $1FFF)
+  MapMemory(0x0000, 0x2000, memory->GetData(), WorkRAM::GetSize(), true);
+  // PPU registers (8 bytes, mirrored up to $3FFF)
+  MapIO(0x2000, 0x2000, ReadPPU, WritePPU, ppu);
+  // APU and I/O registers ($4000-$401F), the rest of the page is cartridge
+  // expansion space
+  MapIO(0x4000, PAGE_SIZE, ReadAPUIO, WriteAPUIO, this);
+}
+
+template <typename APPLY>
+void NESBus::ForEachPage(u16 address, u32 size, APPLY apply) {
+  ASSERT(address % PAGE_SIZE == 0 && size % PAGE_SIZE == 0,
+         "Mapping is not page aligned");
+  ASSERT(address + size <= 0x10000, "Mapping exceeds the address space");
+  for (u32 page_address = address; page_address < address + size;
+       page_address += PAGE_SIZE) {
+    apply(pages[page_address >> PAGE_BITS], page_address);
+  }
+}
+
+void NESBus::MapMemory(u16 address, u32 size, u8 *data, u32 data_size,
+                       bool writable) {
+  ASSERT(data_size != 0 && (data_size & (data_size - 1)) == 0,
+         "Mapped memory size must be a power of two");
+  ForEachPage(address, size, [&](Page &page, u32 page_address) {
+    // Memory smaller than a page is mirrored within the page
+    u8 *base = data;
+    page.mask = static_cast<u16>(data_size - 1);
+    if (data_size >= PAGE_SIZE) {
+      base = data + (page_address - address) % data_size;
+      page.mask = PAGE_SIZE - 1;
+    }
+    page.read_memory = base;
+    page.paged_read = false;
+    if (writable) {
+      page.write_memory = base;
+      page.paged_write = false;
+    }
+  });
+}
+
+void NESBus::MapMemory(u16 address, u32 size, const u8 *data,
+                       u32 data_size) {
+  // Without writable the data only ends up in read_memory
+  MapMemory(address, size, const_cast<u8 *>(data), data_size, false);
+}
+
+void NESBus::MapPagedMemory(u16 address, u32 size, PagedMemory *memory,
+                            u32 offset, bool writable) {
+  static_assert(PagedMemory::PAGE_SIZE == PAGE_SIZE);
+  ASSERT(offset % PAGE_SIZE == 0, "Mapping offset is not page aligned");
+  ForEachPage(address, size, [&](Page &page, u32 page_address) {
+    page.paged_memory = memory;
+    page.paged_page = ((offset + page_address - address) / PAGE_SIZE) %
+                      memory->GetPageCount();
+    page.read_memory = memory->GetPage(page.paged_page);
+    page.mask = PAGE_SIZE - 1;
+    page.paged_read = true;
+    if (writable) {
+      page.paged_write = true;
+      MapPagedWrite(page);
+    }
+  });
+}
+
+void NESBus::ProtectSharedPages() {
+  for (Page &page : pages) {
+    if (page.paged_write) {
+      MapPagedWrite(page);
+    }
+  }
+}
+
+void NESBus::MapPagedWrite(Page &page) {
+  if (page.paged_memory->IsShared(page.paged_page)) {
+    page.write_memory = nullptr;
+    page.write_handler = WriteCopyOnWrite;
+    page.write_device = this;
   } else {
-    ASSERT(false, "Invalid address");
+    page.write_memory = page.paged_memory->GetWritablePage(page.paged_page);
   }
-  return;
 }
 
-u8 PPUBus::Read() { return vram->Read(addr); }
+void NESBus::MapIO(u16 address, u32 size, ReadHandler read,
+                   WriteHandler write, void *device) {
+  ForEachPage(address, size, [&](Page &page, u32) {
+    if (read != nullptr) {
+      page.read_memory = nullptr;
+      page.read_handler = read;
+      page.read_device = device;
+      page.paged_read = false;
+    }
+    if (write != nullptr) {
+      page.write_memory = nullptr;
+      page.write_handler = write;
+      page.write_device = device;
+      page.paged_write = false;
+    }
+  });
+}
+
+void NESBus::Unmap(u16 address, u32 size) {
+  ForEachPage(address, size, [](Page &page, u32) {
+    page = {.read_handler = ReadOpenBus, .write_handler = IgnoreWrite};
+  });
+}
+
+u8 NESBus::ReadOpenBus(void *, u16 address) {
+  // The data bus keeps the last value driven on it, which for the usual
+  // absolute addressed read is the high byte of the address
+  return U16High(address);
+}
+
+void NESBus::IgnoreWrite(void *, u16, u8) {}
 
-void PPUBus::Write(u8 value) { vram->Write(addr, value); }
+void NESBus::WriteCopyOnWrite(void *device, u16 address, u8 value) {
+  auto *bus = static_cast<NESBus *>(device);
+  const Page &written = bus->pages[address >> PAGE_BITS];
+  PagedMemory *memory = written.paged_memory;
+  const u32 paged_page = written.paged_page;
+  u8 *copy = memory->GetWritablePage(paged_page);
+  // every mirror of the page uses the copy from now on
+  for (Page &page : bus->pages) {
+    if (page.paged_memory != memory || page.paged_page != paged_page) {
+      continue;
+    }
+    if (page.paged_read) {
+      page.read_memory = copy;
+    }
+    if (page.paged_write) {
+      page.write_memory = copy;
+    }
+  }
+  copy[address & (PAGE_SIZE - 1)] = value;
+}
+
+u8 NESBus::ReadPPU(void *device, u16 address) {
+  auto *ppu = static_cast<PPU *>(device);
+  ASSERT(ppu != nullptr, "PPU is not initialized");
+  // PPU registers (8 bytes mirrored)
+  // mask the address to 0x0007 effectively truncating the address to 3 bits
+  // NOTE: Only PPUSTATUS, OAMDATA, and PPUDATA registers are readable by the
+  // external bus
+  const u8 masked_addr = address & 0x0007;
+  ASSERT(masked_addr == 2 || masked_addr == 4 || masked_addr == 7,
+         "Invalid PPU register read address");
+  return ppu->BusReadMappedRegister(masked_addr);
+}
+
+void NESBus::WritePPU(void *device, u16 address, u8 value) {
+  auto *ppu = static_cast<PPU *>(device);
+  ASSERT(ppu != nullptr, "PPU is not initialized");
+  // PPU registers (8 bytes mirrored)
+  // mask the address to 0x0007 effectively truncating the address to 3 bits
+  // NOTE: Only PPUCONTROL, PPUMASK, OAMADDR, OAMDATA, PPUSCROLL, PPUADDRESS,
+  // PPUDATA registers are writable by the external bus
+  const u8 masked_addr = address & 0x0007;
+  ASSERT(masked_addr == 0 || masked_addr == 1 || masked_addr == 3 ||
+             masked_addr == 4 || masked_addr == 5 || masked_addr == 6 ||
+             masked_addr == 7,
+         "Invalid PPU register write address");
+  ppu->BusWriteMappedRegister(masked_addr, value);
+}
+
+u8 NESBus::ReadAPUIO(void *device, u16 address) {
+  // No APU or controllers yet
+  return ReadOpenBus(device, address);
+}
+
+void NESBus::WriteAPUIO(void *device, u16 address, u8 value) {
+  if (address == 0x4014) {
+    static_cast<NESBus *>(device)->RunOAMDMA(value);
+    return;
+  }
+  // No APU or controllers yet
+}
+
+void NESBus::RunOAMDMA(u8 source_page) {
+  ASSERT(ppu != nullptr, "PPU is not initialized");
+  const u16 source = CombineToU16(source_page, 0x00);
+  const Page &page = GetPage(source);
+  if (page.read_memory != nullptr && page.mask >= 0xFF) [[likely]] {
+    // RAM or ROM, the 256 bytes are contiguous within the mapped memory
+    ppu->BusWriteOAMDMA(page.read_memory + (source & page.mask));
+  } else {
+    // Device registers see every read
+    std::array<u8, 256> data;
+    for (u16 offset = 0; offset < data.size(); ++offset) {
+      data[offset] = Read(static_cast<u16>(source + offset));
+    }
+    ppu->BusWriteOAMDMA(data.data());
+  }
+  if (cpu != nullptr) {
+    cpu->Halt(OAM_DMA_CYCLES, true);
+  }
+}
+
+namespace {
+
+// What unmapped PPU pages read
+constexpr std::array<u8, PPUBus::PAGE_SIZE> UNMAPPED_PPU_PAGE{};
+
+}  // namespace
+
+PPUBus::PPUBus(VideoRAM *vram) : vram(vram) {
+  Unmap(0x0000, 0x4000);
+  SetMirroring(Mirroring::VERTICAL);
+}
+
+void PPUBus::MapMemory(u16 address, u32 size, u8 *data, u32 data_size,
+                       bool writable) {
+  ASSERT(address % PAGE_SIZE == 0 && size % PAGE_SIZE == 0,
+         "Mapping is not page aligned");
+  ASSERT(address + size <= 0x4000, "Mapping exceeds the address space");
+  ASSERT(data_size >= PAGE_SIZE && (data_size & (data_size - 1)) == 0,
+         "Mapped memory size must be a power of two of at least a page");
+  for (u32 offset = 0; offset < size; offset += PAGE_SIZE) {
+    Page &page = pages[(address + offset) >> PAGE_BITS];
+    u8 *base = data + offset % data_size;
+    page.read_memory = base;
+    page.write_memory = writable ? base : nullptr;
+  }
+}
+
+void PPUBus::MapMemory(u16 address, u32 size, const u8 *data,
+                       u32 data_size) {
+  // Without writable the data only ends up in read_memory
+  MapMemory(address, size, const_cast<u8 *>(data), data_size, false);
+}
+
+void PPUBus::Unmap(u16 address, u32 size) {
+  MapMemory(address, size, UNMAPPED_PPU_PAGE.data(), PAGE_SIZE);
+}
+
+void PPUBus::SetMirroring(Mirroring mirroring) {
+  // VRAM half of each nametable
+  std::array<u8, 4> halves{};
+  switch (mirroring) {
+    case Mirroring::HORIZONTAL:
+      halves = {0, 0, 1, 1};
+      break;
+    case Mirroring::VERTICAL:
+    case Mirroring::FOUR_SCREEN:
+      halves = {0, 1, 0, 1};
+      break;
+    case Mirroring::SINGLE_SCREEN_LOWER:
+      halves = {0, 0, 0, 0};
+      break;
+    case Mirroring::SINGLE_SCREEN_UPPER:
+      halves = {1, 1, 1, 1};
+      break;
+  }
+  for (u16 nametable = 0; nametable < 4; ++nametable) {
+    u8 *data = vram->GetData() + halves[nametable] * PAGE_SIZE;
+    // $3000-$3FFF mirrors $2000-$2FFF
+    MapMemory(static_cast<u16>(0x2000 + nametable * PAGE_SIZE), PAGE_SIZE,
+              data, PAGE_SIZE, true);
+    MapMemory(static_cast<u16>(0x3000 + nametable * PAGE_SIZE), PAGE_SIZE,
+              data, PAGE_SIZE, true);
+  }
+}
 
-}  // namespace QNes
\ No newline at end of file
+}  // namespace QNes
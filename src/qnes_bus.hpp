@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
+
 #include "qnes_bits.hpp"
 #include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
 #include "qnes_cpu.hpp"
 #include "qnes_memory.hpp"
 #include "qnes_ppu.hpp"
@@ -11,7 +14,11 @@ namespace QNes {
 /**
  * @brief Bus interface
  * @details The Bus interface is used to abstract the memory addressing logic
- * for the connected devices.
+ * for the connected devices. Every access passes its address, the bus keeps no
+ * state between accesses (the address latches belong to the CPU). The concrete
+ * buses are final, so a CPU that is instantiated on a concrete bus type (see
+ * QNES_CPU_BUS_TYPES) calls their Read/Write directly instead of through the
+ * vtable.
  */
 class Bus {
  public:
@@ -22,19 +29,33 @@ class Bus {
   Bus &operator=(Bus &&) = delete;
   virtual ~Bus() = default;
 
-  void SetAddress(u8 high, u8 low) { addr = CombineToU16(high, low); }
-  void SetAddress(u16 address) { addr = address; }
+  [[nodiscard]] virtual u8 Read(u16 address) = 0;
+  virtual void Write(u16 address, u8 value) = 0;
 
-  [[nodiscard]] virtual u8 Read() = 0;
-  virtual void Write(u8 value) = 0;
+  // True when address maps to memory that the CPU may keep decoded or
+  // translated copies of: reads have no side effects, the byte only changes
+  // through a CPU write to this very address (no mirroring) or is reported
+  // with CPU::InvalidateCode
+  [[nodiscard]] virtual bool IsDecodeCacheable(
+      [[maybe_unused]] u16 address) const {
+    return false;
+  }
 
- protected:
-  u8 adl = 0, adh = 0;  // Address Latch Low/High
-  u8 op_latch = 0;      // Operand Latch
-  u16 addr = 0;         // Effective Address
+  // True when reading address again right after reading it returns the same
+  // value and changes nothing: plain memory, or registers whose read side
+  // effects settle after the first read (PPUSTATUS). The CPU skips loops that
+  // only read such addresses (see IdleLoopDetector).
+  [[nodiscard]] virtual bool IsIdempotentRead(
+      [[maybe_unused]] u16 address) const {
+    return false;
+  }
 
-  friend struct ISA;
-  friend struct ISA_detail;
+  // False when reading address only returns a value: plain memory. The CPU
+  // skips dummy reads of such addresses in CPU::Accuracy::FAST.
+  [[nodiscard]] virtual bool HasReadSideEffects(
+      [[maybe_unused]] u16 address) const {
+    return true;
+  }
 };
 
 using BusPtr = std::unique_ptr<Bus>;
@@ -47,7 +68,7 @@ using BusPtr = std::unique_ptr<Bus>;
  *
  * @note This bus is used mostly for testing purposes.
  */
-class RAMBus : public Bus {
+class RAMBus final : public Bus {
  public:
   RAMBus(Memory *memory) : memory(memory) {
     ASSERT(memory->GetSize() >= Kilobytes(64),
@@ -59,50 +80,280 @@ class RAMBus : public Bus {
   RAMBus &operator=(RAMBus &&) = delete;
   ~RAMBus() override = default;
 
-  [[nodiscard]] u8 Read() override { return memory->Read(addr); }
-  void Write(u8 value) override { memory->Write(addr, value); }
+  [[nodiscard]] u8 Read(u16 address) override {
+    return memory->Read(address);
+  }
+  void Write(u16 address, u8 value) override { memory->Write(address, value); }
+  [[nodiscard]] bool IsDecodeCacheable(
+      [[maybe_unused]] u16 address) const override {
+    return true;
+  }
+  [[nodiscard]] bool IsIdempotentRead(
+      [[maybe_unused]] u16 address) const override {
+    return true;
+  }
+  [[nodiscard]] bool HasReadSideEffects(
+      [[maybe_unused]] u16 address) const override {
+    return false;
+  }
 
  private:
   Memory *memory = nullptr;  // RAM
 };
 
+/**
+ * @brief Bus of a single lane of a CPUBatch
+ * @details The batch memory is interleaved: the byte at address A of lane L is
+ * at memory[A * lane_count + L], so the same address of all lanes is a single
+ * contiguous row. The bus reads and writes the column of one lane, the lane can
+ * be switched between instructions.
+ */
+class BatchLaneBus final : public Bus {
+ public:
+  BatchLaneBus(u8 *memory, u32 lane_count)
+      : memory(memory), lane_count(lane_count) {}
+  BatchLaneBus(const BatchLaneBus &) = delete;
+  BatchLaneBus &operator=(const BatchLaneBus &) = delete;
+  BatchLaneBus(BatchLaneBus &&) = delete;
+  BatchLaneBus &operator=(BatchLaneBus &&) = delete;
+  ~BatchLaneBus() override = default;
+
+  void SetLane(u32 lane) { this->lane = lane; }
+
+  [[nodiscard]] u8 Read(u16 address) override {
+    return memory[static_cast<size_t>(address) * lane_count + lane];
+  }
+  void Write(u16 address, u8 value) override {
+    memory[static_cast<size_t>(address) * lane_count + lane] = value;
+  }
+  [[nodiscard]] bool IsIdempotentRead(
+      [[maybe_unused]] u16 address) const override {
+    return true;
+  }
+  [[nodiscard]] bool HasReadSideEffects(
+      [[maybe_unused]] u16 address) const override {
+    return false;
+  }
+
+ private:
+  u8 *memory = nullptr;
+  u32 lane_count = 0;
+  u32 lane = 0;
+};
+
 /**
  * @brief NES Bus
  * @details The NES Bus is used to read and write to the NES memory mapped
  * devices. It performs correct mapping/mirroring of the memory spaces as
  * expected by the NES hardware.
+ *
+ * The address space is split into PAGE_COUNT pages of PAGE_SIZE bytes. A page
+ * either points directly at the memory it maps (internal RAM, cartridge
+ * PRG-ROM/RAM), so an access is a page table load and a masked memory access,
+ * or at the handlers of the device behind it (PPU registers, APU/IO, mapper
+ * registers). Reads and writes are mapped separately, e.g. PRG-ROM reads come
+ * from memory while writes to the same page go to the mapper registers.
+ *
+ * Internal RAM, the PPU registers and APU/IO are mapped by the constructor,
+ * the cartridge ($4020-$FFFF) is mapped with MapMemory/MapIO. Unmapped
+ * addresses read as open bus and ignore writes.
  */
-class NESBus : public Bus {
+class NESBus final : public Bus {
  public:
-  NESBus(Memory *memory, PPU *ppu) : memory(memory), ppu(ppu) {};
+  static constexpr u32 PAGE_BITS = 10;
+  static constexpr u32 PAGE_SIZE = 1u << PAGE_BITS;
+  static constexpr u32 PAGE_COUNT = 0x10000 / PAGE_SIZE;
+
+  // Device access, address is the full CPU address
+  using ReadHandler = u8 (*)(void *device, u16 address);
+  using WriteHandler = void (*)(void *device, u16 address, u8 value);
+
+  NESBus(WorkRAM *memory, PPU *ppu);
   NESBus(const NESBus &) = delete;
   NESBus &operator=(const NESBus &) = delete;
   NESBus(NESBus &&) = delete;
   NESBus &operator=(NESBus &&) = delete;
   ~NESBus() override = default;
 
-  [[nodiscard]] u8 Read() override;
-  void Write(u8 value) override;
+  [[nodiscard]] u8 Read(u16 address) override;
+  void Write(u16 address, u8 value) override;
+  // Mapped memory and PPUSTATUS (reading it clears the vblank flag and the
+  // write toggle, the next read sees them cleared)
+  [[nodiscard]] bool IsIdempotentRead(u16 address) const override {
+    return GetPage(address).read_memory != nullptr ||
+           (address >= 0x2000 && address < 0x4000 && (address & 0x0007) == 2);
+  }
+  // Device pages (PPU, APU and I/O registers, open bus), decided per page
+  [[nodiscard]] bool HasReadSideEffects(u16 address) const override {
+    return GetPage(address).read_memory == nullptr;
+  }
+  // Read-only mapped memory (PRG-ROM), bank switches are reported with
+  // CPU::InvalidateCode. RAM is mirrored, so it is not cacheable.
+  [[nodiscard]] bool IsDecodeCacheable(u16 address) const override {
+    const Page &page = GetPage(address);
+    return page.read_memory != nullptr && page.write_memory == nullptr &&
+           page.write_handler != WriteCopyOnWrite;
+  }
+
+  // The 2 KB of internal RAM. $0000-$07FF always maps to it, the CPU accesses
+  // the zero page and the stack directly (see HasInternalRAM).
+  [[nodiscard]] u8 *GetInternalRAM() { return memory->GetData(); }
+
+  // CPU that DMA transfers halt, without one they only copy
+  void ConnectCPU(CPUCore *cpu) { this->cpu = cpu; }
+
+  // Maps [address, address + size) to data, repeating data (data_size bytes,
+  // a power of two) over the range. Without writable only reads are mapped
+  // and the write side of the pages stays as it is. Address and size are
+  // multiples of PAGE_SIZE. Mapping memory the CPU may have executed code
+  // from has to be reported with CPU::InvalidateCode.
+  void MapMemory(u16 address, u32 size, u8 *data, u32 data_size,
+                 bool writable);
+  // Read-only memory (PRG-ROM of a RomImage), writes to the pages keep going
+  // where they went before
+  void MapMemory(u16 address, u32 size, const u8 *data, u32 data_size);
+  // Maps [address, address + size) to the pages of memory from offset on,
+  // repeating the memory over the range (see MapMemory). Pages memory shares
+  // with a fork are read in place and copied on their first write, after that
+  // the copy is written directly. Offset is a multiple of PAGE_SIZE.
+  void MapPagedMemory(u16 address, u32 size, PagedMemory *memory, u32 offset,
+                      bool writable);
+  // Has to be called after memory mapped with MapPagedMemory was forked, so
+  // writes to the pages it now shares copy them first
+  void ProtectSharedPages();
+  // Maps [address, address + size) to device handlers, nullptr leaves that
+  // side of the pages as it is
+  void MapIO(u16 address, u32 size, ReadHandler read, WriteHandler write,
+             void *device);
+  // Back to open bus
+  void Unmap(u16 address, u32 size);
 
  private:
-  Memory *memory = nullptr;  // RAM
-  PPU *ppu = nullptr;        // PPU
+  struct Page {
+    const u8 *read_memory = nullptr;  // nullptr: read_handler
+    u8 *write_memory = nullptr;       // nullptr: write_handler
+    u16 mask = PAGE_SIZE - 1;         // of the address within the memory
+    ReadHandler read_handler = nullptr;
+    WriteHandler write_handler = nullptr;
+    void *read_device = nullptr;
+    void *write_device = nullptr;
+    // Sides mapped with MapPagedMemory, to paged_page of paged_memory
+    bool paged_read = false;
+    bool paged_write = false;
+    u32 paged_page = 0;
+    PagedMemory *paged_memory = nullptr;
+  };
+
+  [[nodiscard]] const Page &GetPage(u16 address) const {
+    return pages[address >> PAGE_BITS];
+  }
+  // Calls apply(page, page_address) for the pages of the range
+  template <typename APPLY>
+  void ForEachPage(u16 address, u32 size, APPLY apply);
+
+  // Maps the write side of a page mapped with MapPagedMemory
+  void MapPagedWrite(Page &page);
+
+  // Copies the 256 bytes at $XX00 to OAM and halts the CPU
+  void RunOAMDMA(u8 source_page);
+
+  static u8 ReadOpenBus(void *device, u16 address);
+  static void IgnoreWrite(void *device, u16 address, u8 value);
+  static void WriteCopyOnWrite(void *device, u16 address, u8 value);
+  static u8 ReadPPU(void *device, u16 address);
+  static void WritePPU(void *device, u16 address, u8 value);
+  static u8 ReadAPUIO(void *device, u16 address);
+  static void WriteAPUIO(void *device, u16 address, u8 value);
+
+  std::array<Page, PAGE_COUNT> pages{};
+
+  WorkRAM *memory = nullptr;  // RAM
+  PPU *ppu = nullptr;         // PPU
+  CPUCore *cpu = nullptr;     // CPU
 };
 
-class PPUBus : public Bus {
+inline u8 NESBus::Read(u16 address) {
+  const Page &page = GetPage(address);
+  if (page.read_memory != nullptr) [[likely]] {
+    return page.read_memory[address & page.mask];
+  }
+  return page.read_handler(page.read_device, address);
+}
+
+inline void NESBus::Write(u16 address, u8 value) {
+  const Page &page = GetPage(address);
+  if (page.write_memory != nullptr) [[likely]] {
+    page.write_memory[address & page.mask] = value;
+    return;
+  }
+  page.write_handler(page.write_device, address, value);
+}
+
+/**
+ * @brief PPU Bus
+ * @details The 16 KB address space of the PPU ($0000-$3FFF, addresses are
+ * masked to it) is split into PAGE_COUNT pages of PAGE_SIZE bytes that point
+ * directly at memory, like the pages of NESBus. The pattern tables
+ * ($0000-$1FFF) are mapped by the cartridge (CHR-ROM/RAM banks), the
+ * nametables ($2000-$2FFF, mirrored up to $3FFF) map to VRAM as the
+ * cartridge wires it (SetMirroring). The palette is inside the PPU.
+ *
+ * Unmapped pages read as 0 and ignore writes. The constructor maps the
+ * nametables with vertical mirroring and leaves the pattern tables unmapped.
+ */
+class PPUBus final : public Bus {
  public:
-  PPUBus(Memory *vram) : vram(vram) {};
+  static constexpr u32 PAGE_BITS = 10;
+  static constexpr u32 PAGE_SIZE = 1u << PAGE_BITS;
+  static constexpr u32 PAGE_COUNT = 0x4000 / PAGE_SIZE;
+
+  PPUBus(VideoRAM *vram);
   PPUBus(const PPUBus &) = delete;
   PPUBus &operator=(const PPUBus &) = delete;
   PPUBus(PPUBus &&) = delete;
   PPUBus &operator=(PPUBus &&) = delete;
   ~PPUBus() override = default;
 
-  [[nodiscard]] u8 Read() override;
-  void Write(u8 value) override;
+  [[nodiscard]] u8 Read(u16 address) override;
+  void Write(u16 address, u8 value) override;
+
+  // Maps [address, address + size) to data, repeating data (data_size bytes,
+  // a power of two and at least PAGE_SIZE) over the range. Address and size
+  // are multiples of PAGE_SIZE.
+  void MapMemory(u16 address, u32 size, u8 *data, u32 data_size,
+                 bool writable);
+  // Read-only memory (CHR-ROM), writes to the pages are ignored
+  void MapMemory(u16 address, u32 size, const u8 *data, u32 data_size);
+  void Unmap(u16 address, u32 size);
+  // Maps the four nametables and their mirrors to the two 1 KB halves of
+  // VRAM. FOUR_SCREEN maps them like VERTICAL, the cartridge maps its own RAM
+  // over the third and the fourth.
+  void SetMirroring(Mirroring mirroring);
 
  private:
-  Memory *vram = nullptr;
+  struct Page {
+    const u8 *read_memory = nullptr;
+    u8 *write_memory = nullptr;  // nullptr: writes are ignored
+  };
+
+  [[nodiscard]] const Page &GetPage(u16 address) const {
+    return pages[(address >> PAGE_BITS) & (PAGE_COUNT - 1)];
+  }
+
+  std::array<Page, PAGE_COUNT> pages{};
+
+  VideoRAM *vram = nullptr;
 };
 
+inline u8 PPUBus::Read(u16 address) {
+  return GetPage(address).read_memory[address & (PAGE_SIZE - 1)];
+}
+
+inline void PPUBus::Write(u16 address, u8 value) {
+  const Page &page = GetPage(address);
+  if (page.write_memory != nullptr) [[likely]] {
+    page.write_memory[address & (PAGE_SIZE - 1)] = value;
+  }
+}
+
 }  // namespace QNes
\ No newline at end of file
@@ -32,6 +32,20 @@
 #define QNES_FORCE_INLINE inline
 #endif
 
+// Labels as values (computed goto), used by the threaded interpreter loop
+#if QNES_COMPILER_GCC || QNES_COMPILER_CLANG
+#define QNES_HAS_COMPUTED_GOTO 1
+#else
+#define QNES_HAS_COMPUTED_GOTO 0
+#endif
+
+// Dynamic recompiler, emits x86-64 code into mmap'ed memory (see qnes_jit.hpp)
+#if defined(__x86_64__) && defined(__linux__)
+#define QNES_HAS_JIT 1
+#else
+#define QNES_HAS_JIT 0
+#endif
+
 #ifdef NDEBUG
 #define DBG_PRINT(msg) ((void)0)
 #else
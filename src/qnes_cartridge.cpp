@@ -0,0 +1,211 @@
+#include "qnes_cartridge.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QNES_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define QNES_HAS_MMAP 0
+#include <filesystem>
+#include <fstream>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace QNes {
+
+namespace {
+
+// Images open in the process, by file identity
+std::mutex open_images_mutex;
+std::map<std::string, std::weak_ptr<const RomImage>> open_images;
+
+// PRG-ROM/CHR-ROM size from the LSB byte and the NES 2.0 MSB nibble
+u64 RomSize(u8 lsb, u8 msb, u64 unit) {
+  if (msb == 0x0F) {
+    // Exponent-multiplier notation, 2^E * (MM * 2 + 1) bytes
+    const u32 exponent = lsb >> 2;
+    const u64 multiplier = (lsb & 0x03) * 2 + 1;
+    if (exponent >= 32) {
+      return std::numeric_limits<u64>::max();  // rejected by ParseHeader
+    }
+    return (u64{1} << exponent) * multiplier;
+  }
+  return ((u64{msb} << 8) | lsb) * unit;
+}
+
+// NES 2.0 RAM sizes are shift counts, 64 << shift bytes
+u32 RamSize(u8 shift) { return shift == 0 ? 0 : 64u << shift; }
+
+}  // namespace
+
+RomImage::~RomImage() {
+#if QNES_HAS_MMAP
+  if (data != nullptr) {
+    munmap(const_cast<u8 *>(data), size);
+  }
+#endif
+}
+
+std::shared_ptr<const RomImage> RomImage::Open(const std::string &path) {
+#if QNES_HAS_MMAP
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < HEADER_SIZE) {
+    close(fd);
+    return nullptr;
+  }
+  const std::string key = std::to_string(file_stat.st_dev) + ":" +
+                          std::to_string(file_stat.st_ino);
+#else
+  std::error_code error;
+  const std::string key = std::filesystem::canonical(path, error).string();
+  if (error) {
+    return nullptr;
+  }
+#endif
+
+  const std::lock_guard lock(open_images_mutex);
+  std::erase_if(open_images,
+                [](const auto &entry) { return entry.second.expired(); });
+  if (auto image = open_images[key].lock()) {
+#if QNES_HAS_MMAP
+    close(fd);
+#endif
+    return image;
+  }
+
+  std::shared_ptr<RomImage> image(new RomImage());
+#if QNES_HAS_MMAP
+  image->size = static_cast<size_t>(file_stat.st_size);
+  void *mapping = mmap(nullptr, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  image->data = static_cast<const u8 *>(mapping);
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  image->size = static_cast<size_t>(file.tellg());
+  image->buffer = std::make_unique<u8[]>(image->size);
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char *>(image->buffer.get()),
+                 static_cast<std::streamsize>(image->size))) {
+    return nullptr;
+  }
+  image->data = image->buffer.get();
+#endif
+
+  if (!image->Parse()) {
+    return nullptr;
+  }
+  open_images[key] = image;
+  return image;
+}
+
+bool RomImage::ParseHeader(std::span<const u8> data, RomHeader &header) {
+  if (data.size() < HEADER_SIZE || data[0] != 'N' || data[1] != 'E' ||
+      data[2] != 'S' || data[3] != 0x1A) {
+    return false;
+  }
+  header = {};
+  const u8 flags6 = data[6];
+  const u8 flags7 = data[7];
+  if ((flags6 & 0x08) != 0) {
+    header.mirroring = Mirroring::FOUR_SCREEN;
+  } else if ((flags6 & 0x01) != 0) {
+    header.mirroring = Mirroring::VERTICAL;
+  }
+  header.battery = (flags6 & 0x02) != 0;
+  header.trainer = (flags6 & 0x04) != 0;
+  header.mapper = flags6 >> 4;
+
+  u64 prg_rom_size = 0;
+  u64 chr_rom_size = 0;
+  if ((flags7 & 0x0C) == 0x08) {
+    header.format = RomHeader::Format::NES2;
+    header.mapper |= (flags7 & 0xF0) | ((data[8] & 0x0F) << 8);
+    header.submapper = data[8] >> 4;
+    prg_rom_size = RomSize(data[4], data[9] & 0x0F, Kilobytes(16));
+    chr_rom_size = RomSize(data[5], data[9] >> 4, Kilobytes(8));
+    header.prg_ram_size = RamSize(data[10] & 0x0F);
+    header.prg_nvram_size = RamSize(data[10] >> 4);
+    header.chr_ram_size = RamSize(data[11] & 0x0F);
+    header.chr_nvram_size = RamSize(data[11] >> 4);
+  } else {
+    // Old dumps have garbage in bytes 7-15 (e.g. "DiskDude!"), the upper
+    // mapper nibble is only trusted when the padding is zero
+    if ((flags7 & 0x0C) == 0 &&
+        std::all_of(data.begin() + 12, data.begin() + 16,
+                    [](u8 byte) { return byte == 0; })) {
+      header.mapper |= flags7 & 0xF0;
+    }
+    prg_rom_size = data[4] * Kilobytes(16);
+    chr_rom_size = data[5] * Kilobytes(8);
+    // 0 means 8 KB, boards without PRG-RAM ignore it
+    const auto prg_ram_size =
+        static_cast<u32>(std::max<u8>(data[8], 1) * Kilobytes(8));
+    if (header.battery) {
+      header.prg_nvram_size = prg_ram_size;
+    } else {
+      header.prg_ram_size = prg_ram_size;
+    }
+    if (chr_rom_size == 0) {
+      header.chr_ram_size = Kilobytes(8);
+    }
+  }
+
+  if (prg_rom_size == 0 ||
+      prg_rom_size > std::numeric_limits<u32>::max() ||
+      chr_rom_size > std::numeric_limits<u32>::max()) {
+    return false;
+  }
+  header.prg_rom_size = static_cast<u32>(prg_rom_size);
+  header.chr_rom_size = static_cast<u32>(chr_rom_size);
+  return true;
+}
+
+u64 RomImage::GetContentHash() const {
+  std::call_once(content_hash_flag, [this] {
+    u64 hash = 0xCBF29CE484222325;
+    for (const std::span<const u8> rom : {prg_rom, chr_rom}) {
+      for (const u8 byte : rom) {
+        hash = (hash ^ byte) * 0x100000001B3;
+      }
+    }
+    content_hash = hash;
+  });
+  return content_hash;
+}
+
+bool RomImage::Parse() {
+  if (!ParseHeader(GetData(), header)) {
+    return false;
+  }
+  size_t offset = HEADER_SIZE + (header.trainer ? TRAINER_SIZE : 0);
+  // Anything after CHR-ROM (PlayChoice data, title) is ignored
+  if (u64{offset} + header.prg_rom_size + header.chr_rom_size > size) {
+    return false;
+  }
+  if (header.trainer) {
+    trainer = GetData().subspan(HEADER_SIZE, TRAINER_SIZE);
+  }
+  prg_rom = GetData().subspan(offset, header.prg_rom_size);
+  offset += header.prg_rom_size;
+  chr_rom = GetData().subspan(offset, header.chr_rom_size);
+  return true;
+}
+
+}  // namespace QNes
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+// Nametable arrangement the cartridge wires up
+enum class Mirroring : u8 {
+  HORIZONTAL,
+  VERTICAL,
+  FOUR_SCREEN,
+  SINGLE_SCREEN_LOWER,  // set by mappers (MMC1), never by a header
+  SINGLE_SCREEN_UPPER,
+};
+
+// Board description from an iNES or NES 2.0 header, sizes in bytes
+struct RomHeader {
+  enum class Format : u8 {
+    INES,
+    NES2,
+  };
+
+  Format format = Format::INES;
+  u16 mapper = 0;
+  u8 submapper = 0;
+  Mirroring mirroring = Mirroring::HORIZONTAL;
+  bool battery = false;  // the NVRAM sizes are kept by a battery
+  bool trainer = false;  // 512 bytes for $7000-$71FF before PRG-ROM
+  u32 prg_rom_size = 0;
+  u32 chr_rom_size = 0;  // 0 when the board has CHR-RAM
+  u32 prg_ram_size = 0;
+  u32 prg_nvram_size = 0;
+  u32 chr_ram_size = 0;
+  u32 chr_nvram_size = 0;
+};
+
+/**
+ * @brief iNES / NES 2.0 ROM file mapped read-only into memory
+ * @details The file is mmap'ed and never copied: the trainer, PRG-ROM and
+ * CHR-ROM are spans into the mapping, the bus maps PRG-ROM banks straight from
+ * it. The image is immutable, any number of emulators (on any threads) use the
+ * same one. Opening a file that is already open in the process returns the
+ * image that is already mapped, the mapping lives until the last emulator
+ * using it drops it. Emulators in other processes share the pages through the
+ * page cache of the OS.
+ *
+ * Platforms without mmap read the file into memory instead.
+ */
+class RomImage {
+ public:
+  static constexpr size_t HEADER_SIZE = 16;
+  static constexpr size_t TRAINER_SIZE = 512;
+
+  RomImage(const RomImage &) = delete;
+  RomImage &operator=(const RomImage &) = delete;
+  RomImage(RomImage &&) = delete;
+  RomImage &operator=(RomImage &&) = delete;
+  ~RomImage();
+
+  // nullptr when the file cannot be read or is not a complete iNES/NES 2.0
+  // image
+  [[nodiscard]] static std::shared_ptr<const RomImage> Open(
+      const std::string &path);
+  // False when data does not start with an iNES/NES 2.0 header. Only the
+  // header is checked, not that the file holds the sizes it declares.
+  [[nodiscard]] static bool ParseHeader(std::span<const u8> data,
+                                        RomHeader &header);
+
+  [[nodiscard]] const RomHeader &GetHeader() const { return header; }
+  [[nodiscard]] std::span<const u8> GetTrainer() const { return trainer; }
+  [[nodiscard]] std::span<const u8> GetPRGROM() const { return prg_rom; }
+  [[nodiscard]] std::span<const u8> GetCHRROM() const { return chr_rom; }
+  // The whole file
+  [[nodiscard]] std::span<const u8> GetData() const { return {data, size}; }
+  // 64 bit FNV-1a of PRG-ROM and CHR-ROM, tells the images of different games
+  // apart (savestates of another game are refused with it). Computed on the
+  // first call, once per image.
+  [[nodiscard]] u64 GetContentHash() const;
+
+ private:
+  RomImage() = default;
+
+  // Splits the file into its parts, false when it is too short
+  bool Parse();
+
+  const u8 *data = nullptr;
+  size_t size = 0;
+  // Heap copy where there is no mmap, data points into it
+  std::unique_ptr<u8[]> buffer;
+
+  RomHeader header{};
+  std::span<const u8> trainer;
+  std::span<const u8> prg_rom;
+  std::span<const u8> chr_rom;
+
+  mutable std::once_flag content_hash_flag;
+  mutable u64 content_hash = 0;
+};
+
+using RomImagePtr = std::shared_ptr<const RomImage>;
+
+}  // namespace QNes
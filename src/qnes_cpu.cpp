@@ -1,23 +1,170 @@
 #include "qnes_cpu.hpp"
 
+#include <algorithm>
+
 #include "cpu_isa.hpp"
 #include "qnes_bus.hpp"
+#include "qnes_decode_cache.hpp"
+#include "qnes_idle_loop.hpp"
+#include "qnes_jit.hpp"
+#include "qnes_profiler.hpp"
 
 namespace QNes {
 
-void CPU::WriteStackValue(u8 value) {
-  bus->SetAddress(0x01, state.sp);
-  bus->Write(value);
+namespace {
+
+// Compares the architectural state as the program sees it
+bool IsSameState(const CPUCore::State &a, const CPUCore::State &b) {
+  return a.pc == b.pc && a.sp == b.sp && a.a == b.a && a.x == b.x &&
+         a.y == b.y && a.status.status == b.status.status;
+}
+
+}  // namespace
+
+template <typename BUS>
+BasicCPU<BUS>::BasicCPU(BUS *bus) : bus(bus) {
+  if constexpr (HasInternalRAM<BUS>) {
+    internal_ram = bus->GetInternalRAM();
+  }
+}
+
+template <typename BUS>
+BasicCPU<BUS>::~BasicCPU() = default;
+
+template <typename BUS>
+void BasicCPU<BUS>::EnableDecodeCache() {
+  if (decode_cache == nullptr) {
+    decode_cache = std::make_unique<DecodeCache<BasicCPU>>();
+  }
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::DisableDecodeCache() {
+  decode_cache.reset();
+  decoded = nullptr;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::SetJitConfig(const JitConfig &config) {
+  jit_config = config;
+#if QNES_HAS_JIT
+  jit.reset();
+#endif
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::EnableIdleLoopSkip() {
+  if (idle_loop_detector == nullptr) {
+    idle_loop_detector = std::make_unique<IdleLoopDetector>();
+  }
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::DisableIdleLoopSkip() {
+  idle_loop_detector.reset();
+}
+
+template <typename BUS>
+u64 BasicCPU<BUS>::GetSkippedIdleCycles() const {
+  return idle_loop_detector != nullptr ? idle_loop_detector->GetSkippedCycles()
+                                       : 0;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::EnableProfiler() {
+  if (profiler == nullptr) {
+    profiler = std::make_unique<Profiler>();
+  }
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::DisableProfiler() {
+  profiler.reset();
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::InvalidateCode() {
+  if (decode_cache != nullptr) {
+    decode_cache->Invalidate();
+    // the rest of the instruction in flight comes from the bus
+    decoded = nullptr;
+  }
+  if (idle_loop_detector != nullptr) {
+    idle_loop_detector->Invalidate();
+  }
+#if QNES_HAS_JIT
+  if (jit != nullptr) {
+    jit->Invalidate();
+  }
+#endif
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::InvalidateCode(u16 first, u16 last) {
+  if (decode_cache != nullptr) {
+    decode_cache->Invalidate(first, last);
+  }
+  if (idle_loop_detector != nullptr) {
+    idle_loop_detector->Invalidate();
+  }
+#if QNES_HAS_JIT
+  if (jit != nullptr) {
+    jit->Invalidate(first, last);
+  }
+#endif
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::FetchOpcode() {
+  // Counted before the access, as in Step
+  ++cycle_count;
+  if (decode_cache != nullptr) {
+    decoded = decode_cache->Fetch(bus, state.pc);
+  }
+  if (decoded != nullptr) {
+    ir = decoded->opcode;
+  } else {
+    ir = bus->Read(state.pc);
+  }
+  ++state.pc;
+  instruction_cycle = 1;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::InvalidateDecodedWrite(u16 address) {
+  if (decode_cache != nullptr) {
+    decode_cache->InvalidateWrite(address);
+    // the write may have changed a byte of the instruction in flight (e.g. JSR
+    // pushing over its own operand), take the rest of it from the bus
+    decoded = nullptr;
+  }
+#if QNES_HAS_JIT
+  if (jit != nullptr) {
+    jit->InvalidateWrite(address);
+  }
+#endif
 }
 
-u8 CPU::ReadStackValue() {
-  bus->SetAddress(0x01, state.sp);
-  return bus->Read();
+template <typename BUS>
+void BasicCPU<BUS>::WriteStackValue(u8 value) {
+  WriteLowPage(CombineToU16(0x01, state.sp), value);
+  InvalidateDecodedWrite(CombineToU16(0x01, state.sp));
 }
 
-void CPU::Reset() { glabal_mode = GlobalMode::RESET; }
+template <typename BUS>
+u8 BasicCPU<BUS>::ReadStackValue() {
+  return ReadLowPage(CombineToU16(0x01, state.sp));
+}
 
-void CPU::Step() {
+template <typename BUS>
+void BasicCPU<BUS>::Step() {
+  if (IsHalted()) [[unlikely]] {
+    AlignHalt();
+    --halt_cycles;
+    ++cycle_count;
+    return;
+  }
+  ++cycle_count;
   switch (glabal_mode) {
     case GlobalMode::RESET: {
       HandleReset();
@@ -50,25 +197,210 @@ void CPU::Step() {
         }
 
         // No interrupt, fetch next opcode
-        bus->SetAddress(U16High(state.pc), U16Low(state.pc));
-        ir = bus->Read();
+        ir = bus->Read(state.pc);
+        if (profiler != nullptr) {
+          profiler->BeginInstruction(state.pc, ir, cycle_count - 1);
+        }
         ++state.pc;
         ++instruction_cycle;
       } else {
         // Execute instruction
-        Instructions[ir](*this);
+        InstructionTables<BasicCPU>::cycle[ir](*this);
+        if (profiler != nullptr && instruction_cycle == 0) {
+          profiler->EndInstruction(cycle_count);
+        }
       }
     } break;
   }
 }
 
-void CPU::HandleReset() {
-  thread_local u8 pc_adl = 0;
-  thread_local u8 pc_adh = 0;
+template <typename BUS>
+u16 BasicCPU<BUS>::StepInstruction() {
+  return profiler == nullptr ? ExecuteInstruction<false>()
+                             : ExecuteInstruction<true>();
+}
+
+template <typename BUS>
+template <bool PROFILE>
+u16 BasicCPU<BUS>::ExecuteInstruction() {
+  if (IsHalted()) {
+    AlignHalt();
+    const u16 halted = halt_cycles;
+    cycle_count += halted;
+    halt_cycles = 0;
+    return halted;
+  }
+
+  u8 cycles = 0;
+  if (glabal_mode != GlobalMode::RUN || instruction_cycle != 0) {
+    // Reset/interrupt sequence or instruction in flight - finish it with the
+    // cycle stepped path
+    do {
+      Step();
+      ++cycles;
+    } while (glabal_mode != GlobalMode::RUN || instruction_cycle != 0);
+    return cycles;
+  }
+
+  if (nmi_pending || (irq_pending && !state.status.interrupt_disable)) {
+    // Interrupt is taken instead of fetching the next opcode, let Step() enter
+    // the interrupt sequence and run it to completion
+    do {
+      Step();
+      ++cycles;
+    } while (glabal_mode != GlobalMode::RUN);
+    return cycles;
+  }
+
+  const u16 pc = state.pc;
+  FetchOpcode();
+
+  ASSERT(InstructionTables<BasicCPU>::fast[ir] != nullptr, "Invalid opcode");
+  // Execute the rest of the instruction
+  const auto handler = decoded != nullptr
+                           ? decoded->handler
+                           : InstructionTables<BasicCPU>::fast[ir];
+  const auto cycles_executed = static_cast<u8>(1 + handler(*this));
+  decoded = nullptr;
+  if constexpr (PROFILE) {
+    profiler->Record(pc, ir, cycles_executed);
+  }
+  return cycles_executed;
+}
+
+template <typename BUS>
+u64 BasicCPU<BUS>::RunUntil(u64 target_cycle) {
+  // Longest instruction/interrupt sequence
+  constexpr u64 MAX_INSTRUCTION_CYCLES = 7;
+
+  const u64 start_cycle = cycle_count;
+  exit_requested = false;
+  idle_loop_watch = idle_loop_detector != nullptr;
+
+  while (!exit_requested &&
+         cycle_count + MAX_INSTRUCTION_CYCLES <= target_cycle) {
+    if (IsHalted()) {
+      // Nothing runs while halted, skip up to the target at most
+      AlignHalt();
+      const auto halted = static_cast<u16>(
+          std::min<u64>(halt_cycles, target_cycle - cycle_count));
+      halt_cycles -= halted;
+      cycle_count += halted;
+      continue;
+    }
+    RunInstructions(target_cycle - MAX_INSTRUCTION_CYCLES);
+    if (idle_loop_reported) {
+      idle_loop_reported = false;
+      exit_requested = false;
+      SkipIdleLoop(target_cycle - MAX_INSTRUCTION_CYCLES);
+    }
+  }
+  idle_loop_watch = false;
+  while (!exit_requested && cycle_count < target_cycle) {
+    Step();
+  }
+
+  return cycle_count - start_cycle;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::RunInstructions(u64 last_start_cycle) {
+  if (profiler != nullptr) {
+    // Threaded and JIT code do not report single instructions
+    ExecuteInstruction<true>();
+    return;
+  }
+#if QNES_HAS_JIT
+  if (dispatch == Dispatch::JIT && ReadyToFetchOpcode()) {
+    if (jit == nullptr) {
+      jit = std::make_unique<Jit<BasicCPU>>(jit_config);
+    }
+    // Same contract as RunThreaded
+    jit->Run(*this, last_start_cycle);
+    return;
+  }
+#endif
+#if QNES_HAS_COMPUTED_GOTO
+  if (dispatch != Dispatch::TABLE && ReadyToFetchOpcode()) {
+    // Returns at the budget, on an exit request or when an interrupt has to
+    // be taken, the latter is handled by StepInstruction
+    ISA::RunThreaded(*this, last_start_cycle);
+    return;
+  }
+#endif
+  ExecuteInstruction<false>();
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::ReportLoop(u16 head, u16 end) {
+  if (end - head > IdleLoopDetector::MAX_LOOP_BYTES || exit_requested ||
+      idle_loop_detector->IsRejected(head)) {
+    return;
+  }
+  // Leave the interpreter loop after this instruction, RunUntil takes over
+  idle_loop_head = head;
+  idle_loop_end = end;
+  idle_loop_reported = true;
+  exit_requested = true;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::SkipIdleLoop(u64 last_start_cycle) {
+  if (state.pc != idle_loop_head || !ReadyToFetchOpcode()) {
+    return;
+  }
+  if (!idle_loop_detector->IsCandidate(bus, idle_loop_head, idle_loop_end)) {
+    idle_loop_detector->Reject(idle_loop_head);
+    return;
+  }
+
+  // The iterations run here close the loop again, do not report them
+  idle_loop_watch = false;
+  // The first iteration leaves every read in its settled state, after that the
+  // loop is idle if an iteration does not change the state
+  if (RunIdleLoopIteration(last_start_cycle)) {
+    const State settled = GetState();
+    const u64 iteration_start = cycle_count;
+    if (RunIdleLoopIteration(last_start_cycle)) {
+      if (!IsSameState(settled, GetState())) {
+        // The loop itself changes the state (e.g. a counter)
+        idle_loop_detector->Reject(idle_loop_head);
+      } else if (cycle_count <= last_start_cycle) {
+        const u64 length = cycle_count - iteration_start;
+        const u64 skipped =
+            (last_start_cycle - cycle_count) / length * length;
+        cycle_count += skipped;
+        idle_loop_detector->AddSkippedCycles(skipped);
+      }
+    }
+  }
+  idle_loop_watch = true;
+}
+
+template <typename BUS>
+bool BasicCPU<BUS>::RunIdleLoopIteration(u64 last_start_cycle) {
+  for (u16 i = 0; i < IdleLoopDetector::MAX_LOOP_BYTES; ++i) {
+    if (exit_requested || cycle_count > last_start_cycle ||
+        !ReadyToFetchOpcode()) {
+      return false;
+    }
+    StepInstruction();
+    if (state.pc == idle_loop_head) {
+      return true;
+    }
+    if (state.pc < idle_loop_head || state.pc >= idle_loop_end) {
+      return false;
+    }
+  }
+  return false;
+}
+
+template <typename BUS>
+void BasicCPU<BUS>::HandleReset() {
   switch (interrupt_cycle) {
     case 0: {
       // clear internal state
-      state.status.status = 0;
+      SetStatus({});
       state.pc = 0;
       instruction_cycle = 0;
       ir = 0;
@@ -87,19 +419,17 @@ void CPU::HandleReset() {
     } break;
     case 2: {
       // fetch low byte of reset vector
-      bus->SetAddress(0xFF, 0xFC);
-      pc_adl = bus->Read();
+      adl = bus->Read(0xFFFC);
       ++interrupt_cycle;
     } break;
     case 3: {
       // fetch high byte of reset vector
-      bus->SetAddress(0xFF, 0xFD);
-      pc_adh = bus->Read();
+      adh = bus->Read(0xFFFD);
       ++interrupt_cycle;
     } break;
     case 4: {
       // set PC
-      state.pc = CombineToU16(pc_adh, pc_adl);
+      state.pc = CombineToU16(adh, adl);
       glabal_mode = GlobalMode::RUN;
       interrupt_cycle = 0;
     } break;
@@ -108,12 +438,14 @@ void CPU::HandleReset() {
   }
 }
 
-void CPU::HandleNMI() {
+template <typename BUS>
+void BasicCPU<BUS>::HandleNMI() {
   switch (interrupt_cycle) {
     case 0: {
       // Dummy read
-      bus->SetAddress(U16High(state.pc), U16Low(state.pc));
-      (void)bus->Read();  // Dummy read for cycle accuracy
+      if (!SkipsDummyRead(state.pc)) {
+        (void)bus->Read(state.pc);  // Dummy read for cycle accuracy
+      }
       ++interrupt_cycle;
     } break;
     case 1: {
@@ -130,7 +462,7 @@ void CPU::HandleNMI() {
       // Push status to stack - set unused flag, but NOT break flag
       state.status.break_command = 0;
       state.status.unused = 1;
-      PushStack(state.status.status);
+      PushStack(GetStatus().status);
       ++interrupt_cycle;
     } break;
     case 4: {
@@ -139,15 +471,13 @@ void CPU::HandleNMI() {
     } break;
     case 5: {
       // Fetch low byte of NMI vector from 0xFFFA
-      bus->SetAddress(0xFF, 0xFA);
-      u8 low_byte = bus->Read();
+      u8 low_byte = bus->Read(0xFFFA);
       state.pc = CombineToU16(U16High(state.pc), low_byte);
       ++interrupt_cycle;
     } break;
     case 6: {
       // Fetch high byte of NMI vector from 0xFFFB
-      bus->SetAddress(0xFF, 0xFB);
-      u8 high_byte = bus->Read();
+      u8 high_byte = bus->Read(0xFFFB);
       state.pc = CombineToU16(high_byte, U16Low(state.pc));
       interrupt_cycle = 0;
       glabal_mode = GlobalMode::RUN;
@@ -157,12 +487,14 @@ void CPU::HandleNMI() {
   }
 }
 
-void CPU::HandleIRQ() {
+template <typename BUS>
+void BasicCPU<BUS>::HandleIRQ() {
   switch (interrupt_cycle) {
     case 0: {
       // Dummy read
-      bus->SetAddress(U16High(state.pc), U16Low(state.pc));
-      (void)bus->Read();  // Dummy read for cycle accuracy
+      if (!SkipsDummyRead(state.pc)) {
+        (void)bus->Read(state.pc);  // Dummy read for cycle accuracy
+      }
       ++interrupt_cycle;
     } break;
     case 1: {
@@ -179,7 +511,7 @@ void CPU::HandleIRQ() {
       // Push status to stack - set unused flag, but NOT break flag
       state.status.unused = 1;
       state.status.break_command = 0;
-      PushStack(state.status.status);
+      PushStack(GetStatus().status);
       ++interrupt_cycle;
     } break;
     case 4: {
@@ -188,15 +520,13 @@ void CPU::HandleIRQ() {
     } break;
     case 5: {
       // Fetch low byte of IRQ vector from 0xFFFE
-      bus->SetAddress(0xFF, 0xFE);
-      u8 low_byte = bus->Read();
+      u8 low_byte = bus->Read(0xFFFE);
       state.pc = CombineToU16(U16High(state.pc), low_byte);
       ++interrupt_cycle;
     } break;
     case 6: {
       // Fetch high byte of IRQ vector from 0xFFFF
-      bus->SetAddress(0xFF, 0xFF);
-      u8 high_byte = bus->Read();
+      u8 high_byte = bus->Read(0xFFFF);
       state.pc = CombineToU16(high_byte, U16Low(state.pc));
       glabal_mode = GlobalMode::RUN;
       interrupt_cycle = 0;
@@ -206,9 +536,8 @@ void CPU::HandleIRQ() {
   }
 }
 
-u8 CPU_Testing::ReadStackValue(CPU &cpu, u8 sp) {
-  cpu.bus->SetAddress(0x01, sp);
-  return cpu.bus->Read();
-}
+#define QNES_INSTANTIATE_CPU(BUS) template class BasicCPU<BUS>;
+QNES_CPU_BUS_TYPES(QNES_INSTANTIATE_CPU)
+#undef QNES_INSTANTIATE_CPU
 
 }  // namespace QNes
\ No newline at end of file
@@ -1,20 +1,46 @@
 #pragma once
 
+#include <concepts>
+#include <memory>
+
 #include "qnes_c.hpp"
 
 namespace QNes {
 
 struct ISA_detail;
+template <typename CPU_T>
+struct DecodedInstruction;
+template <typename CPU_T>
+class DecodeCache;
+template <typename CPU_T>
+class Jit;
+class IdleLoopDetector;
+class Profiler;
 class Bus;
+class RAMBus;
+class NESBus;
+class BatchLaneBus;
+class CPUBatch;
+
+// Bus types the CPU core is compiled for. Every entry gets its own
+// BasicCPU<BUS> and its own instruction tables (see qnes_cpu.cpp and
+// cpu_isa.cpp), a new bus type has to be added here before it can be used.
+#define QNES_CPU_BUS_TYPES(X) X(Bus) X(RAMBus) X(NESBus) X(BatchLaneBus)
 
-class CPU {
+/**
+ * @brief Bus independent part of the CPU
+ * @details Holds the architectural and internal state of the 6502 together
+ * with the parts of the interface that never touch the bus. The bus dependent
+ * part lives in BasicCPU.
+ */
+class CPUCore {
  public:
-  CPU(Bus *bus) : bus(bus) {};
-  CPU(const CPU &) = delete;
-  CPU &operator=(const CPU &) = delete;
-  CPU(CPU &&) = delete;
-  CPU &operator=(CPU &&) = delete;
-  ~CPU() = default;
+  CPUCore() = default;
+  CPUCore(const CPUCore &) = delete;
+  CPUCore &operator=(const CPUCore &) = delete;
+  CPUCore(CPUCore &&) = delete;
+  CPUCore &operator=(CPUCore &&) = delete;
+  ~CPUCore() = default;
 
   enum class GlobalMode : u8 {
     RESET = 0,
@@ -46,28 +72,312 @@ class CPU {
     StatusFlags status{};  // Status Register
   };
 
-  [[nodiscard]] State GetState() const { return state; }
+  // Interpreter loop RunUntil uses for whole instructions
+  enum class Dispatch : u8 {
+    TABLE,     // central loop calling through InstructionTables::fast
+    THREADED,  // every handler jumps straight to the next one (computed goto)
+    JIT,       // hot code is translated to native code (see qnes_jit.hpp)
+  };
 
-  void Reset();
-  void Step();
+  // How closely the bus traffic follows the hardware. Dummy reads (the reads
+  // a 6502 performs while it computes an address, or of the byte after a one
+  // byte opcode) only matter when the read has side effects.
+  enum class Accuracy : u8 {
+    EXACT,  // every dummy read reaches the bus
+    FAST,   // dummy reads of addresses without read side effects are skipped
+  };
 
-  void SignalNMI() { nmi_pending = true; }
-  void SignalIRQ() { irq_pending = true; }
+  struct JitConfig {
+    u32 hot_threshold = 8;  // executions of a block start before it is compiled
+    bool perf_map = false;  // describe generated code in /tmp/perf-<pid>.map
+  };
 
- private:
+  // Everything of the CPU that changes while it runs, without pointers, so
+  // snapshots can be copied around with memcpy (see Emulator::SaveState).
+  // Taken and restored between RunUntil calls, an instruction may be in
+  // flight.
+  struct Snapshot {
+    GlobalMode global_mode;
+    State state;  // with the folded status
+    u8 interrupt_cycle;
+    u8 ir;
+    u8 adl, adh;
+    u8 op_latch;
+    bool page_crossed;
+    u8 instruction_cycle;
+    bool nmi_pending;
+    bool irq_pending;
+    u16 halt_cycles;
+    bool halt_align;
+    u64 cycle_count;
+  };
+
+  [[nodiscard]] State GetState() const {
+    State result = state;
+    result.status = GetStatus();
+    return result;
+  }
+
+  void Reset() { glabal_mode = GlobalMode::RESET; }
+
+  // THREADED falls back to TABLE when the compiler has no computed goto, JIT
+  // falls back to THREADED when the target has no code generator
+  void SetDispatch(Dispatch mode) { dispatch = mode; }
+  [[nodiscard]] Dispatch GetDispatch() const { return dispatch; }
+
+  // Registers, cycle counts and memory are the same in both tiers, only the
+  // reads the bus sees differ (see Bus::HasReadSideEffects)
+  void SetAccuracy(Accuracy level) { accuracy = level; }
+  [[nodiscard]] Accuracy GetAccuracy() const { return accuracy; }
+
+  void SaveSnapshot(Snapshot &snapshot) const {
+    snapshot = {.global_mode = glabal_mode,
+                .state = GetState(),
+                .interrupt_cycle = interrupt_cycle,
+                .ir = ir,
+                .adl = adl,
+                .adh = adh,
+                .op_latch = op_latch,
+                .page_crossed = page_crossed,
+                .instruction_cycle = instruction_cycle,
+                .nmi_pending = nmi_pending,
+                .irq_pending = irq_pending,
+                .halt_cycles = halt_cycles,
+                .halt_align = halt_align,
+                .cycle_count = cycle_count};
+  }
+  // Code the CPU keeps decoded or translated is not part of the snapshot, the
+  // memory it came from has to be reported with BasicCPU::InvalidateCode
+  void LoadSnapshot(const Snapshot &snapshot) {
+    glabal_mode = snapshot.global_mode;
+    state = snapshot.state;
+    SetStatus(snapshot.state.status);
+    interrupt_cycle = snapshot.interrupt_cycle;
+    ir = snapshot.ir;
+    adl = snapshot.adl;
+    adh = snapshot.adh;
+    op_latch = snapshot.op_latch;
+    page_crossed = snapshot.page_crossed;
+    instruction_cycle = snapshot.instruction_cycle;
+    nmi_pending = snapshot.nmi_pending;
+    irq_pending = snapshot.irq_pending;
+    halt_cycles = snapshot.halt_cycles;
+    halt_align = snapshot.halt_align;
+    cycle_count = snapshot.cycle_count;
+  }
+
+  // Total number of cycles executed since construction
+  [[nodiscard]] u64 GetCycleCount() const { return cycle_count; }
+
+  // Makes a running RunUntil return early
+  void RequestExit() { exit_requested = true; }
+
+  void SignalNMI() {
+    nmi_pending = true;
+    exit_requested = true;
+  }
+  void SignalIRQ() {
+    irq_pending = true;
+    exit_requested = true;
+  }
+  // The device released the IRQ line before the CPU took the interrupt
+  // (mapper IRQ acknowledge)
+  void ClearIRQ() { irq_pending = false; }
+
+  // Stops the CPU for cycles cycles after the instruction in flight (OAM
+  // DMA). With align the halt takes one more cycle when it starts on an odd
+  // cycle. The halted cycles count as executed, interrupts are taken after the
+  // halt.
+  void Halt(u16 cycles, bool align) {
+    halt_cycles = cycles;
+    halt_align = align;
+  }
+
+ protected:
   GlobalMode glabal_mode = GlobalMode::RESET;
   State state{};
 
+  // C, Z, V and N are not kept in state.status while instructions execute,
+  // they are stored in a form that is cheap to produce and only folded into
+  // the status byte when it is read (GetStatus). The other bits of
+  // state.status are always up to date.
+  struct LazyFlags {
+    u8 carry = 0;            // C, 0 or 1
+    u8 zero_result = 1;      // Z is set when this is 0
+    u8 negative_result = 0;  // N is bit 7
+    u8 overflow_result = 0;  // V is bit 7
+  };
+  LazyFlags flags{};
+
+  // Status byte with C, Z, V and N taken from lazy
+  [[nodiscard]] static StatusFlags FoldFlags(StatusFlags status,
+                                             const LazyFlags &lazy) {
+    status.carry = lazy.carry;
+    status.zero = lazy.zero_result == 0;
+    status.overflow = lazy.overflow_result >> 7;
+    status.negative = lazy.negative_result >> 7;
+    return status;
+  }
+  [[nodiscard]] static LazyFlags UnfoldFlags(StatusFlags status) {
+    return {.carry = status.carry,
+            .zero_result = static_cast<u8>(status.zero ? 0 : 1),
+            .negative_result = static_cast<u8>(status.negative << 7),
+            .overflow_result = static_cast<u8>(status.overflow << 7)};
+  }
+
+  [[nodiscard]] StatusFlags GetStatus() const {
+    return FoldFlags(state.status, flags);
+  }
+  void SetStatus(StatusFlags status) {
+    state.status = status;
+    flags = UnfoldFlags(status);
+  }
+
+  u8 interrupt_cycle = 0;
+
+  void IncrementSP() { state.sp = static_cast<u8>((state.sp + 1) & 0xFF); }
+  void DecrementSP() { state.sp = static_cast<u8>((state.sp - 1) & 0xFF); }
+
+  // True when the next cycle fetches an opcode, i.e. no instruction is in
+  // flight and no interrupt has to be taken first
+  [[nodiscard]] bool ReadyToFetchOpcode() const {
+    return glabal_mode == GlobalMode::RUN && instruction_cycle == 0 &&
+           halt_cycles == 0 && !nmi_pending &&
+           !(irq_pending && !state.status.interrupt_disable);
+  }
+
+  // True when the next cycle is a halted one (see Halt)
+  [[nodiscard]] bool IsHalted() const {
+    return halt_cycles != 0 && instruction_cycle == 0;
+  }
+  // Called when the halt starts, cycle_count is its first cycle
+  void AlignHalt() {
+    if (halt_align) {
+      halt_cycles += cycle_count & 1;
+      halt_align = false;
+    }
+  }
+
+  u8 ir = 0;  // Instruction Register (Opcode)
+  // Latches of the instruction in flight, the bus only sees the addresses
+  // formed from them
+  u8 adl = 0, adh = 0;  // Address Latch Low/High
+  u8 op_latch = 0;      // Operand Latch
+  bool page_crossed = false;
+  u8 instruction_cycle = 0;
+
+  bool nmi_pending = false;
+  bool irq_pending = false;
+  bool exit_requested = false;
+
+  // Cycles left of a halt (see Halt)
+  u16 halt_cycles = 0;
+  bool halt_align = false;
+
+  u64 cycle_count = 0;
+
+  Dispatch dispatch = Dispatch::THREADED;
+  Accuracy accuracy = Accuracy::EXACT;
+
+  // Set while RunUntil executes whole instructions with idle loop skipping
+  // enabled, taken backward branches report the loop they close
+  bool idle_loop_watch = false;
+  // A loop was reported, exit_requested was set only to get back to RunUntil
+  bool idle_loop_reported = false;
+  u16 idle_loop_head = 0;
+  u16 idle_loop_end = 0;  // address after the branch closing the loop
+
+  friend struct ISA;
+  friend struct ISA_detail;
+  friend struct CPU_Testing;
+  template <typename CPU_T>
+  friend class Jit;
+  friend class CPUBatch;
+};
+
+// Buses whose $0000-$01FF is always plain internal RAM, the zero page and the
+// stack. GetInternalRAM returns it, at least 512 bytes indexed by the address.
+template <typename BUS>
+concept HasInternalRAM = requires(BUS &bus) {
+  { bus.GetInternalRAM() } -> std::same_as<u8 *>;
+};
+
+/**
+ * @brief 6502 CPU
+ * @details The CPU is parameterized on the concrete type of the bus it is
+ * connected to, so the bus accesses of the instruction handlers are direct
+ * (and usually inlined) calls instead of virtual ones. BasicCPU<Bus> goes
+ * through the virtual Bus interface and works with any bus implementation.
+ */
+template <typename BUS>
+class BasicCPU : public CPUCore {
+ public:
+  BasicCPU(BUS *bus);
+  BasicCPU(const BasicCPU &) = delete;
+  BasicCPU &operator=(const BasicCPU &) = delete;
+  BasicCPU(BasicCPU &&) = delete;
+  BasicCPU &operator=(BasicCPU &&) = delete;
+  ~BasicCPU();
+
+  void Step();
+  // Executes a whole instruction (or a whole reset/interrupt sequence or the
+  // rest of a halt) in a single call and returns the number of cycles it took.
+  // If called while an instruction is in flight, only the remaining cycles of
+  // that instruction are executed.
+  u16 StepInstruction();
+
+  // Runs the CPU until the cycle counter reaches target_cycle or until an exit
+  // is requested (RequestExit, SignalNMI, SignalIRQ), whichever comes first.
+  // Whole instructions are executed while at least a full instruction fits in
+  // the remaining budget, the last few cycles are stepped one by one so the
+  // target is hit exactly. Returns the number of cycles executed.
+  u64 RunUntil(u64 target_cycle);
+  u64 RunCycles(u64 budget) { return RunUntil(cycle_count + budget); }
+
+  // Whole instruction execution (StepInstruction/RunUntil) takes opcodes and
+  // operands of the code the bus reports as cacheable from a decoded
+  // instruction cache instead of fetching them through the bus.
+  void EnableDecodeCache();
+  void DisableDecodeCache();
+  [[nodiscard]] bool IsDecodeCacheEnabled() const {
+    return decode_cache != nullptr;
+  }
+
+  // Takes effect on the next RunUntil, drops the code translated so far
+  void SetJitConfig(const JitConfig &config);
+
+  // The decode cache and the JIT keep copies of code. CPU writes keep them
+  // coherent, memory changed behind the CPU's back (bank switches, DMA, host
+  // writes) has to be reported here.
+  void InvalidateCode();
+  void InvalidateCode(u16 first, u16 last);
+
+  // RunUntil fast-forwards short loops that only read memory and spin until
+  // something outside the CPU changes it (see qnes_idle_loop.hpp). The skipped
+  // iterations are counted as executed cycles, the state stays the same as if
+  // they had run.
+  void EnableIdleLoopSkip();
+  void DisableIdleLoopSkip();
+  [[nodiscard]] bool IsIdleLoopSkipEnabled() const {
+    return idle_loop_detector != nullptr;
+  }
+  // Cycles fast-forwarded since EnableIdleLoopSkip
+  [[nodiscard]] u64 GetSkippedIdleCycles() const;
+
+  // Records the executed guest code (see qnes_profiler.hpp). While disabled
+  // the CPU runs exactly the code it runs without a profiler.
+  void EnableProfiler();
+  void DisableProfiler();
+  // nullptr while disabled
+  [[nodiscard]] Profiler *GetProfiler() const { return profiler.get(); }
+
+ private:
   void HandleReset();
   void HandleNMI();
   void HandleIRQ();
 
-  u8 interrupt_cycle = 0;
-
   void WriteStackValue(u8 value);
   u8 ReadStackValue();
-  void IncrementSP() { state.sp = static_cast<u8>((state.sp + 1) & 0xFF); }
-  void DecrementSP() { state.sp = static_cast<u8>((state.sp - 1) & 0xFF); }
   void PushStack(u8 value) {
     WriteStackValue(value);
     DecrementSP();
@@ -77,59 +387,137 @@ class CPU {
     return ReadStackValue();
   }
 
-  u8 ir = 0;  // Instruction Register (Opcode)
-  bool page_crossed = false;
-  u8 instruction_cycle = 0;
+  // Zero page and stack accesses ($0000-$01FF), these skip the bus when it
+  // guarantees internal RAM there
+  [[nodiscard]] u8 ReadLowPage(u16 address) {
+    if constexpr (HasInternalRAM<BUS>) {
+      return internal_ram[address];
+    } else {
+      return bus->Read(address);
+    }
+  }
+  void WriteLowPage(u16 address, u8 value) {
+    if constexpr (HasInternalRAM<BUS>) {
+      internal_ram[address] = value;
+    } else {
+      bus->Write(address, value);
+    }
+  }
 
-  bool nmi_pending = false;
-  bool irq_pending = false;
+  [[nodiscard]] bool SkipsDummyRead(u16 address) const {
+    return accuracy == Accuracy::FAST && !bus->HasReadSideEffects(address);
+  }
+
+  // StepInstruction, PROFILE reports the instruction to the profiler
+  template <bool PROFILE>
+  u16 ExecuteInstruction();
+
+  // Fetches the opcode at PC, through the decode cache when enabled
+  void FetchOpcode();
+  void InvalidateDecodedWrite(u16 address);
+
+  // Runs whole instructions with the selected Dispatch until an instruction
+  // would start after last_start_cycle, an exit is requested or an interrupt
+  // has to be taken (RunThreaded returns at all three)
+  void RunInstructions(u64 last_start_cycle);
 
-  Bus *bus = nullptr;
+  // Taken branch from end back to head, called while idle_loop_watch is set
+  void ReportLoop(u16 head, u16 end);
+  // Checks the reported loop and skips its iterations up to last_start_cycle
+  void SkipIdleLoop(u64 last_start_cycle);
+  // Runs the reported loop from its head back to its head, false when it left
+  // the loop or ran into the budget, an exit request or an interrupt
+  bool RunIdleLoopIteration(u64 last_start_cycle);
+
+  BUS *bus = nullptr;
+  // $0000-$01FF of the bus, only set when HasInternalRAM<BUS>
+  u8 *internal_ram = nullptr;
+
+  std::unique_ptr<DecodeCache<BasicCPU>> decode_cache;
+  // Instruction being executed from the decode cache, nullptr otherwise
+  const DecodedInstruction<BasicCPU> *decoded = nullptr;
+
+  JitConfig jit_config{};
+#if QNES_HAS_JIT
+  // Created on the first RunUntil with Dispatch::JIT
+  std::unique_ptr<Jit<BasicCPU>> jit;
+#endif
+
+  std::unique_ptr<IdleLoopDetector> idle_loop_detector;
+
+  std::unique_ptr<Profiler> profiler;
 
   friend struct ISA;
   friend struct ISA_detail;
   friend struct CPU_Testing;
+  template <typename CPU_T>
+  friend class Jit;
+  friend class CPUBatch;
 };
 
+// CPU connected through the virtual Bus interface
+using CPU = BasicCPU<Bus>;
 using CPUPtr = std::unique_ptr<CPU>;
 
 struct CPU_Testing {
-  static CPU::GlobalMode GetGlobalMode(const CPU &cpu) {
+  static CPUCore::GlobalMode GetGlobalMode(const CPUCore &cpu) {
     return cpu.glabal_mode;
   }
-  static void SetGlobalMode(CPU &cpu, CPU::GlobalMode mode) {
+  static void SetGlobalMode(CPUCore &cpu, CPUCore::GlobalMode mode) {
     cpu.glabal_mode = mode;
   }
-  static void ExecuteReset(CPU &cpu) {
+  template <typename BUS>
+  static void ExecuteReset(BasicCPU<BUS> &cpu) {
     cpu.Reset();
     for (int i = 0; i < 5; ++i) {
       cpu.Step();
     }
   }
 
-  static void ZeroInterruptCycle(CPU &cpu) { cpu.interrupt_cycle = 0; }
-  static void SetPC(CPU &cpu, u16 pc) { cpu.state.pc = pc; }
-  static void SetCarry(CPU &cpu, bool carry) { cpu.state.status.carry = carry; }
-  static bool GetCarry(const CPU &cpu) { return cpu.state.status.carry; }
-  static void SetA(CPU &cpu, u8 a) { cpu.state.a = a; }
-  static void SetX(CPU &cpu, u8 x) { cpu.state.x = x; }
-  static void SetY(CPU &cpu, u8 y) { cpu.state.y = y; }
-  static void SetStatus(CPU &cpu, CPU::StatusFlags status) {
-    cpu.state.status = status;
-  }
-  static void SetSP(CPU &cpu, u8 sp) { cpu.state.sp = sp; }
-  static void IncrementSP(CPU &cpu) { cpu.IncrementSP(); }
-  static void DecrementSP(CPU &cpu) { cpu.DecrementSP(); }
-  static void SetInstructionCycle(CPU &cpu, u8 cycle) {
+  static void ZeroInterruptCycle(CPUCore &cpu) { cpu.interrupt_cycle = 0; }
+  static void SetPC(CPUCore &cpu, u16 pc) { cpu.state.pc = pc; }
+  static void SetCarry(CPUCore &cpu, bool carry) { cpu.flags.carry = carry; }
+  static bool GetCarry(const CPUCore &cpu) { return cpu.flags.carry != 0; }
+  static void SetA(CPUCore &cpu, u8 a) { cpu.state.a = a; }
+  static void SetX(CPUCore &cpu, u8 x) { cpu.state.x = x; }
+  static void SetY(CPUCore &cpu, u8 y) { cpu.state.y = y; }
+  static void SetStatus(CPUCore &cpu, CPUCore::StatusFlags status) {
+    cpu.SetStatus(status);
+  }
+  static void SetSP(CPUCore &cpu, u8 sp) { cpu.state.sp = sp; }
+  static void IncrementSP(CPUCore &cpu) { cpu.IncrementSP(); }
+  static void DecrementSP(CPUCore &cpu) { cpu.DecrementSP(); }
+  static void SetInstructionCycle(CPUCore &cpu, u8 cycle) {
     cpu.instruction_cycle = cycle;
   }
-  static u8 GetInstructionCycle(const CPU &cpu) {
+  static u8 GetInstructionCycle(const CPUCore &cpu) {
     return cpu.instruction_cycle;
   }
 
-  static void PushStack(CPU &cpu, u8 value) { cpu.PushStack(value); }
-  static u8 PopStack(CPU &cpu) { return cpu.PopStack(); }
-  static u8 ReadStackValue(CPU &cpu, u8 sp);
+  template <typename BUS>
+  static void PushStack(BasicCPU<BUS> &cpu, u8 value) {
+    cpu.PushStack(value);
+  }
+  template <typename BUS>
+  static u8 PopStack(BasicCPU<BUS> &cpu) {
+    return cpu.PopStack();
+  }
+  template <typename BUS>
+  static u8 ReadStackValue(BasicCPU<BUS> &cpu, u8 sp) {
+    return cpu.bus->Read(static_cast<u16>(0x0100 | sp));
+  }
+
+#if QNES_HAS_JIT
+  // Need qnes_jit.hpp
+  template <typename BUS>
+  static size_t GetJitBlockCount(const BasicCPU<BUS> &cpu) {
+    return cpu.jit != nullptr ? cpu.jit->GetValidBlockCount() : 0;
+  }
+  template <typename BUS>
+  static bool IsRunningJitBlock(const BasicCPU<BUS> &cpu) {
+    return cpu.jit != nullptr && cpu.jit->IsRunningBlock();
+  }
+#endif
 };
 
 }  // namespace QNes
@@ -0,0 +1,549 @@
+#include "qnes_cpu_batch.hpp"
+
+#include <algorithm>
+
+#include "cpu_isa.hpp"
+#include "qnes_bits.hpp"
+
+namespace QNes {
+
+namespace {
+
+// Instructions the batch executes on all lanes at once
+enum class LockstepOp : u8 {
+  NONE,
+  LDA,
+  LDX,
+  LDY,
+  STA,
+  STX,
+  STY,
+  AND,
+  ORA,
+  EOR,
+  ADC,
+  SBC,
+  CMP,
+  CPX,
+  CPY,
+  BIT,
+  TAX,
+  TAY,
+  TXA,
+  TYA,
+  TSX,
+  TXS,
+  INX,
+  INY,
+  DEX,
+  DEY,
+  CLC,
+  SEC,
+  CLV,
+  CLD,
+  SED,
+  NOP,
+  BCC,
+  BCS,
+  BEQ,
+  BMI,
+  BNE,
+  BPL,
+  BVC,
+  BVS,
+  JMP,
+};
+
+// Modes whose effective address is the same on every lane
+constexpr bool IsLockstepMode(AddressingMode mode) {
+  switch (mode) {
+    case AddressingMode::Implied:
+    case AddressingMode::Immediate:
+    case AddressingMode::ZeroPage:
+    case AddressingMode::Absolute:
+    case AddressingMode::Relative:
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename CPU_T, typename INSTRUCTION>
+struct LockstepDispatch {
+  static constexpr LockstepOp Execute = LockstepOp::NONE;
+};
+
+#define QNES_LOCKSTEP_INSTRUCTION(NAME)                       \
+  template <typename CPU_T, AddressingMode MODE>              \
+  struct LockstepDispatch<CPU_T, ISA::NAME<MODE>> {           \
+    static constexpr LockstepOp Execute =                     \
+        IsLockstepMode(MODE) ? LockstepOp::NAME : LockstepOp::NONE; \
+  };
+QNES_LOCKSTEP_INSTRUCTION(LDA)
+QNES_LOCKSTEP_INSTRUCTION(LDX)
+QNES_LOCKSTEP_INSTRUCTION(LDY)
+QNES_LOCKSTEP_INSTRUCTION(STA)
+QNES_LOCKSTEP_INSTRUCTION(STX)
+QNES_LOCKSTEP_INSTRUCTION(STY)
+QNES_LOCKSTEP_INSTRUCTION(AND)
+QNES_LOCKSTEP_INSTRUCTION(ORA)
+QNES_LOCKSTEP_INSTRUCTION(EOR)
+QNES_LOCKSTEP_INSTRUCTION(ADC)
+QNES_LOCKSTEP_INSTRUCTION(SBC)
+QNES_LOCKSTEP_INSTRUCTION(CMP)
+QNES_LOCKSTEP_INSTRUCTION(CPX)
+QNES_LOCKSTEP_INSTRUCTION(CPY)
+QNES_LOCKSTEP_INSTRUCTION(BIT)
+QNES_LOCKSTEP_INSTRUCTION(TAX)
+QNES_LOCKSTEP_INSTRUCTION(TAY)
+QNES_LOCKSTEP_INSTRUCTION(TXA)
+QNES_LOCKSTEP_INSTRUCTION(TYA)
+QNES_LOCKSTEP_INSTRUCTION(TSX)
+QNES_LOCKSTEP_INSTRUCTION(TXS)
+QNES_LOCKSTEP_INSTRUCTION(INX)
+QNES_LOCKSTEP_INSTRUCTION(INY)
+QNES_LOCKSTEP_INSTRUCTION(DEX)
+QNES_LOCKSTEP_INSTRUCTION(DEY)
+QNES_LOCKSTEP_INSTRUCTION(CLC)
+QNES_LOCKSTEP_INSTRUCTION(SEC)
+QNES_LOCKSTEP_INSTRUCTION(CLV)
+QNES_LOCKSTEP_INSTRUCTION(CLD)
+QNES_LOCKSTEP_INSTRUCTION(SED)
+QNES_LOCKSTEP_INSTRUCTION(NOP)
+QNES_LOCKSTEP_INSTRUCTION(BCC)
+QNES_LOCKSTEP_INSTRUCTION(BCS)
+QNES_LOCKSTEP_INSTRUCTION(BEQ)
+QNES_LOCKSTEP_INSTRUCTION(BMI)
+QNES_LOCKSTEP_INSTRUCTION(BNE)
+QNES_LOCKSTEP_INSTRUCTION(BPL)
+QNES_LOCKSTEP_INSTRUCTION(BVC)
+QNES_LOCKSTEP_INSTRUCTION(BVS)
+QNES_LOCKSTEP_INSTRUCTION(JMP)
+#undef QNES_LOCKSTEP_INSTRUCTION
+
+constexpr auto LockstepOpTable =
+    MakeInstructionTable<LockstepOp, void, LockstepDispatch>();
+
+constexpr u8 DECIMAL_FLAG = 0x08;
+
+}  // namespace
+
+CPUBatch::CPUBatch(u32 lane_count)
+    : lane_count(lane_count),
+      memory(std::make_unique<u8[]>(Kilobytes(64) * lane_count)),
+      pc(lane_count),
+      sp(lane_count),
+      a(lane_count),
+      x(lane_count),
+      y(lane_count),
+      status(lane_count),
+      carry(lane_count),
+      zero_result(lane_count),
+      negative_result(lane_count),
+      overflow_result(lane_count),
+      cycles(lane_count),
+      active(lane_count),
+      operand(lane_count),
+      scalar_bus(memory.get(), lane_count),
+      scalar_cpu(std::make_unique<BasicCPU<BatchLaneBus>>(&scalar_bus)) {
+  ASSERT(lane_count > 0, "Batch needs at least one lane");
+  for (u32 lane = 0; lane < lane_count; ++lane) {
+    SetState(lane, CPUCore::State{});
+  }
+  // Lanes start on an opcode fetch, there is no reset sequence
+  scalar_cpu->glabal_mode = CPUCore::GlobalMode::RUN;
+}
+
+CPUBatch::~CPUBatch() = default;
+
+void CPUBatch::Load(u16 offset, std::span<const u8> data) {
+  ASSERT(offset + data.size() <= Kilobytes(64), "Data exceeds lane memory");
+  for (size_t i = 0; i < data.size(); ++i) {
+    std::fill_n(Row(static_cast<u16>(offset + i)), lane_count, data[i]);
+  }
+}
+
+CPUCore::State CPUBatch::GetState(u32 lane) const {
+  CPUCore::StatusFlags other{};
+  other.status = status[lane];
+  return {.pc = pc[lane],
+          .sp = sp[lane],
+          .a = a[lane],
+          .x = x[lane],
+          .y = y[lane],
+          .status = CPUCore::FoldFlags(
+              other, {.carry = carry[lane],
+                      .zero_result = zero_result[lane],
+                      .negative_result = negative_result[lane],
+                      .overflow_result = overflow_result[lane]})};
+}
+
+void CPUBatch::SetState(u32 lane, const CPUCore::State &state) {
+  pc[lane] = state.pc;
+  sp[lane] = state.sp;
+  a[lane] = state.a;
+  x[lane] = state.x;
+  y[lane] = state.y;
+  status[lane] = state.status.status;
+  const CPUCore::LazyFlags flags = CPUCore::UnfoldFlags(state.status);
+  carry[lane] = flags.carry;
+  zero_result[lane] = flags.zero_result;
+  negative_result[lane] = flags.negative_result;
+  overflow_result[lane] = flags.overflow_result;
+}
+
+void CPUBatch::RunUntil(u64 target_cycle) {
+  while (Step(target_cycle)) {
+  }
+}
+
+bool CPUBatch::Step(u64 target_cycle) {
+  // The lane furthest behind leads, lanes that went ahead on another path wait
+  // for it, which lets lanes that diverged on a branch meet again
+  u32 leader = lane_count;
+  u64 leader_cycles = target_cycle;
+  for (u32 lane = 0; lane < lane_count; ++lane) {
+    if (cycles[lane] < leader_cycles) {
+      leader = lane;
+      leader_cycles = cycles[lane];
+    }
+  }
+  if (leader == lane_count) {
+    return false;
+  }
+
+  const u16 at = pc[leader];
+  u32 active_count = 0;
+  for (u32 lane = 0; lane < lane_count; ++lane) {
+    active[lane] = cycles[lane] < target_cycle && pc[lane] == at;
+    active_count += active[lane];
+  }
+
+  const u8 opcode = Read(leader, at);
+  if (active_count > 1 && LockstepOpTable[opcode] != LockstepOp::NONE &&
+      IsSameCode(at, InstructionInfoTable[opcode].length)) {
+    ExecuteLockstep(opcode, at);
+    ++stats.lockstep_steps;
+    stats.lockstep_instructions += active_count;
+    return true;
+  }
+
+  for (u32 lane = 0; lane < lane_count; ++lane) {
+    if (active[lane]) {
+      ExecuteScalar(lane);
+    }
+  }
+  stats.scalar_instructions += active_count;
+  return true;
+}
+
+bool CPUBatch::IsSameCode(u16 at, u8 length) const {
+  const auto first =
+      std::find(active.begin(), active.end(), 1) - active.begin();
+  for (u8 i = 0; i < length; ++i) {
+    const u8 *row = Row(static_cast<u16>(at + i));
+    u8 mismatch = 0;
+    for (u32 lane = 0; lane < lane_count; ++lane) {
+      mismatch |= active[lane] & static_cast<u8>(row[lane] != row[first]);
+    }
+    if (mismatch != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CPUBatch::ExecuteLockstep(u8 opcode, u16 at) {
+  const LockstepOp op = LockstepOpTable[opcode];
+  const InstructionInfo info = InstructionInfoTable[opcode];
+  const u32 n = lane_count;
+  const u8 *on = active.data();
+
+  // The operand bytes are the same on every active lane, take them from any
+  const u32 first = static_cast<u32>(
+      std::find(active.begin(), active.end(), 1) - active.begin());
+  u16 argument = 0;
+  for (u8 i = 1; i < info.length; ++i) {
+    argument |= static_cast<u16>(Read(first, static_cast<u16>(at + i))
+                                 << (8 * (i - 1)));
+  }
+  const auto next_pc = static_cast<u16>(at + info.length);
+
+  // Memory row of zero page and absolute operands, operand[] gets the value
+  // every lane reads
+  u8 *row = nullptr;
+  if (info.mode == AddressingMode::ZeroPage ||
+      info.mode == AddressingMode::Absolute) {
+    row = Row(argument);
+    std::copy_n(row, n, operand.data());
+  } else if (info.mode == AddressingMode::Immediate) {
+    std::fill_n(operand.data(), n, static_cast<u8>(argument));
+  }
+  const u8 *m = operand.data();
+
+  const auto select = [](u8 on, auto value, auto old) {
+    return on != 0 ? static_cast<decltype(old)>(value) : old;
+  };
+  const auto set_zn = [&](const std::vector<u8> &result) {
+    for (u32 i = 0; i < n; ++i) {
+      zero_result[i] = select(on[i], result[i], zero_result[i]);
+      negative_result[i] = select(on[i], result[i], negative_result[i]);
+    }
+  };
+  const auto load = [&](std::vector<u8> &reg, const u8 *value) {
+    for (u32 i = 0; i < n; ++i) {
+      reg[i] = select(on[i], value[i], reg[i]);
+    }
+    set_zn(reg);
+  };
+  const auto store = [&](const std::vector<u8> &reg) {
+    for (u32 i = 0; i < n; ++i) {
+      row[i] = select(on[i], reg[i], row[i]);
+    }
+  };
+  const auto add = [&](bool subtract) {
+    for (u32 i = 0; i < n; ++i) {
+      // SBC is ADC of the inverted operand (see ISA_detail::ExecuteOperation)
+      const auto value = static_cast<u8>(subtract ? ~m[i] : m[i]);
+      const auto result = static_cast<u16>(a[i] + value + carry[i]);
+      const auto overflow =
+          static_cast<u8>(~(a[i] ^ value) & (a[i] ^ result));
+      carry[i] = select(on[i], result >> 8, carry[i]);
+      overflow_result[i] = select(on[i], overflow, overflow_result[i]);
+      a[i] = select(on[i], result, a[i]);
+    }
+    set_zn(a);
+  };
+  const auto compare = [&](const std::vector<u8> &reg) {
+    for (u32 i = 0; i < n; ++i) {
+      const auto result = static_cast<u8>(reg[i] - m[i]);
+      carry[i] = select(on[i], reg[i] >= m[i] ? 1 : 0, carry[i]);
+      zero_result[i] = select(on[i], result, zero_result[i]);
+      negative_result[i] = select(on[i], result, negative_result[i]);
+    }
+  };
+  const auto increment = [&](std::vector<u8> &reg, u8 delta) {
+    for (u32 i = 0; i < n; ++i) {
+      reg[i] = select(on[i], reg[i] + delta, reg[i]);
+    }
+    set_zn(reg);
+  };
+  const auto fill = [&](std::vector<u8> &flag, u8 value) {
+    for (u32 i = 0; i < n; ++i) {
+      flag[i] = select(on[i], value, flag[i]);
+    }
+  };
+  // Taken when flag & mask equals expected
+  const auto branch = [&](const std::vector<u8> &flag, u8 mask, u8 expected) {
+    const auto target =
+        static_cast<u16>(next_pc + static_cast<i8>(U16Low(argument)));
+    const u8 taken_cycles =
+        U16High(target) != U16High(next_pc) ? 2 : 1;  // taken, page crossed
+    for (u32 i = 0; i < n; ++i) {
+      const bool taken = (flag[i] & mask) == expected;
+      pc[i] = select(on[i], taken ? target : next_pc, pc[i]);
+      cycles[i] += on[i] != 0 ? info.cycles + (taken ? taken_cycles : 0) : 0;
+    }
+  };
+
+  bool is_branch = false;
+  switch (op) {
+    case LockstepOp::LDA:
+      load(a, m);
+      break;
+    case LockstepOp::LDX:
+      load(x, m);
+      break;
+    case LockstepOp::LDY:
+      load(y, m);
+      break;
+    case LockstepOp::STA:
+      store(a);
+      break;
+    case LockstepOp::STX:
+      store(x);
+      break;
+    case LockstepOp::STY:
+      store(y);
+      break;
+    case LockstepOp::AND:
+      for (u32 i = 0; i < n; ++i) {
+        a[i] = select(on[i], a[i] & m[i], a[i]);
+      }
+      set_zn(a);
+      break;
+    case LockstepOp::ORA:
+      for (u32 i = 0; i < n; ++i) {
+        a[i] = select(on[i], a[i] | m[i], a[i]);
+      }
+      set_zn(a);
+      break;
+    case LockstepOp::EOR:
+      for (u32 i = 0; i < n; ++i) {
+        a[i] = select(on[i], a[i] ^ m[i], a[i]);
+      }
+      set_zn(a);
+      break;
+    case LockstepOp::ADC:
+      add(false);
+      break;
+    case LockstepOp::SBC:
+      add(true);
+      break;
+    case LockstepOp::CMP:
+      compare(a);
+      break;
+    case LockstepOp::CPX:
+      compare(x);
+      break;
+    case LockstepOp::CPY:
+      compare(y);
+      break;
+    case LockstepOp::BIT:
+      for (u32 i = 0; i < n; ++i) {
+        zero_result[i] = select(on[i], a[i] & m[i], zero_result[i]);
+        negative_result[i] = select(on[i], m[i], negative_result[i]);
+        overflow_result[i] = select(on[i], m[i] << 1, overflow_result[i]);
+      }
+      break;
+    case LockstepOp::TAX:
+      load(x, a.data());
+      break;
+    case LockstepOp::TAY:
+      load(y, a.data());
+      break;
+    case LockstepOp::TXA:
+      load(a, x.data());
+      break;
+    case LockstepOp::TYA:
+      load(a, y.data());
+      break;
+    case LockstepOp::TSX:
+      load(x, sp.data());
+      break;
+    case LockstepOp::TXS:
+      for (u32 i = 0; i < n; ++i) {
+        sp[i] = select(on[i], x[i], sp[i]);
+      }
+      break;
+    case LockstepOp::INX:
+      increment(x, 1);
+      break;
+    case LockstepOp::INY:
+      increment(y, 1);
+      break;
+    case LockstepOp::DEX:
+      increment(x, 0xFF);
+      break;
+    case LockstepOp::DEY:
+      increment(y, 0xFF);
+      break;
+    case LockstepOp::CLC:
+      fill(carry, 0);
+      break;
+    case LockstepOp::SEC:
+      fill(carry, 1);
+      break;
+    case LockstepOp::CLV:
+      fill(overflow_result, 0);
+      break;
+    case LockstepOp::CLD:
+      for (u32 i = 0; i < n; ++i) {
+        status[i] = select(on[i], status[i] & ~DECIMAL_FLAG, status[i]);
+      }
+      break;
+    case LockstepOp::SED:
+      for (u32 i = 0; i < n; ++i) {
+        status[i] = select(on[i], status[i] | DECIMAL_FLAG, status[i]);
+      }
+      break;
+    case LockstepOp::NOP:
+      break;
+    case LockstepOp::BCC:
+      branch(carry, 0x01, 0x00);
+      is_branch = true;
+      break;
+    case LockstepOp::BCS:
+      branch(carry, 0x01, 0x01);
+      is_branch = true;
+      break;
+    case LockstepOp::BEQ:
+      for (u32 i = 0; i < n; ++i) {
+        operand[i] = zero_result[i] == 0 ? 1 : 0;
+      }
+      branch(operand, 0x01, 0x01);
+      is_branch = true;
+      break;
+    case LockstepOp::BNE:
+      for (u32 i = 0; i < n; ++i) {
+        operand[i] = zero_result[i] == 0 ? 1 : 0;
+      }
+      branch(operand, 0x01, 0x00);
+      is_branch = true;
+      break;
+    case LockstepOp::BMI:
+      branch(negative_result, 0x80, 0x80);
+      is_branch = true;
+      break;
+    case LockstepOp::BPL:
+      branch(negative_result, 0x80, 0x00);
+      is_branch = true;
+      break;
+    case LockstepOp::BVS:
+      branch(overflow_result, 0x80, 0x80);
+      is_branch = true;
+      break;
+    case LockstepOp::BVC:
+      branch(overflow_result, 0x80, 0x00);
+      is_branch = true;
+      break;
+    case LockstepOp::JMP:
+      for (u32 i = 0; i < n; ++i) {
+        pc[i] = select(on[i], argument, pc[i]);
+        cycles[i] += on[i] != 0 ? info.cycles : 0;
+      }
+      return;
+    case LockstepOp::NONE:
+      ASSERT(false, "Instruction has no lockstep implementation");
+      return;
+  }
+
+  if (!is_branch) {
+    for (u32 i = 0; i < n; ++i) {
+      pc[i] = select(on[i], next_pc, pc[i]);
+      cycles[i] += on[i] != 0 ? info.cycles : 0;
+    }
+  }
+}
+
+void CPUBatch::ExecuteScalar(u32 lane) {
+  auto &cpu = *scalar_cpu;
+  scalar_bus.SetLane(lane);
+  cpu.state.pc = pc[lane];
+  cpu.state.sp = sp[lane];
+  cpu.state.a = a[lane];
+  cpu.state.x = x[lane];
+  cpu.state.y = y[lane];
+  cpu.state.status.status = status[lane];
+  cpu.flags = {.carry = carry[lane],
+               .zero_result = zero_result[lane],
+               .negative_result = negative_result[lane],
+               .overflow_result = overflow_result[lane]};
+  cpu.cycle_count = cycles[lane];
+
+  cpu.StepInstruction();
+
+  pc[lane] = cpu.state.pc;
+  sp[lane] = cpu.state.sp;
+  a[lane] = cpu.state.a;
+  x[lane] = cpu.state.x;
+  y[lane] = cpu.state.y;
+  status[lane] = cpu.state.status.status;
+  carry[lane] = cpu.flags.carry;
+  zero_result[lane] = cpu.flags.zero_result;
+  negative_result[lane] = cpu.flags.negative_result;
+  overflow_result[lane] = cpu.flags.overflow_result;
+  cycles[lane] = cpu.cycle_count;
+}
+
+}  // namespace QNes
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+
+namespace QNes {
+
+/**
+ * @brief Lockstep batch of independent 6502 instances
+ * @details Every lane is a CPU with its own 64KB of RAM (no NES devices, no
+ * interrupts), the registers of all lanes are kept in structure-of-arrays
+ * form. Each step picks the lane that is furthest behind and executes the
+ * instruction at its PC on every lane that has the same PC:
+ *  - loads, stores, ALU operations, register transfers, flag operations,
+ *    branches and JMP with immediate, zero page or absolute operands run as
+ *    loops over all lanes, which the compiler turns into SIMD code (build with
+ *    QNES_NATIVE_ARCH to get AVX2/AVX-512),
+ *  - everything else, and lanes whose PC diverged, runs one lane at a time on
+ *    a scalar BasicCPU<BatchLaneBus>, so the ISA semantics stay those of
+ *    cpu_isa.cpp.
+ * Only whole instructions are executed.
+ */
+class CPUBatch {
+ public:
+  explicit CPUBatch(u32 lane_count);
+  CPUBatch(const CPUBatch &) = delete;
+  CPUBatch &operator=(const CPUBatch &) = delete;
+  CPUBatch(CPUBatch &&) = delete;
+  CPUBatch &operator=(CPUBatch &&) = delete;
+  ~CPUBatch();
+
+  [[nodiscard]] u32 GetLaneCount() const { return lane_count; }
+
+  [[nodiscard]] u8 Read(u32 lane, u16 address) const {
+    return memory[Index(lane, address)];
+  }
+  void Write(u32 lane, u16 address, u8 value) {
+    memory[Index(lane, address)] = value;
+  }
+  // Copies data to offset in the memory of every lane
+  void Load(u16 offset, std::span<const u8> data);
+
+  [[nodiscard]] CPUCore::State GetState(u32 lane) const;
+  void SetState(u32 lane, const CPUCore::State &state);
+  [[nodiscard]] u64 GetCycleCount(u32 lane) const { return cycles[lane]; }
+
+  // Runs every lane until its cycle counter reaches target_cycle, the last
+  // instruction of a lane may end past it
+  void RunUntil(u64 target_cycle);
+
+  struct Stats {
+    u64 lockstep_steps = 0;         // instructions run on all lanes at once
+    u64 lockstep_instructions = 0;  // lane instructions of those steps
+    u64 scalar_instructions = 0;    // lane instructions run one by one
+  };
+  [[nodiscard]] const Stats &GetStats() const { return stats; }
+
+ private:
+  [[nodiscard]] size_t Index(u32 lane, u16 address) const {
+    return static_cast<size_t>(address) * lane_count + lane;
+  }
+  [[nodiscard]] const u8 *Row(u16 address) const {
+    return memory.get() + static_cast<size_t>(address) * lane_count;
+  }
+  u8 *Row(u16 address) {
+    return memory.get() + static_cast<size_t>(address) * lane_count;
+  }
+
+  // Executes one instruction on the lanes behind the furthest, false when
+  // every lane reached target_cycle
+  bool Step(u64 target_cycle);
+  // True when the instruction bytes at pc are the same on every active lane
+  [[nodiscard]] bool IsSameCode(u16 pc, u8 length) const;
+  void ExecuteLockstep(u8 opcode, u16 pc);
+  void ExecuteScalar(u32 lane);
+
+  u32 lane_count = 0;
+  std::unique_ptr<u8[]> memory;
+
+  // Registers, the flags in the lazy form of CPUCore::LazyFlags
+  std::vector<u16> pc;
+  std::vector<u8> sp, a, x, y;
+  std::vector<u8> status;  // I, D, B and the unused bit
+  std::vector<u8> carry, zero_result, negative_result, overflow_result;
+  std::vector<u64> cycles;
+
+  // 1 for the lanes taking part in the current step
+  std::vector<u8> active;
+  // Operand of the current step on every lane
+  std::vector<u8> operand;
+
+  BatchLaneBus scalar_bus;
+  std::unique_ptr<BasicCPU<BatchLaneBus>> scalar_cpu;
+
+  Stats stats;
+};
+
+using CPUBatchPtr = std::unique_ptr<CPUBatch>;
+
+}  // namespace QNes
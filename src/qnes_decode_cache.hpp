@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <memory>
+
+#include "cpu_isa.hpp"
+#include "qnes_bits.hpp"
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+// Pre-decoded instruction, everything that the opcode and operand fetches
+// would read from the bus
+template <typename CPU_T>
+struct DecodedInstruction {
+  ISA::InstructionFastFunc<CPU_T> handler = nullptr;
+  u16 pc = 0;  // address of the opcode
+  u8 opcode = 0;
+  u8 operands[2] = {};
+  u8 length = 0;
+  u8 cycles = 0;
+  bool valid = false;
+};
+
+/**
+ * @brief Decoded instruction cache of a CPU
+ * @details Direct mapped cache of DecodedInstruction entries keyed by the PC of
+ * the opcode. Only code the bus reports as cacheable (plain RAM/ROM without
+ * read side effects or mirroring, see Bus::IsDecodeCacheable) is decoded.
+ * Every CPU write invalidates the entries whose bytes it touches, writes that
+ * do not come from the CPU and mapper bank switches have to be reported with
+ * Invalidate().
+ */
+template <typename CPU_T>
+class DecodeCache {
+ public:
+  static constexpr u32 ENTRY_COUNT = 8192;
+
+  DecodeCache() = default;
+  DecodeCache(const DecodeCache &) = delete;
+  DecodeCache &operator=(const DecodeCache &) = delete;
+  DecodeCache(DecodeCache &&) = delete;
+  DecodeCache &operator=(DecodeCache &&) = delete;
+  ~DecodeCache() = default;
+
+  // Returns the decoded instruction at pc or nullptr when the instruction can
+  // not be cached, in which case it has to be fetched through the bus
+  template <typename BUS>
+  const DecodedInstruction<CPU_T> *Fetch(BUS *bus, u16 pc) {
+    auto &entry = entries[Index(pc)];
+    if (entry.valid && entry.pc == pc) {
+      return &entry;
+    }
+    return Decode(bus, pc, entry);
+  }
+
+  // Call after the byte at address changed
+  void InvalidateWrite(u16 address) {
+    if (!code_pages[U16High(address)]) {
+      return;
+    }
+    // the byte can be the opcode or an operand of an instruction starting up
+    // to two bytes before it
+    for (u16 offset = 0; offset < 3; ++offset) {
+      const auto pc = static_cast<u16>(address - offset);
+      auto &entry = entries[Index(pc)];
+      if (entry.valid && entry.pc == pc && offset < entry.length) {
+        entry.valid = false;
+      }
+    }
+  }
+
+  // Invalidates every instruction with a byte in [first, last]
+  void Invalidate(u16 first, u16 last) {
+    for (auto &entry : entries) {
+      const u16 entry_last = entry.pc + entry.length - 1;
+      if (entry.valid && entry_last >= first && entry.pc <= last) {
+        entry.valid = false;
+      }
+    }
+  }
+
+  void Invalidate() {
+    for (auto &entry : entries) {
+      entry.valid = false;
+    }
+    code_pages.reset();
+  }
+
+ private:
+  static u32 Index(u16 pc) { return pc & (ENTRY_COUNT - 1); }
+
+  template <typename BUS>
+  const DecodedInstruction<CPU_T> *Decode(BUS *bus, u16 pc,
+                                          DecodedInstruction<CPU_T> &entry) {
+    if (!bus->IsDecodeCacheable(pc)) {
+      return nullptr;
+    }
+    const u8 opcode = bus->Read(pc);
+    const auto handler = InstructionTables<CPU_T>::fast[opcode];
+    const auto info = InstructionInfoTable[opcode];
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    for (u8 i = 1; i < info.length; ++i) {
+      if (!bus->IsDecodeCacheable(static_cast<u16>(pc + i))) {
+        return nullptr;
+      }
+    }
+
+    entry.handler = handler;
+    entry.pc = pc;
+    entry.opcode = opcode;
+    for (u8 i = 1; i < info.length; ++i) {
+      entry.operands[i - 1] = bus->Read(static_cast<u16>(pc + i));
+      code_pages[U16High(static_cast<u16>(pc + i))] = true;
+    }
+    entry.length = info.length;
+    entry.cycles = info.cycles;
+    entry.valid = true;
+    code_pages[U16High(pc)] = true;
+    return &entry;
+  }
+
+  std::array<DecodedInstruction<CPU_T>, ENTRY_COUNT> entries{};
+  std::bitset<256> code_pages;  // pages that hold bytes of decoded entries
+};
+
+template <typename CPU_T>
+using DecodeCachePtr = std::unique_ptr<DecodeCache<CPU_T>>;
+
+}  // namespace QNes
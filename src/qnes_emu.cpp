@@ -1,9 +1,238 @@
 #include "qnes_emu.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
 namespace QNes {
 
-void Emulator::Run() {
-  // Emulator main loop would go here
+static_assert(std::is_trivially_copyable_v<Emulator::SaveState>);
+static_assert(Emulator::DELTA_PAGE_COUNT <= 64,
+              "Dirty pages do not fit into the dirty mask");
+static_assert(PagedMemory::PAGE_SIZE % Emulator::DELTA_PAGE_SIZE == 0);
+
+namespace {
+
+constexpr u32 RAM_PAGES = WorkRAM::GetSize() / Emulator::DELTA_PAGE_SIZE;
+
+u8 *GetDeltaPage(Emulator::SaveState &save_state, u32 page) {
+  if (page < RAM_PAGES) {
+    return save_state.ram.data() + page * Emulator::DELTA_PAGE_SIZE;
+  }
+  return save_state.vram.data() +
+         (page - RAM_PAGES) * Emulator::DELTA_PAGE_SIZE;
+}
+
+}  // namespace
+
+u64 Emulator::RunFrame() {
+  return RunUntil(std::numeric_limits<u64>::max(), ppu.GetFrameCount() + 1);
+}
+
+u64 Emulator::RunCycles(u64 cycles) {
+  return RunUntil(cpu.GetCycleCount() + cycles,
+                  std::numeric_limits<u64>::max());
+}
+
+u64 Emulator::RunUntil(u64 target_cycle, u64 target_frame) {
+  const u64 start_cycle = cpu.GetCycleCount();
+  while (cpu.GetCycleCount() < target_cycle &&
+         ppu.GetFrameCount() < target_frame) {
+    // The CPU cycle after which the PPU has passed its next event
+    const u64 sync_cycle =
+        ppu.GetCPUCycleCountAt(ppu.GetDotCount() + ppu.GetDotsToNextEvent());
+    cpu.RunUntil(std::min(target_cycle, sync_cycle));
+    ppu.CatchUp();
+  }
+  return cpu.GetCycleCount() - start_cycle;
+}
+
+bool Emulator::InsertCartridge(RomImagePtr image) {
+  ASSERT(image != nullptr, "ROM image is not initialized");
+  const RomHeader header = image->GetHeader();
+  return InsertCartridge(std::move(image), header);
+}
+
+bool Emulator::InsertCartridge(RomImagePtr image, const RomHeader &header) {
+  CartridgePtr inserted = Cartridge::Create(std::move(image), header);
+  if (inserted == nullptr) {
+    return false;
+  }
+  // Drop what the previous cartridge mapped, $4000-$43FF holds the APU and
+  // I/O registers
+  bus.Unmap(0x4400, 0x10000 - 0x4400);
+  ppu_bus.Unmap(0x0000, 0x2000);
+  ppu_bus.SetMirroring(Mirroring::VERTICAL);
+  cartridge = std::move(inserted);
+  delta_prg_ram = nullptr;
+  delta_checkpoint = nullptr;
+  cartridge->Insert(&bus, &ppu_bus, &cpu);
+  ppu.ConnectCartridge(cartridge.get());
+  cpu.InvalidateCode();
+  cpu.Reset();
+  return true;
+}
+
+u32 Emulator::GetCartridgeRAMSize() const {
+  return cartridge != nullptr ? cartridge->GetRAMSize() : 0;
+}
+
+void Emulator::Save(SaveState &save_state,
+                    std::span<u8> cartridge_ram) const {
+  SaveMachine(save_state);
+  if (cartridge != nullptr) {
+    cartridge->SaveSnapshot(save_state.cartridge, cartridge_ram);
+  } else {
+    ASSERT(cartridge_ram.empty(), "No cartridge RAM to save");
+    save_state.cartridge = {};
+  }
+}
+
+bool Emulator::Load(const SaveState &save_state,
+                    std::span<const u8> cartridge_ram) {
+  if (cartridge == nullptr
+          ? save_state.cartridge.present || !cartridge_ram.empty()
+          : !cartridge->LoadSnapshot(save_state.cartridge, cartridge_ram)) {
+    return false;
+  }
+  LoadMachine(save_state);
+  return true;
+}
+
+void Emulator::SaveMachine(SaveState &save_state) const {
+  cpu.SaveSnapshot(save_state.cpu);
+  ppu.SaveSnapshot(save_state.ppu);
+  std::ranges::copy_n(memory.GetData(), WorkRAM::GetSize(),
+                      save_state.ram.begin());
+  std::ranges::copy_n(vram.GetData(), VideoRAM::GetSize(),
+                      save_state.vram.begin());
+}
+
+void Emulator::LoadMachine(const SaveState &save_state) {
+  cpu.LoadSnapshot(save_state.cpu);
+  ppu.LoadSnapshot(save_state.ppu);
+  memory.Initialize(save_state.ram);
+  vram.Initialize(save_state.vram);
+  // RAM changed behind the CPU's back
+  cpu.InvalidateCode();
+}
+
+void Emulator::SaveDelta(SaveState &checkpoint, Delta &delta,
+                         std::span<u8> checkpoint_cartridge_ram) {
+  cpu.SaveSnapshot(delta.cpu);
+  ppu.SaveSnapshot(delta.ppu);
+  checkpoint.cpu = delta.cpu;
+  checkpoint.ppu = delta.ppu;
+  delta.dirty_pages = 0;
+  delta.pages.clear();
+  for (u32 page = 0; page < DELTA_PAGE_COUNT; ++page) {
+    const u8 *current =
+        page < RAM_PAGES
+            ? memory.GetData() + page * DELTA_PAGE_SIZE
+            : vram.GetData() + (page - RAM_PAGES) * DELTA_PAGE_SIZE;
+    u8 *saved = GetDeltaPage(checkpoint, page);
+    if (std::equal(current, current + DELTA_PAGE_SIZE, saved)) {
+      continue;
+    }
+    std::copy_n(current, DELTA_PAGE_SIZE, saved);
+    delta.dirty_pages |= u64{1} << page;
+    std::copy_n(current, DELTA_PAGE_SIZE, delta.pages.emplace_back().begin());
+  }
+
+  delta.cartridge = {};
+  delta.cartridge_dirty_pages.clear();
+  delta.cartridge_pages.clear();
+  if (cartridge == nullptr) {
+    ASSERT(checkpoint_cartridge_ram.empty(), "No cartridge RAM to save");
+    checkpoint.cartridge = {};
+    return;
+  }
+  cartridge->SaveRegisters(delta.cartridge);
+  checkpoint.cartridge = delta.cartridge;
+  ASSERT(checkpoint_cartridge_ram.size() == cartridge->GetRAMSize(),
+         "Checkpoint RAM does not fit the cartridge");
+  const PagedMemory *prg_ram = cartridge->GetPRGRAM();
+  const bool same_checkpoint =
+      delta_prg_ram != nullptr &&
+      delta_checkpoint == checkpoint_cartridge_ram.data();
+  u32 offset = 0;
+  const auto save_pages = [&](const u8 *current, u32 size) {
+    for (u32 i = 0; i < size; i += DELTA_PAGE_SIZE, offset += DELTA_PAGE_SIZE) {
+      u8 *saved = checkpoint_cartridge_ram.data() + offset;
+      if (std::equal(current + i, current + i + DELTA_PAGE_SIZE, saved)) {
+        continue;
+      }
+      std::copy_n(current + i, DELTA_PAGE_SIZE, saved);
+      delta.cartridge_dirty_pages.push_back(offset / DELTA_PAGE_SIZE);
+      std::copy_n(current + i, DELTA_PAGE_SIZE,
+                  delta.cartridge_pages.emplace_back().begin());
+    }
+  };
+  if (prg_ram != nullptr) {
+    for (u32 page = 0; page < prg_ram->GetPageCount(); ++page) {
+      // Written pages were copied away from the previous delta's fork
+      if (same_checkpoint &&
+          prg_ram->GetPage(page) == delta_prg_ram->GetPage(page)) {
+        offset += PagedMemory::PAGE_SIZE;
+        continue;
+      }
+      save_pages(prg_ram->GetPage(page), PagedMemory::PAGE_SIZE);
+    }
+    delta_prg_ram = cartridge->SnapshotPRGRAM();
+    delta_checkpoint = checkpoint_cartridge_ram.data();
+  }
+  for (const Memory *memory :
+       {cartridge->GetCHRRAM(), cartridge->GetNametableRAM()}) {
+    if (memory != nullptr) {
+      save_pages(memory->GetData(), static_cast<u32>(memory->GetSize()));
+    }
+  }
+}
+
+void Emulator::ApplyDelta(const Delta &delta, SaveState &save_state,
+                          std::span<u8> cartridge_ram) {
+  ASSERT(static_cast<size_t>(std::popcount(delta.dirty_pages)) ==
+             delta.pages.size(),
+         "Delta pages do not match the dirty mask");
+  save_state.cpu = delta.cpu;
+  save_state.ppu = delta.ppu;
+  auto page = delta.pages.begin();
+  for (u64 dirty = delta.dirty_pages; dirty != 0; dirty &= dirty - 1) {
+    const auto index = static_cast<u32>(std::countr_zero(dirty));
+    std::ranges::copy(*page++, GetDeltaPage(save_state, index));
+  }
+
+  ASSERT(delta.cartridge_dirty_pages.size() == delta.cartridge_pages.size(),
+         "Delta cartridge pages do not match their indices");
+  save_state.cartridge = delta.cartridge;
+  for (size_t i = 0; i < delta.cartridge_pages.size(); ++i) {
+    ASSERT((delta.cartridge_dirty_pages[i] + 1) * DELTA_PAGE_SIZE <=
+               cartridge_ram.size(),
+           "Delta cartridge page is outside the cartridge RAM");
+    std::ranges::copy(delta.cartridge_pages[i],
+                      cartridge_ram.begin() +
+                          delta.cartridge_dirty_pages[i] * DELTA_PAGE_SIZE);
+  }
+}
+
+std::unique_ptr<Emulator> Emulator::Fork() {
+  auto fork = std::make_unique<Emulator>();
+  if (cartridge != nullptr) {
+    fork->cartridge = cartridge->Fork();
+    fork->cartridge->Insert(&fork->bus, &fork->ppu_bus, &fork->cpu);
+    fork->ppu.ConnectCartridge(fork->cartridge.get());
+    bus.ProtectSharedPages();
+  }
+  // Before the state, which holds where the region took effect
+  fork->SetRegion(GetRegion());
+  SaveState save_state;
+  SaveMachine(save_state);
+  fork->LoadMachine(save_state);
+  fork->cpu.SetDispatch(cpu.GetDispatch());
+  fork->cpu.SetAccuracy(cpu.GetAccuracy());
+  return fork;
 }
 
 } // namespace QNes
@@ -1,37 +1,180 @@
 #pragma once
 
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
 #include "qnes_bus.hpp"
 #include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
 #include "qnes_cpu.hpp"
+#include "qnes_mapper.hpp"
 #include "qnes_memory.hpp"
 #include "qnes_ppu.hpp"
 
 namespace QNes {
 
-class Emulator {
+/**
+ * @brief NES machine
+ * @details All components and their RAM live inside the Emulator object, so
+ * an instance is a single cache line aligned block of sizeof(Emulator) bytes
+ * (the decode cache, the JIT and the profiler of the CPU are allocated only
+ * when enabled). Instances can be packed into an array, e.g.
+ * std::make_unique<Emulator[]>(count).
+ *
+ * The members are ordered by how often they are touched while running: RAM,
+ * the bus page table, the PPU and the CPU together, VRAM last. Components only
+ * keep pointers to each other, a component is constructed after every
+ * component its constructor reads from or converts a pointer of.
+ */
+class alignas(64) Emulator {
  public:
   Emulator()
-      : memory(std::make_unique<Memory>(Kilobytes(2))),
-        vram(std::make_unique<Memory>(Kilobytes(2))),
-        ppu_bus(std::make_unique<PPUBus>(vram.get())),
-        ppu(std::make_unique<PPU>(ppu_bus.get(), nullptr)),
-        bus(std::make_unique<NESBus>(memory.get(), ppu.get())),
-        cpu(std::make_unique<CPU>(bus.get())) {};
+      : bus(&memory, &ppu),
+        ppu_bus(&vram),
+        ppu(&ppu_bus, nullptr),
+        cpu(&bus) {
+    bus.ConnectCPU(&cpu);
+    ppu.ConnectCPU(&cpu);
+  }
   Emulator(const Emulator &) = delete;
   Emulator &operator=(const Emulator &) = delete;
   Emulator(Emulator &&) = delete;
   Emulator &operator=(Emulator &&) = delete;
   ~Emulator() = default;
 
-  void Run();
+  // Master clock scheduler. The CPU runs in bursts (BasicCPU::RunUntil) up to
+  // the cycle at which the PPU reaches its next event the CPU can see (see
+  // PPU::GetDotsToNextEvent), then the PPU catches up in one burst. On NTSC
+  // the PPU runs 3 dots per CPU cycle, on PAL 3.2. Accesses to the PPU
+  // registers in between catch the PPU up first, so the CPU never sees it
+  // behind.
+  //
+  // Runs until the current frame ends (vblank starts), returns the CPU cycles
+  // it ran
+  u64 RunFrame();
+  // Runs cycles CPU cycles, returns the cycles it ran
+  u64 RunCycles(u64 cycles);
+  // CPU cycles since power-on
+  [[nodiscard]] u64 GetCycleCount() const { return cpu.GetCycleCount(); }
+  // Frames completed since power-on
+  [[nodiscard]] u64 GetFrameCount() const { return ppu.GetFrameCount(); }
+
+  // Configuration like the CPU dispatch, not part of SaveState. Takes effect
+  // from the current CPU cycle, the frames before keep their length.
+  void SetRegion(Region region) { ppu.SetRegion(region); }
+  [[nodiscard]] Region GetRegion() const { return ppu.GetRegion(); }
+
+  // Replaces the cartridge and resets the CPU. False when the mapper of the
+  // image is not supported, the machine is left as it was.
+  bool InsertCartridge(RomImagePtr image);
+  // With the header the ROM database has for the image (see RomDatabase)
+  bool InsertCartridge(RomImagePtr image, const RomHeader &header);
+
+  // Mutable state of the whole machine. Trivially copyable and without
+  // pointers, savestates can be kept in plain buffers and copied with memcpy.
+  // The cartridge is in it with its mapper registers only, the RAM of the
+  // board (PRG-RAM, CHR-RAM) is saved into a separate buffer of
+  // GetCartridgeRAMSize() bytes. The ROM image and the configuration of the
+  // CPU are not part of it.
+  struct SaveState {
+    CPUCore::Snapshot cpu;
+    PPU::Snapshot ppu;
+    std::array<u8, WorkRAM::GetSize()> ram;
+    std::array<u8, VideoRAM::GetSize()> vram;
+    Cartridge::Registers cartridge;
+  };
+
+  // Bytes of cartridge RAM next to a SaveState, 0 without a cartridge (see
+  // Cartridge::GetRAMSize)
+  [[nodiscard]] u32 GetCartridgeRAMSize() const;
+
+  void Save(SaveState &save_state, std::span<u8> cartridge_ram = {}) const;
+  // False when save_state was saved with another cartridge inserted or
+  // cartridge_ram does not fit it (see Cartridge::LoadSnapshot), the machine
+  // is left as it was
+  [[nodiscard]] bool Load(const SaveState &save_state,
+                          std::span<const u8> cartridge_ram = {});
+
+  // RAM and VRAM are split into pages of DELTA_PAGE_SIZE bytes for
+  // incremental savestates
+  static constexpr u32 DELTA_PAGE_SIZE = 64;
+  static constexpr u32 DELTA_PAGE_COUNT =
+      (WorkRAM::GetSize() + VideoRAM::GetSize()) / DELTA_PAGE_SIZE;
+  using DeltaPage = std::array<u8, DELTA_PAGE_SIZE>;
+
+  // Incremental savestate: the CPU and PPU snapshots, the mapper registers
+  // and the pages that changed since the previous checkpoint. Page i of RAM
+  // is bit i of dirty_pages, page i of VRAM follows the RAM pages. The
+  // cartridge RAM can have too many pages for a mask, its dirty pages are
+  // listed.
+  struct Delta {
+    CPUCore::Snapshot cpu;
+    PPU::Snapshot ppu;
+    Cartridge::Registers cartridge{};
+    u64 dirty_pages = 0;
+    std::vector<DeltaPage> pages;  // the dirty pages in ascending order
+    std::vector<u32> cartridge_dirty_pages;  // ascending
+    std::vector<DeltaPage> cartridge_pages;  // one per cartridge dirty page
+  };
+
+  // Saves the changes since the checkpoint into delta and moves the
+  // checkpoint to the current state, afterwards checkpoint holds the same
+  // state Save would. Pages are found dirty by comparing them with the
+  // checkpoint, so writes through the bus page table, the zero page fast path
+  // and compiled code are all caught without any cost while running. The
+  // PRG-RAM pages that were not written since the previous SaveDelta into the
+  // same checkpoint_cartridge_ram are skipped without comparing them, the
+  // buffer must not be changed in between other than by Save. Not const:
+  // PRG-RAM is shared copy-on-write with the emulator from then on.
+  void SaveDelta(SaveState &checkpoint, Delta &delta,
+                 std::span<u8> checkpoint_cartridge_ram = {});
+  // Moves save_state forward by one delta. Rewinding to a checkpoint is
+  // applying its deltas to the last full savestate before it and loading it.
+  static void ApplyDelta(const Delta &delta, SaveState &save_state,
+                         std::span<u8> cartridge_ram = {});
+
+  // New emulator in the same state, with the same CPU dispatch and accuracy,
+  // the same region and a fork of the cartridge. The ROM image and the
+  // cartridge PRG-RAM are shared with the fork copy-on-write, the internal RAM
+  // and VRAM (4 KB) are simply copied. Not const: writes of this emulator to
+  // PRG-RAM copy the pages it now shares from then on.
+  [[nodiscard]] std::unique_ptr<Emulator> Fork();
 
  private:
-  MemoryPtr memory;
-  MemoryPtr vram;
-  BusPtr ppu_bus;
-  PPUPtr ppu;
-  BusPtr bus;
-  CPUPtr cpu;
+  // Everything but the cartridge
+  void SaveMachine(SaveState &save_state) const;
+  void LoadMachine(const SaveState &save_state);
+  // Stops at the first sync point at or after target_cycle or after the
+  // frame count reached target_frame
+  u64 RunUntil(u64 target_cycle, u64 target_frame);
+
+  WorkRAM memory;
+  NESBus bus;
+  PPUBus ppu_bus;
+  PPU ppu;
+  BasicCPU<NESBus> cpu;
+  VideoRAM vram;
+  CartridgePtr cartridge;  // nullptr: nothing mapped above $4400
+  // PRG-RAM at the last SaveDelta into delta_checkpoint, pages that are still
+  // shared with it were not written since
+  PagedMemoryPtr delta_prg_ram;
+  const u8 *delta_checkpoint = nullptr;
+
+  friend struct Emulator_Testing;
+};
+
+struct Emulator_Testing {
+  static BasicCPU<NESBus> &GetCPU(Emulator &emulator) { return emulator.cpu; }
+  static WorkRAM &GetMemory(Emulator &emulator) { return emulator.memory; }
+  static NESBus &GetBus(Emulator &emulator) { return emulator.bus; }
+  static VideoRAM &GetVideoRAM(Emulator &emulator) { return emulator.vram; }
+  static PPU &GetPPU(Emulator &emulator) { return emulator.ppu; }
+  static PPUBus &GetPPUBus(Emulator &emulator) { return emulator.ppu_bus; }
+  static Cartridge *GetCartridge(Emulator &emulator) {
+    return emulator.cartridge.get();
+  }
 };
 
-}  // namespace QNes
\ No newline at end of file
+}  // namespace QNes
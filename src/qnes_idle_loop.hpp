@@ -0,0 +1,148 @@
+#pragma once
+
+#include <bitset>
+#include <memory>
+
+#include "cpu_isa.hpp"
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+constexpr bool IsIdleLoopMode(AddressingMode mode) {
+  switch (mode) {
+    case AddressingMode::Implied:
+    case AddressingMode::Immediate:
+    case AddressingMode::ZeroPage:
+    case AddressingMode::Absolute:
+    case AddressingMode::Relative:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Table policy marking the instructions an idle loop may consist of: loads,
+// compares, logic operations, register transfers and branches with a fixed
+// effective address. Nothing that writes memory or touches the stack.
+template <typename CPU_T, typename INSTRUCTION>
+struct IdleLoopDispatch {
+  static constexpr bool Execute = false;
+};
+
+#define QNES_IDLE_LOOP_INSTRUCTION(NAME)                   \
+  template <typename CPU_T, AddressingMode MODE>           \
+  struct IdleLoopDispatch<CPU_T, ISA::NAME<MODE>> {        \
+    static constexpr bool Execute = IsIdleLoopMode(MODE);  \
+  };
+QNES_IDLE_LOOP_INSTRUCTION(LDA)
+QNES_IDLE_LOOP_INSTRUCTION(LDX)
+QNES_IDLE_LOOP_INSTRUCTION(LDY)
+QNES_IDLE_LOOP_INSTRUCTION(CMP)
+QNES_IDLE_LOOP_INSTRUCTION(CPX)
+QNES_IDLE_LOOP_INSTRUCTION(CPY)
+QNES_IDLE_LOOP_INSTRUCTION(BIT)
+QNES_IDLE_LOOP_INSTRUCTION(AND)
+QNES_IDLE_LOOP_INSTRUCTION(ORA)
+QNES_IDLE_LOOP_INSTRUCTION(EOR)
+QNES_IDLE_LOOP_INSTRUCTION(TAX)
+QNES_IDLE_LOOP_INSTRUCTION(TAY)
+QNES_IDLE_LOOP_INSTRUCTION(TXA)
+QNES_IDLE_LOOP_INSTRUCTION(TYA)
+QNES_IDLE_LOOP_INSTRUCTION(CLC)
+QNES_IDLE_LOOP_INSTRUCTION(SEC)
+QNES_IDLE_LOOP_INSTRUCTION(CLV)
+QNES_IDLE_LOOP_INSTRUCTION(NOP)
+QNES_IDLE_LOOP_INSTRUCTION(BCC)
+QNES_IDLE_LOOP_INSTRUCTION(BCS)
+QNES_IDLE_LOOP_INSTRUCTION(BEQ)
+QNES_IDLE_LOOP_INSTRUCTION(BMI)
+QNES_IDLE_LOOP_INSTRUCTION(BNE)
+QNES_IDLE_LOOP_INSTRUCTION(BPL)
+QNES_IDLE_LOOP_INSTRUCTION(BVC)
+QNES_IDLE_LOOP_INSTRUCTION(BVS)
+#undef QNES_IDLE_LOOP_INSTRUCTION
+
+inline constexpr auto IdleLoopInstructionTable =
+    MakeInstructionTable<bool, void, IdleLoopDispatch>();
+
+/**
+ * @brief Finds guest loops that can be fast-forwarded
+ * @details A taken branch back to an address at most MAX_LOOP_BYTES before it
+ * closes a loop candidate. The loop qualifies when its code only holds
+ * IdleLoopInstructionTable instructions, all of its memory reads are
+ * idempotent (see Bus::IsIdempotentRead) and the branch back to the head is
+ * its last instruction. BasicCPU then runs two iterations: the first settles
+ * every read, if the second ends in the same state, every following iteration
+ * does too until something outside the CPU changes memory, so the CPU can skip
+ * them up to the next scheduled event (the RunUntil target).
+ *
+ * Loops that do not qualify are remembered by their head address so their
+ * branches do not interrupt the interpreter again, until InvalidateCode.
+ */
+class IdleLoopDetector {
+ public:
+  static constexpr u16 MAX_LOOP_BYTES = 16;
+
+  IdleLoopDetector() = default;
+  IdleLoopDetector(const IdleLoopDetector &) = delete;
+  IdleLoopDetector &operator=(const IdleLoopDetector &) = delete;
+  IdleLoopDetector(IdleLoopDetector &&) = delete;
+  IdleLoopDetector &operator=(IdleLoopDetector &&) = delete;
+  ~IdleLoopDetector() = default;
+
+  [[nodiscard]] bool IsRejected(u16 head) const { return rejected[head]; }
+  void Reject(u16 head) { rejected[head] = true; }
+  void Invalidate() { rejected.reset(); }
+
+  // Checks the code in [head, end) without executing it
+  template <typename BUS>
+  [[nodiscard]] bool IsCandidate(BUS *bus, u16 head, u16 end) const {
+    const auto read = [bus](u32 address, u8 &value) {
+      if (!bus->IsIdempotentRead(static_cast<u16>(address))) {
+        return false;
+      }
+      value = bus->Read(static_cast<u16>(address));
+      return true;
+    };
+
+    u32 pc = head;
+    AddressingMode last_mode = AddressingMode::Implied;
+    while (pc < end) {
+      u8 opcode = 0;
+      if (!read(pc, opcode) || !IdleLoopInstructionTable[opcode]) {
+        return false;
+      }
+      const InstructionInfo info = InstructionInfoTable[opcode];
+      if (pc + info.length > end) {
+        return false;
+      }
+      u16 operand = 0;
+      for (u8 i = 1; i < info.length; ++i) {
+        u8 value = 0;
+        if (!read(pc + i, value)) {
+          return false;
+        }
+        operand |= static_cast<u16>(value << (8 * (i - 1)));
+      }
+      if ((info.mode == AddressingMode::ZeroPage ||
+           info.mode == AddressingMode::Absolute) &&
+          !bus->IsIdempotentRead(operand)) {
+        return false;
+      }
+      last_mode = info.mode;
+      pc += info.length;
+    }
+    return last_mode == AddressingMode::Relative;
+  }
+
+  void AddSkippedCycles(u64 cycles) { skipped_cycles += cycles; }
+  [[nodiscard]] u64 GetSkippedCycles() const { return skipped_cycles; }
+
+ private:
+  std::bitset<0x10000> rejected;
+  u64 skipped_cycles = 0;
+};
+
+using IdleLoopDetectorPtr = std::unique_ptr<IdleLoopDetector>;
+
+}  // namespace QNes
@@ -0,0 +1,650 @@
+#include "qnes_jit.hpp"
+
+#if QNES_HAS_JIT
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iomanip>
+#include <string>
+#include <type_traits>
+
+#include "cpu_isa.hpp"
+#include "qnes_bits.hpp"
+#include "qnes_bus.hpp"
+
+namespace QNes {
+
+namespace {
+
+constexpr size_t CODE_BUFFER_SIZE = Megabytes(4);
+constexpr size_t MAX_BLOCK_INSTRUCTIONS = 64;
+// Upper bounds of the emitted code, checked before a block is emitted
+constexpr size_t MAX_INSTRUCTION_CODE = 160;
+constexpr size_t MAX_BLOCK_CODE =
+    64 + MAX_BLOCK_INSTRUCTIONS * MAX_INSTRUCTION_CODE;
+
+// Status register bits kept in state.status (see CPUCore::StatusFlags), C, Z,
+// V and N live in CPUCore::LazyFlags
+constexpr u8 INTERRUPT_FLAG = 0x04;
+constexpr u8 DECIMAL_FLAG = 0x08;
+
+enum class Reg8 : u8 { AL = 0 };
+
+/**
+ * @brief Minimal x86-64 machine code writer
+ * @details Knows just the instructions the block translator needs. Register
+ * use of a block: rbx = CPUCore *, r12 = CPU *, r13 = last start cycle,
+ * r14 = valid flag of the block. Memory operands are [rbx + offset].
+ */
+class X64Emitter {
+ public:
+  explicit X64Emitter(u8 *code) : code(code) {}
+  X64Emitter(const X64Emitter &) = delete;
+  X64Emitter &operator=(const X64Emitter &) = delete;
+  X64Emitter(X64Emitter &&) = delete;
+  X64Emitter &operator=(X64Emitter &&) = delete;
+  ~X64Emitter() = default;
+
+  [[nodiscard]] size_t GetSize() const { return size; }
+
+  // void block(CPU *rdi, CPUCore *rsi, u64 rdx, const bool *rcx)
+  void Prologue() {
+    Bytes({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56});  // push rbx..r14
+    Bytes({0x48, 0x83, 0xEC, 0x08});  // sub rsp, 8 - calls stay 16 aligned
+    Bytes({0x48, 0x89, 0xF3});        // mov rbx, rsi
+    Bytes({0x49, 0x89, 0xFC});        // mov r12, rdi
+    Bytes({0x49, 0x89, 0xD5});        // mov r13, rdx
+    Bytes({0x49, 0x89, 0xCE});        // mov r14, rcx
+  }
+  void Epilogue() {
+    Bytes({0x48, 0x83, 0xC4, 0x08});                    // add rsp, 8
+    Bytes({0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B});  // pop r14..rbx
+    Byte(0xC3);                                         // ret
+  }
+
+  void LoadByte(Reg8 reg, u32 offset) {
+    Byte(0x8A);
+    CoreOperand(static_cast<u8>(reg), offset);
+  }
+  void StoreByte(u32 offset, Reg8 reg) {
+    Byte(0x88);
+    CoreOperand(static_cast<u8>(reg), offset);
+  }
+  void StoreByte(u32 offset, u8 value) {
+    Byte(0xC6);
+    CoreOperand(0, offset);
+    Byte(value);
+  }
+  void StoreWord(u32 offset, u16 value) {
+    Bytes({0x66, 0xC7});
+    CoreOperand(0, offset);
+    Word(value);
+  }
+  void AndByte(u32 offset, u8 value) {
+    Byte(0x80);
+    CoreOperand(4, offset);
+    Byte(value);
+  }
+  void OrByte(u32 offset, u8 value) {
+    Byte(0x80);
+    CoreOperand(1, offset);
+    Byte(value);
+  }
+  // value has to fit a signed byte
+  void AddQword(u32 offset, u8 value) {
+    Bytes({0x48, 0x83});
+    CoreOperand(0, offset);
+    Byte(value);
+  }
+  void IncAl() { Bytes({0xFE, 0xC0}); }
+  void DecAl() { Bytes({0xFE, 0xC8}); }
+
+  // function(CPU *, esi), the result ends up in al
+  void CallWithCpu(uintptr_t function) {
+    Bytes({0x4C, 0x89, 0xE7});  // mov rdi, r12
+    Bytes({0x48, 0xB8});        // mov rax, function
+    Qword(function);
+    Bytes({0xFF, 0xD0});  // call rax
+  }
+  void SetEsi(u32 value) {
+    Byte(0xBE);
+    Dword(value);
+  }
+
+  // Conditional jumps with a rel32 target, return the position of the rel32
+  size_t JumpIfQwordAboveR13(u32 offset) {
+    Bytes({0x4C, 0x39});  // cmp [rbx + offset], r13
+    CoreOperand(5, offset);
+    return Jcc(0x87);  // ja
+  }
+  size_t JumpIfByteNonZero(u32 offset) {
+    Byte(0x80);  // cmp byte [rbx + offset], 0
+    CoreOperand(7, offset);
+    Byte(0x00);
+    return Jcc(0x85);  // jne
+  }
+  size_t JumpIfR14ByteZero() {
+    Bytes({0x41, 0x80, 0x3E, 0x00});  // cmp byte [r14], 0
+    return Jcc(0x84);                 // je
+  }
+  size_t JumpIfAlNonZero() {
+    Bytes({0x84, 0xC0});  // test al, al
+    return Jcc(0x85);     // jne
+  }
+
+  void PatchJump(size_t rel32, size_t target) {
+    const auto displacement = static_cast<i32>(target - (rel32 + 4));
+    std::memcpy(code + rel32, &displacement, sizeof(displacement));
+  }
+
+ private:
+  void Byte(u8 value) { code[size++] = value; }
+  void Bytes(std::initializer_list<u8> values) {
+    for (u8 value : values) {
+      Byte(value);
+    }
+  }
+  void Word(u16 value) {
+    std::memcpy(code + size, &value, sizeof(value));
+    size += sizeof(value);
+  }
+  void Dword(u32 value) {
+    std::memcpy(code + size, &value, sizeof(value));
+    size += sizeof(value);
+  }
+  void Qword(u64 value) {
+    std::memcpy(code + size, &value, sizeof(value));
+    size += sizeof(value);
+  }
+  // ModRM of [rbx + disp32] with the given reg field
+  void CoreOperand(u8 reg, u32 offset) {
+    Byte(static_cast<u8>(0x80 | (reg << 3) | 0x03));
+    Dword(offset);
+  }
+  size_t Jcc(u8 condition) {
+    Bytes({0x0F, condition});
+    const size_t rel32 = size;
+    Dword(0);
+    return rel32;
+  }
+
+  u8 *code = nullptr;
+  size_t size = 0;
+};
+
+bool IsIOAddress(u16 address) { return address >= 0x2000 && address <= 0x401F; }
+
+// Indexed access, the page crossing dummy read hits the unfixed address
+bool IndexedTouchesIO(u16 base, u8 index) {
+  const auto address = static_cast<u16>(base + index);
+  return IsIOAddress(address) ||
+         IsIOAddress(CombineToU16(U16High(base), U16Low(address)));
+}
+
+// Instructions after which the interpreter has to take over: control flow and
+// everything that can clear the I flag (a pending IRQ has to be taken)
+bool EndsBlock(u8 opcode, AddressingMode mode) {
+  switch (opcode) {
+    case ISA::JMP<AddressingMode::Absolute>::OPCODE:
+    case ISA::JMP<AddressingMode::Indirect>::OPCODE:
+    case ISA::JSR<AddressingMode::Absolute>::OPCODE:
+    case ISA::RTS<AddressingMode::Implied>::OPCODE:
+    case ISA::RTI<AddressingMode::Implied>::OPCODE:
+    case ISA::BRK<AddressingMode::Implied>::OPCODE:
+    case ISA::CLI<AddressingMode::Implied>::OPCODE:
+    case ISA::PLP<AddressingMode::Implied>::OPCODE:
+      return true;
+    default:
+      return mode == AddressingMode::Relative;
+  }
+}
+
+// I/O accesses with an address known at translation time
+bool StaticallyTouchesIO(u8 opcode, AddressingMode mode, u16 operand) {
+  switch (mode) {
+    case AddressingMode::Absolute:
+      // JMP/JSR take the operand as the target, nothing is accessed there
+      return opcode != ISA::JMP<AddressingMode::Absolute>::OPCODE &&
+             opcode != ISA::JSR<AddressingMode::Absolute>::OPCODE &&
+             IsIOAddress(operand);
+    case AddressingMode::Indirect:
+      // the pointer high byte does not cross the page
+      return IsIOAddress(operand) ||
+             IsIOAddress(CombineToU16(U16High(operand),
+                                      static_cast<u8>(U16Low(operand) + 1)));
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+template <typename CPU_T>
+Jit<CPU_T>::Jit(const JitConfig &config) : config(config) {
+  this->config.hot_threshold = std::clamp<u32>(config.hot_threshold, 1, 0xFF);
+  void *memory = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  // Without executable memory nothing gets compiled and Run interprets
+  if (memory != MAP_FAILED) {
+    code_buffer = static_cast<u8 *>(memory);
+  }
+  if (config.perf_map) {
+    perf_map.open("/tmp/perf-" + std::to_string(getpid()) + ".map",
+                  std::ios::app);
+  }
+}
+
+template <typename CPU_T>
+Jit<CPU_T>::~Jit() {
+  if (code_buffer != nullptr) {
+    munmap(code_buffer, CODE_BUFFER_SIZE);
+  }
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::Run(CPU_T &cpu, u64 last_start_cycle) {
+  while (cpu.cycle_count <= last_start_cycle && !cpu.exit_requested &&
+         cpu.ReadyToFetchOpcode()) {
+    const u16 pc = cpu.state.pc;
+    Block *block = lookup[pc];
+    if (block == nullptr) {
+      if (heat[pc] < 0xFF) {
+        ++heat[pc];
+      }
+      if (heat[pc] >= config.hot_threshold) {
+        block = Compile(cpu, pc);
+        if (block == nullptr) {
+          heat[pc] = 0;
+        }
+      }
+    }
+
+    const u64 start_cycle = cpu.cycle_count;
+    if (block != nullptr) {
+      running_block = true;
+      block->code(&cpu, &cpu, last_start_cycle, &block->valid);
+      running_block = false;
+    }
+    // Not compiled, or the block handed its first instruction back because
+    // it accesses I/O
+    if (cpu.cycle_count == start_cycle) {
+      cpu.StepInstruction();
+    }
+  }
+}
+
+template <typename CPU_T>
+typename Jit<CPU_T>::Block *Jit<CPU_T>::Compile(CPU_T &cpu, u16 start) {
+  static_assert(std::is_standard_layout_v<CPUCore>,
+                "Generated code addresses CPUCore members by offset");
+  constexpr auto STATE = static_cast<u32>(offsetof(CPUCore, state));
+  constexpr auto PC = STATE + static_cast<u32>(offsetof(CPUCore::State, pc));
+  constexpr auto SP = STATE + static_cast<u32>(offsetof(CPUCore::State, sp));
+  constexpr auto A = STATE + static_cast<u32>(offsetof(CPUCore::State, a));
+  constexpr auto X = STATE + static_cast<u32>(offsetof(CPUCore::State, x));
+  constexpr auto Y = STATE + static_cast<u32>(offsetof(CPUCore::State, y));
+  constexpr auto STATUS =
+      STATE + static_cast<u32>(offsetof(CPUCore::State, status));
+  constexpr auto FLAGS = static_cast<u32>(offsetof(CPUCore, flags));
+  constexpr auto CARRY =
+      FLAGS + static_cast<u32>(offsetof(CPUCore::LazyFlags, carry));
+  constexpr auto ZERO_RESULT =
+      FLAGS + static_cast<u32>(offsetof(CPUCore::LazyFlags, zero_result));
+  constexpr auto NEGATIVE_RESULT =
+      FLAGS + static_cast<u32>(offsetof(CPUCore::LazyFlags, negative_result));
+  constexpr auto OVERFLOW_RESULT =
+      FLAGS + static_cast<u32>(offsetof(CPUCore::LazyFlags, overflow_result));
+  constexpr auto IR = static_cast<u32>(offsetof(CPUCore, ir));
+  constexpr auto INSTRUCTION_CYCLE =
+      static_cast<u32>(offsetof(CPUCore, instruction_cycle));
+  constexpr auto EXIT_REQUESTED =
+      static_cast<u32>(offsetof(CPUCore, exit_requested));
+  constexpr auto CYCLE_COUNT = static_cast<u32>(offsetof(CPUCore, cycle_count));
+
+  if (code_buffer == nullptr) {
+    return nullptr;
+  }
+
+  const auto peek = [&cpu](u32 address) {
+    return cpu.bus->Read(static_cast<u16>(address));
+  };
+
+  // Decode
+  struct Instruction {
+    u16 pc;
+    u8 opcode;
+    u16 operand;
+    InstructionInfo info;
+  };
+  std::array<Instruction, MAX_BLOCK_INSTRUCTIONS> instructions{};
+  size_t count = 0;
+  u32 pc = start;
+  while (count < MAX_BLOCK_INSTRUCTIONS && pc <= 0xFFFF &&
+         cpu.bus->IsDecodeCacheable(static_cast<u16>(pc))) {
+    const u8 opcode = peek(pc);
+    const InstructionInfo info = InstructionInfoTable[opcode];
+    if (info.length == 0 || pc + info.length > 0x10000) {
+      break;
+    }
+    bool cacheable = true;
+    u16 operand = 0;
+    for (u8 i = 1; i < info.length && cacheable; ++i) {
+      cacheable = cpu.bus->IsDecodeCacheable(static_cast<u16>(pc + i));
+      if (cacheable) {
+        operand |= static_cast<u16>(peek(pc + i) << (8 * (i - 1)));
+      }
+    }
+    if (!cacheable || StaticallyTouchesIO(opcode, info.mode, operand)) {
+      break;
+    }
+    instructions[count++] = {static_cast<u16>(pc), opcode, operand, info};
+    pc += info.length;
+    if (EndsBlock(opcode, info.mode)) {
+      break;
+    }
+  }
+  if (count == 0) {
+    return nullptr;
+  }
+
+  if (code_used + MAX_BLOCK_CODE > CODE_BUFFER_SIZE) {
+    // Full, start over. Never happens while a block runs.
+    Invalidate();
+    blocks.clear();
+    code_used = 0;
+  }
+  mprotect(code_buffer, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE);
+
+  // Emit
+  u8 *code = code_buffer + code_used;
+  X64Emitter emit(code);
+  std::array<size_t, MAX_BLOCK_INSTRUCTIONS * 4> exits{};
+  size_t exit_count = 0;
+
+  emit.Prologue();
+  for (size_t i = 0; i < count; ++i) {
+    const Instruction &instruction = instructions[i];
+    exits[exit_count++] = emit.JumpIfQwordAboveR13(CYCLE_COUNT);
+    exits[exit_count++] = emit.JumpIfByteNonZero(EXIT_REQUESTED);
+    exits[exit_count++] = emit.JumpIfR14ByteZero();
+
+    bool (*guard)(CPU_T *, u32) = nullptr;
+    switch (instruction.info.mode) {
+      case AddressingMode::AbsoluteX:
+        guard = AbsoluteXTouchesIO;
+        break;
+      case AddressingMode::AbsoluteY:
+        guard = AbsoluteYTouchesIO;
+        break;
+      case AddressingMode::XIndirect:
+        guard = XIndirectTouchesIO;
+        break;
+      case AddressingMode::IndirectY:
+        guard = IndirectYTouchesIO;
+        break;
+      default:
+        break;
+    }
+    if (guard != nullptr) {
+      emit.SetEsi(instruction.operand);
+      emit.CallWithCpu(reinterpret_cast<uintptr_t>(guard));
+      exits[exit_count++] = emit.JumpIfAlNonZero();
+    }
+
+    // Register and flag instructions are emitted inline
+    bool inline_instruction = true;
+    switch (instruction.opcode) {
+      case ISA::NOP<AddressingMode::Implied>::OPCODE:
+        break;
+      case ISA::CLC<AddressingMode::Implied>::OPCODE:
+        emit.StoreByte(CARRY, u8{0});
+        break;
+      case ISA::SEC<AddressingMode::Implied>::OPCODE:
+        emit.StoreByte(CARRY, u8{1});
+        break;
+      case ISA::CLD<AddressingMode::Implied>::OPCODE:
+        emit.AndByte(STATUS, static_cast<u8>(~DECIMAL_FLAG));
+        break;
+      case ISA::SED<AddressingMode::Implied>::OPCODE:
+        emit.OrByte(STATUS, DECIMAL_FLAG);
+        break;
+      case ISA::CLV<AddressingMode::Implied>::OPCODE:
+        emit.StoreByte(OVERFLOW_RESULT, u8{0});
+        break;
+      case ISA::SEI<AddressingMode::Implied>::OPCODE:
+        emit.OrByte(STATUS, INTERRUPT_FLAG);
+        break;
+      case ISA::INX<AddressingMode::Implied>::OPCODE:
+      case ISA::INY<AddressingMode::Implied>::OPCODE:
+      case ISA::DEX<AddressingMode::Implied>::OPCODE:
+      case ISA::DEY<AddressingMode::Implied>::OPCODE: {
+        const bool x = instruction.opcode ==
+                           ISA::INX<AddressingMode::Implied>::OPCODE ||
+                       instruction.opcode ==
+                           ISA::DEX<AddressingMode::Implied>::OPCODE;
+        const bool increment = instruction.opcode ==
+                                   ISA::INX<AddressingMode::Implied>::OPCODE ||
+                               instruction.opcode ==
+                                   ISA::INY<AddressingMode::Implied>::OPCODE;
+        emit.LoadByte(Reg8::AL, x ? X : Y);
+        if (increment) {
+          emit.IncAl();
+        } else {
+          emit.DecAl();
+        }
+        emit.StoreByte(x ? X : Y, Reg8::AL);
+        emit.StoreByte(ZERO_RESULT, Reg8::AL);
+        emit.StoreByte(NEGATIVE_RESULT, Reg8::AL);
+      } break;
+      case ISA::TAX<AddressingMode::Implied>::OPCODE:
+      case ISA::TAY<AddressingMode::Implied>::OPCODE:
+      case ISA::TXA<AddressingMode::Implied>::OPCODE:
+      case ISA::TYA<AddressingMode::Implied>::OPCODE:
+      case ISA::TSX<AddressingMode::Implied>::OPCODE: {
+        u32 source = A;
+        u32 destination = X;
+        switch (instruction.opcode) {
+          case ISA::TAY<AddressingMode::Implied>::OPCODE:
+            destination = Y;
+            break;
+          case ISA::TXA<AddressingMode::Implied>::OPCODE:
+            source = X;
+            destination = A;
+            break;
+          case ISA::TYA<AddressingMode::Implied>::OPCODE:
+            source = Y;
+            destination = A;
+            break;
+          case ISA::TSX<AddressingMode::Implied>::OPCODE:
+            source = SP;
+            break;
+          default:
+            break;
+        }
+        emit.LoadByte(Reg8::AL, source);
+        emit.StoreByte(destination, Reg8::AL);
+        emit.StoreByte(ZERO_RESULT, Reg8::AL);
+        emit.StoreByte(NEGATIVE_RESULT, Reg8::AL);
+      } break;
+      case ISA::TXS<AddressingMode::Implied>::OPCODE:
+        emit.LoadByte(Reg8::AL, X);
+        emit.StoreByte(SP, Reg8::AL);
+        break;
+      case ISA::LDA<AddressingMode::Immediate>::OPCODE:
+      case ISA::LDX<AddressingMode::Immediate>::OPCODE:
+      case ISA::LDY<AddressingMode::Immediate>::OPCODE: {
+        const auto value = static_cast<u8>(instruction.operand);
+        u32 destination = A;
+        if (instruction.opcode == ISA::LDX<AddressingMode::Immediate>::OPCODE) {
+          destination = X;
+        } else if (instruction.opcode ==
+                   ISA::LDY<AddressingMode::Immediate>::OPCODE) {
+          destination = Y;
+        }
+        emit.StoreByte(destination, value);
+        emit.StoreByte(ZERO_RESULT, value);
+        emit.StoreByte(NEGATIVE_RESULT, value);
+      } break;
+      default:
+        inline_instruction = false;
+        break;
+    }
+
+    if (inline_instruction) {
+      emit.StoreWord(PC, static_cast<u16>(instruction.pc +
+                                          instruction.info.length));
+      emit.StoreByte(IR, instruction.opcode);
+      emit.AddQword(CYCLE_COUNT, instruction.info.cycles);
+    } else {
+      // Opcode fetch, then the rest of the instruction in the ISA handler,
+      // which counts its own cycles
+      emit.StoreWord(PC, static_cast<u16>(instruction.pc + 1));
+      emit.StoreByte(IR, instruction.opcode);
+      emit.StoreByte(INSTRUCTION_CYCLE, 1);
+      emit.AddQword(CYCLE_COUNT, 1);
+      emit.CallWithCpu(reinterpret_cast<uintptr_t>(
+          InstructionTables<CPU_T>::fast[instruction.opcode]));
+    }
+  }
+  const size_t exit = emit.GetSize();
+  emit.Epilogue();
+  for (size_t i = 0; i < exit_count; ++i) {
+    emit.PatchJump(exits[i], exit);
+  }
+  ASSERT(emit.GetSize() <= MAX_BLOCK_CODE, "Block code overflow");
+
+  mprotect(code_buffer, CODE_BUFFER_SIZE, PROT_READ | PROT_EXEC);
+  code_used += (emit.GetSize() + 15) & ~size_t{15};
+
+  // Register
+  const Instruction &last_instruction = instructions[count - 1];
+  auto &block = blocks.emplace_back(std::make_unique<Block>());
+  block->code = reinterpret_cast<BlockFunc>(code);
+  block->first = start;
+  block->last = static_cast<u16>(last_instruction.pc +
+                                 last_instruction.info.length - 1);
+  block->valid = true;
+  lookup[start] = block.get();
+  for (u32 page = U16High(block->first); page <= U16High(block->last);
+       ++page) {
+    page_blocks[page].push_back(block.get());
+    code_pages[page] = true;
+  }
+
+  if (perf_map.is_open()) {
+    WritePerfMapEntry(*block, code, emit.GetSize());
+  }
+  return block.get();
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::WritePerfMapEntry(const Block &block, const u8 *code,
+                                   size_t size) {
+  perf_map << std::hex << reinterpret_cast<uintptr_t>(code) << ' ' << size
+           << " qnes_jit_" << std::setw(4) << std::setfill('0') << block.first
+           << '_' << std::setw(4) << block.last << std::dec << std::endl;
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::InvalidateBlock(Block &block) {
+  block.valid = false;
+  if (lookup[block.first] == &block) {
+    lookup[block.first] = nullptr;
+    heat[block.first] = 0;
+  }
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::InvalidateWrite(u16 address) {
+  const u8 page = U16High(address);
+  if (!code_pages[page]) {
+    return;
+  }
+  auto &page_list = page_blocks[page];
+  for (Block *block : page_list) {
+    if (block->valid && block->first <= address && address <= block->last) {
+      InvalidateBlock(*block);
+    }
+  }
+  std::erase_if(page_list, [](const Block *block) { return !block->valid; });
+  code_pages[page] = !page_list.empty();
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::Invalidate(u16 first, u16 last) {
+  // A block is listed in every page it covers
+  for (u32 page = U16High(first); page <= U16High(last); ++page) {
+    if (!code_pages[page]) {
+      continue;
+    }
+    auto &page_list = page_blocks[page];
+    for (Block *block : page_list) {
+      if (block->valid && block->first <= last && first <= block->last) {
+        InvalidateBlock(*block);
+      }
+    }
+    std::erase_if(page_list, [](const Block *block) { return !block->valid; });
+    code_pages[page] = !page_list.empty();
+  }
+}
+
+template <typename CPU_T>
+void Jit<CPU_T>::Invalidate() {
+  // Blocks stay allocated, one of them may be running (e.g. a bank switch
+  // write), the memory is reclaimed when the code buffer is flushed
+  for (auto &block : blocks) {
+    if (block->valid) {
+      InvalidateBlock(*block);
+    }
+  }
+  for (auto &page_list : page_blocks) {
+    page_list.clear();
+  }
+  code_pages.reset();
+}
+
+template <typename CPU_T>
+size_t Jit<CPU_T>::GetValidBlockCount() const {
+  return static_cast<size_t>(std::ranges::count_if(
+      blocks, [](const auto &block) { return block->valid; }));
+}
+
+template <typename CPU_T>
+bool Jit<CPU_T>::AbsoluteXTouchesIO(CPU_T *cpu, u32 base) {
+  return IndexedTouchesIO(static_cast<u16>(base), cpu->state.x);
+}
+
+template <typename CPU_T>
+bool Jit<CPU_T>::AbsoluteYTouchesIO(CPU_T *cpu, u32 base) {
+  return IndexedTouchesIO(static_cast<u16>(base), cpu->state.y);
+}
+
+template <typename CPU_T>
+bool Jit<CPU_T>::XIndirectTouchesIO(CPU_T *cpu, u32 zero_page) {
+  // the pointer lives in the zero page, which is plain RAM
+  const auto pointer = static_cast<u8>(zero_page + cpu->state.x);
+  const u8 low = cpu->ReadLowPage(pointer);
+  const u8 high = cpu->ReadLowPage(static_cast<u8>(pointer + 1));
+  return IsIOAddress(CombineToU16(high, low));
+}
+
+template <typename CPU_T>
+bool Jit<CPU_T>::IndirectYTouchesIO(CPU_T *cpu, u32 zero_page) {
+  const auto pointer = static_cast<u8>(zero_page);
+  const u8 low = cpu->ReadLowPage(pointer);
+  const u8 high = cpu->ReadLowPage(static_cast<u8>(pointer + 1));
+  return IndexedTouchesIO(CombineToU16(high, low), cpu->state.y);
+}
+
+#define QNES_INSTANTIATE_JIT(BUS) template class Jit<BasicCPU<BUS>>;
+QNES_CPU_BUS_TYPES(QNES_INSTANTIATE_JIT)
+#undef QNES_INSTANTIATE_JIT
+
+}  // namespace QNes
+
+#endif
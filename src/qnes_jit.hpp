@@ -0,0 +1,104 @@
+#pragma once
+
+#include "qnes_c.hpp"
+
+#if QNES_HAS_JIT
+
+#include <array>
+#include <bitset>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "qnes_cpu.hpp"
+
+namespace QNes {
+
+/**
+ * @brief x86-64 dynamic recompiler for the 6502 core
+ * @details Straight-line runs of 6502 code (blocks, ending at the first
+ * control flow instruction) that start executing often enough are translated
+ * to native code. Simple register and flag instructions are emitted inline,
+ * everything else calls the instruction granular ISA handler of the opcode
+ * directly, so the ISA semantics (and cycle counts) of cpu_isa.cpp are shared
+ * with the interpreters.
+ *
+ * Between two instructions the generated code returns to the interpreter when
+ * the cycle budget is used up, an exit or interrupt is requested, the block
+ * got overwritten, or the next instruction is going to access the I/O range
+ * ($2000-$401F). Only code the bus reports as cacheable is translated (see
+ * Bus::IsDecodeCacheable), CPU writes invalidate the blocks they hit.
+ */
+template <typename CPU_T>
+class Jit {
+ public:
+  using JitConfig = CPUCore::JitConfig;
+
+  explicit Jit(const JitConfig &config);
+  Jit(const Jit &) = delete;
+  Jit &operator=(const Jit &) = delete;
+  Jit(Jit &&) = delete;
+  Jit &operator=(Jit &&) = delete;
+  ~Jit();
+
+  static constexpr u16 IO_FIRST = 0x2000;
+  static constexpr u16 IO_LAST = 0x401F;
+
+  // Same contract as ISA::RunThreaded: runs whole instructions until one would
+  // start after last_start_cycle, an exit is requested or an interrupt has to
+  // be taken. Expects to be entered on an opcode fetch.
+  void Run(CPU_T &cpu, u64 last_start_cycle);
+
+  // Call after the byte at address changed
+  void InvalidateWrite(u16 address);
+  // Invalidates every block with a byte in [first, last]
+  void Invalidate(u16 first, u16 last);
+  void Invalidate();
+
+  [[nodiscard]] size_t GetValidBlockCount() const;
+  [[nodiscard]] bool IsRunningBlock() const { return running_block; }
+
+ private:
+  // cpu, the same cpu as CPUCore, last_start_cycle, valid flag of the block
+  using BlockFunc = void (*)(CPU_T *, CPUCore *, u64, const bool *);
+
+  struct Block {
+    BlockFunc code = nullptr;
+    u16 first = 0;  // address of the first byte
+    u16 last = 0;   // address of the last byte
+    bool valid = false;
+  };
+
+  Block *Compile(CPU_T &cpu, u16 pc);
+  void InvalidateBlock(Block &block);
+  void WritePerfMapEntry(const Block &block, const u8 *code, size_t size);
+
+  // Guards called by the generated code before an instruction with an indexed
+  // or indirect effective address, true when it would touch the I/O range
+  static bool AbsoluteXTouchesIO(CPU_T *cpu, u32 base);
+  static bool AbsoluteYTouchesIO(CPU_T *cpu, u32 base);
+  static bool XIndirectTouchesIO(CPU_T *cpu, u32 zero_page);
+  static bool IndirectYTouchesIO(CPU_T *cpu, u32 zero_page);
+
+  JitConfig config;
+
+  u8 *code_buffer = nullptr;
+  size_t code_used = 0;
+
+  std::vector<std::unique_ptr<Block>> blocks;
+  std::array<Block *, 0x10000> lookup{};
+  std::array<u8, 0x10000> heat{};  // block start executions so far
+  std::array<std::vector<Block *>, 256> page_blocks;
+  std::bitset<256> code_pages;  // pages that hold bytes of valid blocks
+
+  bool running_block = false;
+
+  std::ofstream perf_map;
+};
+
+template <typename CPU_T>
+using JitPtr = std::unique_ptr<Jit<CPU_T>>;
+
+}  // namespace QNes
+
+#endif
@@ -4,7 +4,7 @@
 int main() {
   QNes::Emulator emulator;
 
-  emulator.Run();
+  emulator.RunFrame();
 
   ASSERT(false, "lol");
 
@@ -0,0 +1,248 @@
+#include "qnes_mapper.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace QNes {
+
+namespace {
+
+// Every mapper here switches PRG-ROM in units of at most 16 KB and CHR-ROM in
+// units of at most 8 KB, the iNES size units
+bool HasSupportedSizes(const RomImage &image) {
+  return image.GetPRGROM().size() % Kilobytes(16) == 0 &&
+         image.GetCHRROM().size() % Kilobytes(8) == 0;
+}
+
+// Size of RAM the board may not have
+template <typename MEMORY>
+u32 SizeOf(const std::unique_ptr<MEMORY> &memory) {
+  return memory != nullptr ? static_cast<u32>(memory->GetSize()) : 0;
+}
+
+}  // namespace
+
+std::unique_ptr<Cartridge> Cartridge::Create(RomImagePtr image) {
+  ASSERT(image != nullptr, "ROM image is not initialized");
+  const RomHeader header = image->GetHeader();
+  return Create(std::move(image), header);
+}
+
+std::unique_ptr<Cartridge> Cartridge::Create(RomImagePtr image,
+                                             const RomHeader &header) {
+  ASSERT(image != nullptr, "ROM image is not initialized");
+  if (!HasSupportedSizes(*image)) {
+    return nullptr;
+  }
+  RomHeader board = header;
+  board.trainer = image->GetHeader().trainer;
+  board.prg_rom_size = static_cast<u32>(image->GetPRGROM().size());
+  board.chr_rom_size = static_cast<u32>(image->GetCHRROM().size());
+  switch (board.mapper) {
+#define QNES_CREATE_CARTRIDGE(MAPPER) \
+  case MAPPER::NUMBER:                \
+    return std::make_unique<BasicCartridge<MAPPER>>(std::move(image), board);
+    QNES_MAPPER_TYPES(QNES_CREATE_CARTRIDGE)
+#undef QNES_CREATE_CARTRIDGE
+    default:
+      return nullptr;
+  }
+}
+
+Cartridge::Cartridge(RomImagePtr image, const RomHeader &header,
+                     const Cartridge *parent,
+                     NESBus::WriteHandler write_register)
+    : image(std::move(image)), header(header), write_register(write_register) {
+
+  // PRG-RAM is mapped in 8 KB banks
+  const u32 prg_ram_size = header.prg_ram_size + header.prg_nvram_size;
+  if (parent != nullptr && parent->prg_ram != nullptr) {
+    prg_ram = parent->prg_ram->Fork();
+  } else if (prg_ram_size != 0) {
+    const u64 bank = Kilobytes(8);
+    prg_ram = std::make_unique<PagedMemory>((prg_ram_size + bank - 1) /
+                                            bank * bank);
+    if (header.trainer) {
+      // The trainer is loaded at $7000
+      prg_ram->InitializeFrom(0x1000, this->image->GetTrainer());
+    }
+  }
+
+  if (this->image->GetCHRROM().empty()) {
+    chr_ram = std::make_unique<Memory>(
+        std::max<u64>(header.chr_ram_size + header.chr_nvram_size,
+                      Kilobytes(8)));
+    if (parent != nullptr) {
+      std::copy_n(parent->chr_ram->GetData(), chr_ram->GetSize(),
+                  chr_ram->GetData());
+    }
+  }
+
+  if (header.mirroring == Mirroring::FOUR_SCREEN) {
+    nametable_ram = std::make_unique<Memory>(Kilobytes(2));
+    if (parent != nullptr) {
+      std::copy_n(parent->nametable_ram->GetData(), nametable_ram->GetSize(),
+                  nametable_ram->GetData());
+    }
+  }
+}
+
+void Cartridge::Insert(NESBus *bus, PPUBus *ppu_bus, BasicCPU<NESBus> *cpu) {
+  ASSERT(bus != nullptr && ppu_bus != nullptr, "Buses are not initialized");
+  this->bus = bus;
+  this->ppu_bus = ppu_bus;
+  this->cpu = cpu;
+  prg_banks.fill(nullptr);
+
+  MapPRGRAM();
+  // PRG-ROM reads are mapped by the banks, writes go to the mapper
+  bus->MapIO(0x8000, 0x8000, nullptr, write_register, this);
+  MapBanks();
+}
+
+void Cartridge::MapPRGRAM() {
+  if (prg_ram != nullptr) {
+    bus->MapPagedMemory(0x6000, 0x2000, prg_ram.get(), 0, true);
+  }
+}
+
+u32 Cartridge::GetRAMSize() const {
+  return SizeOf(prg_ram) + SizeOf(chr_ram) + SizeOf(nametable_ram);
+}
+
+void Cartridge::SaveSnapshot(Registers &registers, std::span<u8> ram) const {
+  SaveRegisters(registers);
+  ASSERT(ram.size() == GetRAMSize(), "Snapshot RAM does not fit the board");
+  u8 *saved = ram.data();
+  if (prg_ram != nullptr) {
+    for (u32 page = 0; page < prg_ram->GetPageCount(); ++page) {
+      saved = std::copy_n(prg_ram->GetPage(page), PagedMemory::PAGE_SIZE,
+                          saved);
+    }
+  }
+  for (const Memory *memory : {chr_ram.get(), nametable_ram.get()}) {
+    if (memory != nullptr) {
+      saved = std::copy_n(memory->GetData(), memory->GetSize(), saved);
+    }
+  }
+}
+
+bool Cartridge::LoadSnapshot(const Registers &registers,
+                             std::span<const u8> ram) {
+  Registers current{};
+  SaveRegisters(current);
+  if (!registers.present || registers.image_hash != current.image_hash ||
+      registers.mapper != current.mapper ||
+      registers.prg_ram_size != current.prg_ram_size ||
+      registers.chr_ram_size != current.chr_ram_size ||
+      registers.nametable_ram_size != current.nametable_ram_size ||
+      ram.size() != GetRAMSize()) {
+    return false;
+  }
+  LoadMapper(registers.mapper_state);
+  const u8 *saved = ram.data();
+  if (prg_ram != nullptr) {
+    // Only the pages that differ, the others stay shared with forks
+    for (u32 page = 0; page < prg_ram->GetPageCount(); ++page) {
+      if (!std::equal(saved, saved + PagedMemory::PAGE_SIZE,
+                      prg_ram->GetPage(page))) {
+        std::copy_n(saved, PagedMemory::PAGE_SIZE,
+                    prg_ram->GetWritablePage(page));
+      }
+      saved += PagedMemory::PAGE_SIZE;
+    }
+  }
+  for (Memory *memory : {chr_ram.get(), nametable_ram.get()}) {
+    if (memory != nullptr) {
+      std::copy_n(saved, memory->GetSize(), memory->GetData());
+      saved += memory->GetSize();
+    }
+  }
+  if (bus != nullptr) {
+    // Written PRG-RAM pages were copied away from the ones the bus maps
+    MapPRGRAM();
+    MapBanks();
+  }
+  return true;
+}
+
+void Cartridge::SaveRegisters(Registers &registers) const {
+  registers = {.present = true,
+               .image_hash = image->GetContentHash(),
+               .prg_ram_size = SizeOf(prg_ram),
+               .chr_ram_size = SizeOf(chr_ram),
+               .nametable_ram_size = SizeOf(nametable_ram),
+               .mapper = GetHeader().mapper,
+               .mapper_state = {}};
+  SaveMapper(registers.mapper_state);
+}
+
+PagedMemoryPtr Cartridge::SnapshotPRGRAM() {
+  if (prg_ram == nullptr) {
+    return nullptr;
+  }
+  PagedMemoryPtr snapshot = prg_ram->Fork();
+  if (bus != nullptr) {
+    bus->ProtectSharedPages();
+  }
+  return snapshot;
+}
+
+void Cartridge::MapPRGROM(u16 address, u32 size, u32 bank) {
+  ASSERT(address >= 0x8000 && size >= Kilobytes(8),
+         "PRG-ROM banks are mapped in $8000-$FFFF");
+  const u32 bank_count = GetPRGBankCount(size);
+  ASSERT(bank_count != 0, "PRG-ROM is smaller than the bank");
+  const u8 *data = image->GetPRGROM().data() + (bank % bank_count) * size;
+  bus->MapMemory(address, size, data, size);
+
+  bool changed = false;
+  for (u32 offset = 0; offset < size; offset += Kilobytes(8)) {
+    const u8 *&slot = prg_banks[(address - 0x8000 + offset) / Kilobytes(8)];
+    changed |= slot != data + offset;
+    slot = data + offset;
+  }
+  // Writing the same bank again (games often do it every frame) keeps the
+  // decoded and compiled code
+  if (changed && cpu != nullptr) {
+    cpu->InvalidateCode(address, static_cast<u16>(address + size - 1));
+  }
+}
+
+void Cartridge::MapCHR(u16 address, u32 size, u32 bank) {
+  const std::span<const u8> chr_rom = image->GetCHRROM();
+  if (!chr_rom.empty()) {
+    const auto bank_count = static_cast<u32>(chr_rom.size() / size);
+    ppu_bus->MapMemory(address, size,
+                       chr_rom.data() + (bank % bank_count) * size, size);
+    return;
+  }
+  const auto bank_count = static_cast<u32>(chr_ram->GetSize() / size);
+  ppu_bus->MapMemory(address, size,
+                     chr_ram->GetData() + (bank % bank_count) * size, size,
+                     true);
+}
+
+void Cartridge::SetMirroring(Mirroring mirroring) {
+  ppu_bus->SetMirroring(mirroring);
+  if (mirroring == Mirroring::FOUR_SCREEN && nametable_ram != nullptr) {
+    // The third and the fourth nametable and their mirror
+    ppu_bus->MapMemory(0x2800, 0x0800, nametable_ram->GetData(),
+                       Kilobytes(2), true);
+    ppu_bus->MapMemory(0x3800, 0x0800, nametable_ram->GetData(),
+                       Kilobytes(2), true);
+  }
+}
+
+void Cartridge::SetIRQ(bool asserted) {
+  if (cpu == nullptr) {
+    return;
+  }
+  if (asserted) {
+    cpu->SignalIRQ();
+  } else {
+    cpu->ClearIRQ();
+  }
+}
+
+}  // namespace QNes
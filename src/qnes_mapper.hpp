@@ -0,0 +1,439 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+namespace QNes {
+
+/**
+ * @brief Cartridge inserted into an emulator
+ * @details Owns what a cartridge adds to a machine: the shared RomImage, the
+ * PRG-RAM, the CHR-RAM and (four-screen boards) the extra nametable RAM. The
+ * mapper decides which banks the buses see. Banks are mapped by pointing the
+ * pages of NESBus and PPUBus straight at the ROM/RAM, so PRG and CHR reads
+ * never reach the mapper, only writes to the mapper registers ($8000-$FFFF)
+ * do.
+ *
+ * The mapper is a policy class, BasicCartridge<MAPPER> calls it directly from
+ * the register write handler. Cartridge is the mapper independent part the
+ * emulator holds and the mappers map banks with.
+ */
+class Cartridge {
+ public:
+  static constexpr u32 MAX_MAPPER_SIZE = 32;
+
+  // Mapper registers of a savestate and the board they belong to. Trivially
+  // copyable and without pointers, the banks are mapped again from the
+  // registers when they are loaded.
+  struct Registers {
+    bool present;      // false: the machine had no cartridge
+    u64 image_hash;    // see RomImage::GetContentHash
+    u32 prg_ram_size;  // sizes of the RAM the board has
+    u32 chr_ram_size;
+    u32 nametable_ram_size;
+    u16 mapper;
+    std::array<u8, MAX_MAPPER_SIZE> mapper_state;  // the MAPPER policy
+  };
+
+  Cartridge(const Cartridge &) = delete;
+  Cartridge &operator=(const Cartridge &) = delete;
+  Cartridge(Cartridge &&) = delete;
+  Cartridge &operator=(Cartridge &&) = delete;
+  virtual ~Cartridge() = default;
+
+  // nullptr when the mapper of the image is not supported
+  [[nodiscard]] static std::unique_ptr<Cartridge> Create(RomImagePtr image);
+  // With a corrected header (see RomDatabase) in place of the one in the
+  // file. The PRG-ROM and CHR-ROM sizes are always the ones of the image.
+  [[nodiscard]] static std::unique_ptr<Cartridge> Create(
+      RomImagePtr image, const RomHeader &header);
+
+  // Maps the cartridge into the buses with the banks of the current mapper
+  // registers. Bank switches are reported to cpu (decode cache, JIT) and the
+  // mapper IRQ goes to it, cpu may be nullptr.
+  void Insert(NESBus *bus, PPUBus *ppu_bus, BasicCPU<NESBus> *cpu);
+  // Mapper registers back to their power-on state
+  virtual void Reset() = 0;
+  // Cartridge with the same image and mapper registers for another emulator.
+  // PRG-RAM is shared copy-on-write (the bus this cartridge is inserted into
+  // has to call NESBus::ProtectSharedPages), CHR-RAM is copied.
+  [[nodiscard]] virtual std::unique_ptr<Cartridge> Fork() const = 0;
+  // Called by the PPU once per rendered scanline (PPU A12 rising edge)
+  virtual void ClockScanline() {}
+  // False when ClockScanline does nothing, the PPU then runs over whole
+  // frames without stopping on every scanline
+  [[nodiscard]] virtual bool HasScanlineCounter() const { return false; }
+
+  // Bytes of RAM a snapshot holds next to the registers: PRG-RAM, then
+  // CHR-RAM, then the nametable RAM of four-screen boards. Only the RAM the
+  // board has, 0 for most ROM-only boards.
+  [[nodiscard]] u32 GetRAMSize() const;
+  // ram has GetRAMSize() bytes
+  void SaveSnapshot(Registers &registers, std::span<u8> ram) const;
+  // False when registers were saved with another image or mapper or ram does
+  // not fit the board, the cartridge is left as it was
+  [[nodiscard]] bool LoadSnapshot(const Registers &registers,
+                                  std::span<const u8> ram);
+  void SaveRegisters(Registers &registers) const;
+
+  [[nodiscard]] const RomHeader &GetHeader() const { return header; }
+  [[nodiscard]] const RomImagePtr &GetImage() const { return image; }
+  // nullptr when the board has none
+  [[nodiscard]] PagedMemory *GetPRGRAM() const { return prg_ram.get(); }
+  // Copy-on-write fork of PRG-RAM that another thread may read while the
+  // emulation keeps writing: the pages are copied on their first write after
+  // it. A page of PRG-RAM that still is the page of the snapshot has not been
+  // written since. nullptr when the board has no PRG-RAM.
+  [[nodiscard]] PagedMemoryPtr SnapshotPRGRAM();
+  [[nodiscard]] Memory *GetCHRRAM() const { return chr_ram.get(); }
+  [[nodiscard]] Memory *GetNametableRAM() const { return nametable_ram.get(); }
+
+  // For the mappers. Banks are numbered in units of size and wrap around the
+  // ROM, size is a power of two.
+  void MapPRGROM(u16 address, u32 size, u32 bank);
+  // CHR-ROM, or CHR-RAM on boards without CHR-ROM
+  void MapCHR(u16 address, u32 size, u32 bank);
+  void SetMirroring(Mirroring mirroring);
+  [[nodiscard]] u32 GetPRGBankCount(u32 size) const {
+    return static_cast<u32>(image->GetPRGROM().size() / size);
+  }
+  void SetIRQ(bool asserted);
+
+ protected:
+  // parent is the cartridge to fork (see Fork), nullptr for a new one
+  Cartridge(RomImagePtr image, const RomHeader &header,
+            const Cartridge *parent, NESBus::WriteHandler write_register);
+
+  // Maps PRG/CHR banks and the mirroring of the current mapper registers
+  virtual void MapBanks() = 0;
+  // The MAPPER policy as bytes, for Registers
+  virtual void SaveMapper(std::span<u8> data) const = 0;
+  virtual void LoadMapper(std::span<const u8> data) = 0;
+
+  RomImagePtr image;
+  RomHeader header;
+  PagedMemoryPtr prg_ram;
+  MemoryPtr chr_ram;
+  MemoryPtr nametable_ram;  // four-screen boards
+
+  NESBus *bus = nullptr;
+  PPUBus *ppu_bus = nullptr;
+  BasicCPU<NESBus> *cpu = nullptr;
+
+ private:
+  void MapPRGRAM();
+
+  NESBus::WriteHandler write_register = nullptr;
+  // 8 KB PRG-ROM banks mapped at $8000, $A000, $C000 and $E000, to tell bank
+  // switches that change code from writes that map the same banks again
+  std::array<const u8 *, 4> prg_banks{};
+};
+
+using CartridgePtr = std::unique_ptr<Cartridge>;
+
+// Mappers Cartridge::Create knows, see qnes_mapper.hpp
+#define QNES_MAPPER_TYPES(X) X(NROM) X(UxROM) X(CNROM) X(MMC1) X(MMC3)
+
+/**
+ * @brief Cartridge with the mapper MAPPER
+ * @details MAPPER is a trivially copyable policy whose member initializers are
+ * the power-on register values and that provides
+ *
+ *   static constexpr u16 NUMBER;  // iNES mapper number
+ *   // Register write ($8000-$FFFF), true when the banks have to be mapped
+ *   // again
+ *   bool Write(Cartridge &cartridge, u16 address, u8 value);
+ *   // Maps the banks and the mirroring of the current registers
+ *   void MapBanks(Cartridge &cartridge) const;
+ *
+ * and optionally void ClockScanline(Cartridge &cartridge) for a scanline
+ * counter. The write handler of the bus calls Write of the concrete policy,
+ * so it is inlined into the handler.
+ */
+template <typename MAPPER>
+class BasicCartridge final : public Cartridge {
+ public:
+  static_assert(std::is_trivially_copyable_v<MAPPER> &&
+                    sizeof(MAPPER) <= MAX_MAPPER_SIZE,
+                "Mapper registers do not fit into Registers");
+  static constexpr bool HAS_SCANLINE_COUNTER =
+      requires(MAPPER &mapper, Cartridge &cartridge) {
+        mapper.ClockScanline(cartridge);
+      };
+
+  BasicCartridge(RomImagePtr image, const RomHeader &header,
+                 const BasicCartridge *parent = nullptr)
+      : Cartridge(std::move(image), header, parent, WriteRegister) {
+    if (parent != nullptr) {
+      mapper = parent->mapper;
+    }
+  }
+  BasicCartridge(const BasicCartridge &) = delete;
+  BasicCartridge &operator=(const BasicCartridge &) = delete;
+  BasicCartridge(BasicCartridge &&) = delete;
+  BasicCartridge &operator=(BasicCartridge &&) = delete;
+  ~BasicCartridge() override = default;
+
+  void Reset() override {
+    mapper = {};
+    SetIRQ(false);
+    if (bus != nullptr) {
+      MapBanks();
+    }
+  }
+
+  [[nodiscard]] std::unique_ptr<Cartridge> Fork() const override {
+    return std::make_unique<BasicCartridge>(image, header, this);
+  }
+
+  void ClockScanline() override {
+    if constexpr (HAS_SCANLINE_COUNTER) {
+      mapper.ClockScanline(*this);
+    }
+  }
+  [[nodiscard]] bool HasScanlineCounter() const override {
+    return HAS_SCANLINE_COUNTER;
+  }
+
+  [[nodiscard]] const MAPPER &GetMapper() const { return mapper; }
+
+ private:
+  void MapBanks() override { mapper.MapBanks(*this); }
+  void SaveMapper(std::span<u8> data) const override {
+    std::memcpy(data.data(), &mapper, sizeof(MAPPER));
+  }
+  void LoadMapper(std::span<const u8> data) override {
+    std::memcpy(&mapper, data.data(), sizeof(MAPPER));
+  }
+
+  static void WriteRegister(void *device, u16 address, u8 value) {
+    auto *cartridge =
+        static_cast<BasicCartridge *>(static_cast<Cartridge *>(device));
+    if (cartridge->mapper.Write(*cartridge, address, value)) {
+      cartridge->MapBanks();
+    }
+  }
+
+  MAPPER mapper{};
+};
+
+// Mapper 0: 16 or 32 KB PRG-ROM, 8 KB CHR, no registers
+struct NROM {
+  static constexpr u16 NUMBER = 0;
+
+  bool Write(Cartridge &, u16, u8) { return false; }
+  void MapBanks(Cartridge &cartridge) const {
+    // 16 KB images are mirrored
+    cartridge.MapPRGROM(0x8000, Kilobytes(16), 0);
+    cartridge.MapPRGROM(0xC000, Kilobytes(16), 1);
+    cartridge.MapCHR(0x0000, Kilobytes(8), 0);
+    cartridge.SetMirroring(cartridge.GetHeader().mirroring);
+  }
+};
+
+// Mapper 2: switchable 16 KB PRG bank at $8000, last bank fixed at $C000
+struct UxROM {
+  static constexpr u16 NUMBER = 2;
+
+  u8 prg_bank = 0;
+
+  bool Write(Cartridge &, u16, u8 value) {
+    prg_bank = value;
+    return true;
+  }
+  void MapBanks(Cartridge &cartridge) const {
+    cartridge.MapPRGROM(0x8000, Kilobytes(16), prg_bank);
+    cartridge.MapPRGROM(0xC000, Kilobytes(16),
+                        cartridge.GetPRGBankCount(Kilobytes(16)) - 1);
+    cartridge.MapCHR(0x0000, Kilobytes(8), 0);
+    cartridge.SetMirroring(cartridge.GetHeader().mirroring);
+  }
+};
+
+// Mapper 3: NROM PRG, switchable 8 KB CHR bank
+struct CNROM {
+  static constexpr u16 NUMBER = 3;
+
+  u8 chr_bank = 0;
+
+  bool Write(Cartridge &, u16, u8 value) {
+    chr_bank = value;
+    return true;
+  }
+  void MapBanks(Cartridge &cartridge) const {
+    cartridge.MapPRGROM(0x8000, Kilobytes(16), 0);
+    cartridge.MapPRGROM(0xC000, Kilobytes(16), 1);
+    cartridge.MapCHR(0x0000, Kilobytes(8), chr_bank);
+    cartridge.SetMirroring(cartridge.GetHeader().mirroring);
+  }
+};
+
+// Mapper 1: registers are loaded serially through a 5 bit shift register,
+// 16/32 KB PRG banks, 4/8 KB CHR banks, mapper controlled mirroring. 512 KB
+// boards (SUROM) select the 256 KB half of PRG-ROM with CHR bank bit 4.
+struct MMC1 {
+  static constexpr u16 NUMBER = 1;
+
+  u8 shift = 0x10;  // bit 4 marks the fifth write
+  u8 control = 0x0C;
+  u8 chr_bank_0 = 0;
+  u8 chr_bank_1 = 0;
+  u8 prg_bank = 0;
+
+  bool Write(Cartridge &, u16 address, u8 value) {
+    if ((value & 0x80) != 0) {
+      shift = 0x10;
+      control |= 0x0C;
+      return true;
+    }
+    const bool complete = (shift & 0x01) != 0;
+    shift = static_cast<u8>((shift >> 1) | ((value & 0x01) << 4));
+    if (!complete) {
+      return false;
+    }
+    switch ((address >> 13) & 0x03) {
+      case 0:
+        control = shift;
+        break;
+      case 1:
+        chr_bank_0 = shift;
+        break;
+      case 2:
+        chr_bank_1 = shift;
+        break;
+      case 3:
+        prg_bank = shift & 0x0F;
+        break;
+    }
+    shift = 0x10;
+    return true;
+  }
+
+  void MapBanks(Cartridge &cartridge) const {
+    const u32 outer = cartridge.GetPRGBankCount(Kilobytes(16)) > 16
+                          ? (chr_bank_0 & 0x10)
+                          : 0;
+    const u32 last = outer | 0x0F;
+    switch ((control >> 2) & 0x03) {
+      case 0:
+      case 1:  // 32 KB
+        cartridge.MapPRGROM(0x8000, Kilobytes(16), outer | (prg_bank & 0x0E));
+        cartridge.MapPRGROM(0xC000, Kilobytes(16), outer | prg_bank | 0x01);
+        break;
+      case 2:  // first bank fixed at $8000
+        cartridge.MapPRGROM(0x8000, Kilobytes(16), outer);
+        cartridge.MapPRGROM(0xC000, Kilobytes(16), outer | prg_bank);
+        break;
+      case 3:  // last bank fixed at $C000
+        cartridge.MapPRGROM(0x8000, Kilobytes(16), outer | prg_bank);
+        cartridge.MapPRGROM(0xC000, Kilobytes(16), last);
+        break;
+    }
+    if ((control & 0x10) != 0) {
+      cartridge.MapCHR(0x0000, Kilobytes(4), chr_bank_0);
+      cartridge.MapCHR(0x1000, Kilobytes(4), chr_bank_1);
+    } else {
+      cartridge.MapCHR(0x0000, Kilobytes(8), chr_bank_0 >> 1);
+    }
+    constexpr Mirroring MIRRORING[] = {
+        Mirroring::SINGLE_SCREEN_LOWER, Mirroring::SINGLE_SCREEN_UPPER,
+        Mirroring::VERTICAL, Mirroring::HORIZONTAL};
+    cartridge.SetMirroring(MIRRORING[control & 0x03]);
+  }
+};
+
+// Mapper 4: 8 KB PRG banks, 1/2 KB CHR banks, mapper controlled mirroring
+// and a scanline counter that raises IRQs
+struct MMC3 {
+  static constexpr u16 NUMBER = 4;
+
+  u8 bank_select = 0;
+  std::array<u8, 8> banks = {0, 2, 4, 5, 6, 7, 0, 1};  // R0-R7
+  bool horizontal = false;
+  u8 irq_latch = 0;
+  u8 irq_counter = 0;
+  bool irq_reload = false;
+  bool irq_enabled = false;
+
+  bool Write(Cartridge &cartridge, u16 address, u8 value) {
+    const bool odd = (address & 0x01) != 0;
+    switch (address & 0xE000) {
+      case 0x8000:
+        if (odd) {
+          banks[bank_select & 0x07] = value;
+        } else {
+          bank_select = value;
+        }
+        return true;
+      case 0xA000:
+        if (!odd) {
+          horizontal = (value & 0x01) != 0;
+          return true;
+        }
+        return false;  // PRG-RAM protect
+      case 0xC000:
+        if (odd) {
+          irq_counter = 0;
+          irq_reload = true;
+        } else {
+          irq_latch = value;
+        }
+        return false;
+      default:  // $E000
+        irq_enabled = odd;
+        if (!odd) {
+          cartridge.SetIRQ(false);
+        }
+        return false;
+    }
+  }
+
+  void MapBanks(Cartridge &cartridge) const {
+    const u32 second_last = cartridge.GetPRGBankCount(Kilobytes(8)) - 2;
+    const bool prg_swap = (bank_select & 0x40) != 0;
+    cartridge.MapPRGROM(0x8000, Kilobytes(8),
+                        prg_swap ? second_last : banks[6]);
+    cartridge.MapPRGROM(0xA000, Kilobytes(8), banks[7]);
+    cartridge.MapPRGROM(0xC000, Kilobytes(8),
+                        prg_swap ? banks[6] : second_last);
+    cartridge.MapPRGROM(0xE000, Kilobytes(8), second_last + 1);
+
+    // A12 inversion swaps the 2 KB and the 1 KB halves
+    const u16 inversion = (bank_select & 0x80) != 0 ? 0x1000 : 0x0000;
+    cartridge.MapCHR(0x0000 ^ inversion, Kilobytes(2), banks[0] >> 1);
+    cartridge.MapCHR(0x0800 ^ inversion, Kilobytes(2), banks[1] >> 1);
+    for (u16 i = 0; i < 4; ++i) {
+      cartridge.MapCHR(static_cast<u16>((0x1000 + i * 0x400) ^ inversion),
+                       Kilobytes(1), banks[2 + i]);
+    }
+    if (cartridge.GetHeader().mirroring == Mirroring::FOUR_SCREEN) {
+      cartridge.SetMirroring(Mirroring::FOUR_SCREEN);
+    } else {
+      cartridge.SetMirroring(horizontal ? Mirroring::HORIZONTAL
+                                        : Mirroring::VERTICAL);
+    }
+  }
+
+  void ClockScanline(Cartridge &cartridge) {
+    if (irq_counter == 0 || irq_reload) {
+      irq_counter = irq_latch;
+      irq_reload = false;
+    } else {
+      --irq_counter;
+    }
+    if (irq_counter == 0 && irq_enabled) {
+      cartridge.SetIRQ(true);
+    }
+  }
+};
+
+}  // namespace QNes
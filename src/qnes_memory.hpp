@@ -1,7 +1,11 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <span>
+#include <utility>
+#include <vector>
 
 #include "qnes_c.hpp"
 
@@ -32,6 +36,9 @@ class Memory {
   }
 
   [[nodiscard]] size_t GetSize() const { return size; }
+  // For buses that map the memory into their address space (NESBus)
+  [[nodiscard]] u8 *GetData() { return data.get(); }
+  [[nodiscard]] const u8 *GetData() const { return data.get(); }
 
  private:
   size_t size;
@@ -39,4 +46,152 @@ class Memory {
 };
 
 using MemoryPtr = std::unique_ptr<Memory>;
+
+/**
+ * @brief Memory of a size known at compile time
+ * @details The bytes are stored inline (no pointer to chase) and cache line
+ * aligned. SIZE is a power of two, addresses are masked with SIZE - 1, so
+ * reading or writing past the end wraps around like the mirrored RAM chips of
+ * the NES do.
+ */
+template <size_t SIZE>
+class alignas(64) StaticMemory {
+ public:
+  static_assert(SIZE != 0 && (SIZE & (SIZE - 1)) == 0,
+                "Memory size must be a power of two");
+  static constexpr size_t MASK = SIZE - 1;
+
+  StaticMemory() = default;
+  StaticMemory(const StaticMemory &) = delete;
+  StaticMemory &operator=(const StaticMemory &) = delete;
+  StaticMemory(StaticMemory &&) = delete;
+  StaticMemory &operator=(StaticMemory &&) = delete;
+  ~StaticMemory() = default;
+
+  [[nodiscard]] u8 Read(u16 address) const { return data[address & MASK]; }
+  void Write(u16 address, u8 value) { data[address & MASK] = value; }
+
+  void Clear() { data.fill(0); }
+
+  void Initialize(std::span<const u8> data) { InitializeFrom(0, data); }
+
+  void InitializeFrom(size_t offset, std::span<const u8> data) {
+    ASSERT(offset + data.size() <= SIZE,
+           "Offset and data size exceed memory size");
+    std::ranges::copy(data, this->data.begin() + offset);
+  }
+
+  [[nodiscard]] static constexpr size_t GetSize() { return SIZE; }
+  [[nodiscard]] u8 *GetData() { return data.data(); }
+  [[nodiscard]] const u8 *GetData() const { return data.data(); }
+
+ private:
+  std::array<u8, SIZE> data{};
+};
+
+/**
+ * @brief Memory that forks share copy-on-write
+ * @details The memory is split into pages of PAGE_SIZE bytes. Fork returns a
+ * memory with the same contents that shares every page with this one, a
+ * shared page is copied on the first write to it by either side. A fork costs
+ * one reference per page, afterwards every side pays only for the pages it
+ * writes. Memory that is never written after it was loaded (PRG-ROM, CHR-ROM)
+ * stays shared by all forks.
+ *
+ * A memory and its forks may be used from different threads, each of them by
+ * one thread at a time. A page is written in place only once every other
+ * reference to it is dropped, IsShared orders those drops (and the reads of
+ * the page before them) before the write. Fork itself must not run
+ * concurrently with accesses to the memory it forks.
+ */
+class PagedMemory {
+ public:
+  static constexpr u32 PAGE_BITS = 10;
+  static constexpr u32 PAGE_SIZE = 1u << PAGE_BITS;
+  static constexpr u32 PAGE_MASK = PAGE_SIZE - 1;
+
+  explicit PagedMemory(size_t size) : size(size) {
+    ASSERT(size != 0 && size % PAGE_SIZE == 0,
+           "Paged memory size must be a multiple of the page size");
+    pages.resize(size / PAGE_SIZE);
+    for (auto &page : pages) {
+      page = std::make_shared<Page>();
+    }
+  }
+  PagedMemory(const PagedMemory &) = delete;
+  PagedMemory &operator=(const PagedMemory &) = delete;
+  PagedMemory(PagedMemory &&) = delete;
+  PagedMemory &operator=(PagedMemory &&) = delete;
+  ~PagedMemory() = default;
+
+  [[nodiscard]] std::unique_ptr<PagedMemory> Fork() const {
+    return std::unique_ptr<PagedMemory>(new PagedMemory(size, pages));
+  }
+
+  [[nodiscard]] u8 Read(u32 address) const {
+    return (*pages[address >> PAGE_BITS])[address & PAGE_MASK];
+  }
+  void Write(u32 address, u8 value) {
+    GetWritablePage(address >> PAGE_BITS)[address & PAGE_MASK] = value;
+  }
+
+  void Clear() {
+    for (u32 page = 0; page < GetPageCount(); ++page) {
+      std::fill_n(GetWritablePage(page), PAGE_SIZE, 0);
+    }
+  }
+
+  void Initialize(std::span<const u8> data) { InitializeFrom(0, data); }
+
+  void InitializeFrom(size_t offset, std::span<const u8> data) {
+    ASSERT(offset + data.size() <= size,
+           "Offset and data size exceed memory size");
+    for (size_t i = 0; i < data.size(); ++i) {
+      Write(static_cast<u32>(offset + i), data[i]);
+    }
+  }
+
+  [[nodiscard]] size_t GetSize() const { return size; }
+  [[nodiscard]] u32 GetPageCount() const {
+    return static_cast<u32>(pages.size());
+  }
+
+  // For buses that map the pages into their address space (NESBus). The
+  // pointer of a page changes when a shared page is copied.
+  [[nodiscard]] const u8 *GetPage(u32 page) const {
+    return pages[page]->data();
+  }
+  // Copies the page first when it is shared
+  [[nodiscard]] u8 *GetWritablePage(u32 page) {
+    if (IsShared(page)) {
+      pages[page] = std::make_shared<Page>(*pages[page]);
+    }
+    return pages[page]->data();
+  }
+  [[nodiscard]] bool IsShared(u32 page) const {
+    // use_count is a relaxed load, the fence pairs it with the release of
+    // the last other reference
+    if (pages[page].use_count() > 1) {
+      return true;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return false;
+  }
+
+ private:
+  using Page = std::array<u8, PAGE_SIZE>;
+
+  PagedMemory(size_t size, std::vector<std::shared_ptr<Page>> pages)
+      : size(size), pages(std::move(pages)) {}
+
+  size_t size;
+  std::vector<std::shared_ptr<Page>> pages;
+};
+
+using PagedMemoryPtr = std::unique_ptr<PagedMemory>;
+
+using WorkRAM = StaticMemory<Kilobytes(2)>;       // CPU internal RAM
+using VideoRAM = StaticMemory<Kilobytes(2)>;      // nametables
+using PaletteRAM = StaticMemory<32>;              // PPU palette indices
+using ObjectAttributeMemory = StaticMemory<256>;  // PPU sprite attributes
 }  // namespace QNes
\ No newline at end of file
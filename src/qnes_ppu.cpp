@@ -1,14 +1,27 @@
 #include "qnes_ppu.hpp"
 
+#include <algorithm>
+
 #include "qnes_bus.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_mapper.hpp"
 
 namespace QNes {
 
 constexpr u16 PPU_16_BIT_MASK = 0x3FFF;
 
 constexpr u8 PPU_STATUS_VBLANK_STARTED_MASK = 0x80;
+// vblank, sprite 0 hit and sprite overflow, cleared on the pre-render scanline
+constexpr u8 PPU_STATUS_FRAME_FLAGS_MASK = 0xE0;
 
 constexpr u8 PPU_CTRL_VRAM_ADDRESS_INCREMENT_MASK = 0b00000100;
+constexpr u8 PPU_CTRL_NMI_ENABLE_MASK = 0b10000000;
+
+// Dot at which vblank starts and, on the pre-render scanline, ends
+constexpr u16 VBLANK_DOT = 1;
+// Dot of a rendered scanline at which the sprite pattern fetches raise PPU A12
+// and clock the scanline counter of the mapper
+constexpr u16 SCANLINE_CLOCK_DOT = 260;
 
 constexpr u16 TEMP_VRAM_COARSE_X_MASK = 0b000000000000011111;
 constexpr u16 TEMP_VRAM_COARSE_Y_MASK = 0b000000001111100000;
@@ -25,28 +38,194 @@ constexpr u8 PPU_MASK_SHOW_SPRITES = 0b00010000;
 constexpr u8 PPU_RENDERING_MASK =
     PPU_MASK_SHOW_BACKGROUND | PPU_MASK_SHOW_SPRITES;
 
-void PPU::UpdateRenderingToggle() {
+void PPU::UpdateRenderingToggle(u64 dots) {
   if (rendering_toggle_scheduled) {
-    if (rendering_toggle_cycles_to_wait == 0) {
+    // The toggle happens on the dot after the wait
+    if (dots > static_cast<u64>(rendering_toggle_cycles_to_wait)) {
       rendering_toggle_scheduled = false;
+      rendering_toggle_cycles_to_wait = 0;
       registers.ppu_mask = (registers.ppu_mask & ~PPU_RENDERING_MASK) |
                            (new_rendering_flags & PPU_RENDERING_MASK);
       this->new_rendering_flags = 0;
     } else {
-      --rendering_toggle_cycles_to_wait;
+      rendering_toggle_cycles_to_wait -= static_cast<int>(dots);
+    }
+  }
+}
+
+void PPU::Run(u64 dots) {
+  while (dots != 0) {
+    // Up to the next event or the end of the scanline, whichever is first
+    const u64 burst =
+        std::min({dots, GetDotsToNextEvent(),
+                  static_cast<u64>(GetScanlineLength() - scanline_cycle)});
+    dots -= burst;
+    dot_count += burst;
+    UpdateRenderingToggle(burst);
+    scanline_cycle += static_cast<u16>(burst);
+    if (scanline_cycle >= GetScanlineLength()) {
+      scanline_cycle = 0;
+      if (++scanline_idx == GetScanlineCount()) {
+        scanline_idx = 0;
+        odd_frame = !odd_frame;
+      }
+    }
+    RunEvents();
+  }
+}
+
+void PPU::SetRegion(Region region) {
+  if (region == this->region) {
+    return;
+  }
+  if (cpu != nullptr) {
+    CatchUp();
+    region_cpu_cycles = cpu->GetCycleCount();
+    region_dot_count = dot_count;
+  }
+  this->region = region;
+}
+
+void PPU::CatchUp() {
+  if (cpu == nullptr) {
+    return;
+  }
+  const u64 target = GetDotCountAt(cpu->GetCycleCount());
+  if (target > dot_count) {
+    Run(target - dot_count);
+  }
+}
+
+u64 PPU::GetDotCountAt(u64 cpu_cycles) const {
+  ASSERT(cpu_cycles >= region_cpu_cycles,
+         "CPU cycle count is before the region switch");
+  return region_dot_count +
+         CPUCyclesToDots(cpu_cycles - region_cpu_cycles, region);
+}
+
+u64 PPU::GetCPUCycleCountAt(u64 dots) const {
+  ASSERT(dots >= region_dot_count, "Dot count is before the region switch");
+  return region_cpu_cycles + DotsToCPUCycles(dots - region_dot_count, region);
+}
+
+u64 PPU::GetDotsToNextEvent() const {
+  u64 dots = std::min(GetDotsUntil(VBLANK_SCANLINE, VBLANK_DOT),
+                      GetDotsUntil(GetPreRenderScanline(), VBLANK_DOT));
+  if (IsClockingScanlines()) {
+    // Next rendered scanline whose clock dot is still ahead
+    u16 scanline = scanline_idx;
+    if (scanline_cycle >= SCANLINE_CLOCK_DOT) {
+      scanline = scanline + 1 == GetScanlineCount() ? 0 : scanline + 1;
     }
+    if (scanline >= VISIBLE_SCANLINES) {
+      scanline = GetPreRenderScanline();
+    }
+    dots = std::min(dots, GetDotsUntil(scanline, SCANLINE_CLOCK_DOT));
+  }
+  if (rendering_toggle_scheduled) {
+    dots = std::min(dots,
+                    static_cast<u64>(rendering_toggle_cycles_to_wait) + 1);
+  }
+  return dots;
+}
+
+u16 PPU::GetScanlineLength() const {
+  // NTSC skips the last dot of the pre-render scanline of every other frame
+  // while rendering
+  if (region == Region::NTSC && odd_frame &&
+      scanline_idx == GetPreRenderScanline() && IsRenderingEnabled()) {
+    return DOTS_PER_SCANLINE - 1;
+  }
+  return DOTS_PER_SCANLINE;
+}
+
+u64 PPU::GetDotsUntil(u16 scanline, u16 dot) const {
+  const u64 here = u64{scanline_idx} * DOTS_PER_SCANLINE + scanline_cycle;
+  const u64 there = u64{scanline} * DOTS_PER_SCANLINE + dot;
+  if (there > here) {
+    return there - here;
+  }
+  // Over the end of the frame, the pre-render scanline may be a dot short
+  const bool short_frame = region == Region::NTSC && odd_frame &&
+                           IsRenderingEnabled();
+  return u64{GetScanlineCount()} * DOTS_PER_SCANLINE - (short_frame ? 1 : 0) +
+         there - here;
+}
+
+bool PPU::IsClockingScanlines() const {
+  return cartridge != nullptr && cartridge->HasScanlineCounter() &&
+         IsRenderingEnabled();
+}
+
+void PPU::RunEvents() {
+  if (scanline_cycle == VBLANK_DOT) {
+    if (scanline_idx == VBLANK_SCANLINE) {
+      registers.ppu_status |= PPU_STATUS_VBLANK_STARTED_MASK;
+      ++frame_count;
+      if ((registers.ppu_control & PPU_CTRL_NMI_ENABLE_MASK) != 0 &&
+          cpu != nullptr) {
+        cpu->SignalNMI();
+      }
+    } else if (scanline_idx == GetPreRenderScanline()) {
+      registers.ppu_status &= ~PPU_STATUS_FRAME_FLAGS_MASK;
+    }
+  } else if (scanline_cycle == SCANLINE_CLOCK_DOT && IsClockingScanlines() &&
+             (scanline_idx < VISIBLE_SCANLINES ||
+              scanline_idx == GetPreRenderScanline())) {
+    cartridge->ClockScanline();
   }
 }
 
-void PPU::Step() { UpdateRenderingToggle(); }
+void PPU::SaveSnapshot(Snapshot &snapshot) const {
+  snapshot.internal_registers = internal_registers;
+  snapshot.registers = registers;
+  snapshot.ppu_data_buffer = ppu_data_buffer;
+  std::ranges::copy_n(palette_ram.GetData(), PaletteRAM::GetSize(),
+                      snapshot.palette.begin());
+  std::ranges::copy_n(oam.GetData(), ObjectAttributeMemory::GetSize(),
+                      snapshot.oam.begin());
+  snapshot.scanline_idx = scanline_idx;
+  snapshot.scanline_cycle = scanline_cycle;
+  snapshot.odd_frame = odd_frame;
+  snapshot.dot_count = dot_count;
+  snapshot.frame_count = frame_count;
+  snapshot.region_cpu_cycles = region_cpu_cycles;
+  snapshot.region_dot_count = region_dot_count;
+  snapshot.rendering_toggle_scheduled = rendering_toggle_scheduled;
+  snapshot.rendering_toggle_cycles_to_wait = rendering_toggle_cycles_to_wait;
+  snapshot.new_rendering_flags = new_rendering_flags;
+}
+
+void PPU::LoadSnapshot(const Snapshot &snapshot) {
+  internal_registers = snapshot.internal_registers;
+  registers = snapshot.registers;
+  ppu_data_buffer = snapshot.ppu_data_buffer;
+  palette_ram.Initialize(snapshot.palette);
+  oam.Initialize(snapshot.oam);
+  scanline_idx = snapshot.scanline_idx;
+  scanline_cycle = snapshot.scanline_cycle;
+  odd_frame = snapshot.odd_frame;
+  dot_count = snapshot.dot_count;
+  frame_count = snapshot.frame_count;
+  region_cpu_cycles = snapshot.region_cpu_cycles;
+  region_dot_count = snapshot.region_dot_count;
+  rendering_toggle_scheduled = snapshot.rendering_toggle_scheduled;
+  rendering_toggle_cycles_to_wait = snapshot.rendering_toggle_cycles_to_wait;
+  new_rendering_flags = snapshot.new_rendering_flags;
+}
 
 void PPU::ScheduleRenderingToggle(u8 new_rendering_flags, int cycles_to_wait) {
   rendering_toggle_scheduled = true;
   rendering_toggle_cycles_to_wait = cycles_to_wait;
   this->new_rendering_flags = new_rendering_flags;
+  // The toggle is an event the CPU burst that wrote PPUMASK did not stop for
+  if (cpu != nullptr) {
+    cpu->RequestExit();
+  }
 }
 
 u8 PPU::BusReadMappedRegister(u8 address) {
+  CatchUp();
   switch (address) {
     case 2:
       return ReadPPUSTATUS();
@@ -61,6 +240,7 @@ u8 PPU::BusReadMappedRegister(u8 address) {
 }
 
 void PPU::BusWriteMappedRegister(u8 address, u8 value) {
+  CatchUp();
   switch (address) {
     case 0:
       WritePPUCONTROL(value);
@@ -72,6 +252,9 @@ void PPU::BusWriteMappedRegister(u8 address, u8 value) {
       registers.oam_address = value;
       break;
     case 4:
+      // OAMADDR advances with every write
+      oam.Write(registers.oam_address, value);
+      ++registers.oam_address;
       registers.oam_data = value;
       break;
     case 5:
@@ -89,13 +272,25 @@ void PPU::BusWriteMappedRegister(u8 address, u8 value) {
   }
 }
 
+void PPU::BusWriteOAMDMA(const u8 *data) {
+  // Same as 256 writes to OAMDATA: starts at OAMADDR, wraps around and leaves
+  // OAMADDR where it was
+  CatchUp();
+  constexpr size_t OAM_SIZE = ObjectAttributeMemory::GetSize();
+  const size_t first = registers.oam_address;
+  std::copy_n(data, OAM_SIZE - first, oam.GetData() + first);
+  std::copy_n(data + OAM_SIZE - first, first, oam.GetData());
+  registers.oam_data = data[OAM_SIZE - 1];
+}
+
 bool PPU::IsRenderingEnabled() const {
   return (registers.ppu_mask &
           (PPU_MASK_SHOW_BACKGROUND | PPU_MASK_SHOW_SPRITES)) != 0;
 }
 
 bool PPU::IsRenderingActive() const {
-  return IsRenderingEnabled() && (scanline_idx < 240 || scanline_idx == 261);
+  return IsRenderingEnabled() && (scanline_idx < VISIBLE_SCANLINES ||
+                                  scanline_idx == GetPreRenderScanline());
 }
 
 u8 PPU::ReadPPUSTATUS() {
@@ -123,14 +318,13 @@ u8 PPU::ReadPPUDATA() {
     // would need to have pointer to ppu, while the ppu needs pointer to bus,
     // which makes it a bit akward)
 
-    // bit-and with 0x1F to get the index into the palette RAM - mirroring
-    result = palette_ram[address & 0x1F];
+    // PaletteRAM masks the address with 0x1F - mirroring
+    result = palette_ram.Read(address);
     // even if this was a palette read we still need to read from the bus
     address -= 0x1000;
   }
 
-  ppu_bus->SetAddress(address);
-  ppu_data_buffer = ppu_bus->Read();
+  ppu_data_buffer = ppu_bus->Read(address);
 
   IncrementVRAMAddress();
 
@@ -138,6 +332,12 @@ u8 PPU::ReadPPUDATA() {
 }
 
 void PPU::WritePPUCONTROL(u8 value) {
+  // Enabling NMI during vblank raises it right away
+  if ((value & ~registers.ppu_control & PPU_CTRL_NMI_ENABLE_MASK) != 0 &&
+      (registers.ppu_status & PPU_STATUS_VBLANK_STARTED_MASK) != 0 &&
+      cpu != nullptr) {
+    cpu->SignalNMI();
+  }
   registers.ppu_control = value;
   internal_registers.temp_vram_address =
       (internal_registers.temp_vram_address &
@@ -223,11 +423,10 @@ void PPU::WritePPUDATA(u8 value) {
   u16 address = internal_registers.current_vram_address & PPU_16_BIT_MASK;
   if (address > 0x3F00) {
     // internal palette write
-    palette_ram[address & 0x1F] = value;
+    palette_ram.Write(address, value);
   } else {
     // name/pattern table write
-    ppu_bus->SetAddress(address);
-    ppu_bus->Write(value);
+    ppu_bus->Write(address, value);
   }
   IncrementVRAMAddress();
 }
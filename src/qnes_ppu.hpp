@@ -1,16 +1,35 @@
 #pragma once
 
+#include <array>
+
 #include "qnes_c.hpp"
 #include "qnes_framebuffer.hpp"
+#include "qnes_memory.hpp"
+#include "qnes_timing.hpp"
 
 namespace QNes {
 
-class Bus;
 class NESBus;
-
+class PPUBus;
+class CPUCore;
+class Cartridge;
+
+/**
+ * @brief Picture processing unit
+ * @details The PPU runs in bursts of dots (Run) instead of one dot at a time.
+ * A burst stops only at the dots where something the CPU can see happens:
+ * vblank starts (the frame ends, NMI) or ends, the mapper scanline counter is
+ * clocked or a PPUMASK write toggles rendering. GetDotsToNextEvent tells the
+ * scheduler (see Emulator) how far the CPU can run before the PPU has to catch
+ * up, register accesses catch the PPU up to the CPU first (CatchUp).
+ */
 class PPU {
  public:
-  PPU(Bus *ppu_bus, FrameBuffer *external_framebuffer)
+  static constexpr u16 DOTS_PER_SCANLINE = 341;
+  static constexpr u16 VISIBLE_SCANLINES = 240;
+  static constexpr u16 VBLANK_SCANLINE = 241;
+
+  PPU(PPUBus *ppu_bus, FrameBuffer *external_framebuffer)
       : ppu_bus(ppu_bus), external_framebuffer(external_framebuffer) {};
   PPU(const PPU &) = delete;
   PPU &operator=(const PPU &) = delete;
@@ -18,7 +37,35 @@ class PPU {
   PPU &operator=(PPU &&) = delete;
   ~PPU() = default;
 
-  void Step();
+  // CPU that gets the NMI and whose cycle count CatchUp follows, without one
+  // the PPU only runs when Run is called
+  void ConnectCPU(CPUCore *cpu) { this->cpu = cpu; }
+  // Cartridge whose scanline counter is clocked on rendered scanlines,
+  // nullptr for none
+  void ConnectCartridge(Cartridge *cartridge) { this->cartridge = cartridge; }
+  // The dots run so far keep the clock ratio of the old region, the new one
+  // counts from the CPU cycle of the switch
+  void SetRegion(Region region);
+  [[nodiscard]] Region GetRegion() const { return region; }
+
+  // One dot
+  void Step() { Run(1); }
+  void Run(u64 dots);
+  // Runs the dots the PPU is behind the connected CPU
+  void CatchUp();
+  // Dots until the next event the CPU can see, at least 1
+  [[nodiscard]] u64 GetDotsToNextEvent() const;
+  // Dots completed after cpu_cycles cycles of the connected CPU
+  [[nodiscard]] u64 GetDotCountAt(u64 cpu_cycles) const;
+  // First CPU cycle count after which dots dots have completed
+  [[nodiscard]] u64 GetCPUCycleCountAt(u64 dots) const;
+
+  // Dots run since power-on
+  [[nodiscard]] u64 GetDotCount() const { return dot_count; }
+  // Frames completed since power-on, a frame ends when vblank starts
+  [[nodiscard]] u64 GetFrameCount() const { return frame_count; }
+  [[nodiscard]] u16 GetScanline() const { return scanline_idx; }
+  [[nodiscard]] u16 GetScanlineCycle() const { return scanline_cycle; }
 
   struct InternalRegisters {
     u16 current_vram_address : 15;
@@ -38,26 +85,75 @@ class PPU {
     u8 ppu_data;
   };
 
+  // Everything of the PPU that changes while it runs, without pointers (see
+  // Emulator::SaveState)
+  struct Snapshot {
+    InternalRegisters internal_registers;
+    Registers registers;
+    u8 ppu_data_buffer;
+    std::array<u8, PaletteRAM::GetSize()> palette;
+    std::array<u8, ObjectAttributeMemory::GetSize()> oam;
+    u16 scanline_idx;
+    u16 scanline_cycle;
+    bool odd_frame;
+    u64 dot_count;
+    u64 frame_count;
+    u64 region_cpu_cycles;
+    u64 region_dot_count;
+    bool rendering_toggle_scheduled;
+    int rendering_toggle_cycles_to_wait;
+    u8 new_rendering_flags;
+  };
+
+  void SaveSnapshot(Snapshot &snapshot) const;
+  void LoadSnapshot(const Snapshot &snapshot);
+
  private:
   u8 ppu_data_buffer = 0;
 
-  u8 palette_ram[32];
+  PaletteRAM palette_ram;
+  ObjectAttributeMemory oam;
 
-  InternalRegisters internal_registers;
-  Registers registers;
+  InternalRegisters internal_registers{};
+  Registers registers{};
   u16 scanline_idx = 0;
   u16 scanline_cycle = 0;
+  bool odd_frame = false;
+  u64 dot_count = 0;
+  u64 frame_count = 0;
+  // CPU cycles and dots at the last region switch, the clock ratio of the
+  // region applies from there
+  u64 region_cpu_cycles = 0;
+  u64 region_dot_count = 0;
 
   bool rendering_toggle_scheduled = false;
   int rendering_toggle_cycles_to_wait = 0;
   u8 new_rendering_flags = 0;
   void ScheduleRenderingToggle(u8 new_rendering_flags, int cycles_to_wait);
-  void UpdateRenderingToggle();
+  // dots is at most the dots to the toggle
+  void UpdateRenderingToggle(u64 dots);
+
+  [[nodiscard]] u16 GetScanlineCount() const {
+    return region == Region::PAL ? 312 : 262;
+  }
+  [[nodiscard]] u16 GetPreRenderScanline() const {
+    return GetScanlineCount() - 1;
+  }
+  // Dots of the current scanline
+  [[nodiscard]] u16 GetScanlineLength() const;
+  // Dots from the current position to dot of scanline, a whole frame when it
+  // is the current position
+  [[nodiscard]] u64 GetDotsUntil(u16 scanline, u16 dot) const;
+  [[nodiscard]] bool IsClockingScanlines() const;
+  // Vblank, NMI and the scanline counter at the dot the PPU arrived at
+  void RunEvents();
 
   // Method for reading PPU registers trough the external NES bus
   [[nodiscard]] u8 BusReadMappedRegister(u8 address);
   // Method for writing PPU registers trough the external NES bus
   void BusWriteMappedRegister(u8 address, u8 value);
+  // OAM DMA, the 256 bytes of data are written to OAMDATA
+  void BusWriteOAMDMA(const u8 *data);
 
   [[nodiscard]] bool IsRenderingEnabled() const;
   [[nodiscard]] bool IsRenderingActive() const;
@@ -76,8 +172,11 @@ class PPU {
   void VRAMIncrementCoarseX();
   void VRAMIncrementFineY();
 
-  Bus *ppu_bus = nullptr;
+  PPUBus *ppu_bus = nullptr;
   FrameBuffer *external_framebuffer = nullptr;
+  CPUCore *cpu = nullptr;
+  Cartridge *cartridge = nullptr;
+  Region region = Region::NTSC;
 
   friend class NESBus;
   friend struct PPU_Testing;
@@ -96,6 +195,7 @@ struct PPU_Testing {
   static void SetVRAMAddress(PPU &ppu, u16 value) {
     ppu.internal_registers.current_vram_address = value;
   }
+  static ObjectAttributeMemory &GetOAM(PPU &ppu) { return ppu.oam; }
 };
 
 }  // namespace QNes
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "qnes_profiler.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace QNes {
+
+namespace {
+
+const char *ModeName(AddressingMode mode) {
+  switch (mode) {
+    case AddressingMode::Implied:
+      return "Implied";
+    case AddressingMode::Immediate:
+      return "Immediate";
+    case AddressingMode::ZeroPage:
+      return "ZeroPage";
+    case AddressingMode::ZeroPageX:
+      return "ZeroPageX";
+    case AddressingMode::ZeroPageY:
+      return "ZeroPageY";
+    case AddressingMode::Absolute:
+      return "Absolute";
+    case AddressingMode::AbsoluteX:
+      return "AbsoluteX";
+    case AddressingMode::AbsoluteY:
+      return "AbsoluteY";
+    case AddressingMode::Indirect:
+      return "Indirect";
+    case AddressingMode::XIndirect:
+      return "XIndirect";
+    case AddressingMode::IndirectY:
+      return "IndirectY";
+    case AddressingMode::Relative:
+      return "Relative";
+  }
+  return "Unknown";
+}
+
+// Calls visit(key, counter) for the non-zero entries of every table
+template <typename COUNTERS, typename KEY, typename VISIT>
+void ForEachEntry(const COUNTERS &counters, KEY key, VISIT visit) {
+  for (size_t i = 0; i < counters.size(); ++i) {
+    if (counters[i].count != 0) {
+      visit(key(i), counters[i]);
+    }
+  }
+}
+
+std::string HexKey(size_t value, int digits) {
+  char key[8];
+  std::snprintf(key, sizeof(key), "0x%0*zX", digits, value);
+  return key;
+}
+std::string OpcodeKey(size_t opcode) { return HexKey(opcode, 2); }
+std::string PCKey(size_t pc) { return HexKey(pc, 4); }
+std::string ModeKey(size_t mode) {
+  return ModeName(static_cast<AddressingMode>(mode));
+}
+
+}  // namespace
+
+void Profiler::Clear() {
+  by_opcode.fill({});
+  by_pc.fill({});
+  by_mode.fill({});
+  pending = false;
+}
+
+void Profiler::WriteCSV(std::ostream &out) const {
+  out << "table,key,count,cycles\n";
+  const auto row = [&out](const char *table) {
+    return [&out, table](const std::string &key, const Counter &counter) {
+      out << table << ',' << key << ',' << counter.count << ','
+          << counter.cycles << '\n';
+    };
+  };
+  ForEachEntry(by_opcode, OpcodeKey, row("opcode"));
+  ForEachEntry(by_pc, PCKey, row("pc"));
+  ForEachEntry(by_mode, ModeKey, row("mode"));
+}
+
+void Profiler::WriteJSON(std::ostream &out) const {
+  const auto table = [&out](const char *name, const char *key_name,
+                            const auto &counters, auto key) {
+    out << '"' << name << "\": [";
+    bool first = true;
+    ForEachEntry(counters, key,
+                 [&](const std::string &key_value, const Counter &counter) {
+                   out << (first ? "\n" : ",\n") << "  {\"" << key_name
+                       << "\": \"" << key_value
+                       << "\", \"count\": " << counter.count
+                       << ", \"cycles\": " << counter.cycles << '}';
+                   first = false;
+                 });
+    out << (first ? "]" : "\n]");
+  };
+  out << "{\n";
+  table("opcodes", "opcode", by_opcode, OpcodeKey);
+  out << ",\n";
+  table("pcs", "pc", by_pc, PCKey);
+  out << ",\n";
+  table("modes", "mode", by_mode, ModeKey);
+  out << "\n}\n";
+}
+
+}  // namespace QNes
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <ostream>
+
+#include "cpu_isa.hpp"
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+/**
+ * @brief Guest code profile of a CPU
+ * @details Counts executed instructions and the cycles they took per opcode,
+ * per address of the opcode and per addressing mode, in flat arrays indexed by
+ * the opcode, the PC and the AddressingMode. Interrupt sequences and idle loop
+ * iterations skipped by RunUntil are not attributed to any instruction.
+ *
+ * While a profiler is enabled, BasicCPU runs whole instructions with the
+ * ExecuteInstruction<true> instantiation and does not use the threaded or JIT
+ * dispatch, which do not see single instructions. Without one, the only cost
+ * left is a null check per StepInstruction, RunInstructions and Step call.
+ */
+class Profiler {
+ public:
+  static constexpr size_t MODE_COUNT =
+      static_cast<size_t>(AddressingMode::Relative) + 1;
+
+  struct Counter {
+    u64 count = 0;   // executed instructions
+    u64 cycles = 0;  // cycles of those instructions
+  };
+
+  Profiler() = default;
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+  Profiler(Profiler &&) = delete;
+  Profiler &operator=(Profiler &&) = delete;
+  ~Profiler() = default;
+
+  void Record(u16 pc, u8 opcode, u64 cycles) {
+    Add(by_opcode[opcode], cycles);
+    Add(by_pc[pc], cycles);
+    Add(by_mode[static_cast<size_t>(InstructionInfoTable[opcode].mode)],
+        cycles);
+  }
+
+  // The cycle stepped path (Step) learns the length of an instruction only
+  // when its last cycle has run
+  void BeginInstruction(u16 pc, u8 opcode, u64 start_cycle) {
+    pending_pc = pc;
+    pending_opcode = opcode;
+    pending_start_cycle = start_cycle;
+    pending = true;
+  }
+  void EndInstruction(u64 end_cycle) {
+    if (pending) {
+      pending = false;
+      Record(pending_pc, pending_opcode, end_cycle - pending_start_cycle);
+    }
+  }
+
+  [[nodiscard]] const Counter &GetOpcode(u8 opcode) const {
+    return by_opcode[opcode];
+  }
+  [[nodiscard]] const Counter &GetPC(u16 pc) const { return by_pc[pc]; }
+  [[nodiscard]] const Counter &GetMode(AddressingMode mode) const {
+    return by_mode[static_cast<size_t>(mode)];
+  }
+
+  void Clear();
+
+  // Non-zero entries as "table,key,count,cycles" rows, keys are hex opcodes,
+  // hex addresses and addressing mode names
+  void WriteCSV(std::ostream &out) const;
+  // {"opcodes": [...], "pcs": [...], "modes": [...]} with the same entries
+  void WriteJSON(std::ostream &out) const;
+
+ private:
+  static void Add(Counter &counter, u64 cycles) {
+    ++counter.count;
+    counter.cycles += cycles;
+  }
+
+  std::array<Counter, 0x100> by_opcode{};
+  std::array<Counter, 0x10000> by_pc{};
+  std::array<Counter, MODE_COUNT> by_mode{};
+
+  u64 pending_start_cycle = 0;
+  u16 pending_pc = 0;
+  u8 pending_opcode = 0;
+  bool pending = false;
+};
+
+using ProfilerPtr = std::unique_ptr<Profiler>;
+
+}  // namespace QNes
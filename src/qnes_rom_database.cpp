@@ -0,0 +1,635 @@
+#include "qnes_rom_database.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QNES_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define QNES_HAS_MMAP 0
+#endif
+
+// Carry-less multiplication folds the CRC over 64 bytes at a time. The SSE4.2
+// crc32 instruction is no help here, it computes CRC-32C.
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#define QNES_HAS_PCLMUL_CRC 1
+#else
+#define QNES_HAS_PCLMUL_CRC 0
+#endif
+
+// SHA extensions, four rounds per instruction
+#if defined(__SHA__) && defined(__SSE4_1__)
+#define QNES_HAS_SHA_NI 1
+#else
+#define QNES_HAS_SHA_NI 0
+#endif
+
+#if QNES_HAS_PCLMUL_CRC || QNES_HAS_SHA_NI
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace QNes {
+
+namespace {
+
+// Reflected IEEE polynomial
+constexpr u32 CRC_POLYNOMIAL = 0xEDB88320;
+
+// Table i advances the CRC of a byte by i more zero bytes (slicing-by-8)
+constexpr std::array<std::array<u32, 256>, 8> MakeCrcTables() {
+  std::array<std::array<u32, 256>, 8> tables{};
+  for (u32 byte = 0; byte < 256; ++byte) {
+    u32 crc = byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC_POLYNOMIAL : crc >> 1;
+    }
+    tables[0][byte] = crc;
+  }
+  for (u32 byte = 0; byte < 256; ++byte) {
+    for (size_t table = 1; table < tables.size(); ++table) {
+      const u32 previous = tables[table - 1][byte];
+      tables[table][byte] = (previous >> 8) ^ tables[0][previous & 0xFF];
+    }
+  }
+  return tables;
+}
+
+constexpr auto CRC_TABLES = MakeCrcTables();
+
+u32 LoadLittle32(const u8 *bytes) {
+  return bytes[0] | (u32{bytes[1]} << 8) | (u32{bytes[2]} << 16) |
+         (u32{bytes[3]} << 24);
+}
+
+u32 LoadBig32(const u8 *bytes) {
+  return (u32{bytes[0]} << 24) | (u32{bytes[1]} << 16) |
+         (u32{bytes[2]} << 8) | bytes[3];
+}
+
+// crc is the running (inverted) CRC
+u32 Crc32Table(const u8 *bytes, size_t size, u32 crc) {
+  const auto &t = CRC_TABLES;
+  for (; size >= 8; bytes += 8, size -= 8) {
+    const u32 low = LoadLittle32(bytes) ^ crc;
+    const u32 high = LoadLittle32(bytes + 4);
+    crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+          t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^ t[3][high & 0xFF] ^
+          t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^
+          t[0][high >> 24];
+  }
+  for (; size != 0; ++bytes, --size) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xFF];
+  }
+  return crc;
+}
+
+#if QNES_HAS_PCLMUL_CRC
+// Folds four 128 bit lanes over the data and reduces them to the CRC
+// (Gopal et al., "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction"). size is at least 64 and a multiple of 16, crc is the running
+// (inverted) CRC.
+u32 Crc32Fold(const u8 *bytes, size_t size, u32 crc) {
+  // x^(4*128+64) mod P, x^(4*128) mod P, then the same for a 128 bit fold
+  const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+  const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+  // P and the Barrett constant
+  const __m128i poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  const auto load = [](const u8 *at) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+  };
+  const auto fold = [](__m128i lane, __m128i k, __m128i data) {
+    const __m128i low = _mm_clmulepi64_si128(lane, k, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(lane, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, low), data);
+  };
+
+  __m128i x1 = _mm_xor_si128(load(bytes),
+                             _mm_cvtsi32_si128(static_cast<int>(crc)));
+  __m128i x2 = load(bytes + 16);
+  __m128i x3 = load(bytes + 32);
+  __m128i x4 = load(bytes + 48);
+  bytes += 64;
+  size -= 64;
+  for (; size >= 64; bytes += 64, size -= 64) {
+    x1 = fold(x1, k1k2, load(bytes));
+    x2 = fold(x2, k1k2, load(bytes + 16));
+    x3 = fold(x3, k1k2, load(bytes + 32));
+    x4 = fold(x4, k1k2, load(bytes + 48));
+  }
+
+  x1 = fold(x1, k3k4, x2);
+  x1 = fold(x1, k3k4, x3);
+  x1 = fold(x1, k3k4, x4);
+  for (; size >= 16; bytes += 16, size -= 16) {
+    x1 = fold(x1, k3k4, load(bytes));
+  }
+
+  // 128 bits to 64
+  __m128i shifted = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), shifted);
+  shifted = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5, 0x00), shifted);
+
+  // Barrett reduction to 32 bits
+  __m128i reduced = _mm_and_si128(x1, mask32);
+  reduced = _mm_clmulepi64_si128(reduced, poly, 0x10);
+  reduced = _mm_and_si128(reduced, mask32);
+  reduced = _mm_clmulepi64_si128(reduced, poly, 0x00);
+  x1 = _mm_xor_si128(x1, reduced);
+  return static_cast<u32>(_mm_extract_epi32(x1, 1));
+}
+#endif
+
+using Sha1State = std::array<u32, 5>;
+
+void Sha1CompressScalar(Sha1State &state, const u8 *blocks, size_t count) {
+  for (; count != 0; --count, blocks += Sha1::BLOCK_SIZE) {
+    // The message schedule is kept as a ring of the last 16 words
+    std::array<u32, 16> w;
+    for (size_t i = 0; i < w.size(); ++i) {
+      w[i] = LoadBig32(blocks + i * 4);
+    }
+    u32 a = state[0];
+    u32 b = state[1];
+    u32 c = state[2];
+    u32 d = state[3];
+    u32 e = state[4];
+    const auto round = [&](u32 index, u32 f, u32 k) {
+      if (index >= 16) {
+        w[index & 15] = std::rotl(w[(index + 13) & 15] ^ w[(index + 8) & 15] ^
+                                      w[(index + 2) & 15] ^ w[index & 15],
+                                  1);
+      }
+      const u32 temp = std::rotl(a, 5) + f + e + k + w[index & 15];
+      e = d;
+      d = c;
+      c = std::rotl(b, 30);
+      b = a;
+      a = temp;
+    };
+    u32 index = 0;
+    for (; index < 20; ++index) {
+      round(index, d ^ (b & (c ^ d)), 0x5A827999);
+    }
+    for (; index < 40; ++index) {
+      round(index, b ^ c ^ d, 0x6ED9EBA1);
+    }
+    for (; index < 60; ++index) {
+      round(index, (b & c) | (d & (b | c)), 0x8F1BBCDC);
+    }
+    for (; index < 80; ++index) {
+      round(index, b ^ c ^ d, 0xCA62C1D6);
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+  }
+}
+
+#if QNES_HAS_SHA_NI
+// Four rounds of a block. The E values alternate between e[0] and e[1], the
+// message schedule runs three groups ahead in msg.
+template <int GROUP>
+QNES_FORCE_INLINE void Sha1Group(__m128i &abcd, __m128i (&e)[2],
+                                 __m128i (&msg)[4]) {
+  constexpr int FUNCTION = GROUP / 5;
+  constexpr int CURRENT = GROUP % 4;
+  __m128i &round_e = e[GROUP % 2];
+  if constexpr (GROUP == 0) {
+    round_e = _mm_add_epi32(round_e, msg[CURRENT]);
+  } else {
+    round_e = _mm_sha1nexte_epu32(round_e, msg[CURRENT]);
+  }
+  e[(GROUP + 1) % 2] = abcd;
+  if constexpr (GROUP >= 3 && GROUP <= 18) {
+    msg[(GROUP + 1) % 4] =
+        _mm_sha1msg2_epu32(msg[(GROUP + 1) % 4], msg[CURRENT]);
+  }
+  abcd = _mm_sha1rnds4_epu32(abcd, round_e, FUNCTION);
+  if constexpr (GROUP >= 1 && GROUP <= 16) {
+    msg[(GROUP + 3) % 4] =
+        _mm_sha1msg1_epu32(msg[(GROUP + 3) % 4], msg[CURRENT]);
+  }
+  if constexpr (GROUP >= 2 && GROUP <= 17) {
+    msg[(GROUP + 2) % 4] = _mm_xor_si128(msg[(GROUP + 2) % 4], msg[CURRENT]);
+  }
+}
+
+void Sha1CompressSHANI(Sha1State &state, const u8 *blocks, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  // Message words are big endian
+  const __m128i byte_swap =
+      _mm_set_epi64x(0x0001020304050607, 0x08090A0B0C0D0E0F);
+  __m128i abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(state.data())), 0x1B);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+  for (; count != 0; --count, blocks += Sha1::BLOCK_SIZE) {
+    const __m128i abcd_saved = abcd;
+    const __m128i e0_saved = e0;
+    __m128i msg[4];
+    for (size_t i = 0; i < 4; ++i) {
+      msg[i] = _mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + i * 16)),
+          byte_swap);
+    }
+    __m128i e[2] = {e0, _mm_setzero_si128()};
+    [&]<int... GROUPS>(std::integer_sequence<int, GROUPS...>) {
+      (Sha1Group<GROUPS>(abcd, e, msg), ...);
+    }(std::make_integer_sequence<int, 20>{});
+    e0 = _mm_sha1nexte_epu32(e[0], e0_saved);
+    abcd = _mm_add_epi32(abcd, abcd_saved);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(state.data()),
+                   _mm_shuffle_epi32(abcd, 0x1B));
+  state[4] = static_cast<u32>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+void Sha1Compress(Sha1State &state, const u8 *blocks, size_t count) {
+#if QNES_HAS_SHA_NI
+  Sha1CompressSHANI(state, blocks, count);
+#else
+  Sha1CompressScalar(state, blocks, count);
+#endif
+}
+
+// Index file: IndexHeader, then count records sorted by CRC-32 and SHA-1, in
+// host byte order
+struct IndexHeader {
+  std::array<char, 8> magic;
+  u32 version;
+  u32 count;
+};
+
+constexpr std::array<char, 8> INDEX_MAGIC = {'Q', 'N', 'E', 'S',
+                                             'R', 'D', 'B', 0};
+constexpr u32 INDEX_VERSION = 1;
+
+// Hash cache file: CacheHeader, then count entries of a CacheRecord followed
+// by the path
+struct CacheHeader {
+  std::array<char, 8> magic;
+  u32 version;
+  u32 count;
+};
+
+struct CacheRecord {
+  i64 modified;
+  u64 size;
+  u32 crc32;
+  u32 path_size;
+  Sha1::Digest sha1;
+  std::array<u8, 4> reserved;
+};
+
+constexpr std::array<char, 8> CACHE_MAGIC = {'Q', 'N', 'E', 'S',
+                                             'R', 'H', 'C', 0};
+constexpr u32 CACHE_VERSION = 1;
+// Longer paths than PATH_MAX on Linux mean the file is damaged
+constexpr u32 MAX_CACHE_PATH_SIZE = 4096;
+
+// Modification time and size of a file, false when it cannot be read
+bool GetFileStamp(const std::string &path, i64 &modified, u64 &size) {
+  std::error_code error;
+  const auto time = std::filesystem::last_write_time(path, error);
+  if (error) {
+    return false;
+  }
+  size = std::filesystem::file_size(path, error);
+  modified = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 time.time_since_epoch())
+                 .count();
+  return !error;
+}
+
+}  // namespace
+
+struct RomDatabase::Record {
+  u32 crc32;
+  Sha1::Digest sha1;
+  u16 mapper;
+  u8 submapper;
+  Mirroring mirroring;
+  u8 battery;
+  u8 reserved[3];
+  u32 prg_ram_size;
+  u32 prg_nvram_size;
+  u32 chr_ram_size;
+  u32 chr_nvram_size;
+};
+
+static_assert(sizeof(IndexHeader) == 16);
+static_assert(std::is_trivially_copyable_v<IndexHeader>);
+static_assert(std::is_trivially_copyable_v<CacheRecord>);
+
+u32 Crc32(std::span<const u8> data, u32 crc) {
+  const u8 *bytes = data.data();
+  size_t size = data.size();
+  crc = ~crc;
+#if QNES_HAS_PCLMUL_CRC
+  if (size >= 64) {
+    const size_t folded = size & ~size_t{15};
+    crc = Crc32Fold(bytes, folded, crc);
+    bytes += folded;
+    size -= folded;
+  }
+#endif
+  return ~Crc32Table(bytes, size, crc);
+}
+
+void Sha1::Update(std::span<const u8> data) {
+  const size_t buffered = length % BLOCK_SIZE;
+  length += data.size();
+  if (buffered != 0) {
+    const size_t taken = std::min(BLOCK_SIZE - buffered, data.size());
+    std::copy_n(data.begin(), taken, buffer.begin() + buffered);
+    data = data.subspan(taken);
+    if (buffered + taken < BLOCK_SIZE) {
+      return;
+    }
+    Sha1Compress(state, buffer.data(), 1);
+  }
+  // Whole blocks are compressed in place
+  const size_t blocks = data.size() / BLOCK_SIZE;
+  Sha1Compress(state, data.data(), blocks);
+  std::ranges::copy(data.subspan(blocks * BLOCK_SIZE), buffer.begin());
+}
+
+Sha1::Digest Sha1::Finish() {
+  const u64 bits = length * 8;
+  // 0x80, zeros up to 8 bytes before a block end, the length in bits
+  std::array<u8, BLOCK_SIZE + 8> padding{0x80};
+  const size_t buffered = length % BLOCK_SIZE;
+  const size_t end = buffered < BLOCK_SIZE - 8 ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+  size_t padding_size = end - 8 - buffered;
+  for (int i = 0; i < 8; ++i) {
+    padding[padding_size++] = static_cast<u8>(bits >> (56 - i * 8));
+  }
+  Update({padding.data(), padding_size});
+
+  Digest digest;
+  for (size_t i = 0; i < state.size(); ++i) {
+    for (size_t byte = 0; byte < 4; ++byte) {
+      digest[i * 4 + byte] = static_cast<u8>(state[i] >> (24 - byte * 8));
+    }
+  }
+  return digest;
+}
+
+RomHashes HashRom(const RomImage &image) {
+  // Both hashes run over the same chunk while it is in the cache
+  constexpr size_t CHUNK_SIZE = Kilobytes(32);
+  RomHashes hashes;
+  Sha1 sha1;
+  for (const std::span<const u8> rom : {image.GetPRGROM(), image.GetCHRROM()}) {
+    for (size_t offset = 0; offset < rom.size(); offset += CHUNK_SIZE) {
+      const auto chunk =
+          rom.subspan(offset, std::min(CHUNK_SIZE, rom.size() - offset));
+      hashes.crc32 = Crc32(chunk, hashes.crc32);
+      sha1.Update(chunk);
+    }
+  }
+  hashes.sha1 = sha1.Finish();
+  return hashes;
+}
+
+RomDatabase::~RomDatabase() {
+#if QNES_HAS_MMAP
+  if (data != nullptr && buffer == nullptr) {
+    munmap(const_cast<u8 *>(data), size);
+  }
+#endif
+}
+
+std::unique_ptr<RomDatabase> RomDatabase::Open(const std::string &path) {
+  static_assert(sizeof(Record) == 48, "Index records are not packed");
+  std::unique_ptr<RomDatabase> database(new RomDatabase());
+#if QNES_HAS_MMAP
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(IndexHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  database->size = static_cast<size_t>(file_stat.st_size);
+  void *mapping =
+      mmap(nullptr, database->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  database->data = static_cast<const u8 *>(mapping);
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  database->size = static_cast<size_t>(file.tellg());
+  database->buffer = std::make_unique<u8[]>(database->size);
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char *>(database->buffer.get()),
+                 static_cast<std::streamsize>(database->size))) {
+    return nullptr;
+  }
+  database->data = database->buffer.get();
+#endif
+
+  IndexHeader header{};
+  if (database->size < sizeof(header)) {
+    return nullptr;
+  }
+  std::copy_n(database->data, sizeof(header),
+              reinterpret_cast<u8 *>(&header));
+  if (header.magic != INDEX_MAGIC || header.version != INDEX_VERSION ||
+      database->size !=
+          sizeof(header) + u64{header.count} * sizeof(Record)) {
+    return nullptr;
+  }
+  database->records =
+      reinterpret_cast<const Record *>(database->data + sizeof(header));
+  database->record_count = header.count;
+  return database;
+}
+
+bool RomDatabase::WriteIndex(const std::string &path,
+                             std::vector<Entry> entries) {
+  std::ranges::sort(entries, [](const Entry &lhs, const Entry &rhs) {
+    return std::tie(lhs.hashes.crc32, lhs.hashes.sha1) <
+           std::tie(rhs.hashes.crc32, rhs.hashes.sha1);
+  });
+  const IndexHeader header = {.magic = INDEX_MAGIC,
+                              .version = INDEX_VERSION,
+                              .count = static_cast<u32>(entries.size())};
+  std::vector<Record> records;
+  records.reserve(entries.size());
+  for (const Entry &entry : entries) {
+    records.push_back({.crc32 = entry.hashes.crc32,
+                       .sha1 = entry.hashes.sha1,
+                       .mapper = entry.header.mapper,
+                       .submapper = entry.header.submapper,
+                       .mirroring = entry.header.mirroring,
+                       .battery = entry.header.battery,
+                       .reserved = {},
+                       .prg_ram_size = entry.header.prg_ram_size,
+                       .prg_nvram_size = entry.header.prg_nvram_size,
+                       .chr_ram_size = entry.header.chr_ram_size,
+                       .chr_nvram_size = entry.header.chr_nvram_size});
+  }
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(records.data()),
+             static_cast<std::streamsize>(records.size() * sizeof(Record)));
+  return file.good();
+}
+
+std::optional<RomHeader> RomDatabase::Find(const RomHashes &hashes) const {
+  const std::span<const Record> index(records, record_count);
+  auto record = std::ranges::lower_bound(index, hashes.crc32, {},
+                                         &Record::crc32);
+  // CRC-32 collisions are told apart by the SHA-1
+  for (; record != index.end() && record->crc32 == hashes.crc32; ++record) {
+    if (record->sha1 != hashes.sha1) {
+      continue;
+    }
+    return RomHeader{.format = RomHeader::Format::NES2,
+                     .mapper = record->mapper,
+                     .submapper = record->submapper,
+                     .mirroring = record->mirroring,
+                     .battery = record->battery != 0,
+                     .prg_ram_size = record->prg_ram_size,
+                     .prg_nvram_size = record->prg_nvram_size,
+                     .chr_ram_size = record->chr_ram_size,
+                     .chr_nvram_size = record->chr_nvram_size};
+  }
+  return std::nullopt;
+}
+
+RomHeader RomDatabase::GetHeader(const RomImage &image,
+                                 const RomHashes &hashes) const {
+  const std::optional<RomHeader> known = Find(hashes);
+  if (!known.has_value()) {
+    return image.GetHeader();
+  }
+  // The layout of the file stays as it is
+  RomHeader header = *known;
+  header.trainer = image.GetHeader().trainer;
+  header.prg_rom_size = image.GetHeader().prg_rom_size;
+  header.chr_rom_size = image.GetHeader().chr_rom_size;
+  return header;
+}
+
+RomHashCache::RomHashCache(std::string path) : path(std::move(path)) {
+  std::ifstream file(this->path, std::ios::binary);
+  CacheHeader header{};
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+    return;
+  }
+  for (u32 i = 0; i < header.count; ++i) {
+    CacheRecord record{};
+    if (!file.read(reinterpret_cast<char *>(&record), sizeof(record)) ||
+        record.path_size > MAX_CACHE_PATH_SIZE) {
+      entries.clear();
+      return;
+    }
+    std::string rom_path(record.path_size, '\0');
+    if (!file.read(rom_path.data(), record.path_size)) {
+      entries.clear();
+      return;
+    }
+    entries[std::move(rom_path)] = {
+        .modified = record.modified,
+        .size = record.size,
+        .hashes = {.crc32 = record.crc32, .sha1 = record.sha1}};
+  }
+}
+
+RomHashes RomHashCache::Get(const std::string &rom_path,
+                            const RomImage &image) {
+  i64 modified = 0;
+  u64 size = 0;
+  const bool stamped = GetFileStamp(rom_path, modified, size);
+  if (stamped) {
+    const std::lock_guard lock(mutex);
+    const auto entry = entries.find(rom_path);
+    if (entry != entries.end() && entry->second.modified == modified &&
+        entry->second.size == size) {
+      return entry->second.hashes;
+    }
+  }
+
+  // Hashed without the lock, other threads keep hashing their files
+  const RomHashes hashes = HashRom(image);
+  if (stamped) {
+    const std::lock_guard lock(mutex);
+    entries[rom_path] = {.modified = modified, .size = size, .hashes = hashes};
+    dirty = true;
+  }
+  return hashes;
+}
+
+bool RomHashCache::Save() {
+  const std::lock_guard lock(mutex);
+  if (!dirty) {
+    return true;
+  }
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    const CacheHeader header = {.magic = CACHE_MAGIC,
+                                .version = CACHE_VERSION,
+                                .count = static_cast<u32>(entries.size())};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto &[rom_path, entry] : entries) {
+      const CacheRecord record = {
+          .modified = entry.modified,
+          .size = entry.size,
+          .crc32 = entry.hashes.crc32,
+          .path_size = static_cast<u32>(rom_path.size()),
+          .sha1 = entry.hashes.sha1,
+          .reserved = {}};
+      file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+      file.write(rom_path.data(),
+                 static_cast<std::streamsize>(rom_path.size()));
+    }
+    if (!file.good()) {
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    return false;
+  }
+  dirty = false;
+  return true;
+}
+
+size_t RomHashCache::GetSize() const {
+  const std::lock_guard lock(mutex);
+  return entries.size();
+}
+
+}  // namespace QNes
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+
+namespace QNes {
+
+// CRC-32 (IEEE 802.3, the one of zlib and the ROM databases) of data,
+// continuing from the CRC of the data before it
+[[nodiscard]] u32 Crc32(std::span<const u8> data, u32 crc = 0);
+
+/**
+ * @brief SHA-1 of a byte stream
+ * @details Update can be called any number of times, Finish returns the
+ * digest of everything passed to it. Builds for a host CPU with the SHA
+ * extensions (QNES_NATIVE_ARCH) compress with them.
+ */
+class Sha1 {
+ public:
+  static constexpr size_t BLOCK_SIZE = 64;
+  using Digest = std::array<u8, 20>;
+
+  void Update(std::span<const u8> data);
+  [[nodiscard]] Digest Finish();
+
+ private:
+  std::array<u32, 5> state = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                              0xC3D2E1F0};
+  std::array<u8, BLOCK_SIZE> buffer{};
+  u64 length = 0;  // bytes passed to Update
+};
+
+// Hashes the ROM databases identify dumps by: PRG-ROM followed by CHR-ROM,
+// without the header and the trainer
+struct RomHashes {
+  u32 crc32 = 0;
+  Sha1::Digest sha1{};
+
+  bool operator==(const RomHashes &) const = default;
+};
+
+[[nodiscard]] RomHashes HashRom(const RomImage &image);
+
+/**
+ * @brief Known good dumps by their hashes
+ * @details The index is a file of fixed size records sorted by CRC-32 that is
+ * mapped read-only into memory. Opening it reads nothing but the file header,
+ * a lookup is a binary search over the mapping, so any number of emulators
+ * and threads use one index without loading it. The CRC-32 finds the record,
+ * the SHA-1 confirms it.
+ *
+ * A record holds the board the dump needs, which replaces the header of the
+ * file: old dumps often have the wrong mirroring, no battery flag or garbage
+ * in the upper mapper nibble.
+ */
+class RomDatabase {
+ public:
+  struct Entry {
+    RomHashes hashes;
+    RomHeader header;  // the PRG-ROM/CHR-ROM sizes and trainer are unused
+  };
+
+  RomDatabase(const RomDatabase &) = delete;
+  RomDatabase &operator=(const RomDatabase &) = delete;
+  RomDatabase(RomDatabase &&) = delete;
+  RomDatabase &operator=(RomDatabase &&) = delete;
+  ~RomDatabase();
+
+  // nullptr when the file cannot be read or is not an index
+  [[nodiscard]] static std::unique_ptr<RomDatabase> Open(
+      const std::string &path);
+  // Sorts the entries and writes them as an index, false on I/O errors
+  static bool WriteIndex(const std::string &path, std::vector<Entry> entries);
+
+  [[nodiscard]] std::optional<RomHeader> Find(const RomHashes &hashes) const;
+  // The header to insert the image with: the one of the database when it
+  // knows the dump, otherwise the one of the file
+  [[nodiscard]] RomHeader GetHeader(const RomImage &image,
+                                    const RomHashes &hashes) const;
+  [[nodiscard]] size_t GetSize() const { return record_count; }
+
+ private:
+  struct Record;
+
+  RomDatabase() = default;
+
+  const u8 *data = nullptr;
+  size_t size = 0;
+  std::unique_ptr<u8[]> buffer;  // where there is no mmap, data points into it
+  const Record *records = nullptr;
+  size_t record_count = 0;
+};
+
+using RomDatabasePtr = std::unique_ptr<RomDatabase>;
+
+/**
+ * @brief Hashes of ROM files, kept across runs
+ * @details The hashes of a file are computed once and stored with its path,
+ * size and modification time, they are computed again only when the file
+ * changes. The cache is loaded from its file on construction and written back
+ * by Save. Get may be called from any number of threads.
+ */
+class RomHashCache {
+ public:
+  explicit RomHashCache(std::string path);
+  RomHashCache(const RomHashCache &) = delete;
+  RomHashCache &operator=(const RomHashCache &) = delete;
+  RomHashCache(RomHashCache &&) = delete;
+  RomHashCache &operator=(RomHashCache &&) = delete;
+  ~RomHashCache() = default;
+
+  // Hashes of image, which was opened from rom_path
+  [[nodiscard]] RomHashes Get(const std::string &rom_path,
+                              const RomImage &image);
+  // Writes the cache to its file if it changed, false on I/O errors. The
+  // file is replaced atomically.
+  bool Save();
+
+  [[nodiscard]] size_t GetSize() const;
+
+ private:
+  struct Entry {
+    i64 modified = 0;  // nanoseconds
+    u64 size = 0;
+    RomHashes hashes;
+  };
+
+  std::string path;
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  bool dirty = false;
+};
+
+}  // namespace QNes
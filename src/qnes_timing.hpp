@@ -0,0 +1,38 @@
+#pragma once
+
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+// Video standard of the console, decides the length of a frame and how the
+// CPU and the PPU divide the master clock
+enum class Region : u8 {
+  NTSC,
+  PAL,
+};
+
+// Master clock ticks of a CPU cycle and of a PPU dot: 12 and 4 on NTSC (3 dots
+// per CPU cycle), 16 and 5 on PAL (3.2 dots per CPU cycle)
+struct ClockDividers {
+  u32 cpu;
+  u32 ppu;
+};
+
+[[nodiscard]] constexpr ClockDividers GetClockDividers(Region region) {
+  return region == Region::PAL ? ClockDividers{.cpu = 16, .ppu = 5}
+                               : ClockDividers{.cpu = 12, .ppu = 4};
+}
+
+// PPU dots that have completed after cpu_cycles CPU cycles
+[[nodiscard]] constexpr u64 CPUCyclesToDots(u64 cpu_cycles, Region region) {
+  const ClockDividers dividers = GetClockDividers(region);
+  return cpu_cycles * dividers.cpu / dividers.ppu;
+}
+
+// First CPU cycle count after which dots PPU dots have completed
+[[nodiscard]] constexpr u64 DotsToCPUCycles(u64 dots, Region region) {
+  const ClockDividers dividers = GetClockDividers(region);
+  return (dots * dividers.ppu + dividers.cpu - 1) / dividers.cpu;
+}
+
+}  // namespace QNes
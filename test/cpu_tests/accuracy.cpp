@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "differential.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+namespace {
+
+// RAM bus with a register range whose reads have side effects: every read
+// there returns the next value of a sequence and is logged. Only implemented
+// opcodes are ever stored or returned, so random code stays executable.
+class SideEffectBus : public QNes::Bus {
+ public:
+  static constexpr u16 IO_FIRST = 0x2000;
+  static constexpr u16 IO_LAST = 0x3FFF;
+
+  explicit SideEffectBus(QNes::Memory *memory)
+      : memory(memory), opcodes(LegalOpcodes()) {
+    for (u8 opcode : opcodes) {
+      implemented[opcode] = true;
+    }
+  }
+
+  [[nodiscard]] u8 Read(u16 address) override {
+    ++reads;
+    if (IsIO(address)) {
+      io_reads.push_back(address);
+      return opcodes[io_reads.size() % opcodes.size()];
+    }
+    return memory->Read(address);
+  }
+  void Write(u16 address, u8 value) override {
+    memory->Write(address, implemented[value] ? value : NOP);
+  }
+  [[nodiscard]] bool HasReadSideEffects(u16 address) const override {
+    return IsIO(address);
+  }
+
+  u64 reads = 0;
+  std::vector<u16> io_reads;
+
+ private:
+  static constexpr u8 NOP =
+      QNes::ISA::NOP<QNes::AddressingMode::Implied>::OPCODE;
+
+  static bool IsIO(u16 address) {
+    return address >= IO_FIRST && address <= IO_LAST;
+  }
+
+  QNes::Memory *memory = nullptr;
+  std::vector<u8> opcodes;
+  std::array<bool, 0x100> implemented{};
+};
+
+}  // namespace
+
+// Runs the same random code in the EXACT tier (reference_cpu) and the FAST
+// tier (cpu), the tiers must only differ in the reads of side effect free
+// addresses
+class AccuracyTest
+    : public DifferentialTest<QNes::CPU, SideEffectBus,
+                              ::testing::TestWithParam<QNes::CPU::Dispatch>> {
+ protected:
+  void Start(QNes::CPU &cpu, QNes::CPU::Accuracy accuracy,
+             const QNes::CPU::State &state) {
+    QNes::CPU_Testing::SetPC(cpu, state.pc);
+    QNes::CPU_Testing::SetSP(cpu, state.sp);
+    QNes::CPU_Testing::SetA(cpu, state.a);
+    QNes::CPU_Testing::SetX(cpu, state.x);
+    QNes::CPU_Testing::SetY(cpu, state.y);
+    QNes::CPU_Testing::SetStatus(cpu, state.status);
+    cpu.SetDispatch(GetParam());
+    cpu.SetAccuracy(accuracy);
+  }
+};
+
+TEST_P(AccuracyTest, FastTierMatchesExactTierOnRandomCode) {
+  size_t io_reads = 0;
+  for (int program = 0; program < 8; ++program) {
+    SCOPED_TRACE(testing::Message() << "program " << program);
+    std::mt19937 rng(0xACC0 + program);
+    WriteRandomCode(rng);
+    bus.reads = reference_bus.reads = 0;
+    bus.io_reads.clear();
+    reference_bus.io_reads.clear();
+
+    std::uniform_int_distribution<u32> byte(0, 0xFF);
+    QNes::CPU::StatusFlags status{};
+    status.status = static_cast<u8>(byte(rng));
+    const QNes::CPU::State state = {.pc = 0x0200,
+                                    .sp = static_cast<u8>(byte(rng)),
+                                    .a = static_cast<u8>(byte(rng)),
+                                    .x = static_cast<u8>(byte(rng)),
+                                    .y = static_cast<u8>(byte(rng)),
+                                    .status = status};
+    Start(reference_cpu, QNes::CPU::Accuracy::EXACT, state);
+    Start(cpu, QNes::CPU::Accuracy::FAST, state);
+
+    for (int run = 0; run < 100; ++run) {
+      const u64 target = reference_cpu.GetCycleCount() + 200;
+      reference_cpu.RunUntil(target);
+      cpu.RunUntil(target);
+      // registers may hold a dummy read value in the middle of an instruction
+      for (QNes::CPU *c : {&reference_cpu, &cpu}) {
+        while (QNes::CPU_Testing::GetInstructionCycle(*c) != 0) {
+          c->Step();
+        }
+      }
+
+      ASSERT_TRUE(HaveSameState(cpu, reference_cpu)) << "run " << run;
+      // every read with side effects happened, in the same order
+      ASSERT_EQ(bus.io_reads, reference_bus.io_reads) << "run " << run;
+    }
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      ASSERT_EQ(memory.Read(static_cast<u16>(address)),
+                reference_memory.Read(static_cast<u16>(address)))
+          << "address 0x" << std::hex << address;
+    }
+    io_reads += reference_bus.io_reads.size();
+    EXPECT_LT(bus.reads, reference_bus.reads);
+  }
+  EXPECT_GT(io_reads, 0);
+}
+
+TEST_P(AccuracyTest, FastTierKeepsDummyReadsOfRegisters) {
+  // LDX #$01 ; LDA $20FF,X (page crossing, dummy read of $2000) ; JMP *
+  const std::vector<u8> program = {
+      QNes::ISA::LDX<QNes::AddressingMode::Immediate>::OPCODE, 0x01,
+      QNes::ISA::LDA<QNes::AddressingMode::AbsoluteX>::OPCODE, 0xFF, 0x20,
+      QNes::ISA::JMP<QNes::AddressingMode::Absolute>::OPCODE,  0x05, 0x02,
+  };
+  for (size_t i = 0; i < program.size(); ++i) {
+    memory.Write(static_cast<u16>(0x0200 + i), program[i]);
+  }
+  Start(cpu, QNes::CPU::Accuracy::FAST, {.pc = 0x0200, .sp = 0xFD});
+
+  cpu.RunUntil(9);
+  EXPECT_EQ(bus.io_reads, (std::vector<u16>{0x2000, 0x2100}));
+}
+
+TEST(AccuracyDefaultTest, CPUStartsInTheExactTier) {
+  QNes::Memory memory(Kilobytes(64));
+  QNes::RAMBus bus(&memory);
+  QNes::CPU cpu(&bus);
+  EXPECT_EQ(cpu.GetAccuracy(), QNes::CPU::Accuracy::EXACT);
+  EXPECT_FALSE(bus.HasReadSideEffects(0x2002));
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, AccuracyTest,
+                         ::testing::Values(QNes::CPU::Dispatch::TABLE,
+                                           QNes::CPU::Dispatch::THREADED,
+                                           QNes::CPU::Dispatch::JIT));
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_cpu_batch.hpp"
+#include "qnes_memory.hpp"
+
+using QNes::AddressingMode;
+using QNes::ISA;
+
+namespace {
+
+// Scalar CPU with its own RAM, the reference for one lane
+struct ReferenceLane {
+  ReferenceLane() : memory(Kilobytes(64)), bus(&memory), cpu(&bus) {
+    memory.Clear();
+    QNes::CPU_Testing::SetGlobalMode(cpu, QNes::CPU::GlobalMode::RUN);
+    QNes::CPU_Testing::SetInstructionCycle(cpu, 0);
+  }
+
+  QNes::Memory memory;
+  QNes::RAMBus bus;
+  QNes::CPU cpu;
+};
+
+}  // namespace
+
+class CPUBatchTest : public ::testing::Test {
+ protected:
+  static constexpr u32 LANE_COUNT = 8;
+
+  void SetUp() override {
+    batch = std::make_unique<QNes::CPUBatch>(LANE_COUNT);
+    for (auto &lane : lanes) {
+      lane = std::make_unique<ReferenceLane>();
+    }
+  }
+
+  void Write(u32 lane, u16 address, u8 value) {
+    batch->Write(lane, address, value);
+    lanes[lane]->memory.Write(address, value);
+  }
+  void WriteAll(u16 address, const std::vector<u8> &data) {
+    for (u32 lane = 0; lane < LANE_COUNT; ++lane) {
+      for (size_t i = 0; i < data.size(); ++i) {
+        Write(lane, static_cast<u16>(address + i), data[i]);
+      }
+    }
+  }
+  void SetState(u32 lane, const QNes::CPU::State &state) {
+    batch->SetState(lane, state);
+    auto &cpu = lanes[lane]->cpu;
+    QNes::CPU_Testing::SetPC(cpu, state.pc);
+    QNes::CPU_Testing::SetSP(cpu, state.sp);
+    QNes::CPU_Testing::SetA(cpu, state.a);
+    QNes::CPU_Testing::SetX(cpu, state.x);
+    QNes::CPU_Testing::SetY(cpu, state.y);
+    QNes::CPU_Testing::SetStatus(cpu, state.status);
+  }
+
+  // Runs the batch and every reference lane to target_cycle, whole
+  // instructions only, and compares registers, cycles and memory
+  void RunAndCompare(u64 target_cycle) {
+    batch->RunUntil(target_cycle);
+    for (u32 lane = 0; lane < LANE_COUNT; ++lane) {
+      auto &cpu = lanes[lane]->cpu;
+      while (cpu.GetCycleCount() < target_cycle) {
+        cpu.StepInstruction();
+      }
+      ASSERT_EQ(batch->GetCycleCount(lane), cpu.GetCycleCount())
+          << "lane " << lane;
+      const auto state = batch->GetState(lane);
+      const auto reference_state = cpu.GetState();
+      EXPECT_EQ(state.pc, reference_state.pc) << "lane " << lane;
+      EXPECT_EQ(state.sp, reference_state.sp) << "lane " << lane;
+      EXPECT_EQ(state.a, reference_state.a) << "lane " << lane;
+      EXPECT_EQ(state.x, reference_state.x) << "lane " << lane;
+      EXPECT_EQ(state.y, reference_state.y) << "lane " << lane;
+      EXPECT_EQ(state.status.status, reference_state.status.status)
+          << "lane " << lane;
+      for (u32 address = 0; address < Kilobytes(64); ++address) {
+        ASSERT_EQ(batch->Read(lane, static_cast<u16>(address)),
+                  lanes[lane]->memory.Read(static_cast<u16>(address)))
+            << "lane " << lane << " address 0x" << std::hex << address;
+      }
+    }
+  }
+
+  std::unique_ptr<QNes::CPUBatch> batch;
+  std::array<std::unique_ptr<ReferenceLane>, LANE_COUNT> lanes;
+};
+
+TEST_F(CPUBatchTest, PerLaneInputMatchesScalarCPUs) {
+  // loop: LDA $10 ; CLC ; ADC #$05 ; STA $20 ; CMP #$08 ; BCS high
+  //       LDX #$01 ; JMP done
+  // high: LDX #$02
+  // done: STX $21 ; INC $22 ; JMP loop
+  WriteAll(0x0200, {
+      ISA::LDA<AddressingMode::ZeroPage>::OPCODE,  0x10,
+      ISA::CLC<AddressingMode::Implied>::OPCODE,
+      ISA::ADC<AddressingMode::Immediate>::OPCODE, 0x05,
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE,  0x20,
+      ISA::CMP<AddressingMode::Immediate>::OPCODE, 0x08,
+      ISA::BCS<AddressingMode::Relative>::OPCODE,  0x05,
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x01,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x12, 0x02,
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x02,
+      ISA::STX<AddressingMode::ZeroPage>::OPCODE,  0x21,
+      ISA::INC<AddressingMode::ZeroPage>::OPCODE,  0x22,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x00, 0x02,
+  });
+  for (u32 lane = 0; lane < LANE_COUNT; ++lane) {
+    Write(lane, 0x0010, static_cast<u8>(lane));
+    SetState(lane, {.pc = 0x0200, .sp = 0xFD});
+  }
+
+  RunAndCompare(2000);
+  for (u32 lane = 0; lane < LANE_COUNT; ++lane) {
+    EXPECT_EQ(batch->Read(lane, 0x0020), lane + 5);
+    EXPECT_EQ(batch->Read(lane, 0x0021), lane + 5 >= 8 ? 2 : 1);
+  }
+  // the lanes split at BCS and meet again at done
+  EXPECT_GT(batch->GetStats().lockstep_steps, 0);
+  EXPECT_GT(batch->GetStats().lockstep_instructions,
+            batch->GetStats().scalar_instructions);
+}
+
+TEST_F(CPUBatchTest, RandomProgramsMatchScalarCPUs) {
+  // Implemented opcodes that do not write memory, so every byte stays a valid
+  // opcode while the lanes run through random code
+  const auto &instructions = QNes::InstructionTables<QNes::CPU>::cycle;
+  const std::vector<u8> writers = {
+      0x00, 0x06, 0x08, 0x0E, 0x16, 0x1E, 0x20, 0x26, 0x2E, 0x36, 0x3E,
+      0x46, 0x48, 0x4E, 0x56, 0x5E, 0x66, 0x6E, 0x76, 0x7E, 0x81, 0x84,
+      0x85, 0x86, 0x8C, 0x8D, 0x8E, 0x91, 0x94, 0x95, 0x96, 0x99, 0x9D,
+      0xC6, 0xCE, 0xD6, 0xDE, 0xE6, 0xEE, 0xF6, 0xFE,
+  };
+  std::vector<u8> opcodes;
+  for (size_t opcode = 0; opcode < instructions.size(); ++opcode) {
+    if (instructions[opcode] != nullptr &&
+        std::find(writers.begin(), writers.end(), opcode) == writers.end()) {
+      opcodes.push_back(static_cast<u8>(opcode));
+    }
+  }
+
+  for (int program = 0; program < 4; ++program) {
+    SetUp();
+    std::mt19937 rng(0xBA7C + program);
+    std::uniform_int_distribution<size_t> pick(0, opcodes.size() - 1);
+    std::uniform_int_distribution<u32> byte(0, 0xFF);
+    std::vector<u8> code(Kilobytes(64));
+    for (auto &value : code) {
+      value = opcodes[pick(rng)];
+    }
+    WriteAll(0x0000, code);
+    for (u32 lane = 0; lane < LANE_COUNT; ++lane) {
+      QNes::CPU::StatusFlags status{};
+      status.status = static_cast<u8>(byte(rng));
+      SetState(lane, {.pc = 0x0200,
+                      .sp = static_cast<u8>(byte(rng)),
+                      .a = static_cast<u8>(byte(rng)),
+                      .x = static_cast<u8>(byte(rng)),
+                      .y = static_cast<u8>(byte(rng)),
+                      .status = status});
+    }
+
+    for (u64 target = 100; target <= 5000; target += 100) {
+      RunAndCompare(target);
+      if (HasFailure()) {
+        FAIL() << "program " << program << " target " << target;
+      }
+    }
+    EXPECT_GT(batch->GetStats().lockstep_steps, 0);
+  }
+}
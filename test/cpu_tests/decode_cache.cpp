@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "differential.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+class DecodeCacheTest : public DifferentialTest<QNes::BasicCPU<QNes::RAMBus>> {
+ protected:
+  void SetUp() override {
+    DifferentialTest::SetUp();
+    cpu.EnableDecodeCache();
+  }
+};
+
+TEST_F(DecodeCacheTest, TableRunUntilMatchesCycleStepping) {
+  // Random programs overwrite their own code all the time, which exercises the
+  // invalidation on CPU writes
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch::TABLE, 200, 0xDC);
+}
+
+TEST_F(DecodeCacheTest, ThreadedRunUntilMatchesCycleStepping) {
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch::THREADED, 200, 0xDC);
+}
+
+TEST_F(DecodeCacheTest, SelfModifyingCodeIsSeen) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // LDX #$00 ; INX ; STX $0001 ; JMP $0000
+  // every pass patches the operand of the LDX, so the next pass loads the value
+  // stored by the previous one
+  WriteProgram(0x0000, {
+                           ISA::LDX<AddressingMode::Immediate>::OPCODE,
+                           0x00,
+                           ISA::INX<AddressingMode::Implied>::OPCODE,
+                           ISA::STX<AddressingMode::Absolute>::OPCODE,
+                           0x01,
+                           0x00,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x00,
+                           0x00,
+                       });
+
+  constexpr u64 pass_cycles = 2 + 2 + 4 + 3;
+  EXPECT_EQ(cpu.RunCycles(10 * pass_cycles), 10 * pass_cycles);
+  EXPECT_EQ(cpu.GetState().pc, 0x0000);
+  EXPECT_EQ(cpu.GetState().x, 10);
+  EXPECT_EQ(memory.Read(0x0001), 10);
+}
+
+TEST_F(DecodeCacheTest, HostWritesNeedInvalidation) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // LDA #$11 ; JMP $0000
+  WriteProgram(0x0000, {
+                           ISA::LDA<AddressingMode::Immediate>::OPCODE,
+                           0x11,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x00,
+                           0x00,
+                       });
+  cpu.StepInstruction();
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetState().a, 0x11);
+
+  // the operand is changed behind the CPU's back
+  memory.Write(0x0001, 0x22);
+  cpu.StepInstruction();
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetState().a, 0x11);
+
+  cpu.InvalidateCode(0x0001, 0x0001);
+  cpu.StepInstruction();
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetState().a, 0x22);
+}
+
+TEST_F(DecodeCacheTest, JSROperandOverwrittenByItsOwnPush) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // JSR $1234 at $01FC with SP at $FE: the return address push overwrites the
+  // high operand byte ($01FE) before it is read
+  QNes::CPUCore *cpus[] = {&cpu, &reference_cpu};
+  for (QNes::CPUCore *c : cpus) {
+    QNes::CPU_Testing::SetPC(*c, 0x01FC);
+    QNes::CPU_Testing::SetSP(*c, 0xFE);
+  }
+  WriteProgram(0x01FC,
+               {ISA::JSR<AddressingMode::Absolute>::OPCODE, 0x34, 0x12});
+
+  EXPECT_EQ(cpu.StepInstruction(), ISA::JSR<AddressingMode::Absolute>::CYCLES);
+  for (int i = 0; i < ISA::JSR<AddressingMode::Absolute>::CYCLES; ++i) {
+    reference_cpu.Step();
+  }
+  EXPECT_EQ(cpu.GetState().pc, reference_cpu.GetState().pc);
+  EXPECT_EQ(cpu.GetState().pc, 0x0134);
+}
+
+TEST_F(DecodeCacheTest, DisabledCacheReadsThroughTheBus) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  cpu.DisableDecodeCache();
+  EXPECT_FALSE(cpu.IsDecodeCacheEnabled());
+  WriteProgram(0x0000, {ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x11});
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetState().a, 0x11);
+
+  QNes::CPU_Testing::SetPC(cpu, 0x0000);
+  memory.Write(0x0001, 0x22);
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetState().a, 0x22);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+// Opcodes with an implementation, random code is made of these
+inline std::vector<u8> LegalOpcodes() {
+  const auto &instructions = QNes::InstructionTables<QNes::CPU>::cycle;
+  std::vector<u8> opcodes;
+  for (size_t opcode = 0; opcode < instructions.size(); ++opcode) {
+    if (instructions[opcode] != nullptr) {
+      opcodes.push_back(static_cast<u8>(opcode));
+    }
+  }
+  return opcodes;
+}
+
+// Compares the cycle count, the cycle within the instruction and the
+// registers of two CPUs
+template <typename CPU_TYPE, typename REFERENCE_CPU_TYPE>
+::testing::AssertionResult HaveSameState(const CPU_TYPE &cpu,
+                                         const REFERENCE_CPU_TYPE &reference) {
+  const auto differs = [](const char *name, u64 value, u64 expected) {
+    return ::testing::AssertionFailure()
+           << name << " is " << value << ", expected " << expected;
+  };
+  if (cpu.GetCycleCount() != reference.GetCycleCount()) {
+    return differs("cycle count", cpu.GetCycleCount(),
+                   reference.GetCycleCount());
+  }
+  const u64 instruction_cycle = QNes::CPU_Testing::GetInstructionCycle(cpu);
+  const u64 reference_instruction_cycle =
+      QNes::CPU_Testing::GetInstructionCycle(reference);
+  if (instruction_cycle != reference_instruction_cycle) {
+    return differs("instruction cycle", instruction_cycle,
+                   reference_instruction_cycle);
+  }
+  const auto state = cpu.GetState();
+  const auto expected = reference.GetState();
+  if (state.pc != expected.pc) {
+    return differs("pc", state.pc, expected.pc);
+  }
+  if (state.sp != expected.sp) {
+    return differs("sp", state.sp, expected.sp);
+  }
+  if (state.a != expected.a) {
+    return differs("a", state.a, expected.a);
+  }
+  if (state.x != expected.x) {
+    return differs("x", state.x, expected.x);
+  }
+  if (state.y != expected.y) {
+    return differs("y", state.y, expected.y);
+  }
+  if (state.status.status != expected.status.status) {
+    return differs("status", state.status.status, expected.status.status);
+  }
+  return ::testing::AssertionSuccess();
+}
+
+// Twin memories, buses and CPUs that get the same code: cpu is the CPU under
+// test, reference_cpu a plain CPU that is advanced with Step()
+template <typename CPU_TYPE, typename BUS = QNes::RAMBus,
+          typename TEST = ::testing::Test>
+class DifferentialTest : public TEST {
+ public:
+  DifferentialTest()
+      : memory(Kilobytes(64)),
+        reference_memory(Kilobytes(64)),
+        bus(&memory),
+        reference_bus(&reference_memory),
+        cpu(&bus),
+        reference_cpu(&reference_bus) {}
+
+ protected:
+  void SetUp() override {
+    memory.Clear();
+    reference_memory.Clear();
+    QNes::CPUCore *cpus[] = {&cpu, &reference_cpu};
+    for (QNes::CPUCore *c : cpus) {
+      QNes::CPU_Testing::SetGlobalMode(*c, QNes::CPU::GlobalMode::RUN);
+      QNes::CPU_Testing::SetPC(*c, 0);
+      QNes::CPU_Testing::SetSP(*c, 0xFD);
+      QNes::CPU_Testing::SetInstructionCycle(*c, 0);
+    }
+  }
+
+  void Write(u16 address, u8 value) {
+    memory.Write(address, value);
+    reference_memory.Write(address, value);
+  }
+
+  void WriteProgram(u16 address, const std::vector<u8> &program) {
+    for (size_t i = 0; i < program.size(); ++i) {
+      Write(static_cast<u16>(address + i), program[i]);
+    }
+  }
+
+  // Fills the whole memory with random legal opcodes
+  void WriteRandomCode(std::mt19937 &rng) {
+    const std::vector<u8> opcodes = LegalOpcodes();
+    std::uniform_int_distribution<size_t> pick(0, opcodes.size() - 1);
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      Write(static_cast<u16>(address), opcodes[pick(rng)]);
+    }
+  }
+
+  // Runs random code with RunUntil on random budgets of 1 to max_budget cycles
+  // and compares against the cycle stepped reference after every run, then
+  // compares the memories. Stores can leave illegal opcodes behind, the test
+  // ends on the boundary before the first one.
+  void ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch dispatch,
+                                          u64 max_budget, u32 seed) {
+    cpu.SetDispatch(dispatch);
+    std::mt19937 rng(seed);
+    WriteRandomCode(rng);
+    // the code was written behind the CPU's back
+    cpu.InvalidateCode();
+
+    const auto &instructions = QNes::InstructionTables<QNes::CPU>::cycle;
+    std::uniform_int_distribution<u64> budget(1, max_budget);
+    bool illegal_opcode_reached = false;
+    for (int run = 0; run < 2000 && !illegal_opcode_reached; ++run) {
+      u64 target = reference_cpu.GetCycleCount() + budget(rng);
+      while (reference_cpu.GetCycleCount() < target) {
+        if (QNes::CPU_Testing::GetInstructionCycle(reference_cpu) == 0 &&
+            instructions[reference_memory.Read(reference_cpu.GetState().pc)] ==
+                nullptr) {
+          target = reference_cpu.GetCycleCount();
+          illegal_opcode_reached = true;
+          break;
+        }
+        reference_cpu.Step();
+      }
+
+      cpu.RunUntil(target);
+
+      ASSERT_EQ(cpu.GetCycleCount(), target) << "run " << run;
+      ASSERT_TRUE(HaveSameState(cpu, reference_cpu)) << "run " << run;
+    }
+
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      ASSERT_EQ(memory.Read(static_cast<u16>(address)),
+                reference_memory.Read(static_cast<u16>(address)))
+          << "address 0x" << std::hex << address;
+    }
+  }
+
+  QNes::Memory memory;
+  QNes::Memory reference_memory;
+  BUS bus;
+  BUS reference_bus;
+  CPU_TYPE cpu;
+  QNes::CPU reference_cpu;
+};
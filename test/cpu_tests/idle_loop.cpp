@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+using QNes::AddressingMode;
+using QNes::ISA;
+
+class IdleLoopTest : public ::testing::TestWithParam<QNes::CPU::Dispatch> {
+ public:
+  IdleLoopTest()
+      : memory(Kilobytes(64)),
+        reference_memory(Kilobytes(64)),
+        bus(&memory),
+        reference_bus(&reference_memory),
+        cpu(&bus),
+        reference_cpu(&reference_bus) {}
+
+ protected:
+  void SetUp() override {
+    memory.Clear();
+    reference_memory.Clear();
+    for (QNes::CPU *c : {&cpu, &reference_cpu}) {
+      QNes::CPU_Testing::SetGlobalMode(*c, QNes::CPU::GlobalMode::RUN);
+      QNes::CPU_Testing::SetPC(*c, 0);
+      QNes::CPU_Testing::SetSP(*c, 0xFD);
+      QNes::CPU_Testing::SetInstructionCycle(*c, 0);
+    }
+    cpu.SetDispatch(GetParam());
+    cpu.EnableIdleLoopSkip();
+  }
+
+  void Write(u16 address, u8 value) {
+    memory.Write(address, value);
+    reference_memory.Write(address, value);
+  }
+  void WriteProgram(const std::vector<u8> &program) {
+    for (size_t i = 0; i < program.size(); ++i) {
+      Write(static_cast<u16>(i), program[i]);
+    }
+  }
+
+  // Runs the CPU to target_cycle and the reference cycle by cycle without
+  // skipping, both have to end up in the same state
+  void RunAndCompare(u64 target_cycle) {
+    cpu.RunUntil(target_cycle);
+    while (reference_cpu.GetCycleCount() < target_cycle) {
+      reference_cpu.Step();
+    }
+    ASSERT_EQ(cpu.GetCycleCount(), reference_cpu.GetCycleCount());
+    ASSERT_EQ(QNes::CPU_Testing::GetInstructionCycle(cpu),
+              QNes::CPU_Testing::GetInstructionCycle(reference_cpu));
+    const auto state = cpu.GetState();
+    const auto reference_state = reference_cpu.GetState();
+    EXPECT_EQ(state.pc, reference_state.pc);
+    EXPECT_EQ(state.sp, reference_state.sp);
+    EXPECT_EQ(state.a, reference_state.a);
+    EXPECT_EQ(state.x, reference_state.x);
+    EXPECT_EQ(state.y, reference_state.y);
+    EXPECT_EQ(state.status.status, reference_state.status.status);
+  }
+
+  // wait: LDA $10 ; CMP #$01 ; BNE wait ; LDX #$42 ; trap: JMP trap
+  void WriteFlagWaitLoop() {
+    WriteProgram({
+        ISA::LDA<AddressingMode::ZeroPage>::OPCODE,  0x10,
+        ISA::CMP<AddressingMode::Immediate>::OPCODE, 0x01,
+        ISA::BNE<AddressingMode::Relative>::OPCODE,  0xFA,
+        ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x42,
+        ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x08, 0x00,
+    });
+  }
+
+  QNes::Memory memory;
+  QNes::Memory reference_memory;
+  QNes::RAMBus bus;
+  QNes::RAMBus reference_bus;
+  QNes::CPU cpu;
+  QNes::CPU reference_cpu;
+};
+
+TEST_P(IdleLoopTest, SkipsLoopWaitingForRamFlag) {
+  WriteFlagWaitLoop();
+  RunAndCompare(100000);
+  // Everything but the iterations used to detect the loop and the budget tail
+  EXPECT_GT(cpu.GetSkippedIdleCycles(), 99000);
+}
+
+TEST_P(IdleLoopTest, LeavesLoopWhenFlagChanges) {
+  WriteFlagWaitLoop();
+  RunAndCompare(5000);
+  EXPECT_GT(cpu.GetSkippedIdleCycles(), 0);
+
+  Write(0x0010, 0x01);
+  RunAndCompare(6000);
+  EXPECT_EQ(cpu.GetState().x, 0x42);
+}
+
+TEST_P(IdleLoopTest, CountingLoopIsNotSkipped) {
+  // LDX #$00 ; loop: DEX ; BNE loop ; trap: JMP trap
+  WriteProgram({
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x00,
+      ISA::DEX<AddressingMode::Implied>::OPCODE,
+      ISA::BNE<AddressingMode::Relative>::OPCODE,  0xFD,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x05, 0x00,
+  });
+  RunAndCompare(10000);
+  EXPECT_EQ(cpu.GetSkippedIdleCycles(), 0);
+}
+
+TEST_P(IdleLoopTest, LoopThatStoresIsNotSkipped) {
+  // wait: LDA $10 ; STA $11 ; BEQ wait
+  WriteProgram({
+      ISA::LDA<AddressingMode::ZeroPage>::OPCODE, 0x10,
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE, 0x11,
+      ISA::BEQ<AddressingMode::Relative>::OPCODE, 0xFA,
+  });
+  RunAndCompare(10000);
+  EXPECT_EQ(cpu.GetSkippedIdleCycles(), 0);
+}
+
+TEST_P(IdleLoopTest, LoopChangingItsOwnStateIsNotSkipped) {
+  // loop: EOR #$FF ; BNE loop ; BEQ loop
+  WriteProgram({
+      ISA::EOR<AddressingMode::Immediate>::OPCODE, 0xFF,
+      ISA::BNE<AddressingMode::Relative>::OPCODE,  0xFC,
+      ISA::BEQ<AddressingMode::Relative>::OPCODE,  0xFA,
+  });
+  RunAndCompare(10000);
+  EXPECT_EQ(cpu.GetSkippedIdleCycles(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, IdleLoopTest,
+                         ::testing::Values(QNes::CPU::Dispatch::TABLE,
+                                           QNes::CPU::Dispatch::THREADED,
+                                           QNes::CPU::Dispatch::JIT));
+
+TEST(IdleLoopBusTest, NESBusReportsRamAndPPUStatusIdempotent) {
+  QNes::WorkRAM memory;
+  QNes::NESBus bus(&memory, nullptr);
+  EXPECT_TRUE(bus.IsIdempotentRead(0x0010));
+  EXPECT_TRUE(bus.IsIdempotentRead(0x1FFF));
+  EXPECT_TRUE(bus.IsIdempotentRead(0x2002));
+  EXPECT_TRUE(bus.IsIdempotentRead(0x3FFA));
+  EXPECT_FALSE(bus.IsIdempotentRead(0x2007));
+  EXPECT_FALSE(bus.IsIdempotentRead(0x4016));
+}
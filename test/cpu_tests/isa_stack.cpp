@@ -407,3 +407,27 @@ TEST_F(CPUISAStackTest, TXSInstructionTransfersXtoSP) {
                                                                // for
                                                                // TSX
 }
+
+TEST_F(CPUISAStackTest, PHPPushesFlagsOfPrecedingInstruction) {
+  // Arrange
+  // BIT sets Z from A & M but N and V from bits 7 and 6 of M, PHP has to see
+  // all three
+  const u8 initial_sp = cpu.GetState().sp;
+  QNes::CPU_Testing::SetA(cpu, 0x0F);
+  memory.Write(0x0010, 0xC0);
+  memory.Write(0x0000, QNes::ISA::BIT<QNes::AddressingMode::ZeroPage>::OPCODE);
+  memory.Write(0x0001, 0x10);
+  memory.Write(0x0002, QNes::ISA::PHP<QNes::AddressingMode::Implied>::OPCODE);
+
+  // Act
+  cpu.StepInstruction();
+  cpu.StepInstruction();
+
+  // Assert
+  QNes::CPU::StatusFlags expected = cpu.GetState().status;
+  EXPECT_EQ(expected.zero, true);
+  EXPECT_EQ(expected.overflow, true);
+  EXPECT_EQ(expected.negative, true);
+  expected.break_command = 1;  // Break flag is set when pushed
+  EXPECT_EQ(memory.Read(0x0100 + initial_sp), expected.status);
+}
@@ -0,0 +1,338 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "differential.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_jit.hpp"
+#include "qnes_memory.hpp"
+
+namespace {
+
+// RAM bus with the NES I/O range ($2000-$401F) marked as I/O. Records I/O
+// accesses and can raise an NMI when a given address is written.
+class IOBus : public QNes::Bus {
+ public:
+  explicit IOBus(QNes::Memory *memory) : memory(memory) {}
+
+  [[nodiscard]] u8 Read(u16 address) override {
+    RecordAccess(address);
+    return memory->Read(address);
+  }
+  void Write(u16 address, u8 value) override {
+    RecordAccess(address);
+    memory->Write(address, value);
+    if (address == nmi_address && cpu != nullptr) {
+      cpu->SignalNMI();
+    }
+  }
+  [[nodiscard]] bool IsDecodeCacheable(u16 address) const override {
+    return !IsIO(address);
+  }
+
+  QNes::CPU *cpu = nullptr;
+  u16 nmi_address = 0xFFFF;
+  u64 io_accesses = 0;
+  bool io_access_in_block = false;
+
+ private:
+  static bool IsIO(u16 address) {
+    return address >= 0x2000 && address <= 0x401F;
+  }
+  void RecordAccess(u16 address) {
+    if (IsIO(address)) {
+      ++io_accesses;
+#if QNES_HAS_JIT
+      if (cpu != nullptr && QNes::CPU_Testing::IsRunningJitBlock(*cpu)) {
+        io_access_in_block = true;
+      }
+#endif
+    }
+  }
+
+  QNes::Memory *memory = nullptr;
+};
+
+}  // namespace
+
+class JitTest : public DifferentialTest<QNes::BasicCPU<QNes::RAMBus>> {
+ protected:
+  void SetUp() override {
+    DifferentialTest::SetUp();
+    cpu.SetDispatch(QNes::CPU::Dispatch::JIT);
+    reference_cpu.SetDispatch(QNes::CPU::Dispatch::TABLE);
+  }
+
+  // Differential run of random programs against the cycle stepped reference
+  void ExpectRunUntilMatchesCycleStepping(u32 hot_threshold) {
+    cpu.SetJitConfig({.hot_threshold = hot_threshold});
+    for (int program = 0; program < 4; ++program) {
+      SCOPED_TRACE(testing::Message() << "program " << program);
+      SetUp();
+      DifferentialTest::ExpectRunUntilMatchesCycleStepping(
+          QNes::CPU::Dispatch::JIT, 300, 0x1D + program);
+      if (HasFatalFailure()) {
+        return;
+      }
+    }
+  }
+};
+
+TEST_F(JitTest, RunUntilMatchesCycleStepping) {
+  ExpectRunUntilMatchesCycleStepping(1);
+}
+
+TEST_F(JitTest, RunUntilMatchesCycleSteppingWithDefaultThreshold) {
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::JitConfig{}.hot_threshold);
+}
+
+TEST_F(JitTest, CompilesHotLoop) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // LDY #$00 ; loop: LDX #$40 ; inner: TXA ; CLC ; ADC $0300,Y ; STA $0300,Y ;
+  // INY ; DEX ; BNE inner ; SEC ; TYA ; TAX ; DEY ; INX ; TSX ; TXS ; NOP ;
+  // JMP loop
+  WriteProgram(0x0000, {
+                           ISA::LDY<AddressingMode::Immediate>::OPCODE,
+                           0x00,
+                           ISA::LDX<AddressingMode::Immediate>::OPCODE,
+                           0x40,
+                           ISA::TXA<AddressingMode::Implied>::OPCODE,
+                           ISA::CLC<AddressingMode::Implied>::OPCODE,
+                           ISA::ADC<AddressingMode::AbsoluteY>::OPCODE,
+                           0x00,
+                           0x03,
+                           ISA::STA<AddressingMode::AbsoluteY>::OPCODE,
+                           0x00,
+                           0x03,
+                           ISA::INY<AddressingMode::Implied>::OPCODE,
+                           ISA::DEX<AddressingMode::Implied>::OPCODE,
+                           ISA::BNE<AddressingMode::Relative>::OPCODE,
+                           0xF4,
+                           ISA::SEC<AddressingMode::Implied>::OPCODE,
+                           ISA::TYA<AddressingMode::Implied>::OPCODE,
+                           ISA::TAX<AddressingMode::Implied>::OPCODE,
+                           ISA::DEY<AddressingMode::Implied>::OPCODE,
+                           ISA::INX<AddressingMode::Implied>::OPCODE,
+                           ISA::TSX<AddressingMode::Implied>::OPCODE,
+                           ISA::TXS<AddressingMode::Implied>::OPCODE,
+                           ISA::NOP<AddressingMode::Implied>::OPCODE,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x02,
+                           0x00,
+                       });
+
+  for (int run = 0; run < 100; ++run) {
+    cpu.RunCycles(997);
+    reference_cpu.RunCycles(997);
+    EXPECT_TRUE(HaveSameState(cpu, reference_cpu));
+  }
+  for (u16 address = 0x0300; address < 0x0400; ++address) {
+    EXPECT_EQ(memory.Read(address), reference_memory.Read(address));
+  }
+#if QNES_HAS_JIT
+  EXPECT_GT(QNes::CPU_Testing::GetJitBlockCount(cpu), 0);
+#endif
+}
+
+TEST_F(JitTest, SelfModifyingCodeIsSeen) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  cpu.SetJitConfig({.hot_threshold = 1});
+  // LDX #$00 ; INX ; STX $0001 ; JMP $0000 - patches its own LDX operand
+  WriteProgram(0x0000, {
+                           ISA::LDX<AddressingMode::Immediate>::OPCODE,
+                           0x00,
+                           ISA::INX<AddressingMode::Implied>::OPCODE,
+                           ISA::STX<AddressingMode::Absolute>::OPCODE,
+                           0x01,
+                           0x00,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x00,
+                           0x00,
+                       });
+
+  constexpr u64 pass_cycles = 2 + 2 + 4 + 3;
+  EXPECT_EQ(cpu.RunCycles(100 * pass_cycles), 100 * pass_cycles);
+  EXPECT_EQ(cpu.GetState().pc, 0x0000);
+  EXPECT_EQ(cpu.GetState().x, 100);
+}
+
+TEST_F(JitTest, HostWritesNeedInvalidation) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  cpu.SetJitConfig({.hot_threshold = 1});
+  // LDA #$11 ; JMP $0000
+  WriteProgram(0x0000, {
+                           ISA::LDA<AddressingMode::Immediate>::OPCODE,
+                           0x11,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x00,
+                           0x00,
+                       });
+  cpu.RunCycles(50);
+  EXPECT_EQ(cpu.GetState().a, 0x11);
+#if QNES_HAS_JIT
+  EXPECT_EQ(QNes::CPU_Testing::GetJitBlockCount(cpu), 1);
+#endif
+
+  // the operand is changed behind the CPU's back
+  memory.Write(0x0001, 0x22);
+  cpu.InvalidateCode(0x0001, 0x0001);
+#if QNES_HAS_JIT
+  EXPECT_EQ(QNes::CPU_Testing::GetJitBlockCount(cpu), 0);
+#endif
+  cpu.RunCycles(50);
+  EXPECT_EQ(cpu.GetState().a, 0x22);
+}
+
+TEST(JitIOTest, HandsIOAccessesToTheInterpreter) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  QNes::Memory memory(Kilobytes(64));
+  QNes::Memory reference_memory(Kilobytes(64));
+  IOBus bus(&memory);
+  IOBus reference_bus(&reference_memory);
+  QNes::CPU cpu(&bus);
+  QNes::CPU reference_cpu(&reference_bus);
+  bus.cpu = &cpu;
+
+  // loop: LDA $2002 ; LDX #$00 ; STA $4000,X ; LDY #$10 ; LDA ($80),Y ;
+  // LDA $0300,X ; INC $0310 ; JMP loop
+  // with ($80) = $3FF8, so the indirect load hits $4008
+  const std::vector<u8> program = {
+      ISA::LDA<AddressingMode::Absolute>::OPCODE,  0x02, 0x20,
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x00,
+      ISA::STA<AddressingMode::AbsoluteX>::OPCODE, 0x00, 0x40,
+      ISA::LDY<AddressingMode::Immediate>::OPCODE, 0x10,
+      ISA::LDA<AddressingMode::IndirectY>::OPCODE, 0x80,
+      ISA::LDA<AddressingMode::AbsoluteX>::OPCODE, 0x00, 0x03,
+      ISA::INC<AddressingMode::Absolute>::OPCODE,  0x10, 0x03,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x00, 0x00,
+  };
+  for (QNes::Memory *m : {&memory, &reference_memory}) {
+    m->Clear();
+    for (size_t i = 0; i < program.size(); ++i) {
+      m->Write(static_cast<u16>(i), program[i]);
+    }
+    m->Write(0x0080, 0xF8);
+    m->Write(0x0081, 0x3F);
+  }
+  for (QNes::CPU *c : {&cpu, &reference_cpu}) {
+    QNes::CPU_Testing::SetGlobalMode(*c, QNes::CPU::GlobalMode::RUN);
+    QNes::CPU_Testing::SetInstructionCycle(*c, 0);
+  }
+  cpu.SetDispatch(QNes::CPU::Dispatch::JIT);
+  cpu.SetJitConfig({.hot_threshold = 1});
+  reference_cpu.SetDispatch(QNes::CPU::Dispatch::TABLE);
+
+  for (int run = 0; run < 50; ++run) {
+    cpu.RunCycles(301);
+    reference_cpu.RunCycles(301);
+    ASSERT_EQ(cpu.GetState().pc, reference_cpu.GetState().pc);
+    ASSERT_EQ(cpu.GetState().a, reference_cpu.GetState().a);
+  }
+  EXPECT_EQ(memory.Read(0x0310), reference_memory.Read(0x0310));
+  EXPECT_EQ(bus.io_accesses, reference_bus.io_accesses);
+  EXPECT_GT(bus.io_accesses, 0);
+  EXPECT_FALSE(bus.io_access_in_block);
+#if QNES_HAS_JIT
+  EXPECT_GT(QNes::CPU_Testing::GetJitBlockCount(cpu), 0);
+#endif
+}
+
+TEST(JitIOTest, NMIEndsTheBlock) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  QNes::Memory memory(Kilobytes(64));
+  QNes::Memory reference_memory(Kilobytes(64));
+  IOBus bus(&memory);
+  IOBus reference_bus(&reference_memory);
+  QNes::CPU cpu(&bus);
+  QNes::CPU reference_cpu(&reference_bus);
+  bus.cpu = &cpu;
+  reference_bus.cpu = &reference_cpu;
+  bus.nmi_address = 0x0200;
+  reference_bus.nmi_address = 0x0200;
+
+  // loop: INX ; STX $0200 ; INY ; INY ; JMP loop, NMI handler: RTI
+  const std::vector<u8> program = {
+      ISA::INX<AddressingMode::Implied>::OPCODE,
+      ISA::STX<AddressingMode::Absolute>::OPCODE,
+      0x00,
+      0x02,
+      ISA::INY<AddressingMode::Implied>::OPCODE,
+      ISA::INY<AddressingMode::Implied>::OPCODE,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,
+      0x00,
+      0x00,
+  };
+  for (QNes::Memory *m : {&memory, &reference_memory}) {
+    m->Clear();
+    for (size_t i = 0; i < program.size(); ++i) {
+      m->Write(static_cast<u16>(i), program[i]);
+    }
+    m->Write(0x8000, ISA::RTI<AddressingMode::Implied>::OPCODE);
+    m->Write(0xFFFA, 0x00);
+    m->Write(0xFFFB, 0x80);
+  }
+  for (QNes::CPU *c : {&cpu, &reference_cpu}) {
+    QNes::CPU_Testing::SetGlobalMode(*c, QNes::CPU::GlobalMode::RUN);
+    QNes::CPU_Testing::SetSP(*c, 0xFD);
+    QNes::CPU_Testing::SetInstructionCycle(*c, 0);
+  }
+  cpu.SetDispatch(QNes::CPU::Dispatch::JIT);
+  cpu.SetJitConfig({.hot_threshold = 1});
+  reference_cpu.SetDispatch(QNes::CPU::Dispatch::TABLE);
+
+  for (int run = 0; run < 200; ++run) {
+    const u64 cycles = cpu.RunCycles(100);
+    ASSERT_EQ(cycles, reference_cpu.RunCycles(100)) << "run " << run;
+    ASSERT_EQ(cpu.GetState().pc, reference_cpu.GetState().pc);
+    ASSERT_EQ(cpu.GetState().x, reference_cpu.GetState().x);
+    ASSERT_EQ(cpu.GetState().y, reference_cpu.GetState().y);
+    ASSERT_EQ(cpu.GetState().sp, reference_cpu.GetState().sp);
+  }
+}
+
+#if QNES_HAS_JIT
+TEST_F(JitTest, WritesPerfMap) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  const std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+  std::remove(path.c_str());
+
+  cpu.SetJitConfig({.hot_threshold = 1, .perf_map = true});
+  // NOP ; JMP $0000
+  WriteProgram(0x0000, {
+                           ISA::NOP<AddressingMode::Implied>::OPCODE,
+                           ISA::JMP<AddressingMode::Absolute>::OPCODE,
+                           0x00,
+                           0x00,
+                       });
+  cpu.RunCycles(100);
+
+  std::ifstream perf_map(path);
+  ASSERT_TRUE(perf_map.is_open());
+  std::stringstream contents;
+  contents << perf_map.rdbuf();
+  EXPECT_NE(contents.str().find(" qnes_jit_0000_0003"), std::string::npos)
+      << contents.str();
+  std::remove(path.c_str());
+}
+#endif
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+#include "qnes_profiler.hpp"
+
+using QNes::AddressingMode;
+using QNes::ISA;
+
+class ProfilerTest : public ::testing::TestWithParam<QNes::CPU::Dispatch> {
+ public:
+  ProfilerTest() : memory(Kilobytes(64)), bus(&memory), cpu(&bus) {}
+
+ protected:
+  void SetUp() override {
+    memory.Clear();
+    QNes::CPU_Testing::SetGlobalMode(cpu, QNes::CPU::GlobalMode::RUN);
+    QNes::CPU_Testing::SetPC(cpu, 0);
+    QNes::CPU_Testing::SetSP(cpu, 0xFD);
+    QNes::CPU_Testing::SetInstructionCycle(cpu, 0);
+    cpu.SetDispatch(GetParam());
+    cpu.EnableProfiler();
+
+    // LDX #$03 ; loop: DEX ; BNE loop ; trap: JMP trap
+    const std::vector<u8> program = {
+        ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x03,
+        ISA::DEX<AddressingMode::Implied>::OPCODE,
+        ISA::BNE<AddressingMode::Relative>::OPCODE,  0xFD,
+        ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x05, 0x00,
+    };
+    for (size_t i = 0; i < program.size(); ++i) {
+      memory.Write(static_cast<u16>(i), program[i]);
+    }
+  }
+
+  // Every instruction of the program before the trap plus trap iterations
+  void ExpectLoopProfile(u64 trap_count) {
+    const QNes::Profiler &profiler = *cpu.GetProfiler();
+    const u8 ldx = ISA::LDX<AddressingMode::Immediate>::OPCODE;
+    const u8 dex = ISA::DEX<AddressingMode::Implied>::OPCODE;
+    const u8 bne = ISA::BNE<AddressingMode::Relative>::OPCODE;
+    const u8 jmp = ISA::JMP<AddressingMode::Absolute>::OPCODE;
+
+    EXPECT_EQ(profiler.GetOpcode(ldx).count, 1);
+    EXPECT_EQ(profiler.GetOpcode(ldx).cycles, 2);
+    EXPECT_EQ(profiler.GetOpcode(dex).count, 3);
+    EXPECT_EQ(profiler.GetOpcode(dex).cycles, 6);
+    // taken twice (3 cycles), not taken once (2 cycles)
+    EXPECT_EQ(profiler.GetOpcode(bne).count, 3);
+    EXPECT_EQ(profiler.GetOpcode(bne).cycles, 8);
+    EXPECT_EQ(profiler.GetOpcode(jmp).count, trap_count);
+    EXPECT_EQ(profiler.GetOpcode(jmp).cycles, 3 * trap_count);
+
+    EXPECT_EQ(profiler.GetPC(0x0002).count, 3);
+    EXPECT_EQ(profiler.GetPC(0x0003).cycles, 8);
+    EXPECT_EQ(profiler.GetPC(0x0005).count, trap_count);
+
+    EXPECT_EQ(profiler.GetMode(AddressingMode::Immediate).count, 1);
+    EXPECT_EQ(profiler.GetMode(AddressingMode::Implied).count, 3);
+    EXPECT_EQ(profiler.GetMode(AddressingMode::Relative).count, 3);
+    EXPECT_EQ(profiler.GetMode(AddressingMode::Absolute).count, trap_count);
+  }
+
+  QNes::Memory memory;
+  QNes::RAMBus bus;
+  QNes::CPU cpu;
+};
+
+TEST_P(ProfilerTest, RunUntilRecordsEveryInstruction) {
+  // 16 cycles to the trap, then 3 cycles per JMP, the last one ends at 100
+  cpu.RunUntil(100);
+  ExpectLoopProfile(28);
+}
+
+TEST_P(ProfilerTest, CycleSteppingRecordsTheSameProfile) {
+  while (cpu.GetCycleCount() < 100) {
+    cpu.Step();
+  }
+  ExpectLoopProfile(28);
+}
+
+TEST_P(ProfilerTest, InstructionSplitAcrossRunUntilCallsIsRecordedOnce) {
+  for (u64 target = 1; target <= 100; target += 5) {
+    cpu.RunUntil(target);
+  }
+  cpu.RunUntil(100);
+  ExpectLoopProfile(28);
+}
+
+TEST_P(ProfilerTest, ClearResetsCounters) {
+  cpu.RunUntil(100);
+  cpu.GetProfiler()->Clear();
+  EXPECT_EQ(cpu.GetProfiler()->GetMode(AddressingMode::Absolute).count, 0);
+  EXPECT_EQ(cpu.GetProfiler()->GetPC(0x0005).cycles, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, ProfilerTest,
+                         ::testing::Values(QNes::CPU::Dispatch::TABLE,
+                                           QNes::CPU::Dispatch::THREADED,
+                                           QNes::CPU::Dispatch::JIT));
+
+TEST(ProfilerDumpTest, WritesNonZeroEntriesAsCSVAndJSON) {
+  QNes::Profiler profiler;
+  profiler.Record(0x8000, ISA::LDA<AddressingMode::Immediate>::OPCODE, 2);
+  profiler.Record(0x8000, ISA::LDA<AddressingMode::Immediate>::OPCODE, 2);
+  profiler.Record(0x8002, ISA::JMP<AddressingMode::Absolute>::OPCODE, 3);
+
+  std::ostringstream csv;
+  profiler.WriteCSV(csv);
+  EXPECT_EQ(csv.str(),
+            "table,key,count,cycles\n"
+            "opcode,0x4C,1,3\n"
+            "opcode,0xA9,2,4\n"
+            "pc,0x8000,2,4\n"
+            "pc,0x8002,1,3\n"
+            "mode,Immediate,2,4\n"
+            "mode,Absolute,1,3\n");
+
+  std::ostringstream json;
+  profiler.WriteJSON(json);
+  EXPECT_EQ(json.str(),
+            "{\n"
+            "\"opcodes\": [\n"
+            "  {\"opcode\": \"0x4C\", \"count\": 1, \"cycles\": 3},\n"
+            "  {\"opcode\": \"0xA9\", \"count\": 2, \"cycles\": 4}\n"
+            "],\n"
+            "\"pcs\": [\n"
+            "  {\"pc\": \"0x8000\", \"count\": 2, \"cycles\": 4},\n"
+            "  {\"pc\": \"0x8002\", \"count\": 1, \"cycles\": 3}\n"
+            "],\n"
+            "\"modes\": [\n"
+            "  {\"mode\": \"Immediate\", \"count\": 2, \"cycles\": 4},\n"
+            "  {\"mode\": \"Absolute\", \"count\": 1, \"cycles\": 3}\n"
+            "]\n"
+            "}\n");
+}
+
+TEST(ProfilerDumpTest, CPUHasNoProfilerUntilEnabled) {
+  QNes::Memory memory(Kilobytes(64));
+  QNes::RAMBus bus(&memory);
+  QNes::CPU cpu(&bus);
+  EXPECT_EQ(cpu.GetProfiler(), nullptr);
+  cpu.EnableProfiler();
+  EXPECT_NE(cpu.GetProfiler(), nullptr);
+  cpu.DisableProfiler();
+  EXPECT_EQ(cpu.GetProfiler(), nullptr);
+}
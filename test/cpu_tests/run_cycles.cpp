@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "differential.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+namespace {
+
+// RAM bus that asks the CPU to leave RunUntil when a given address is written
+class ExitOnWriteBus : public QNes::Bus {
+ public:
+  ExitOnWriteBus(QNes::Memory *memory, u16 exit_address)
+      : memory(memory), exit_address(exit_address) {}
+
+  [[nodiscard]] u8 Read(u16 address) override { return memory->Read(address); }
+  void Write(u16 address, u8 value) override {
+    memory->Write(address, value);
+    if (address == exit_address && cpu != nullptr) {
+      cpu->RequestExit();
+    }
+  }
+
+  QNes::CPU *cpu = nullptr;
+
+ private:
+  QNes::Memory *memory = nullptr;
+  u16 exit_address = 0;
+};
+
+}  // namespace
+
+class RunCyclesTest : public DifferentialTest<QNes::CPU> {
+ protected:
+  // Counting loop: LDX #$00 ; loop: INX ; STX $0200 ; INC $0201 ; JMP loop
+  void WriteCountingLoop() {
+    using QNes::AddressingMode;
+    using QNes::ISA;
+    const std::vector<u8> program = {
+        ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x00,
+        ISA::INX<AddressingMode::Implied>::OPCODE,
+        ISA::STX<AddressingMode::Absolute>::OPCODE,  0x00, 0x02,
+        ISA::INC<AddressingMode::Absolute>::OPCODE,  0x01, 0x02,
+        ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x02, 0x00,
+    };
+    WriteProgram(0x0000, program);
+  }
+};
+
+TEST_F(RunCyclesTest, StepCountsCycles) {
+  WriteCountingLoop();
+  EXPECT_EQ(cpu.GetCycleCount(), 0);
+  for (int i = 0; i < 10; ++i) {
+    cpu.Step();
+  }
+  EXPECT_EQ(cpu.GetCycleCount(), 10);
+  cpu.StepInstruction();
+  EXPECT_EQ(cpu.GetCycleCount(), 10 + 4);  // finishes INC abs
+}
+
+TEST_F(RunCyclesTest, RunCyclesStopsExactlyOnBudget) {
+  WriteCountingLoop();
+  for (u64 budget : {1, 2, 3, 7, 8, 13, 100, 12345}) {
+    const u64 start = cpu.GetCycleCount();
+    EXPECT_EQ(cpu.RunCycles(budget), budget);
+    EXPECT_EQ(cpu.GetCycleCount(), start + budget);
+  }
+}
+
+TEST_F(RunCyclesTest, RunUntilMatchesCycleStepping) {
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch::TABLE, 50, 0x2A03);
+}
+
+TEST_F(RunCyclesTest, ThreadedRunUntilMatchesCycleStepping) {
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch::THREADED, 50,
+                                     0x2A03);
+}
+
+TEST_F(RunCyclesTest, IdleLoopSkipRunUntilMatchesCycleStepping) {
+  cpu.EnableIdleLoopSkip();
+  ExpectRunUntilMatchesCycleStepping(QNes::CPU::Dispatch::THREADED, 50,
+                                     0x2A03);
+}
+
+TEST_F(RunCyclesTest, PendingIRQIsTakenAfterCLI) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // NOP ; NOP ; CLI ; NOP ... with the IRQ handler at $8000
+  Write(0x0000, ISA::NOP<AddressingMode::Implied>::OPCODE);
+  Write(0x0001, ISA::NOP<AddressingMode::Implied>::OPCODE);
+  Write(0x0002, ISA::CLI<AddressingMode::Implied>::OPCODE);
+  for (u16 address = 0x0003; address < 0x0100; ++address) {
+    Write(address, ISA::NOP<AddressingMode::Implied>::OPCODE);
+  }
+  for (u16 address = 0x8000; address < 0x8100; ++address) {
+    Write(address, ISA::NOP<AddressingMode::Implied>::OPCODE);
+  }
+  Write(0xFFFE, 0x00);
+  Write(0xFFFF, 0x80);
+
+  cpu.SetDispatch(QNes::CPU::Dispatch::TABLE);
+  reference_cpu.SetDispatch(QNes::CPU::Dispatch::THREADED);
+  for (QNes::CPU *c : {&cpu, &reference_cpu}) {
+    QNes::CPU::StatusFlags status{};
+    status.interrupt_disable = 1;
+    QNes::CPU_Testing::SetStatus(*c, status);
+    c->SignalIRQ();
+    // NOP, NOP, CLI, IRQ sequence, then two NOPs of the handler
+    EXPECT_EQ(c->RunCycles(3 * 2 + 7 + 2 * 2), 3 * 2 + 7 + 2 * 2);
+    EXPECT_EQ(c->GetState().pc, 0x8002);
+    EXPECT_EQ(c->GetState().sp, 0xFD - 3);
+  }
+}
+
+TEST(RunCyclesExitTest, RequestExitEndsRunAtInstructionBoundary) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  QNes::Memory memory(Kilobytes(64));
+  memory.Clear();
+  ExitOnWriteBus bus(&memory, 0x0300);
+  QNes::CPU cpu(&bus);
+  bus.cpu = &cpu;
+  QNes::CPU_Testing::SetGlobalMode(cpu, QNes::CPU::GlobalMode::RUN);
+  QNes::CPU_Testing::SetPC(cpu, 0);
+  QNes::CPU_Testing::SetInstructionCycle(cpu, 0);
+
+  // LDA #$01 ; STA $0300 ; NOP ...
+  memory.Write(0x0000, ISA::LDA<AddressingMode::Immediate>::OPCODE);
+  memory.Write(0x0001, 0x01);
+  memory.Write(0x0002, ISA::STA<AddressingMode::Absolute>::OPCODE);
+  memory.Write(0x0003, 0x00);
+  memory.Write(0x0004, 0x03);
+  for (u16 address = 0x0005; address < 0x0100; ++address) {
+    memory.Write(address, ISA::NOP<AddressingMode::Implied>::OPCODE);
+  }
+
+  EXPECT_EQ(cpu.RunCycles(100), 2 + 4);
+  EXPECT_EQ(cpu.GetState().pc, 0x0005);
+  EXPECT_EQ(memory.Read(0x0300), 0x01);
+  EXPECT_EQ(QNes::CPU_Testing::GetInstructionCycle(cpu), 0);
+
+  // exit request does not carry over to the next run
+  EXPECT_EQ(cpu.RunCycles(100), 100);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+class StepInstructionTest : public ::testing::Test {
+ public:
+  StepInstructionTest()
+      : memory(Kilobytes(64)),
+        reference_memory(Kilobytes(64)),
+        bus(&memory),
+        reference_bus(&reference_memory),
+        cpu(&bus),
+        reference_cpu(&reference_bus) {}
+
+ protected:
+  void SetUp() override {
+    memory.Clear();
+    reference_memory.Clear();
+    QNes::CPUCore *cpus[] = {&cpu, &reference_cpu};
+    for (QNes::CPUCore *c : cpus) {
+      QNes::CPU_Testing::SetGlobalMode(*c, QNes::CPU::GlobalMode::RUN);
+      QNes::CPU_Testing::SetPC(*c, 0);
+      QNes::CPU_Testing::SetSP(*c, 0xFD);
+      QNes::CPU_Testing::SetInstructionCycle(*c, 0);
+    }
+  }
+
+  void Write(u16 address, u8 value) {
+    memory.Write(address, value);
+    reference_memory.Write(address, value);
+  }
+
+  static bool AtInstructionBoundary(const QNes::CPU &cpu) {
+    return QNes::CPU_Testing::GetGlobalMode(cpu) ==
+               QNes::CPU::GlobalMode::RUN &&
+           QNes::CPU_Testing::GetInstructionCycle(cpu) == 0;
+  }
+
+  // Runs the reference CPU cycle by cycle until the next instruction boundary
+  int StepReferenceInstruction() {
+    int cycles = 0;
+    do {
+      reference_cpu.Step();
+      ++cycles;
+    } while (!AtInstructionBoundary(reference_cpu));
+    return cycles;
+  }
+
+  static void ExpectSameState(const QNes::CPU::State &lhs,
+                              const QNes::CPU::State &rhs) {
+    EXPECT_EQ(lhs.pc, rhs.pc);
+    EXPECT_EQ(lhs.sp, rhs.sp);
+    EXPECT_EQ(lhs.a, rhs.a);
+    EXPECT_EQ(lhs.x, rhs.x);
+    EXPECT_EQ(lhs.y, rhs.y);
+    EXPECT_EQ(lhs.status.status, rhs.status.status);
+  }
+
+  QNes::Memory memory;
+  QNes::Memory reference_memory;
+  QNes::RAMBus bus;
+  QNes::RAMBus reference_bus;
+  // instruction granular core on the concrete bus, checked against the cycle
+  // stepped core going through the virtual Bus interface
+  QNes::BasicCPU<QNes::RAMBus> cpu;
+  QNes::CPU reference_cpu;
+};
+
+TEST_F(StepInstructionTest, ReturnsInstructionCycleCount) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  // LDA #$42 ; LDA $1234 ; STA $0200 ; LDX #$FF ; LDA $10F0,X ; NOP
+  const std::vector<u8> program = {
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x42,
+      ISA::LDA<AddressingMode::Absolute>::OPCODE,  0x34, 0x12,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00, 0x02,
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0xFF,
+      ISA::LDA<AddressingMode::AbsoluteX>::OPCODE, 0xF0, 0x10,
+      ISA::NOP<AddressingMode::Implied>::OPCODE,
+  };
+  for (size_t i = 0; i < program.size(); ++i) {
+    Write(static_cast<u16>(i), program[i]);
+  }
+
+  EXPECT_EQ(cpu.StepInstruction(), ISA::LDA<AddressingMode::Immediate>::CYCLES);
+  EXPECT_EQ(cpu.StepInstruction(), ISA::LDA<AddressingMode::Absolute>::CYCLES);
+  EXPECT_EQ(cpu.StepInstruction(), ISA::STA<AddressingMode::Absolute>::CYCLES);
+  EXPECT_EQ(cpu.StepInstruction(), ISA::LDX<AddressingMode::Immediate>::CYCLES);
+  // page crossed - one extra cycle
+  EXPECT_EQ(cpu.StepInstruction(),
+            ISA::LDA<AddressingMode::AbsoluteX>::CYCLES + 1);
+  EXPECT_EQ(cpu.StepInstruction(), ISA::NOP<AddressingMode::Implied>::CYCLES);
+  EXPECT_EQ(cpu.GetState().pc, program.size());
+  EXPECT_EQ(QNes::CPU_Testing::GetInstructionCycle(cpu), 0);
+}
+
+TEST_F(StepInstructionTest, FinishesInstructionInFlight) {
+  using QNes::AddressingMode;
+  using QNes::ISA;
+
+  Write(0x0000, ISA::LDA<AddressingMode::Absolute>::OPCODE);
+  Write(0x0001, 0x00);
+  Write(0x0002, 0x03);
+  Write(0x0300, 0x99);
+
+  // fetch opcode and low address byte
+  cpu.Step();
+  cpu.Step();
+
+  EXPECT_EQ(cpu.StepInstruction(), 2);
+  EXPECT_EQ(cpu.GetState().a, 0x99);
+  EXPECT_EQ(cpu.GetState().pc, 0x0003);
+  EXPECT_EQ(QNes::CPU_Testing::GetInstructionCycle(cpu), 0);
+}
+
+TEST_F(StepInstructionTest, RunsResetSequence) {
+  Write(0xFFFC, 0x34);
+  Write(0xFFFD, 0x12);
+  QNes::CPU_Testing::ZeroInterruptCycle(cpu);
+  cpu.Reset();
+
+  EXPECT_EQ(cpu.StepInstruction(), 5);
+  EXPECT_EQ(cpu.GetState().pc, 0x1234);
+  EXPECT_EQ(QNes::CPU_Testing::GetGlobalMode(cpu), QNes::CPU::GlobalMode::RUN);
+}
+
+TEST_F(StepInstructionTest, TakesPendingNMI) {
+  Write(0xFFFA, 0x00);
+  Write(0xFFFB, 0x80);
+  QNes::CPU_Testing::SetPC(cpu, 0x0200);
+  cpu.SignalNMI();
+
+  EXPECT_EQ(cpu.StepInstruction(), 7);
+  EXPECT_EQ(cpu.GetState().pc, 0x8000);
+  EXPECT_EQ(cpu.GetState().sp, 0xFA);
+  EXPECT_TRUE(cpu.GetState().status.interrupt_disable);
+  EXPECT_EQ(QNes::CPU_Testing::GetGlobalMode(cpu), QNes::CPU::GlobalMode::RUN);
+}
+
+TEST_F(StepInstructionTest, MatchesCycleSteppingOnRandomPrograms) {
+  const auto &instructions = QNes::InstructionTables<QNes::CPU>::cycle;
+  std::vector<u8> legal_opcodes;
+  for (size_t opcode = 0; opcode < instructions.size(); ++opcode) {
+    if (instructions[opcode] != nullptr) {
+      legal_opcodes.push_back(static_cast<u8>(opcode));
+    }
+  }
+
+  std::mt19937 rng(0x6502);
+  std::uniform_int_distribution<size_t> pick(0, legal_opcodes.size() - 1);
+
+  for (int program = 0; program < 8; ++program) {
+    SetUp();
+    // Every byte is a legal opcode, so any jump/branch target is executable
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      Write(static_cast<u16>(address), legal_opcodes[pick(rng)]);
+    }
+
+    for (int instruction = 0; instruction < 20000; ++instruction) {
+      const u16 pc = cpu.GetState().pc;
+      // stores can leave illegal opcodes behind
+      if (instructions[memory.Read(pc)] == nullptr) {
+        break;
+      }
+
+      const int cycles = cpu.StepInstruction();
+      const int reference_cycles = StepReferenceInstruction();
+
+      ASSERT_EQ(cycles, reference_cycles)
+          << "program " << program << " instruction " << instruction
+          << " at PC 0x" << std::hex << pc;
+      ExpectSameState(cpu.GetState(), reference_cpu.GetState());
+      if (HasFailure()) {
+        FAIL() << "program " << program << " instruction " << instruction
+               << " at PC 0x" << std::hex << pc;
+      }
+    }
+
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      ASSERT_EQ(memory.Read(static_cast<u16>(address)),
+                reference_memory.Read(static_cast<u16>(address)))
+          << "program " << program << " address 0x" << std::hex << address;
+    }
+  }
+}
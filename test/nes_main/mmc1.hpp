@@ -0,0 +1,17 @@
+#pragma once
+
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+// MMC1 registers are written one bit at a time through a shift register,
+// lowest first. A range of the 5 bits leaves the write unfinished.
+inline void WriteMMC1(NESBus &bus, u16 address, u8 value, int first_bit = 0,
+                      int last_bit = 4) {
+  for (int bit = first_bit; bit <= last_bit; ++bit) {
+    bus.Write(address, static_cast<u8>((value >> bit) & 0x01));
+  }
+}
+
+}  // namespace QNes
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "qnes_battery.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_mapper.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+class BatteryTest : public ::testing::Test {
+ protected:
+  BatteryTest() : emulator(std::make_unique<Emulator>()) {}
+
+  static std::vector<u8> ReadFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), {}};
+  }
+
+  // NROM with 8 KB of PRG-RAM at $6000
+  Cartridge &Insert(bool battery = true) {
+    std::vector<u8> image = {'N',  'E', 'S', 0x1A, 0x01, 0x01,
+                             static_cast<u8>(battery ? 0x02 : 0x00)};
+    image.resize(RomImage::HEADER_SIZE);
+    image.insert(image.end(), Kilobytes(16) + Kilobytes(8), 0xEA);
+    EXPECT_TRUE(emulator->InsertCartridge(RomImage::Open(files.Write(image))));
+    return *Emulator_Testing::GetCartridge(*emulator);
+  }
+
+  NESBus &GetBus() { return Emulator_Testing::GetBus(*emulator); }
+
+  std::unique_ptr<Emulator> emulator;
+  TempFiles files;
+};
+
+TEST_F(BatteryTest, LoadsTheSaveIntoPRGRAM) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  std::vector<u8> save(Kilobytes(8));
+  save[0] = 0x12;
+  save[0x1FFF] = 0x34;
+  TempFiles::WriteFile(path, save);
+
+  const BatteryFilePtr battery =
+      BatteryFile::Open(path, cartridge, BatteryFile::Mode::WRITE);
+  ASSERT_NE(battery, nullptr);
+  EXPECT_EQ(GetBus().Read(0x6000), 0x12);
+  EXPECT_EQ(GetBus().Read(0x7FFF), 0x34);
+  // nothing was written since
+  EXPECT_FALSE(battery->EndFrame());
+  EXPECT_EQ(battery->GetSaveCount(), 0);
+}
+
+TEST_F(BatteryTest, OnlyBatteryBoardsHaveAFile) {
+  Cartridge &cartridge = Insert(false);
+  EXPECT_EQ(BatteryFile::Open(files.Path(".sav"), cartridge,
+                              BatteryFile::Mode::WRITE),
+            nullptr);
+}
+
+TEST_F(BatteryTest, SavesWrittenFramesInTheBackground) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  const BatteryFilePtr battery =
+      BatteryFile::Open(path, cartridge, BatteryFile::Mode::WRITE);
+  ASSERT_NE(battery, nullptr);
+  EXPECT_FALSE(battery->EndFrame());
+
+  GetBus().Write(0x6400, 0xAB);
+  EXPECT_TRUE(battery->EndFrame());
+  // written after the frame ended: not part of its file
+  GetBus().Write(0x6401, 0xCD);
+  ASSERT_TRUE(battery->Flush());
+  std::vector<u8> saved = ReadFile(path);
+  ASSERT_EQ(saved.size(), Kilobytes(8));
+  EXPECT_EQ(saved[0x400], 0xAB);
+  EXPECT_EQ(saved[0x401], 0x00);
+  EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  EXPECT_TRUE(battery->EndFrame());
+  EXPECT_FALSE(battery->EndFrame());
+  ASSERT_TRUE(battery->Flush());
+  saved = ReadFile(path);
+  EXPECT_EQ(saved[0x401], 0xCD);
+  EXPECT_EQ(battery->GetSaveCount(), 2);
+}
+
+TEST_F(BatteryTest, ClosingSavesTheLastFrame) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  {
+    const BatteryFilePtr battery =
+        BatteryFile::Open(path, cartridge, BatteryFile::Mode::WRITE);
+    ASSERT_NE(battery, nullptr);
+    GetBus().Write(0x7000, 0x5A);
+    EXPECT_TRUE(battery->EndFrame());
+  }
+  const std::vector<u8> saved = ReadFile(path);
+  ASSERT_EQ(saved.size(), Kilobytes(8));
+  EXPECT_EQ(saved[0x1000], 0x5A);
+}
+
+TEST_F(BatteryTest, MappedFileFollowsTheFrames) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  const BatteryFilePtr battery =
+      BatteryFile::Open(path, cartridge, BatteryFile::Mode::MAPPED);
+  ASSERT_NE(battery, nullptr);
+  // a new file is created with the size of PRG-RAM
+  EXPECT_EQ(ReadFile(path).size(), Kilobytes(8));
+
+  GetBus().Write(0x6000, 0x11);
+  GetBus().Write(0x7C00, 0x22);
+  EXPECT_TRUE(battery->EndFrame());
+  GetBus().Write(0x6001, 0x33);
+  ASSERT_TRUE(battery->Flush());
+  const std::vector<u8> saved = ReadFile(path);
+  ASSERT_EQ(saved.size(), Kilobytes(8));
+  EXPECT_EQ(saved[0], 0x11);
+  EXPECT_EQ(saved[1], 0x00);
+  EXPECT_EQ(saved[0x1C00], 0x22);
+}
+
+TEST_F(BatteryTest, MappedFileIsNeverCut) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  std::vector<u8> save(Kilobytes(16), 0x44);
+  save[0] = 0x12;
+  TempFiles::WriteFile(path, save);
+
+  const BatteryFilePtr battery =
+      BatteryFile::Open(path, cartridge, BatteryFile::Mode::MAPPED);
+  ASSERT_NE(battery, nullptr);
+  EXPECT_EQ(GetBus().Read(0x6000), 0x12);
+  GetBus().Write(0x6000, 0x34);
+  EXPECT_TRUE(battery->EndFrame());
+  ASSERT_TRUE(battery->Flush());
+  save[0] = 0x34;
+  EXPECT_EQ(ReadFile(path), save);
+}
+
+TEST_F(BatteryTest, ForkedEmulatorDoesNotWriteTheFile) {
+  Cartridge &cartridge = Insert();
+  const std::string path = files.Path(".sav");
+  const BatteryFilePtr battery =
+      BatteryFile::Open(path, cartridge, BatteryFile::Mode::WRITE);
+  ASSERT_NE(battery, nullptr);
+
+  const std::unique_ptr<Emulator> fork = emulator->Fork();
+  Emulator_Testing::GetBus(*fork).Write(0x6000, 0x99);
+  EXPECT_FALSE(battery->EndFrame());
+  EXPECT_EQ(GetBus().Read(0x6000), 0x00);
+}
+
+}  // namespace
+}  // namespace QNes
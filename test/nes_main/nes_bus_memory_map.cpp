@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+#include "qnes_bits.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_memory.hpp"
+
+namespace QNes {
+namespace {
+
+// Records writes to the mapped I/O range
+struct RegisterDevice {
+  static u8 Read(void *device, u16 address) {
+    return static_cast<u8>(static_cast<RegisterDevice *>(device)->value +
+                           U16Low(address));
+  }
+  static void Write(void *device, u16 address, u8 value) {
+    auto *self = static_cast<RegisterDevice *>(device);
+    self->last_address = address;
+    self->value = value;
+  }
+
+  u16 last_address = 0;
+  u8 value = 0;
+};
+
+class NESBusMemoryMapTest : public ::testing::Test {
+ protected:
+  // NOTE: PPU is not used in this test
+  NESBusMemoryMapTest() : bus(&memory, nullptr) {
+    memory.Clear();
+  }
+
+  u8 Read(u16 address) {
+    return bus.Read(address);
+  }
+  void Write(u16 address, u8 value) {
+    bus.Write(address, value);
+  }
+
+  WorkRAM memory;
+  NESBus bus;
+};
+
+TEST_F(NESBusMemoryMapTest, UnmappedCartridgeSpaceReadsOpenBus) {
+  EXPECT_EQ(Read(0x8000), 0x80);
+  EXPECT_EQ(Read(0xFFFC), 0xFF);
+  EXPECT_EQ(Read(0x4016), 0x40);
+  Write(0x8000, 0x12);
+  EXPECT_EQ(Read(0x8000), 0x80);
+  EXPECT_FALSE(bus.IsIdempotentRead(0x8000));
+}
+
+TEST_F(NESBusMemoryMapTest, PRGSmallerThanRangeIsMirrored) {
+  // 16 KB PRG-ROM in a 32 KB window, like NROM-128
+  std::vector<u8> prg(Kilobytes(16));
+  for (size_t i = 0; i < prg.size(); ++i) {
+    prg[i] = static_cast<u8>(i * 7);
+  }
+  bus.MapMemory(0x8000, 0x8000, prg.data(), Kilobytes(16), false);
+
+  for (u16 offset : {0x0000, 0x0001, 0x03FF, 0x0400, 0x2ABC, 0x3FFF}) {
+    EXPECT_EQ(Read(static_cast<u16>(0x8000 + offset)), prg[offset]);
+    EXPECT_EQ(Read(static_cast<u16>(0xC000 + offset)), prg[offset]);
+  }
+  // ROM is not written
+  Write(0x8000, 0xAA);
+  EXPECT_EQ(prg[0], 0x00);
+  EXPECT_TRUE(bus.IsDecodeCacheable(0xC123));
+  EXPECT_TRUE(bus.IsIdempotentRead(0xC123));
+}
+
+TEST_F(NESBusMemoryMapTest, ROMWritesGoToMapperRegisters) {
+  std::vector<u8> prg(Kilobytes(32), 0x5A);
+  RegisterDevice mapper;
+  bus.MapMemory(0x8000, 0x8000, prg.data(), Kilobytes(32), false);
+  bus.MapIO(0x8000, 0x8000, nullptr, RegisterDevice::Write, &mapper);
+
+  Write(0xE001, 0x03);
+  EXPECT_EQ(mapper.last_address, 0xE001);
+  EXPECT_EQ(mapper.value, 0x03);
+  // Reads still come from the ROM
+  EXPECT_EQ(Read(0xE001), 0x5A);
+}
+
+TEST_F(NESBusMemoryMapTest, WritableMemoryIsReadAndWrittenDirectly) {
+  std::vector<u8> prg_ram(Kilobytes(8));
+  bus.MapMemory(0x6000, 0x2000, prg_ram.data(), Kilobytes(8), true);
+
+  Write(0x6000, 0x11);
+  Write(0x7FFF, 0x22);
+  EXPECT_EQ(prg_ram[0x0000], 0x11);
+  EXPECT_EQ(prg_ram[0x1FFF], 0x22);
+  EXPECT_EQ(Read(0x7FFF), 0x22);
+  EXPECT_FALSE(bus.IsDecodeCacheable(0x6000));
+}
+
+TEST_F(NESBusMemoryMapTest, MemorySmallerThanPageIsMirroredWithinPage) {
+  std::array<u8, 0x100> small{};
+  small[0x42] = 0x99;
+  bus.MapMemory(0x5000, NESBus::PAGE_SIZE, small.data(), 0x100, true);
+
+  EXPECT_EQ(Read(0x5042), 0x99);
+  EXPECT_EQ(Read(0x5342), 0x99);
+  Write(0x5201, 0x01);
+  EXPECT_EQ(small[0x01], 0x01);
+}
+
+TEST_F(NESBusMemoryMapTest, IOPagesCallTheirHandlers) {
+  RegisterDevice device;
+  bus.MapIO(0x5000, NESBus::PAGE_SIZE, RegisterDevice::Read,
+            RegisterDevice::Write, &device);
+
+  Write(0x5003, 0x10);
+  EXPECT_EQ(device.last_address, 0x5003);
+  EXPECT_EQ(Read(0x5005), 0x15);
+
+  bus.Unmap(0x5000, NESBus::PAGE_SIZE);
+  EXPECT_EQ(Read(0x5005), 0x50);
+}
+
+TEST_F(NESBusMemoryMapTest, ForkedPagedMemoryIsCopiedOnFirstWrite) {
+  // 8 KB PRG-RAM mirrored twice over $4000-$7FFF
+  PagedMemory prg_ram(Kilobytes(8));
+  prg_ram.Write(0x0000, 0x11);
+  prg_ram.Write(0x1400, 0x22);
+  bus.MapPagedMemory(0x4400, 0x0400, &prg_ram, 0x0000, true);
+  bus.MapPagedMemory(0x6000, 0x2000, &prg_ram, 0x0000, true);
+  EXPECT_EQ(Read(0x6000), 0x11);
+  Write(0x6001, 0x33);
+  EXPECT_EQ(prg_ram.Read(0x0001), 0x33);
+
+  // the fork gets its own bus, the parent bus has to protect its pages
+  PagedMemoryPtr fork = prg_ram.Fork();
+  bus.ProtectSharedPages();
+  WorkRAM fork_ram;
+  NESBus fork_bus(&fork_ram, nullptr);
+  fork_bus.MapPagedMemory(0x6000, 0x2000, fork.get(), 0x0000, true);
+  EXPECT_TRUE(prg_ram.IsShared(0));
+  EXPECT_FALSE(bus.IsDecodeCacheable(0x6000));
+
+  Write(0x6000, 0x44);
+  EXPECT_EQ(Read(0x6000), 0x44);
+  EXPECT_EQ(Read(0x4400), 0x44);  // the mirror sees the copy
+  EXPECT_EQ(fork_bus.Read(0x6000), 0x11);
+  EXPECT_EQ(fork->Read(0x0001), 0x33);
+  EXPECT_FALSE(prg_ram.IsShared(0));
+  // untouched pages stay shared
+  EXPECT_TRUE(prg_ram.IsShared(5));
+  EXPECT_EQ(fork_bus.Read(0x7400), 0x22);
+
+  fork_bus.Write(0x7400, 0x55);
+  EXPECT_EQ(fork->Read(0x1400), 0x55);
+  EXPECT_EQ(Read(0x7400), 0x22);
+  // the page is not shared anymore, the parent writes it in place
+  Write(0x7401, 0x66);
+  EXPECT_EQ(prg_ram.Read(0x1401), 0x66);
+  EXPECT_EQ(fork_bus.Read(0x7401), 0x00);
+}
+
+TEST_F(NESBusMemoryMapTest, ReadOnlyPagedMemoryStaysShared) {
+  PagedMemory prg_rom(Kilobytes(16));
+  prg_rom.Write(0x3FFC, 0x80);
+  PagedMemoryPtr fork = prg_rom.Fork();
+  bus.MapPagedMemory(0x8000, 0x8000, &prg_rom, 0x0000, false);
+  bus.ProtectSharedPages();
+
+  EXPECT_EQ(Read(0xFFFC), 0x80);
+  Write(0xFFFC, 0x00);
+  EXPECT_EQ(Read(0xFFFC), 0x80);
+  EXPECT_TRUE(prg_rom.IsShared(15));
+  EXPECT_EQ(prg_rom.GetPage(15), fork->GetPage(15));
+  EXPECT_TRUE(bus.IsDecodeCacheable(0xC000));
+}
+
+TEST_F(NESBusMemoryMapTest, InternalRamIsNotDecodeCacheable) {
+  EXPECT_FALSE(bus.IsDecodeCacheable(0x0000));
+  EXPECT_TRUE(bus.IsIdempotentRead(0x0000));
+}
+
+}  // namespace
+}  // namespace QNes
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_memory.hpp"
+
+namespace QNes {
+namespace {
+
+static_assert(HasInternalRAM<NESBus>);
+static_assert(!HasInternalRAM<RAMBus>);
+static_assert(!HasInternalRAM<Bus>);
+
+// The NESBus CPU takes zero page and stack accesses straight from internal
+// RAM, a RAMBus CPU running the same program goes through the bus
+class NESCPULowPageTest : public ::testing::TestWithParam<CPU::Dispatch> {
+ protected:
+  // NOTE: PPU is not used in this test
+  NESCPULowPageTest()
+      : nes_bus(&ram, nullptr),
+        nes_cpu(&nes_bus),
+        reference_memory(Kilobytes(64)),
+        reference_bus(&reference_memory),
+        reference_cpu(&reference_bus) {}
+
+  void SetUp() override {
+    ram.Clear();
+    reference_memory.Clear();
+    Start(nes_cpu);
+    Start(reference_cpu);
+  }
+
+  template <typename BUS>
+  void Start(BasicCPU<BUS> &cpu) {
+    CPU_Testing::SetGlobalMode(cpu, CPU::GlobalMode::RUN);
+    CPU_Testing::SetPC(cpu, 0x0300);
+    CPU_Testing::SetSP(cpu, 0xFD);
+    CPU_Testing::SetInstructionCycle(cpu, 0);
+    cpu.SetDispatch(GetParam());
+  }
+
+  void Load(u16 address, const std::vector<u8> &data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      nes_bus.Write(static_cast<u16>(address + i), data[i]);
+      reference_memory.Write(static_cast<u16>(address + i), data[i]);
+    }
+  }
+
+  WorkRAM ram;
+  NESBus nes_bus;
+  BasicCPU<NESBus> nes_cpu;
+  Memory reference_memory;
+  RAMBus reference_bus;
+  CPU reference_cpu;
+};
+
+TEST_P(NESCPULowPageTest, ZeroPageAndStackMatchTheBusPath) {
+  Load(0x0300, {
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x42,        // $0300
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE,  0x10,        // $0302
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x05,        // $0304
+      ISA::STX<AddressingMode::ZeroPage>::OPCODE,  0x11,        // $0306
+      ISA::INC<AddressingMode::ZeroPage>::OPCODE,  0x10,        // $0308
+      ISA::LDA<AddressingMode::ZeroPage>::OPCODE,  0x10,        // $030A
+      ISA::PHA<AddressingMode::Implied>::OPCODE,                // $030C
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x00,        // $030D
+      ISA::PLA<AddressingMode::Implied>::OPCODE,                // $030F
+      ISA::JSR<AddressingMode::Absolute>::OPCODE,  0x20, 0x03,  // $0310
+      ISA::LDX<AddressingMode::Immediate>::OPCODE, 0x01,        // $0313
+      ISA::LDA<AddressingMode::ZeroPageX>::OPCODE, 0x10,        // $0315
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x17, 0x03,  // $0317
+  });
+  // sub: STA $12 ; LDY $12 ; RTS
+  Load(0x0320, {
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE, 0x12,
+      ISA::LDY<AddressingMode::ZeroPage>::OPCODE, 0x12,
+      ISA::RTS<AddressingMode::Implied>::OPCODE,
+  });
+
+  nes_cpu.RunUntil(200);
+  reference_cpu.RunUntil(200);
+
+  EXPECT_EQ(nes_cpu.GetCycleCount(), reference_cpu.GetCycleCount());
+  const auto state = nes_cpu.GetState();
+  const auto reference_state = reference_cpu.GetState();
+  EXPECT_EQ(state.pc, reference_state.pc);
+  EXPECT_EQ(state.sp, reference_state.sp);
+  EXPECT_EQ(state.a, 0x05);
+  EXPECT_EQ(state.a, reference_state.a);
+  EXPECT_EQ(state.y, 0x43);
+  EXPECT_EQ(state.y, reference_state.y);
+
+  EXPECT_EQ(ram.Read(0x0010), 0x43);
+  EXPECT_EQ(ram.Read(0x0011), 0x05);
+  EXPECT_EQ(ram.Read(0x0012), 0x43);
+  for (u16 address = 0x0000; address < 0x0200; ++address) {
+    EXPECT_EQ(ram.Read(address), reference_memory.Read(address))
+        << "address 0x" << std::hex << address;
+  }
+  // zero page and stack are visible through the mirrors
+  EXPECT_EQ(nes_bus.Read(0x0810), 0x43);
+  EXPECT_EQ(nes_bus.Read(0x19FD), reference_memory.Read(0x01FD));
+}
+
+TEST_P(NESCPULowPageTest, MirroredWritesAreSeenByZeroPageReads) {
+  // LDA $20 ; TAX ; JMP *
+  Load(0x0300, {
+      ISA::LDA<AddressingMode::ZeroPage>::OPCODE, 0x20,
+      ISA::TAX<AddressingMode::Implied>::OPCODE,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE, 0x03, 0x03,
+  });
+  nes_bus.Write(0x1020, 0x7E);
+
+  nes_cpu.RunUntil(20);
+  EXPECT_EQ(nes_cpu.GetState().x, 0x7E);
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, NESCPULowPageTest,
+                         ::testing::Values(CPU::Dispatch::TABLE,
+                                           CPU::Dispatch::THREADED,
+                                           CPU::Dispatch::JIT));
+
+}  // namespace
+}  // namespace QNes
@@ -0,0 +1,308 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "mmc1.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_mapper.hpp"
+#include "qnes_memory.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+class MapperTest : public ::testing::Test {
+ protected:
+  MapperTest() : emulator(std::make_unique<Emulator>()) {}
+
+  // iNES image with prg_rom 16 KB and chr_rom 8 KB units. Every 8 KB bank of
+  // PRG-ROM is filled with its number, every 1 KB bank of CHR-ROM too.
+  static std::vector<u8> MakeImage(u8 mapper, u8 prg_rom, u8 chr_rom,
+                                   u8 flags6 = 0) {
+    std::vector<u8> image = {'N', 'E', 'S', 0x1A, prg_rom, chr_rom,
+                             static_cast<u8>((mapper << 4) | flags6),
+                             static_cast<u8>(mapper & 0xF0)};
+    image.resize(RomImage::HEADER_SIZE);
+    for (size_t i = 0; i < prg_rom * Kilobytes(16); ++i) {
+      image.push_back(static_cast<u8>(i / Kilobytes(8)));
+    }
+    for (size_t i = 0; i < chr_rom * Kilobytes(8); ++i) {
+      image.push_back(static_cast<u8>(i / Kilobytes(1)));
+    }
+    return image;
+  }
+
+  bool Insert(const std::vector<u8> &data) {
+    const RomImagePtr image = RomImage::Open(files.Write(data));
+    return image != nullptr && emulator->InsertCartridge(image);
+  }
+
+  NESBus &GetBus() { return Emulator_Testing::GetBus(*emulator); }
+  PPUBus &GetPPUBus() { return Emulator_Testing::GetPPUBus(*emulator); }
+  bool IsIRQPending() {
+    CPUCore::Snapshot snapshot{};
+    Emulator_Testing::GetCPU(*emulator).SaveSnapshot(snapshot);
+    return snapshot.irq_pending;
+  }
+
+  std::unique_ptr<Emulator> emulator;
+  TempFiles files;
+};
+
+TEST_F(MapperTest, RejectsUnsupportedMappers) {
+  EXPECT_FALSE(Insert(MakeImage(5, 2, 1)));
+  EXPECT_EQ(Emulator_Testing::GetCartridge(*emulator), nullptr);
+}
+
+TEST_F(MapperTest, NROMMirrorsSixteenKilobyteImages) {
+  ASSERT_TRUE(Insert(MakeImage(0, 1, 1)));
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetBus().Read(0xA000), 1);
+  EXPECT_EQ(GetBus().Read(0xC000), 0);
+  EXPECT_EQ(GetBus().Read(0xFFFF), 1);
+  GetBus().Write(0x8000, 0x55);  // no registers, ROM stays
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 0);
+  EXPECT_EQ(GetPPUBus().Read(0x1C00), 7);
+
+  GetBus().Write(0x6000, 0x42);  // PRG-RAM
+  EXPECT_EQ(GetBus().Read(0x6000), 0x42);
+}
+
+TEST_F(MapperTest, UxROMSwitchesTheLowBank) {
+  ASSERT_TRUE(Insert(MakeImage(2, 8, 0)));
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetBus().Read(0xC000), 14);  // last 16 KB
+  GetBus().Write(0x8000, 3);
+  EXPECT_EQ(GetBus().Read(0x8000), 6);
+  EXPECT_EQ(GetBus().Read(0xBFFF), 7);
+  EXPECT_EQ(GetBus().Read(0xE000), 15);
+  GetBus().Write(0xFFFF, 9);  // wraps around the 8 banks
+  EXPECT_EQ(GetBus().Read(0x8000), 2);
+
+  // CHR-RAM
+  GetPPUBus().Write(0x1234, 0xAB);
+  EXPECT_EQ(GetPPUBus().Read(0x1234), 0xAB);
+}
+
+TEST_F(MapperTest, CNROMSwitchesCHR) {
+  ASSERT_TRUE(Insert(MakeImage(3, 2, 4)));
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 0);
+  GetBus().Write(0x8000, 2);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 16);
+  EXPECT_EQ(GetPPUBus().Read(0x1FFF), 23);
+  GetPPUBus().Write(0x0000, 0x55);  // CHR-ROM
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 16);
+  EXPECT_EQ(GetBus().Read(0xC000), 2);
+}
+
+TEST_F(MapperTest, MMC1LoadsRegistersSerially) {
+  ASSERT_TRUE(Insert(MakeImage(1, 8, 4)));
+  // power-on: 16 KB mode, last bank fixed at $C000
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetBus().Read(0xC000), 14);
+
+  for (int bit = 0; bit < 4; ++bit) {
+    GetBus().Write(0xE000, 1);
+  }
+  EXPECT_EQ(GetBus().Read(0x8000), 0);  // four bits do not load it
+  GetBus().Write(0xE000, 0);
+  EXPECT_EQ(GetBus().Read(0x8000), 14);  // bank 15 wraps to 7
+
+  // first bank fixed at $8000, 4 KB CHR banks, vertical mirroring
+  WriteMMC1(GetBus(), 0x8000, 0x1A);
+  WriteMMC1(GetBus(), 0xE000, 3);
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetBus().Read(0xC000), 6);
+  WriteMMC1(GetBus(), 0xA000, 5);
+  WriteMMC1(GetBus(), 0xC000, 2);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 20);
+  EXPECT_EQ(GetPPUBus().Read(0x1000), 8);
+
+  GetPPUBus().Write(0x2000, 0x11);
+  EXPECT_EQ(GetPPUBus().Read(0x2800), 0x11);
+  EXPECT_NE(GetPPUBus().Read(0x2400), 0x11);
+}
+
+TEST_F(MapperTest, MMC1ResetBitRestoresTheFixedLastBank) {
+  ASSERT_TRUE(Insert(MakeImage(1, 8, 4)));
+  WriteMMC1(GetBus(), 0x8000, 0x08);
+  EXPECT_EQ(GetBus().Read(0xC000), 0);
+
+  GetBus().Write(0xE000, 1);
+  GetBus().Write(0xE000, 1);
+  GetBus().Write(0x8000, 0x80);  // drops the two bits
+  EXPECT_EQ(GetBus().Read(0xC000), 14);
+  WriteMMC1(GetBus(), 0xE000, 1);
+  EXPECT_EQ(GetBus().Read(0x8000), 2);
+}
+
+TEST_F(MapperTest, MMC1SelectsSingleScreenMirroring) {
+  ASSERT_TRUE(Insert(MakeImage(1, 2, 1)));
+  WriteMMC1(GetBus(), 0x8000, 0x0C);
+  GetPPUBus().Write(0x2000, 0x22);
+  EXPECT_EQ(GetPPUBus().Read(0x2400), 0x22);
+  EXPECT_EQ(GetPPUBus().Read(0x2C00), 0x22);
+
+  WriteMMC1(GetBus(), 0x8000, 0x0D);
+  EXPECT_NE(GetPPUBus().Read(0x2000), 0x22);
+  GetPPUBus().Write(0x2800, 0x33);
+  EXPECT_EQ(GetPPUBus().Read(0x2000), 0x33);
+  WriteMMC1(GetBus(), 0x8000, 0x0C);
+  EXPECT_EQ(GetPPUBus().Read(0x2C00), 0x22);
+}
+
+TEST_F(MapperTest, MMC3SwitchesPRGAndCHRBanks) {
+  ASSERT_TRUE(Insert(MakeImage(4, 8, 16)));
+  EXPECT_EQ(GetBus().Read(0x8000), 0);
+  EXPECT_EQ(GetBus().Read(0xA000), 1);
+  EXPECT_EQ(GetBus().Read(0xC000), 14);
+  EXPECT_EQ(GetBus().Read(0xE000), 15);
+
+  GetBus().Write(0x8000, 6);
+  GetBus().Write(0x8001, 3);
+  GetBus().Write(0x8000, 7);
+  GetBus().Write(0x8001, 5);
+  EXPECT_EQ(GetBus().Read(0x8000), 3);
+  EXPECT_EQ(GetBus().Read(0xA000), 5);
+  GetBus().Write(0x8000, 0x46);  // second-last bank at $8000
+  EXPECT_EQ(GetBus().Read(0x8000), 14);
+  EXPECT_EQ(GetBus().Read(0xC000), 3);
+
+  GetBus().Write(0x8000, 0);
+  GetBus().Write(0x8001, 8);
+  GetBus().Write(0x8000, 2);
+  GetBus().Write(0x8001, 20);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 8);
+  EXPECT_EQ(GetPPUBus().Read(0x0400), 9);
+  EXPECT_EQ(GetPPUBus().Read(0x1000), 20);
+  GetBus().Write(0x8000, 0x80);  // A12 inversion
+  EXPECT_EQ(GetPPUBus().Read(0x1000), 8);
+  EXPECT_EQ(GetPPUBus().Read(0x1400), 9);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 20);
+
+  GetBus().Write(0xA000, 1);  // horizontal
+  GetPPUBus().Write(0x2000, 0x44);
+  EXPECT_EQ(GetPPUBus().Read(0x2400), 0x44);
+  EXPECT_NE(GetPPUBus().Read(0x2800), 0x44);
+}
+
+TEST_F(MapperTest, MMC3CountsScanlinesAndRaisesIRQ) {
+  ASSERT_TRUE(Insert(MakeImage(4, 2, 1)));
+  Cartridge *cartridge = Emulator_Testing::GetCartridge(*emulator);
+  GetBus().Write(0xC000, 2);  // latch
+  GetBus().Write(0xC001, 0);  // reload
+  GetBus().Write(0xE001, 0);  // enable
+
+  cartridge->ClockScanline();  // reloads 2
+  cartridge->ClockScanline();
+  EXPECT_FALSE(IsIRQPending());
+  cartridge->ClockScanline();
+  EXPECT_TRUE(IsIRQPending());
+
+  GetBus().Write(0xE000, 0);  // disable and acknowledge
+  EXPECT_FALSE(IsIRQPending());
+  for (int scanline = 0; scanline < 6; ++scanline) {
+    cartridge->ClockScanline();
+  }
+  EXPECT_FALSE(IsIRQPending());
+}
+
+TEST_F(MapperTest, FourScreenBoardsHaveTheirOwnNametables) {
+  ASSERT_TRUE(Insert(MakeImage(4, 2, 1, 0x08)));
+  GetBus().Write(0xA000, 1);  // ignored, the board wires four screens
+  for (u16 table = 0; table < 4; ++table) {
+    GetPPUBus().Write(static_cast<u16>(0x2000 + table * 0x400),
+                      static_cast<u8>(0xA0 + table));
+  }
+  for (u16 table = 0; table < 4; ++table) {
+    EXPECT_EQ(GetPPUBus().Read(static_cast<u16>(0x2000 + table * 0x400)),
+              0xA0 + table);
+  }
+  EXPECT_EQ(GetPPUBus().Read(0x3800), 0xA2);
+}
+
+TEST_F(MapperTest, ForkSharesPRGRAMCopyOnWrite) {
+  ASSERT_TRUE(Insert(MakeImage(2, 8, 0)));
+  GetBus().Write(0x8000, 3);
+  GetBus().Write(0x6000, 0x42);
+  GetPPUBus().Write(0x0000, 0x99);
+
+  std::unique_ptr<Emulator> fork = emulator->Fork();
+  NESBus &fork_bus = Emulator_Testing::GetBus(*fork);
+  PPUBus &fork_ppu_bus = Emulator_Testing::GetPPUBus(*fork);
+  EXPECT_TRUE(
+      Emulator_Testing::GetCartridge(*emulator)->GetPRGRAM()->IsShared(0));
+  EXPECT_EQ(fork_bus.Read(0x8000), 6);
+  EXPECT_EQ(fork_bus.Read(0x6000), 0x42);
+  EXPECT_EQ(fork_ppu_bus.Read(0x0000), 0x99);
+
+  fork_bus.Write(0x6000, 0x43);
+  GetBus().Write(0x6001, 0x44);
+  fork_bus.Write(0x8000, 1);
+  fork_ppu_bus.Write(0x0000, 0x11);
+  EXPECT_EQ(GetBus().Read(0x6000), 0x42);
+  EXPECT_EQ(GetBus().Read(0x6001), 0x44);
+  EXPECT_EQ(fork_bus.Read(0x6000), 0x43);
+  EXPECT_EQ(fork_bus.Read(0x6001), 0x00);
+  EXPECT_EQ(GetBus().Read(0x8000), 6);
+  EXPECT_EQ(fork_bus.Read(0x8000), 2);
+  EXPECT_EQ(GetPPUBus().Read(0x0000), 0x99);
+}
+
+class MapperDispatchTest : public MapperTest,
+                           public ::testing::WithParamInterface<CPU::Dispatch> {
+};
+
+TEST_P(MapperDispatchTest, BankSwitchDropsDecodedAndCompiledCode) {
+  // UxROM, every switchable bank has LDA #$B0 + bank ; RTS at $9000 (away
+  // from the written register address, CPU writes invalidate that one anyway)
+  std::vector<u8> image = MakeImage(2, 4, 0);
+  const size_t prg = RomImage::HEADER_SIZE;
+  for (u8 bank = 0; bank < 3; ++bank) {
+    const size_t offset = prg + bank * Kilobytes(16) + 0x1000;
+    image[offset] = ISA::LDA<AddressingMode::Immediate>::OPCODE;
+    image[offset + 1] = static_cast<u8>(0xB0 + bank);
+    image[offset + 2] = ISA::RTS<AddressingMode::Implied>::OPCODE;
+  }
+  // $C000: JSR $9000 ; STA $10 ; LDA #1 ; STA $8000 ; JSR $9000 ; STA $11 ;
+  //        LDA #0 ; STA $8000 ; JMP $C000
+  const std::vector<u8> program = {
+      ISA::JSR<AddressingMode::Absolute>::OPCODE,  0x00, 0x90,
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE,  0x10,
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x01,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00, 0x80,
+      ISA::JSR<AddressingMode::Absolute>::OPCODE,  0x00, 0x90,
+      ISA::STA<AddressingMode::ZeroPage>::OPCODE,  0x11,
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x00,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00, 0x80,
+      ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x00, 0xC0,
+  };
+  const size_t fixed = prg + 3 * Kilobytes(16);
+  std::ranges::copy(program, image.begin() + static_cast<long>(fixed));
+  image[fixed + 0x3FFC] = 0x00;  // reset vector
+  image[fixed + 0x3FFD] = 0xC0;
+  ASSERT_TRUE(Insert(image));
+
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  cpu.SetDispatch(GetParam());
+  cpu.EnableDecodeCache();
+  cpu.RunUntil(50000);
+  WorkRAM &memory = Emulator_Testing::GetMemory(*emulator);
+  EXPECT_EQ(memory.Read(0x10), 0xB0);
+  EXPECT_EQ(memory.Read(0x11), 0xB1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, MapperDispatchTest,
+                         ::testing::Values(CPU::Dispatch::TABLE,
+                                           CPU::Dispatch::THREADED,
+                                           CPU::Dispatch::JIT));
+
+}  // namespace
+}  // namespace QNes
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <span>
 
 #include "qnes_bits.hpp"
 #include "qnes_bus.hpp"
@@ -14,18 +15,14 @@ namespace {
 class NESBusMirroringTest : public ::testing::Test {
  protected:
   // NOTE: PPU is not used in this test
-  NESBusMirroringTest() : memory(Kilobytes(2)), bus(&memory, nullptr) {
+  NESBusMirroringTest() : bus(&memory, nullptr) {
     memory.Clear();
   }
 
-  void SetAddress(u16 address) {
-    bus.SetAddress(U16High(address), U16Low(address));
-  }
-
   static constexpr std::array<u16, 4> kMirrors = {0x0000, 0x0800, 0x1000,
                                                   0x1800};
 
-  Memory memory;
+  WorkRAM memory;
   NESBus bus;
 };
 
@@ -41,8 +38,7 @@ TEST_F(NESBusMirroringTest, WriteMirrorsEvery2KB) {
       const u16 mirrored_address = static_cast<u16>(base + offset);
       ASSERT_LT(mirrored_address, 0x2000);
 
-      SetAddress(mirrored_address);
-      bus.Write(write_value);
+      bus.Write(mirrored_address, write_value);
 
       EXPECT_EQ(memory.Read(offset), write_value)
           << std::hex << "Expected mirrored write at base 0x" << offset
@@ -65,8 +61,7 @@ TEST_F(NESBusMirroringTest, ReadMirrorsAcrossInternalRam) {
       const u16 mirrored_address = static_cast<u16>(base + offset);
       ASSERT_LT(mirrored_address, 0x2000);
 
-      SetAddress(mirrored_address);
-      EXPECT_EQ(bus.Read(), value)
+      EXPECT_EQ(bus.Read(mirrored_address), value)
           << std::hex << "Expected mirrored read at base 0x" << offset
           << " from address 0x" << mirrored_address;
     }
@@ -75,5 +70,26 @@ TEST_F(NESBusMirroringTest, ReadMirrorsAcrossInternalRam) {
   }
 }
 
+TEST(StaticMemoryTest, AddressesWrapAroundTheSize) {
+  PaletteRAM palette;
+  palette.Write(0x3F01, 0x2A);
+  EXPECT_EQ(palette.Read(0x0001), 0x2A);
+  EXPECT_EQ(palette.Read(0x3F21), 0x2A);
+
+  WorkRAM ram;
+  const std::array<u8, 3> data = {0x01, 0x02, 0x03};
+  ram.InitializeFrom(0x07FE, std::span<const u8>(data).first(2));
+  EXPECT_EQ(ram.Read(0x0FFF), 0x02);
+  ram.Clear();
+  EXPECT_EQ(ram.Read(0x07FE), 0x00);
+}
+
+TEST(StaticMemoryTest, StorageIsInlineAndCacheLineAligned) {
+  static_assert(sizeof(WorkRAM) == Kilobytes(2));
+  static_assert(alignof(VideoRAM) == 64);
+  WorkRAM ram;
+  EXPECT_EQ(static_cast<void *>(ram.GetData()), static_cast<void *>(&ram));
+}
+
 }  // namespace
 }  // namespace QNes
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bits.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_memory.hpp"
+#include "qnes_ppu.hpp"
+
+namespace QNes {
+namespace {
+
+class OAMDMATest : public ::testing::TestWithParam<CPU::Dispatch> {
+ protected:
+  OAMDMATest() : emulator(std::make_unique<Emulator>()) {}
+
+  void SetUp() override {
+    WorkRAM &memory = Emulator_Testing::GetMemory(*emulator);
+    memory.Clear();
+    for (u16 offset = 0; offset < 0x100; ++offset) {
+      memory.Write(static_cast<u16>(0x0200 + offset),
+                   static_cast<u8>(offset ^ 0x5A));
+    }
+    auto &cpu = GetCPU();
+    CPU_Testing::SetGlobalMode(cpu, CPU::GlobalMode::RUN);
+    CPU_Testing::SetPC(cpu, 0x0300);
+    CPU_Testing::SetSP(cpu, 0xFD);
+    CPU_Testing::SetInstructionCycle(cpu, 0);
+    cpu.SetDispatch(GetParam());
+  }
+
+  // [prefix] LDA #page ; STA $4014 ; INX ; JMP *
+  void LoadProgram(const std::vector<u8> &prefix, u8 page) {
+    std::vector<u8> program = prefix;
+    program.insert(program.end(), {
+        ISA::LDA<AddressingMode::Immediate>::OPCODE, page,
+        ISA::STA<AddressingMode::Absolute>::OPCODE,  0x14, 0x40,
+        ISA::INX<AddressingMode::Implied>::OPCODE,
+        ISA::JMP<AddressingMode::Absolute>::OPCODE,
+    });
+    const auto jmp = static_cast<u16>(0x0300 + program.size() - 1);
+    program.push_back(U16Low(jmp));
+    program.push_back(U16High(jmp));
+    Emulator_Testing::GetMemory(*emulator).InitializeFrom(0x0300, program);
+  }
+
+  BasicCPU<NESBus> &GetCPU() { return Emulator_Testing::GetCPU(*emulator); }
+  ObjectAttributeMemory &GetOAM() {
+    return PPU_Testing::GetOAM(Emulator_Testing::GetPPU(*emulator));
+  }
+
+  std::unique_ptr<Emulator> emulator;
+};
+
+TEST_P(OAMDMATest, CopiesARAMPageToOAM) {
+  LoadProgram({}, 0x02);
+  GetCPU().RunUntil(1000);
+  for (u16 offset = 0; offset < 0x100; ++offset) {
+    EXPECT_EQ(GetOAM().Read(offset), offset ^ 0x5A)
+        << "offset 0x" << std::hex << offset;
+  }
+}
+
+TEST_P(OAMDMATest, StartsAtOAMADDRAndWrapsAround) {
+  // LDA #$10 ; STA $2003
+  LoadProgram({ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x10,
+               ISA::STA<AddressingMode::Absolute>::OPCODE, 0x03, 0x20},
+              0x02);
+  GetCPU().RunUntil(1000);
+  EXPECT_EQ(GetOAM().Read(0x10), 0x00 ^ 0x5A);
+  EXPECT_EQ(GetOAM().Read(0xFF), 0xEF ^ 0x5A);
+  EXPECT_EQ(GetOAM().Read(0x0F), 0xFF ^ 0x5A);
+  EXPECT_EQ(PPU_Testing::GetRegisters(Emulator_Testing::GetPPU(*emulator))
+                .oam_address,
+            0x10);
+}
+
+TEST_P(OAMDMATest, DevicePagesAreReadThroughTheBus) {
+  // $4000-$40FF is open bus, every read returns the high address byte
+  LoadProgram({}, 0x40);
+  GetCPU().RunUntil(1000);
+  for (u16 offset = 0; offset < 0x100; ++offset) {
+    EXPECT_EQ(GetOAM().Read(offset), 0x40);
+  }
+}
+
+TEST_P(OAMDMATest, HaltsTheCPUFor513CyclesOnEvenCycles) {
+  LoadProgram({}, 0x02);
+  // LDA #imm (2) + STA abs (4), the halt starts on cycle 6
+  constexpr u64 RESUME = 6 + 513;
+  auto &cpu = GetCPU();
+  cpu.RunUntil(RESUME);
+  EXPECT_EQ(cpu.GetCycleCount(), RESUME);
+  EXPECT_EQ(cpu.GetState().pc, 0x0305);
+  EXPECT_EQ(cpu.GetState().x, 0x00);
+  cpu.RunUntil(RESUME + 2);
+  EXPECT_EQ(cpu.GetState().x, 0x01);
+}
+
+TEST_P(OAMDMATest, HaltsTheCPUFor514CyclesOnOddCycles) {
+  // LDA $00 (3) shifts the start of the halt to cycle 9
+  LoadProgram({ISA::LDA<AddressingMode::ZeroPage>::OPCODE, 0x00}, 0x02);
+  constexpr u64 RESUME = 9 + 514;
+  auto &cpu = GetCPU();
+  cpu.RunUntil(RESUME - 1);
+  EXPECT_EQ(cpu.GetState().x, 0x00);
+  cpu.RunUntil(RESUME);
+  EXPECT_EQ(cpu.GetState().pc, 0x0307);
+  cpu.RunUntil(RESUME + 2);
+  EXPECT_EQ(cpu.GetState().x, 0x01);
+}
+
+TEST_P(OAMDMATest, StepInstructionRunsTheWholeHalt) {
+  LoadProgram({ISA::LDA<AddressingMode::ZeroPage>::OPCODE, 0x00}, 0x02);
+  auto &cpu = GetCPU();
+  EXPECT_EQ(cpu.StepInstruction(), 3);
+  EXPECT_EQ(cpu.StepInstruction(), 2);
+  EXPECT_EQ(cpu.StepInstruction(), 4);
+  EXPECT_EQ(cpu.StepInstruction(), 514);
+  EXPECT_EQ(cpu.StepInstruction(), 2);
+  EXPECT_EQ(cpu.GetState().x, 0x01);
+}
+
+TEST_P(OAMDMATest, InterruptsWaitForTheHalt) {
+  LoadProgram({}, 0x02);
+  auto &cpu = GetCPU();
+  cpu.RunUntil(100);
+  cpu.SignalNMI();
+  cpu.RunUntil(6 + 513 - 1);
+  EXPECT_EQ(cpu.GetState().pc, 0x0305);
+  EXPECT_EQ(CPU_Testing::GetGlobalMode(cpu), CPU::GlobalMode::RUN);
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, OAMDMATest,
+                         ::testing::Values(CPU::Dispatch::TABLE,
+                                           CPU::Dispatch::THREADED,
+                                           CPU::Dispatch::JIT));
+
+}  // namespace
+}  // namespace QNes
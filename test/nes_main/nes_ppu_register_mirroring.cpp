@@ -14,10 +14,7 @@ namespace {
 
 class NESBusPPURegisterMirroringTest : public ::testing::Test {
  protected:
-  NESBusPPURegisterMirroringTest()
-      : ram_memory(Kilobytes(2)),
-        vram_memory(Kilobytes(2)),
-        bus(&ram_memory, &ppu) {
+  NESBusPPURegisterMirroringTest() : bus(&ram_memory, &ppu) {
     ResetState();
   }
 
@@ -28,10 +25,6 @@ class NESBusPPURegisterMirroringTest : public ::testing::Test {
     PPU_Testing::GetInternalRegisters(ppu) = {};
   }
 
-  void SetAddress(u16 address) {
-    bus.SetAddress(U16High(address), U16Low(address));
-  }
-
   static bool RegistersEqual(const PPU::Registers& lhs,
                              const PPU::Registers& rhs) {
     return std::memcmp(&lhs, &rhs, sizeof(PPU::Registers)) == 0;
@@ -44,8 +37,8 @@ class NESBusPPURegisterMirroringTest : public ::testing::Test {
   static constexpr std::array<u16, 7> kWritableOffsets = {
       0x0000, 0x0001, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007};
 
-  Memory ram_memory;
-  Memory vram_memory;
+  WorkRAM ram_memory;
+  VideoRAM vram_memory;
   PPUBus ppu_bus{&vram_memory};
   PPU ppu{&ppu_bus, nullptr};
   NESBus bus;
@@ -63,8 +56,6 @@ TEST_F(NESBusPPURegisterMirroringTest,
       const u16 address = static_cast<u16>(base + offset);
       ASSERT_LT(address, 0x4000);
 
-      SetAddress(address);
-
       const u8 expected = [offset, ppudata_value, &registers]() -> u8 {
         switch (offset & 0x0007) {
           case 0x0002:
@@ -80,7 +71,7 @@ TEST_F(NESBusPPURegisterMirroringTest,
 
       PPU_Testing::SetPPUDataBuffer(ppu, ppudata_value);
       PPU_Testing::SetVRAMAddress(ppu, 0x3F11);
-      EXPECT_EQ(bus.Read(), expected)
+      EXPECT_EQ(bus.Read(address), expected)
           << std::hex << "Read mismatch at 0x" << address << " (offset 0x"
           << (offset & 0x0007) << ")";
     }
@@ -97,16 +88,14 @@ TEST_F(NESBusPPURegisterMirroringTest, WritesTargetSameRegisterAcrossMirrors) {
     ResetState();
 
     const u16 canonical_address = static_cast<u16>(0x2000 + offset);
-    SetAddress(canonical_address);
-    bus.Write(value);
+    bus.Write(canonical_address, value);
 
     const auto expected_registers = registers;
     const auto expected_internal = internal_registers;
 
     for (u16 base : kBaseMirrors) {
       ResetState();
-      SetAddress(static_cast<u16>(base + offset));
-      bus.Write(value);
+      bus.Write(static_cast<u16>(base + offset), value);
 
       EXPECT_TRUE(RegistersEqual(expected_registers, registers))
           << std::hex << "Register mismatch for offset 0x" << (offset & 0x0007)
@@ -13,9 +13,7 @@ namespace {
 
 class PPURegistersTest : public ::testing::Test {
  protected:
-  PPURegistersTest() : memory(Kilobytes(2)), bus(&memory, &ppu) {
-    ResetState();
-  }
+  PPURegistersTest() : bus(&memory, &ppu) { ResetState(); }
 
   void ResetState() {
     memory.Clear();
@@ -25,11 +23,7 @@ class PPURegistersTest : public ::testing::Test {
     std::memset(&internal, 0, sizeof(internal));
   }
 
-  void SetAddress(u16 address) {
-    bus.SetAddress(U16High(address), U16Low(address));
-  }
-
-  Memory memory;
+  WorkRAM memory;
   PPU ppu{nullptr, nullptr};
   NESBus bus;
 };
@@ -42,8 +36,7 @@ TEST_F(PPURegistersTest,
   regs.ppu_status = 0b1110'0011;  // bits 7-5 set, low bits set
   internal.write_toggle = 1;
 
-  SetAddress(0x2002);
-  const u8 read_value = bus.Read();
+  const u8 read_value = bus.Read(0x2002);
 
   EXPECT_EQ(read_value, 0b1110'0011);
   EXPECT_EQ(regs.ppu_status, 0b0110'0011);  // vblank cleared
@@ -58,15 +51,13 @@ TEST_F(PPURegistersTest,
   regs.ppu_status = 0b1000'0000;  // only vblank set
   internal.write_toggle = 1;
 
-  SetAddress(0x2002);
-  const u8 first_read = bus.Read();
+  const u8 first_read = bus.Read(0x2002);
 
   EXPECT_EQ(first_read, 0b1000'0000);
   EXPECT_EQ(regs.ppu_status, 0);  // vblank bit cleared
   EXPECT_EQ(internal.write_toggle, 0);
 
-  SetAddress(0x2002);
-  const u8 second_read = bus.Read();
+  const u8 second_read = bus.Read(0x2002);
 
   EXPECT_EQ(second_read, 0);            // remains cleared
   EXPECT_EQ(internal.write_toggle, 0);  // stays cleared
@@ -86,8 +77,7 @@ TEST_F(PPURegistersTest, PPUSTATUSMirroredAddressesBehaveIdentically) {
     regs.ppu_status = 0xFF;
     internal.write_toggle = 1;
 
-    SetAddress(addr);
-    const u8 read_value = bus.Read();
+    const u8 read_value = bus.Read(addr);
 
     EXPECT_EQ(read_value, 0xFF) << std::hex << "Mirror address 0x" << addr;
     EXPECT_EQ(regs.ppu_status, 0x7F) << std::hex << "Mirror address 0x" << addr;
@@ -102,29 +92,25 @@ TEST_F(PPURegistersTest, PPUSCROLLRequiresTwoWrites) {
   auto &registers = PPU_Testing::GetRegisters(ppu);
   auto &internal_registers = PPU_Testing::GetInternalRegisters(ppu);
 
-  SetAddress(0x2005);
-  bus.Write(0x12);
+  bus.Write(0x2005, 0x12);
 
   EXPECT_EQ(registers.ppu_scroll[0], 0x12);
   EXPECT_EQ(registers.ppu_scroll[1], 0x00);
   EXPECT_EQ(internal_registers.write_toggle, 1);
 
-  SetAddress(0x2005);
-  bus.Write(0x34);
+  bus.Write(0x2005, 0x34);
 
   EXPECT_EQ(registers.ppu_scroll[0], 0x12);
   EXPECT_EQ(registers.ppu_scroll[1], 0x34);
   EXPECT_EQ(internal_registers.write_toggle, 0);
 
-  SetAddress(0x2005);
-  bus.Write(0x56);
+  bus.Write(0x2005, 0x56);
 
   EXPECT_EQ(registers.ppu_scroll[0], 0x56);
   EXPECT_EQ(registers.ppu_scroll[1], 0x34);
   EXPECT_EQ(internal_registers.write_toggle, 1);
 
-  SetAddress(0x2005);
-  bus.Write(0x78);
+  bus.Write(0x2005, 0x78);
 
   EXPECT_EQ(registers.ppu_scroll[0], 0x56);
   EXPECT_EQ(registers.ppu_scroll[1], 0x78);
@@ -137,29 +123,25 @@ TEST_F(PPURegistersTest, PPUADDRRequiresTwoWrites) {
   auto &registers = PPU_Testing::GetRegisters(ppu);
   auto &internal_registers = PPU_Testing::GetInternalRegisters(ppu);
 
-  SetAddress(0x2006);
-  bus.Write(0xAB);
+  bus.Write(0x2006, 0xAB);
 
   EXPECT_EQ(registers.ppu_address[0], 0xAB);
   EXPECT_EQ(registers.ppu_address[1], 0x00);
   EXPECT_EQ(internal_registers.write_toggle, 1);
 
-  SetAddress(0x2006);
-  bus.Write(0xCD);
+  bus.Write(0x2006, 0xCD);
 
   EXPECT_EQ(registers.ppu_address[0], 0xAB);
   EXPECT_EQ(registers.ppu_address[1], 0xCD);
   EXPECT_EQ(internal_registers.write_toggle, 0);
 
-  SetAddress(0x2006);
-  bus.Write(0x9E);
+  bus.Write(0x2006, 0x9E);
 
   EXPECT_EQ(registers.ppu_address[0], 0x9E);
   EXPECT_EQ(registers.ppu_address[1], 0xCD);
   EXPECT_EQ(internal_registers.write_toggle, 1);
 
-  SetAddress(0x2006);
-  bus.Write(0xF0);
+  bus.Write(0x2006, 0xF0);
 
   EXPECT_EQ(registers.ppu_address[0], 0x9E);
   EXPECT_EQ(registers.ppu_address[1], 0xF0);
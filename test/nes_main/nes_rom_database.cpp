@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_mapper.hpp"
+#include "qnes_rom_database.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+std::span<const u8> Bytes(std::string_view text) {
+  return {reinterpret_cast<const u8 *>(text.data()), text.size()};
+}
+
+std::string ToHex(const Sha1::Digest &digest) {
+  static constexpr char DIGITS[] = "0123456789abcdef";
+  std::string hex;
+  for (const u8 byte : digest) {
+    hex += DIGITS[byte >> 4];
+    hex += DIGITS[byte & 0x0F];
+  }
+  return hex;
+}
+
+// Bit at a time, the definition of the CRC
+u32 ReferenceCrc32(std::span<const u8> data) {
+  u32 crc = ~0u;
+  for (const u8 byte : data) {
+    crc ^= byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+class RomDatabaseTest : public ::testing::Test {
+ protected:
+  // NROM image with a header that says horizontal mirroring, seed changes the
+  // PRG-ROM contents
+  static std::vector<u8> MakeImage(u8 seed, bool trainer = false) {
+    std::vector<u8> image = {'N',  'E', 'S', 0x1A, 0x01, 0x01,
+                             static_cast<u8>(trainer ? 0x04 : 0x00)};
+    image.resize(RomImage::HEADER_SIZE);
+    image.insert(image.end(), trainer ? RomImage::TRAINER_SIZE : 0, 0x77);
+    for (size_t i = 0; i < Kilobytes(16); ++i) {
+      image.push_back(static_cast<u8>(i * 7 + seed));
+    }
+    image.insert(image.end(), Kilobytes(8), 0xC5);
+    return image;
+  }
+
+  RomImagePtr Open(const std::vector<u8> &data) {
+    return RomImage::Open(files.Write(data));
+  }
+
+  TempFiles files;
+};
+
+TEST_F(RomDatabaseTest, Crc32MatchesTheStandardCheckValue) {
+  EXPECT_EQ(Crc32(Bytes("123456789")), 0xCBF43926);
+  EXPECT_EQ(Crc32({}), 0);
+}
+
+TEST_F(RomDatabaseTest, Crc32OfAnySizeAndSplitMatchesTheReference) {
+  std::vector<u8> data(5000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<u8>((i * 131) ^ (i >> 3));
+  }
+  for (const size_t size : {0, 1, 15, 16, 63, 64, 65, 127, 1000, 5000}) {
+    const std::span<const u8> input(data.data(), size);
+    const u32 expected = ReferenceCrc32(input);
+    EXPECT_EQ(Crc32(input), expected) << "size " << size;
+    const size_t split = size / 3;
+    EXPECT_EQ(Crc32(input.subspan(split), Crc32(input.first(split))),
+              expected)
+        << "size " << size;
+  }
+}
+
+TEST_F(RomDatabaseTest, Sha1MatchesTheStandardVectors) {
+  Sha1 empty;
+  EXPECT_EQ(ToHex(empty.Finish()),
+            "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+  Sha1 abc;
+  abc.Update(Bytes("abc"));
+  EXPECT_EQ(ToHex(abc.Finish()), "a9993e364706816aba3e25717850c26c9cd0d89d");
+  Sha1 two_blocks;
+  two_blocks.Update(
+      Bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+  EXPECT_EQ(ToHex(two_blocks.Finish()),
+            "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+  // a million 'a' in uneven pieces
+  const std::string as(1000, 'a');
+  Sha1 million;
+  for (size_t done = 0, piece = 1; done < 1000000; piece = piece % 999 + 1) {
+    const size_t size = std::min(piece, 1000000 - done);
+    million.Update(Bytes(std::string_view(as).substr(0, size)));
+    done += size;
+  }
+  EXPECT_EQ(ToHex(million.Finish()),
+            "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
+
+TEST_F(RomDatabaseTest, HashesCoverPRGAndCHROnly) {
+  const RomImagePtr image = Open(MakeImage(1));
+  const RomImagePtr with_trainer = Open(MakeImage(1, true));
+  ASSERT_NE(image, nullptr);
+  ASSERT_NE(with_trainer, nullptr);
+
+  std::vector<u8> rom(image->GetPRGROM().begin(), image->GetPRGROM().end());
+  rom.insert(rom.end(), image->GetCHRROM().begin(), image->GetCHRROM().end());
+  Sha1 sha1;
+  sha1.Update(rom);
+  const RomHashes hashes = HashRom(*image);
+  EXPECT_EQ(hashes.crc32, ReferenceCrc32(rom));
+  EXPECT_EQ(hashes.sha1, sha1.Finish());
+  EXPECT_EQ(HashRom(*with_trainer), hashes);
+  EXPECT_NE(HashRom(*Open(MakeImage(2))), hashes);
+}
+
+TEST_F(RomDatabaseTest, IndexFindsKnownDumps) {
+  const RomImagePtr known = Open(MakeImage(1));
+  const RomImagePtr unknown = Open(MakeImage(2));
+  ASSERT_NE(known, nullptr);
+  ASSERT_NE(unknown, nullptr);
+
+  RomDatabase::Entry entry{.hashes = HashRom(*known), .header = {}};
+  entry.header.mapper = 0;
+  entry.header.mirroring = Mirroring::VERTICAL;
+  entry.header.battery = true;
+  entry.header.prg_nvram_size = Kilobytes(8);
+  // same CRC, other SHA-1: a collision the index has to tell apart
+  RomDatabase::Entry collision{.hashes = entry.hashes, .header = {}};
+  collision.hashes.sha1[0] ^= 0xFF;
+  collision.header.mapper = 4;
+  std::vector<RomDatabase::Entry> entries = {collision, entry};
+  for (u32 crc = 0; crc < 100; ++crc) {
+    entries.push_back({.hashes = {.crc32 = crc * 0x01010101}, .header = {}});
+  }
+  const std::string path = files.Path(".qdb");
+  ASSERT_TRUE(RomDatabase::WriteIndex(path, entries));
+
+  const RomDatabasePtr database = RomDatabase::Open(path);
+  ASSERT_NE(database, nullptr);
+  EXPECT_EQ(database->GetSize(), entries.size());
+  const std::optional<RomHeader> found = database->Find(entry.hashes);
+  ASSERT_TRUE(found.has_value());
+  EXPECT_EQ(found->mapper, 0);
+  EXPECT_EQ(found->mirroring, Mirroring::VERTICAL);
+  EXPECT_TRUE(found->battery);
+  EXPECT_FALSE(database->Find(HashRom(*unknown)).has_value());
+
+  // the corrected header keeps the layout of the file
+  const RomHeader header = database->GetHeader(*known, entry.hashes);
+  EXPECT_EQ(header.mirroring, Mirroring::VERTICAL);
+  EXPECT_EQ(header.prg_rom_size, Kilobytes(16));
+  EXPECT_EQ(header.chr_rom_size, Kilobytes(8));
+  EXPECT_EQ(database->GetHeader(*unknown, HashRom(*unknown)).mirroring,
+            Mirroring::HORIZONTAL);
+
+  auto emulator = std::make_unique<Emulator>();
+  ASSERT_TRUE(emulator->InsertCartridge(known, header));
+  const Cartridge *cartridge = Emulator_Testing::GetCartridge(*emulator);
+  EXPECT_EQ(cartridge->GetHeader().mirroring, Mirroring::VERTICAL);
+  EXPECT_TRUE(cartridge->GetHeader().battery);
+}
+
+TEST_F(RomDatabaseTest, RejectsFilesThatAreNotIndexes) {
+  EXPECT_EQ(RomDatabase::Open("/nonexistent/qnes.qdb"), nullptr);
+  const std::string garbage = files.Path(".qdb");
+  TempFiles::WriteFile(garbage, std::vector<u8>(100, 0x42));
+  EXPECT_EQ(RomDatabase::Open(garbage), nullptr);
+
+  const std::string truncated = files.Path(".qdb");
+  ASSERT_TRUE(RomDatabase::WriteIndex(truncated, {RomDatabase::Entry{}}));
+  std::filesystem::resize_file(truncated,
+                               std::filesystem::file_size(truncated) - 1);
+  EXPECT_EQ(RomDatabase::Open(truncated), nullptr);
+}
+
+TEST_F(RomDatabaseTest, HashCacheSkipsUnchangedFiles) {
+  const std::string rom_path = files.Path(".nes");
+  TempFiles::WriteFile(rom_path, MakeImage(1));
+  const RomImagePtr image = RomImage::Open(rom_path);
+  const RomImagePtr other = Open(MakeImage(2));
+  ASSERT_NE(image, nullptr);
+  ASSERT_NE(other, nullptr);
+  const std::string cache_path = files.Path(".cache");
+
+  {
+    RomHashCache cache(cache_path);
+    EXPECT_EQ(cache.GetSize(), 0);
+    EXPECT_EQ(cache.Get(rom_path, *image), HashRom(*image));
+    ASSERT_TRUE(cache.Save());
+  }
+
+  RomHashCache cache(cache_path);
+  EXPECT_EQ(cache.GetSize(), 1);
+  // served from the cache: the hashes of what the path held, not of the
+  // image passed in
+  EXPECT_EQ(cache.Get(rom_path, *other), HashRom(*image));
+
+  // a changed file is hashed again
+  std::filesystem::last_write_time(
+      rom_path,
+      std::filesystem::last_write_time(rom_path) + std::chrono::seconds(5));
+  EXPECT_EQ(cache.Get(rom_path, *other), HashRom(*other));
+}
+
+TEST_F(RomDatabaseTest, HashCacheDiscardsDamagedFiles) {
+  const std::string rom_path = files.Path(".nes");
+  TempFiles::WriteFile(rom_path, MakeImage(1));
+  const RomImagePtr image = RomImage::Open(rom_path);
+  ASSERT_NE(image, nullptr);
+  const std::string cache_path = files.Path(".cache");
+  {
+    RomHashCache cache(cache_path);
+    EXPECT_EQ(cache.Get(rom_path, *image), HashRom(*image));
+    ASSERT_TRUE(cache.Save());
+  }
+
+  // the path size of the first record claims 4 GB
+  {
+    std::fstream file(cache_path,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(16 + 20);
+    file.write("\xFF\xFF\xFF\xFF", 4);
+  }
+  const RomHashCache cache(cache_path);
+  EXPECT_EQ(cache.GetSize(), 0);
+}
+
+}  // namespace
+}  // namespace QNes
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_memory.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+class RomImageTest : public ::testing::Test {
+ protected:
+  // header followed by the trainer, PRG-ROM and CHR-ROM with recognizable
+  // contents
+  static std::vector<u8> MakeImage(std::vector<u8> header, size_t trainer,
+                                   size_t prg_rom, size_t chr_rom) {
+    header.resize(RomImage::HEADER_SIZE);
+    std::vector<u8> image = header;
+    image.insert(image.end(), trainer, 0x77);
+    for (size_t i = 0; i < prg_rom; ++i) {
+      image.push_back(static_cast<u8>(i / Kilobytes(16) + 0x10));
+    }
+    for (size_t i = 0; i < chr_rom; ++i) {
+      image.push_back(static_cast<u8>(i / Kilobytes(8) + 0xC0));
+    }
+    return image;
+  }
+
+  TempFiles files;
+};
+
+TEST_F(RomImageTest, ParsesINESHeader) {
+  // mapper 4, vertical mirroring, battery, 32 KB PRG-ROM, 8 KB CHR-ROM
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x02, 0x01, 0x43, 0x00};
+  RomHeader header;
+  ASSERT_TRUE(RomImage::ParseHeader(MakeImage(data, 0, 0, 0), header));
+  EXPECT_EQ(header.format, RomHeader::Format::INES);
+  EXPECT_EQ(header.mapper, 4);
+  EXPECT_EQ(header.mirroring, Mirroring::VERTICAL);
+  EXPECT_TRUE(header.battery);
+  EXPECT_FALSE(header.trainer);
+  EXPECT_EQ(header.prg_rom_size, Kilobytes(32));
+  EXPECT_EQ(header.chr_rom_size, Kilobytes(8));
+  EXPECT_EQ(header.prg_ram_size, 0);
+  EXPECT_EQ(header.prg_nvram_size, Kilobytes(8));
+  EXPECT_EQ(header.chr_ram_size, 0);
+}
+
+TEST_F(RomImageTest, INESWithoutCHRROMHasCHRRAM) {
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x08, 0x00, 0x28, 0x00};
+  RomHeader header;
+  ASSERT_TRUE(RomImage::ParseHeader(MakeImage(data, 0, 0, 0), header));
+  EXPECT_EQ(header.mapper, 2);
+  EXPECT_EQ(header.mirroring, Mirroring::FOUR_SCREEN);
+  EXPECT_EQ(header.chr_rom_size, 0);
+  EXPECT_EQ(header.chr_ram_size, Kilobytes(8));
+  EXPECT_EQ(header.prg_ram_size, Kilobytes(8));
+}
+
+TEST_F(RomImageTest, IgnoresGarbageInOldINESHeaders) {
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x01, 0x01, 0x10, 'D',
+                                'i', 's', 'k', 'D', 'u',  'd',  'e',  '!'};
+  RomHeader header;
+  ASSERT_TRUE(RomImage::ParseHeader(data, header));
+  EXPECT_EQ(header.mapper, 1);
+}
+
+TEST_F(RomImageTest, ParsesNES2Header) {
+  // mapper 0x145 submapper 2, 8 KB PRG-NVRAM, 8 KB CHR-RAM
+  const std::vector<u8> data = {'N',  'E',  'S',  0x1A, 0x04, 0x00,
+                                0x52, 0x48, 0x21, 0x00, 0x70, 0x07};
+  RomHeader header;
+  ASSERT_TRUE(RomImage::ParseHeader(MakeImage(data, 0, 0, 0), header));
+  EXPECT_EQ(header.format, RomHeader::Format::NES2);
+  EXPECT_EQ(header.mapper, 0x145);
+  EXPECT_EQ(header.submapper, 2);
+  EXPECT_TRUE(header.battery);
+  EXPECT_EQ(header.prg_rom_size, Kilobytes(64));
+  EXPECT_EQ(header.chr_rom_size, 0);
+  EXPECT_EQ(header.prg_ram_size, 0);
+  EXPECT_EQ(header.prg_nvram_size, Kilobytes(8));
+  EXPECT_EQ(header.chr_ram_size, Kilobytes(8));
+  EXPECT_EQ(header.chr_nvram_size, 0);
+}
+
+TEST_F(RomImageTest, ParsesNES2ExponentMultiplierSizes) {
+  // PRG-ROM 2^14 * 3 bytes, CHR-ROM $102 * 8 KB
+  const std::vector<u8> data = {'N', 'E',  'S',  0x1A, (14 << 2) | 1,
+                                0x02, 0x00, 0x08, 0x00, 0x1F};
+  RomHeader header;
+  ASSERT_TRUE(RomImage::ParseHeader(MakeImage(data, 0, 0, 0), header));
+  EXPECT_EQ(header.prg_rom_size, Kilobytes(48));
+  EXPECT_EQ(header.chr_rom_size, 0x102 * Kilobytes(8));
+}
+
+TEST_F(RomImageTest, RejectsInvalidFiles) {
+  RomHeader header;
+  EXPECT_FALSE(RomImage::ParseHeader(
+      std::vector<u8>{'N', 'E', 'S', 0x00, 0x01, 0x01}, header));
+
+  const std::vector<u8> nrom = {'N', 'E', 'S', 0x1A, 0x01, 0x01};
+  std::vector<u8> truncated = MakeImage(nrom, 0, Kilobytes(16), Kilobytes(8));
+  truncated.pop_back();
+  EXPECT_EQ(RomImage::Open(files.Write(truncated)), nullptr);
+  EXPECT_EQ(RomImage::Open(files.Write({'N', 'E', 'S'})), nullptr);
+  EXPECT_EQ(RomImage::Open("/nonexistent/qnes.nes"), nullptr);
+}
+
+TEST_F(RomImageTest, BanksPointIntoTheMappedFile) {
+  // NROM-256 with a trainer
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x02, 0x01, 0x04};
+  const RomImagePtr image = RomImage::Open(
+      files.Write(MakeImage(data, RomImage::TRAINER_SIZE, Kilobytes(32),
+                            Kilobytes(8))));
+  ASSERT_NE(image, nullptr);
+  EXPECT_TRUE(image->GetHeader().trainer);
+
+  const u8 *file = image->GetData().data();
+  EXPECT_EQ(image->GetTrainer().data(), file + RomImage::HEADER_SIZE);
+  EXPECT_EQ(image->GetTrainer().size(), RomImage::TRAINER_SIZE);
+  EXPECT_EQ(image->GetPRGROM().data(),
+            file + RomImage::HEADER_SIZE + RomImage::TRAINER_SIZE);
+  EXPECT_EQ(image->GetPRGROM().size(), Kilobytes(32));
+  EXPECT_EQ(image->GetCHRROM().data(),
+            image->GetPRGROM().data() + Kilobytes(32));
+  EXPECT_EQ(image->GetCHRROM().size(), Kilobytes(8));
+  EXPECT_EQ(image->GetPRGROM()[0], 0x10);
+  EXPECT_EQ(image->GetPRGROM()[Kilobytes(16)], 0x11);
+  EXPECT_EQ(image->GetCHRROM()[0], 0xC0);
+}
+
+TEST_F(RomImageTest, OpeningTheSameFileSharesTheMapping) {
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x01, 0x01};
+  const std::string path =
+      files.Write(MakeImage(data, 0, Kilobytes(16), Kilobytes(8)));
+  RomImagePtr first = RomImage::Open(path);
+  const RomImagePtr second = RomImage::Open(path);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+
+  const RomImagePtr other = RomImage::Open(
+      files.Write(MakeImage(data, 0, Kilobytes(16), Kilobytes(8))));
+  ASSERT_NE(other, nullptr);
+  EXPECT_NE(other, first);
+
+  // the mapping stays while any emulator uses it
+  first.reset();
+  EXPECT_EQ(second->GetPRGROM()[0], 0x10);
+  EXPECT_EQ(RomImage::Open(path), second);
+}
+
+TEST_F(RomImageTest, PRGROMIsMappedIntoTheBusWithoutCopies) {
+  // NROM-128 with CHR-RAM, the 16 KB are mirrored over $8000-$FFFF
+  const std::vector<u8> data = {'N', 'E', 'S', 0x1A, 0x01, 0x00};
+  const RomImagePtr image =
+      RomImage::Open(files.Write(MakeImage(data, 0, Kilobytes(16), 0)));
+  ASSERT_NE(image, nullptr);
+  WorkRAM ram;
+  NESBus bus(&ram, nullptr);
+  bus.MapMemory(0x8000, 0x8000, image->GetPRGROM().data(),
+                static_cast<u32>(image->GetPRGROM().size()));
+
+  EXPECT_EQ(bus.Read(0x8000), 0x10);
+  EXPECT_EQ(bus.Read(0xC000), 0x10);
+  bus.Write(0xC000, 0x00);  // ROM, the write goes nowhere
+  EXPECT_EQ(bus.Read(0xC000), 0x10);
+  EXPECT_TRUE(bus.IsDecodeCacheable(0xFFFC));
+  EXPECT_FALSE(bus.HasReadSideEffects(0xFFFC));
+}
+
+}  // namespace
+}  // namespace QNes
@@ -0,0 +1,376 @@
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "mmc1.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_mapper.hpp"
+#include "qnes_memory.hpp"
+#include "qnes_ppu.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+class SaveStateTest : public ::testing::Test {
+ protected:
+  SaveStateTest() : emulator(std::make_unique<Emulator>()) {}
+
+  void SetUp() override {
+    // loop: INC $10 ; LDA $10 ; CLC ; ADC $11 ; STA $11 ; PHA ; PLA ;
+    //       STA $0300,X ; INX ; JMP loop
+    const std::vector<u8> program = {
+        ISA::INC<AddressingMode::ZeroPage>::OPCODE,  0x10,
+        ISA::LDA<AddressingMode::ZeroPage>::OPCODE,  0x10,
+        ISA::CLC<AddressingMode::Implied>::OPCODE,
+        ISA::ADC<AddressingMode::ZeroPage>::OPCODE,  0x11,
+        ISA::STA<AddressingMode::ZeroPage>::OPCODE,  0x11,
+        ISA::PHA<AddressingMode::Implied>::OPCODE,
+        ISA::PLA<AddressingMode::Implied>::OPCODE,
+        ISA::STA<AddressingMode::AbsoluteX>::OPCODE, 0x00, 0x03,
+        ISA::INX<AddressingMode::Implied>::OPCODE,
+        ISA::JMP<AddressingMode::Absolute>::OPCODE,  0x00, 0x02,
+    };
+    WorkRAM &memory = Emulator_Testing::GetMemory(*emulator);
+    memory.Clear();
+    memory.InitializeFrom(0x0200, program);
+
+    auto &cpu = Emulator_Testing::GetCPU(*emulator);
+    CPU_Testing::SetGlobalMode(cpu, CPU::GlobalMode::RUN);
+    CPU_Testing::SetPC(cpu, 0x0200);
+    CPU_Testing::SetSP(cpu, 0xFD);
+    CPU_Testing::SetInstructionCycle(cpu, 0);
+  }
+
+  void ExpectSameMachine(const Emulator::SaveState &lhs,
+                         const Emulator::SaveState &rhs) {
+    EXPECT_EQ(lhs.cpu.cycle_count, rhs.cpu.cycle_count);
+    EXPECT_EQ(lhs.cpu.state.pc, rhs.cpu.state.pc);
+    EXPECT_EQ(lhs.cpu.state.a, rhs.cpu.state.a);
+    EXPECT_EQ(lhs.cpu.state.x, rhs.cpu.state.x);
+    EXPECT_EQ(lhs.cpu.state.status.status, rhs.cpu.state.status.status);
+    EXPECT_EQ(lhs.cpu.instruction_cycle, rhs.cpu.instruction_cycle);
+    EXPECT_EQ(lhs.ram, rhs.ram);
+    EXPECT_EQ(lhs.vram, rhs.vram);
+    EXPECT_EQ(std::memcmp(&lhs.ppu.registers, &rhs.ppu.registers,
+                          sizeof(PPU::Registers)),
+              0);
+    EXPECT_EQ(lhs.ppu.palette, rhs.ppu.palette);
+  }
+
+  std::unique_ptr<Emulator> emulator;
+};
+
+TEST_F(SaveStateTest, LoadRewindsTheMachine) {
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  // odd target, the save is taken in the middle of an instruction
+  cpu.RunUntil(1001);
+
+  auto saved = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*saved);
+  ASSERT_NE(saved->cpu.instruction_cycle, 0);
+
+  cpu.RunUntil(5000);
+  auto after = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*after);
+  EXPECT_NE(after->ram, saved->ram);
+
+  ASSERT_TRUE(emulator->Load(*saved));
+  auto reloaded = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*reloaded);
+  ExpectSameMachine(*reloaded, *saved);
+
+  // replaying from the savestate ends in the same machine
+  cpu.RunUntil(5000);
+  auto replayed = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*replayed);
+  ExpectSameMachine(*replayed, *after);
+}
+
+TEST_F(SaveStateTest, SaveStateCanBeCopiedToAnotherEmulator) {
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  cpu.EnableDecodeCache();
+  cpu.RunUntil(3000);
+
+  // savestates are plain bytes
+  std::vector<u8> buffer(sizeof(Emulator::SaveState));
+  {
+    auto save_state = std::make_unique<Emulator::SaveState>();
+    emulator->Save(*save_state);
+    std::memcpy(buffer.data(), save_state.get(), buffer.size());
+  }
+
+  auto other = std::make_unique<Emulator>();
+  auto loaded = std::make_unique<Emulator::SaveState>();
+  std::memcpy(loaded.get(), buffer.data(), buffer.size());
+  ASSERT_TRUE(other->Load(*loaded));
+
+  cpu.RunUntil(8000);
+  Emulator_Testing::GetCPU(*other).RunUntil(8000);
+  auto expected = std::make_unique<Emulator::SaveState>();
+  auto actual = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*expected);
+  other->Save(*actual);
+  ExpectSameMachine(*actual, *expected);
+}
+
+TEST_F(SaveStateTest, ForkRunsIndependentlyFromTheParent) {
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  cpu.SetAccuracy(CPU::Accuracy::FAST);
+  cpu.RunUntil(2000);
+
+  std::unique_ptr<Emulator> fork = emulator->Fork();
+  auto &fork_cpu = Emulator_Testing::GetCPU(*fork);
+  EXPECT_EQ(fork_cpu.GetAccuracy(), CPU::Accuracy::FAST);
+  EXPECT_EQ(fork_cpu.GetCycleCount(), cpu.GetCycleCount());
+
+  // the fork diverges, the parent is not affected
+  Emulator_Testing::GetMemory(*fork).Write(0x0011, 0x80);
+  fork_cpu.RunUntil(6000);
+  cpu.RunUntil(6000);
+  auto parent_state = std::make_unique<Emulator::SaveState>();
+  auto fork_state = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*parent_state);
+  fork->Save(*fork_state);
+  EXPECT_EQ(parent_state->cpu.cycle_count, fork_state->cpu.cycle_count);
+  EXPECT_NE(parent_state->ram, fork_state->ram);
+}
+
+TEST_F(SaveStateTest, DeltaHoldsOnlyTheChangedPages) {
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  cpu.RunUntil(1000);
+  auto checkpoint = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*checkpoint);
+  const auto keyframe = std::make_unique<Emulator::SaveState>(*checkpoint);
+
+  Emulator::Delta delta;
+  emulator->SaveDelta(*checkpoint, delta);
+  EXPECT_EQ(delta.dirty_pages, 0);
+  EXPECT_TRUE(delta.pages.empty());
+
+  // the loop writes the zero page, the stack and $0300-$03FF
+  cpu.RunUntil(1400);
+  emulator->SaveDelta(*checkpoint, delta);
+  EXPECT_EQ(delta.dirty_pages & 1, 1);  // zero page
+  EXPECT_EQ(static_cast<size_t>(std::popcount(delta.dirty_pages)),
+            delta.pages.size());
+  EXPECT_LT(delta.pages.size(), 8);
+  EXPECT_EQ(delta.dirty_pages >> (WorkRAM::GetSize() /
+                                  Emulator::DELTA_PAGE_SIZE),
+            0);  // VRAM untouched
+
+  auto current = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*current);
+  ExpectSameMachine(*checkpoint, *current);
+  Emulator::ApplyDelta(delta, *keyframe);
+  ExpectSameMachine(*keyframe, *current);
+}
+
+TEST_F(SaveStateTest, RewindReplaysDeltasOverAKeyframe) {
+  auto &cpu = Emulator_Testing::GetCPU(*emulator);
+  cpu.RunUntil(500);
+  auto keyframe = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*keyframe);
+  auto checkpoint = std::make_unique<Emulator::SaveState>(*keyframe);
+
+  std::vector<Emulator::Delta> deltas(6);
+  std::vector<std::unique_ptr<Emulator::SaveState>> full_states;
+  for (size_t frame = 0; frame < deltas.size(); ++frame) {
+    cpu.RunUntil(500 + (frame + 1) * 750);
+    Emulator_Testing::GetVideoRAM(*emulator).Write(
+        static_cast<u16>(frame * 100), 0x20);
+    emulator->SaveDelta(*checkpoint, deltas[frame]);
+    full_states.push_back(std::make_unique<Emulator::SaveState>());
+    emulator->Save(*full_states.back());
+  }
+
+  // seek back to the third checkpoint and replay to the end
+  for (size_t frame = 0; frame <= 2; ++frame) {
+    Emulator::ApplyDelta(deltas[frame], *keyframe);
+  }
+  ExpectSameMachine(*keyframe, *full_states[2]);
+  ASSERT_TRUE(emulator->Load(*keyframe));
+  auto replayed = std::make_unique<Emulator::SaveState>();
+  emulator->Save(*replayed);
+  ExpectSameMachine(*replayed, *full_states[2]);
+}
+
+
+class CartridgeSaveStateTest : public ::testing::Test {
+ protected:
+  // A savestate with its cartridge RAM
+  struct Saved {
+    std::unique_ptr<Emulator::SaveState> save_state =
+        std::make_unique<Emulator::SaveState>();
+    std::vector<u8> cartridge_ram;
+  };
+
+  // 8 KB of PRG-RAM and CHR-RAM, every 16 KB PRG-ROM bank starts with its
+  // number plus seed
+  std::unique_ptr<Emulator> Create(u8 mapper, u8 prg_banks, u8 seed = 0) {
+    std::vector<u8> image = {'N', 'E', 'S', 0x1A, prg_banks, 0x00,
+                             static_cast<u8>(mapper << 4)};
+    image.resize(RomImage::HEADER_SIZE);
+    for (u8 bank = 0; bank < prg_banks; ++bank) {
+      image.push_back(static_cast<u8>(bank + seed));
+      image.insert(image.end(), Kilobytes(16) - 1, 0xEA);
+    }
+    auto emulator = std::make_unique<Emulator>();
+    EXPECT_TRUE(emulator->InsertCartridge(RomImage::Open(files.Write(image))));
+    return emulator;
+  }
+
+  static Saved Save(const Emulator &emulator) {
+    Saved saved;
+    saved.cartridge_ram.resize(emulator.GetCartridgeRAMSize());
+    emulator.Save(*saved.save_state, saved.cartridge_ram);
+    return saved;
+  }
+
+  static bool Load(Emulator &emulator, const Saved &saved) {
+    return emulator.Load(*saved.save_state, saved.cartridge_ram);
+  }
+
+  TempFiles files;
+};
+
+TEST_F(CartridgeSaveStateTest, RAMIsSizedByTheBoard) {
+  // 8 KB of PRG-RAM and 8 KB of CHR-RAM
+  EXPECT_EQ(Create(1, 8)->GetCartridgeRAMSize(), Kilobytes(16));
+  EXPECT_EQ(std::make_unique<Emulator>()->GetCartridgeRAMSize(), 0);
+}
+
+TEST_F(CartridgeSaveStateTest, LoadRestoresMapperAndCartridgeRAM) {
+  const std::unique_ptr<Emulator> emulator = Create(1, 8);
+  NESBus &bus = Emulator_Testing::GetBus(*emulator);
+  PPUBus &ppu_bus = Emulator_Testing::GetPPUBus(*emulator);
+  bus.Write(0x6000, 0x11);
+  ppu_bus.Write(0x0000, 0x22);
+  // PRG bank 3, saved with two of the five bits shifted in
+  WriteMMC1(bus, 0xE000, 3, 0, 1);
+  const Saved saved = Save(*emulator);
+
+  WriteMMC1(bus, 0xE000, 3, 2, 4);
+  EXPECT_EQ(bus.Read(0x8000), 3);
+  bus.Write(0x6000, 0x33);
+  ppu_bus.Write(0x0000, 0x44);
+
+  ASSERT_TRUE(Load(*emulator, saved));
+  EXPECT_EQ(bus.Read(0x6000), 0x11);
+  EXPECT_EQ(ppu_bus.Read(0x0000), 0x22);
+  EXPECT_EQ(bus.Read(0x8000), 0);
+  WriteMMC1(bus, 0xE000, 3, 2, 4);
+  EXPECT_EQ(bus.Read(0x8000), 3);
+}
+
+TEST_F(CartridgeSaveStateTest, LoadRestoresTheScanlineCounter) {
+  const std::unique_ptr<Emulator> emulator = Create(4, 2);
+  NESBus &bus = Emulator_Testing::GetBus(*emulator);
+  bus.Write(0xC000, 5);
+  bus.Write(0xC001, 0);
+  bus.Write(0xE001, 0);
+  Cartridge &cartridge = *Emulator_Testing::GetCartridge(*emulator);
+  const auto &mmc3 =
+      static_cast<const BasicCartridge<MMC3> &>(cartridge).GetMapper();
+  cartridge.ClockScanline();
+  cartridge.ClockScanline();
+  ASSERT_EQ(mmc3.irq_counter, 4);
+  const Saved saved = Save(*emulator);
+
+  cartridge.ClockScanline();
+  cartridge.ClockScanline();
+  ASSERT_TRUE(Load(*emulator, saved));
+  EXPECT_EQ(mmc3.irq_counter, 4);
+  EXPECT_TRUE(mmc3.irq_enabled);
+}
+
+TEST_F(CartridgeSaveStateTest, LoadRefusesAnotherCartridge) {
+  const std::unique_ptr<Emulator> emulator = Create(1, 8);
+  const Saved saved = Save(*emulator);
+
+  // same board, other PRG-ROM
+  const std::unique_ptr<Emulator> other = Create(1, 8, 0x40);
+  Emulator_Testing::GetBus(*other).Write(0x6000, 0x55);
+  EXPECT_FALSE(Load(*other, saved));
+  EXPECT_EQ(Emulator_Testing::GetBus(*other).Read(0x6000), 0x55);
+  // other mapper
+  EXPECT_FALSE(Load(*Create(2, 8), saved));
+  // cartridge RAM of another size
+  EXPECT_FALSE(emulator->Load(*saved.save_state));
+
+  const auto empty = std::make_unique<Emulator>();
+  EXPECT_FALSE(Load(*empty, saved));
+  EXPECT_FALSE(Load(*emulator, Save(*empty)));
+  EXPECT_TRUE(Load(*emulator, saved));
+}
+
+TEST_F(CartridgeSaveStateTest, DeltaHoldsTheChangedCartridgePages) {
+  const std::unique_ptr<Emulator> emulator = Create(1, 8);
+  Saved checkpoint = Save(*emulator);
+  Saved keyframe = Save(*emulator);
+  NESBus &bus = Emulator_Testing::GetBus(*emulator);
+
+  bus.Write(0x6000, 0x11);
+  Emulator_Testing::GetPPUBus(*emulator).Write(0x1000, 0x22);
+  WriteMMC1(bus, 0xE000, 3, 0, 1);
+  Emulator::Delta delta;
+  emulator->SaveDelta(*checkpoint.save_state, delta, checkpoint.cartridge_ram);
+  // CHR-RAM follows the 8 KB of PRG-RAM
+  const std::vector<u32> dirty = {
+      0, (Kilobytes(8) + 0x1000) / Emulator::DELTA_PAGE_SIZE};
+  EXPECT_EQ(delta.cartridge_dirty_pages, dirty);
+  EXPECT_EQ(delta.cartridge_pages.size(), 2);
+
+  // PRG-RAM written again after the delta is still found
+  bus.Write(0x7FFF, 0x33);
+  emulator->SaveDelta(*checkpoint.save_state, delta, checkpoint.cartridge_ram);
+  const std::vector<u32> last_page = {
+      Kilobytes(8) / Emulator::DELTA_PAGE_SIZE - 1};
+  EXPECT_EQ(delta.cartridge_dirty_pages, last_page);
+  emulator->SaveDelta(*checkpoint.save_state, delta, checkpoint.cartridge_ram);
+  EXPECT_TRUE(delta.cartridge_dirty_pages.empty());
+  EXPECT_TRUE(delta.cartridge_pages.empty());
+
+  WriteMMC1(bus, 0xE000, 3, 2, 4);
+  emulator->SaveDelta(*checkpoint.save_state, delta, checkpoint.cartridge_ram);
+  EXPECT_TRUE(delta.cartridge_pages.empty());
+  EXPECT_EQ(checkpoint.cartridge_ram, Save(*emulator).cartridge_ram);
+  ASSERT_TRUE(Load(*emulator, keyframe));
+  EXPECT_EQ(bus.Read(0x6000), 0);
+  ASSERT_TRUE(Load(*emulator, checkpoint));
+  EXPECT_EQ(bus.Read(0x6000), 0x11);
+  EXPECT_EQ(bus.Read(0x7FFF), 0x33);
+  EXPECT_EQ(bus.Read(0x8000), 3);
+}
+
+TEST_F(CartridgeSaveStateTest, ApplyDeltaMovesTheCartridgeForward) {
+  const std::unique_ptr<Emulator> emulator = Create(1, 8);
+  Saved checkpoint = Save(*emulator);
+  Saved keyframe = Save(*emulator);
+  NESBus &bus = Emulator_Testing::GetBus(*emulator);
+
+  bus.Write(0x6000, 0x11);
+  Emulator_Testing::GetPPUBus(*emulator).Write(0x1000, 0x22);
+  WriteMMC1(bus, 0xE000, 3, 0, 1);
+  Emulator::Delta delta;
+  emulator->SaveDelta(*checkpoint.save_state, delta, checkpoint.cartridge_ram);
+  Emulator::ApplyDelta(delta, *keyframe.save_state, keyframe.cartridge_ram);
+  const Saved current = Save(*emulator);
+  EXPECT_EQ(keyframe.cartridge_ram, current.cartridge_ram);
+  EXPECT_EQ(keyframe.save_state->cartridge.mapper_state,
+            current.save_state->cartridge.mapper_state);
+
+  ASSERT_TRUE(Load(*emulator, keyframe));
+  WriteMMC1(bus, 0xE000, 3, 2, 4);
+  EXPECT_EQ(bus.Read(0x8000), 3);
+}
+
+}  // namespace
+}  // namespace QNes
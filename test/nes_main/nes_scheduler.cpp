@@ -0,0 +1,313 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "cpu_isa.hpp"
+#include "qnes_bus.hpp"
+#include "qnes_c.hpp"
+#include "qnes_cartridge.hpp"
+#include "qnes_cpu.hpp"
+#include "qnes_emu.hpp"
+#include "qnes_memory.hpp"
+#include "qnes_ppu.hpp"
+#include "qnes_timing.hpp"
+#include "temp_files.hpp"
+
+namespace QNes {
+namespace {
+
+constexpr u64 NTSC_FRAME_DOTS = 262 * PPU::DOTS_PER_SCANLINE;
+constexpr u64 PAL_FRAME_DOTS = 312 * PPU::DOTS_PER_SCANLINE;
+// From power-on to the start of the first vblank
+constexpr u64 FIRST_FRAME_DOTS =
+    PPU::VBLANK_SCANLINE * PPU::DOTS_PER_SCANLINE + 1;
+
+TEST(TimingTest, ConvertsBetweenCPUCyclesAndDots) {
+  EXPECT_EQ(CPUCyclesToDots(10, Region::NTSC), 30);
+  EXPECT_EQ(CPUCyclesToDots(10, Region::PAL), 32);
+  EXPECT_EQ(DotsToCPUCycles(30, Region::NTSC), 10);
+  EXPECT_EQ(DotsToCPUCycles(31, Region::NTSC), 11);
+  EXPECT_EQ(DotsToCPUCycles(32, Region::PAL), 10);
+  EXPECT_EQ(DotsToCPUCycles(33, Region::PAL), 11);
+}
+
+class PPUTimingTest : public ::testing::Test {
+ protected:
+  PPUTimingTest() : ppu_bus(&vram), ppu(&ppu_bus, nullptr) {}
+
+  VideoRAM vram;
+  PPUBus ppu_bus;
+  PPU ppu;
+};
+
+TEST_F(PPUTimingTest, VBlankStartsAndEndsAtItsDots) {
+  EXPECT_EQ(ppu.GetDotsToNextEvent(), FIRST_FRAME_DOTS);
+  ppu.Run(FIRST_FRAME_DOTS - 1);
+  EXPECT_EQ(ppu.GetFrameCount(), 0);
+  ppu.Step();
+  EXPECT_EQ(ppu.GetFrameCount(), 1);
+  EXPECT_EQ(ppu.GetScanline(), PPU::VBLANK_SCANLINE);
+  EXPECT_EQ(ppu.GetScanlineCycle(), 1);
+  EXPECT_NE(PPU_Testing::GetRegisters(ppu).ppu_status & 0x80, 0);
+
+  // to the pre-render scanline
+  EXPECT_EQ(ppu.GetDotsToNextEvent(), 20 * PPU::DOTS_PER_SCANLINE);
+  ppu.Run(20 * PPU::DOTS_PER_SCANLINE);
+  EXPECT_EQ(ppu.GetScanline(), 261);
+  EXPECT_EQ(PPU_Testing::GetRegisters(ppu).ppu_status & 0x80, 0);
+  EXPECT_EQ(ppu.GetDotCount(), FIRST_FRAME_DOTS + 20 * PPU::DOTS_PER_SCANLINE);
+}
+
+TEST_F(PPUTimingTest, OddFramesSkipADotWhileRendering) {
+  PPU_Testing::GetRegisters(ppu).ppu_mask = 0x18;
+  ppu.Run(NTSC_FRAME_DOTS);
+  EXPECT_EQ(ppu.GetScanline(), 0);
+  EXPECT_EQ(ppu.GetScanlineCycle(), 0);
+  ppu.Run(NTSC_FRAME_DOTS - 1);
+  EXPECT_EQ(ppu.GetScanline(), 0);
+  EXPECT_EQ(ppu.GetScanlineCycle(), 0);
+  EXPECT_EQ(ppu.GetFrameCount(), 2);
+
+  // not without rendering and never on PAL
+  PPU_Testing::GetRegisters(ppu).ppu_mask = 0x00;
+  ppu.Run(NTSC_FRAME_DOTS);
+  EXPECT_EQ(ppu.GetScanlineCycle(), 0);
+  PPU_Testing::GetRegisters(ppu).ppu_mask = 0x18;
+  ppu.SetRegion(Region::PAL);
+  ppu.Run(PAL_FRAME_DOTS);
+  EXPECT_EQ(ppu.GetScanline(), 0);
+  EXPECT_EQ(ppu.GetScanlineCycle(), 0);
+}
+
+class SchedulerTest : public ::testing::Test {
+ protected:
+  SchedulerTest() : emulator(std::make_unique<Emulator>()) {}
+
+  // 32 KB of PRG-ROM with main at $E000, the NMI handler at $E100 and the IRQ
+  // handler at $E200. The last 8 KB are at $E000 on NROM and on MMC3.
+  bool Insert(u8 mapper, const std::vector<u8> &main,
+              const std::vector<u8> &nmi, const std::vector<u8> &irq) {
+    std::vector<u8> image = {'N',  'E', 'S', 0x1A, 0x02, 0x01,
+                             static_cast<u8>(mapper << 4),
+                             static_cast<u8>(mapper & 0xF0)};
+    image.resize(RomImage::HEADER_SIZE + Kilobytes(32) + Kilobytes(8));
+    const size_t last_bank = RomImage::HEADER_SIZE + Kilobytes(24);
+    std::ranges::copy(main, image.begin() + static_cast<long>(last_bank));
+    std::ranges::copy(nmi,
+                      image.begin() + static_cast<long>(last_bank + 0x100));
+    std::ranges::copy(irq,
+                      image.begin() + static_cast<long>(last_bank + 0x200));
+    const std::vector<u8> vectors = {0x00, 0xE1, 0x00, 0xE0, 0x00, 0xE2};
+    std::ranges::copy(vectors,
+                      image.begin() + static_cast<long>(last_bank + 0x1FFA));
+
+    const RomImagePtr rom = RomImage::Open(files.Write(image));
+    return rom != nullptr && emulator->InsertCartridge(rom);
+  }
+
+  // JMP to itself at $E000 + offset
+  static std::vector<u8> Spin(u8 offset) {
+    return {ISA::JMP<AddressingMode::Absolute>::OPCODE, offset, 0xE0};
+  }
+
+  u8 ReadRAM(u16 address) {
+    return Emulator_Testing::GetMemory(*emulator).Read(address);
+  }
+
+  std::unique_ptr<Emulator> emulator;
+  TempFiles files;
+};
+
+TEST_F(SchedulerTest, FramesHaveTheLengthOfTheRegion) {
+  ASSERT_TRUE(Insert(0, Spin(0), {}, {}));
+  const u64 first = emulator->RunFrame();
+  EXPECT_EQ(emulator->GetFrameCount(), 1);
+  EXPECT_NEAR(static_cast<double>(first), FIRST_FRAME_DOTS / 3.0, 1.0);
+
+  u64 cycles = 0;
+  for (int frame = 0; frame < 3; ++frame) {
+    cycles += emulator->RunFrame();
+  }
+  EXPECT_EQ(emulator->GetFrameCount(), 4);
+  EXPECT_EQ(emulator->GetCycleCount(), first + cycles);
+  // 29780.67 cycles per frame
+  EXPECT_NEAR(static_cast<double>(cycles), 3 * NTSC_FRAME_DOTS / 3.0, 1.0);
+
+  auto pal = std::make_unique<Emulator>();
+  std::swap(emulator, pal);
+  ASSERT_TRUE(Insert(0, Spin(0), {}, {}));
+  emulator->SetRegion(Region::PAL);
+  emulator->RunFrame();
+  cycles = 0;
+  for (int frame = 0; frame < 5; ++frame) {
+    cycles += emulator->RunFrame();
+  }
+  // 33247.5 cycles per frame
+  EXPECT_NEAR(static_cast<double>(cycles), 5 * PAL_FRAME_DOTS / 3.2, 1.0);
+  EXPECT_EQ(emulator->Fork()->GetRegion(), Region::PAL);
+}
+
+TEST_F(SchedulerTest, RegionSwitchTakesEffectFromTheCurrentCycle) {
+  ASSERT_TRUE(Insert(0, Spin(0), {}, {}));
+  for (int frame = 0; frame < 600; ++frame) {
+    emulator->RunFrame();
+  }
+  emulator->SetRegion(Region::PAL);
+  // the past 600 frames stay NTSC frames
+  EXPECT_EQ(emulator->GetFrameCount(), 600);
+  EXPECT_NEAR(static_cast<double>(emulator->RunFrame()),
+              PAL_FRAME_DOTS / 3.2, 1.0);
+  EXPECT_EQ(emulator->GetFrameCount(), 601);
+
+  emulator->SetRegion(Region::NTSC);
+  EXPECT_NEAR(static_cast<double>(emulator->RunFrame()),
+              NTSC_FRAME_DOTS / 3.0, 1.0);
+  EXPECT_EQ(emulator->GetFrameCount(), 602);
+}
+
+TEST_F(SchedulerTest, RunCyclesRunsExactly) {
+  ASSERT_TRUE(Insert(0, Spin(0), {}, {}));
+  EXPECT_EQ(emulator->RunCycles(1000), 1000);
+  EXPECT_EQ(emulator->GetCycleCount(), 1000);
+  EXPECT_EQ(emulator->RunCycles(99000), 99000);
+  // 300000 dots: the frames end at dot 82182, 171524 and 260866
+  EXPECT_EQ(emulator->GetFrameCount(), 3);
+  EXPECT_EQ(Emulator_Testing::GetPPU(*emulator).GetDotCount(), 300000);
+}
+
+class SchedulerDispatchTest
+    : public SchedulerTest,
+      public ::testing::WithParamInterface<CPU::Dispatch> {
+ protected:
+  void SetUp() override {
+    Emulator_Testing::GetCPU(*emulator).SetDispatch(GetParam());
+  }
+};
+
+TEST_P(SchedulerDispatchTest, NMIIsTakenOncePerFrame) {
+  // LDA #$80 ; STA $2000 ; JMP $E005
+  std::vector<u8> main = {ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x80,
+                          ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00,
+                          0x20};
+  std::ranges::copy(Spin(0x05), std::back_inserter(main));
+  // INC $10 ; RTI
+  const std::vector<u8> nmi = {ISA::INC<AddressingMode::ZeroPage>::OPCODE,
+                               0x10, ISA::RTI<AddressingMode::Implied>::OPCODE};
+  ASSERT_TRUE(Insert(0, main, nmi, {}));
+
+  for (int frame = 0; frame < 5; ++frame) {
+    emulator->RunFrame();
+  }
+  // the NMI of the last frame is taken at the start of the next one
+  EXPECT_EQ(ReadRAM(0x10), 4);
+  emulator->RunCycles(100);
+  EXPECT_EQ(ReadRAM(0x10), 5);
+}
+
+TEST_P(SchedulerDispatchTest, PolledVBlankIsSeenOncePerFrame) {
+  // BIT $2002 ; BPL $E000 ; INC $10 ; JMP $E000
+  std::vector<u8> main = {ISA::BIT<AddressingMode::Absolute>::OPCODE,  0x02,
+                          0x20,
+                          ISA::BPL<AddressingMode::Relative>::OPCODE,  0xFB,
+                          ISA::INC<AddressingMode::ZeroPage>::OPCODE,  0x10};
+  std::ranges::copy(Spin(0x00), std::back_inserter(main));
+  ASSERT_TRUE(Insert(0, main, {}, {}));
+
+  for (int frame = 0; frame < 3; ++frame) {
+    emulator->RunFrame();
+  }
+  emulator->RunCycles(100);
+  EXPECT_EQ(ReadRAM(0x10), 3);
+}
+
+TEST_P(SchedulerDispatchTest, MMC3CountsRenderedScanlines) {
+  // LDA #9 ; STA $C000 ; STA $C001 ; STA $E001 ; LDA #$18 ; STA $2001 ; CLI ;
+  // JMP $E011
+  std::vector<u8> main = {
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x09,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00, 0xC0,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x01, 0xC0,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x01, 0xE0,
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x18,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x01, 0x20,
+      ISA::CLI<AddressingMode::Implied>::OPCODE,
+  };
+  std::ranges::copy(Spin(0x11), std::back_inserter(main));
+  // INC $11 ; STA $E000 ; STA $E001 ; RTI (acknowledge and enable again)
+  const std::vector<u8> irq = {
+      ISA::INC<AddressingMode::ZeroPage>::OPCODE, 0x11,
+      ISA::STA<AddressingMode::Absolute>::OPCODE, 0x00, 0xE0,
+      ISA::STA<AddressingMode::Absolute>::OPCODE, 0x01, 0xE0,
+      ISA::RTI<AddressingMode::Implied>::OPCODE,
+  };
+  ASSERT_TRUE(Insert(4, main, {}, irq));
+
+  for (int frame = 0; frame < 3; ++frame) {
+    emulator->RunFrame();
+  }
+  // 240 visible scanlines in the first frame, the pre-render scanline and 240
+  // visible ones in the others: an IRQ every 10 of the 722 clocks
+  EXPECT_EQ(ReadRAM(0x11), 72);
+}
+
+TEST_P(SchedulerDispatchTest, NoScanlineIRQWithoutRendering) {
+  // LDA #0 ; STA $C000 ; STA $C001 ; STA $E001 ; CLI ; JMP $E00C
+  std::vector<u8> main = {
+      ISA::LDA<AddressingMode::Immediate>::OPCODE, 0x00,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x00, 0xC0,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x01, 0xC0,
+      ISA::STA<AddressingMode::Absolute>::OPCODE,  0x01, 0xE0,
+      ISA::CLI<AddressingMode::Implied>::OPCODE,
+  };
+  std::ranges::copy(Spin(0x0C), std::back_inserter(main));
+  const std::vector<u8> irq = {ISA::INC<AddressingMode::ZeroPage>::OPCODE,
+                               0x11,
+                               ISA::RTI<AddressingMode::Implied>::OPCODE};
+  ASSERT_TRUE(Insert(4, main, {}, irq));
+
+  emulator->RunFrame();
+  EXPECT_EQ(ReadRAM(0x11), 0);
+}
+
+TEST_P(SchedulerDispatchTest, PollsSeeVBlankOnTheCycleOfTheRead) {
+  // nops NOPs move the reads across the 241/1 edge, 2 cycles at a time over
+  // the 9 cycles of a poll. X counts the polls.
+  for (u8 nops = 0; nops < 9; ++nops) {
+    std::vector<u8> main(nops, ISA::NOP<AddressingMode::Implied>::OPCODE);
+    // INX ; LDA $2002 ; BPL INX ; STX $10
+    const std::vector<u8> poll = {
+        ISA::INX<AddressingMode::Implied>::OPCODE,
+        ISA::LDA<AddressingMode::Absolute>::OPCODE, 0x02, 0x20,
+        ISA::BPL<AddressingMode::Relative>::OPCODE, 0xFA,
+        ISA::STX<AddressingMode::ZeroPage>::OPCODE, 0x10,
+    };
+    std::ranges::copy(poll, std::back_inserter(main));
+    std::ranges::copy(Spin(static_cast<u8>(nops + poll.size())),
+                      std::back_inserter(main));
+    emulator = std::make_unique<Emulator>();
+    Emulator_Testing::GetCPU(*emulator).SetDispatch(GetParam());
+    ASSERT_TRUE(Insert(0, main, {}, {}));
+
+    // Without the scheduler only the reads catch the PPU up. One cycle at a
+    // time every access goes through Step.
+    const std::unique_ptr<Emulator> stepped = emulator->Fork();
+    BasicCPU<NESBus> &cpu = Emulator_Testing::GetCPU(*emulator);
+    BasicCPU<NESBus> &stepped_cpu = Emulator_Testing::GetCPU(*stepped);
+    cpu.RunCycles(FIRST_FRAME_DOTS / 3 + 100);
+    while (stepped_cpu.GetCycleCount() < cpu.GetCycleCount()) {
+      stepped_cpu.RunCycles(1);
+    }
+    EXPECT_EQ(ReadRAM(0x10), Emulator_Testing::GetMemory(*stepped).Read(0x10))
+        << static_cast<int>(nops) << " NOPs";
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Dispatch, SchedulerDispatchTest,
+                         ::testing::Values(CPU::Dispatch::TABLE,
+                                           CPU::Dispatch::THREADED,
+                                           CPU::Dispatch::JIT));
+
+}  // namespace
+}  // namespace QNes
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "qnes_c.hpp"
+
+namespace QNes {
+
+// Files in the temp directory named after the running test, removed together
+// with the TempFiles
+class TempFiles {
+ public:
+  TempFiles() = default;
+  TempFiles(const TempFiles &) = delete;
+  TempFiles &operator=(const TempFiles &) = delete;
+  TempFiles(TempFiles &&) = delete;
+  TempFiles &operator=(TempFiles &&) = delete;
+  ~TempFiles() {
+    for (const auto &path : paths) {
+      std::filesystem::remove(path);
+    }
+  }
+
+  // New path, the file is not created
+  std::string Path(const std::string &suffix = ".nes") {
+    const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+    // parameterized tests are named Prefix/Suite.Name/Index
+    std::string name = std::string("qnes_") + test->test_suite_name() + "_" +
+                       test->name() + "_" + std::to_string(paths.size());
+    std::replace(name.begin(), name.end(), '/', '_');
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / (name + suffix);
+    paths.push_back(path);
+    return path.string();
+  }
+
+  // Writes data to a new path
+  std::string Write(const std::vector<u8> &data,
+                    const std::string &suffix = ".nes") {
+    std::string path = Path(suffix);
+    WriteFile(path, data);
+    return path;
+  }
+
+  static void WriteFile(const std::string &path, const std::vector<u8> &data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+  }
+
+ private:
+  std::vector<std::filesystem::path> paths;
+};
+
+}  // namespace QNes
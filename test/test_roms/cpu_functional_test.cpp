@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -36,7 +37,225 @@ std::string FindBinaryFile() {
   return "";
 }
 
-int main() {
+struct RunResult {
+  bool completed = false;
+  u16 final_pc = 0;
+  u64 cycles = 0;
+  double seconds = 0.0;
+  QNes::CPU::State final_state{};
+};
+
+// Test start address, the reset vector is pointed here
+constexpr u16 test_start = 0x0400;
+
+// Memory, bus and CPU with the test image loaded and the reset sequence done
+struct TestMachine {
+  explicit TestMachine(const std::vector<u8> &binary_data)
+      : memory(Kilobytes(64)), bus(&memory), cpu(&bus) {
+    memory.Clear();
+    memory.Initialize(binary_data);
+    memory.Write(0xFFFC, QNes::U16Low(test_start));
+    memory.Write(0xFFFD, QNes::U16High(test_start));
+
+    // Reset the CPU and execute the reset sequence (5 cycles)
+    QNes::CPU_Testing::ZeroInterruptCycle(cpu);
+    cpu.Reset();
+    for (int i = 0; i < 5; ++i) {
+      cpu.Step();
+    }
+  }
+
+  QNes::Memory memory;
+  QNes::RAMBus bus;
+  QNes::BasicCPU<QNes::RAMBus> cpu;
+};
+
+// Runs the functional test image until it traps (jumps/branches to itself)
+RunResult RunFunctionalTest(const std::vector<u8> &binary_data,
+                            QNes::CPU::Dispatch dispatch, bool decode_cache,
+                            bool verbose) {
+  RunResult result;
+
+  TestMachine machine(binary_data);
+  auto &cpu = machine.cpu;
+  cpu.SetDispatch(dispatch);
+  if (decode_cache) {
+    cpu.EnableDecodeCache();
+  }
+
+  auto initial_state = cpu.GetState();
+  if (verbose) {
+    std::cout << "CPU reset complete. PC: 0x" << std::hex << initial_state.pc
+              << std::dec << "\n\n";
+  }
+
+  if (initial_state.pc != test_start) {
+    std::cerr << "ERROR: CPU did not reset to test start address (0x"
+              << std::hex << test_start << "). Got: 0x" << initial_state.pc
+              << std::dec << "\n";
+    result.final_state = initial_state;
+    return result;
+  }
+
+  if (verbose) {
+    std::cout << "Running functional test...\n";
+    std::cout
+        << "This may take a while. The test will loop when it completes.\n\n";
+  }
+
+  // The test ends in a jump/branch to itself, both on success and on a failure
+  // trap. Run the CPU in batches and after each batch check whether the next
+  // instruction leaves PC unchanged.
+  constexpr u64 batch_cycles = 1000000;
+  constexpr u64 max_cycles = 100000000;  // Safety limit (100M cycles)
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const u64 start_cycle = cpu.GetCycleCount();
+
+  while (cpu.GetCycleCount() - start_cycle < max_cycles) {
+    cpu.RunCycles(batch_cycles);
+
+    // Finish the instruction in flight so PC points to an opcode
+    cpu.StepInstruction();
+    const u16 current_pc = cpu.GetState().pc;
+    cpu.StepInstruction();
+    if (cpu.GetState().pc == current_pc) {
+      result.completed = true;
+      result.final_pc = current_pc;
+      break;
+    }
+
+    // Progress reporting every 1M cycles
+    if (verbose) {
+      std::cout << "Cycles: " << (cpu.GetCycleCount() - start_cycle) / 1000000
+                << "M, PC: 0x" << std::hex << current_pc << std::dec << "\n";
+    }
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start_time;
+  result.cycles = cpu.GetCycleCount() - start_cycle;
+  result.seconds = elapsed.count();
+  result.final_state = cpu.GetState();
+  return result;
+}
+
+// Runs the test image with every dispatcher configuration and reports the
+// emulated speed of the best of a few runs for each
+int RunDispatchBenchmark(const std::vector<u8> &binary_data) {
+  constexpr int runs = 5;
+  constexpr struct {
+    QNes::CPU::Dispatch dispatch;
+    bool decode_cache;
+    const char *name;
+  } dispatchers[] = {
+      {QNes::CPU::Dispatch::TABLE, false, "table"},
+      {QNes::CPU::Dispatch::THREADED, false, "threaded"},
+      {QNes::CPU::Dispatch::THREADED, true, "threaded + decode cache"},
+      {QNes::CPU::Dispatch::JIT, false, "jit"},
+  };
+
+  std::cout << "Dispatch benchmark (best of " << runs << " runs)\n";
+  double mhz[std::size(dispatchers)] = {};
+  for (size_t i = 0; i < std::size(dispatchers); ++i) {
+    double best_seconds = 0.0;
+    u64 cycles = 0;
+    for (int run = 0; run < runs; ++run) {
+      const RunResult result =
+          RunFunctionalTest(binary_data, dispatchers[i].dispatch,
+                            dispatchers[i].decode_cache, false);
+      if (!result.completed) {
+        std::cerr << "ERROR: Test did not complete with the "
+                  << dispatchers[i].name << " dispatcher\n";
+        return 1;
+      }
+      if (run == 0 || result.seconds < best_seconds) {
+        best_seconds = result.seconds;
+      }
+      cycles = result.cycles;
+    }
+    mhz[i] = (cycles / best_seconds) / 1e6;
+    std::cout << "  " << dispatchers[i].name << ": " << cycles
+              << " cycles in " << best_seconds << " s, " << mhz[i]
+              << " MHz\n";
+  }
+  std::cout << "Threaded / table speedup: " << mhz[1] / mhz[0] << "x\n";
+  std::cout << "Decode cache speedup: " << mhz[2] / mhz[1] << "x\n";
+  std::cout << "JIT / threaded speedup: " << mhz[3] / mhz[1] << "x\n";
+  return 0;
+}
+
+// Runs the test image on the JIT and on the table interpreter side by side and
+// compares the CPU state and the memory after every batch of cycles
+int RunDifferential(const std::vector<u8> &binary_data) {
+  TestMachine jit(binary_data);
+  TestMachine interpreter(binary_data);
+  jit.cpu.SetDispatch(QNes::CPU::Dispatch::JIT);
+  interpreter.cpu.SetDispatch(QNes::CPU::Dispatch::TABLE);
+
+  constexpr u64 batch_cycles = 10000;
+  constexpr u64 max_cycles = 100000000;
+
+  std::cout << "Differential run: JIT against the table interpreter\n";
+  while (interpreter.cpu.GetCycleCount() < max_cycles) {
+    jit.cpu.RunCycles(batch_cycles);
+    interpreter.cpu.RunCycles(batch_cycles);
+
+    const auto jit_state = jit.cpu.GetState();
+    const auto state = interpreter.cpu.GetState();
+    const bool same_state =
+        jit.cpu.GetCycleCount() == interpreter.cpu.GetCycleCount() &&
+        jit_state.pc == state.pc && jit_state.sp == state.sp &&
+        jit_state.a == state.a && jit_state.x == state.x &&
+        jit_state.y == state.y &&
+        jit_state.status.status == state.status.status;
+    if (!same_state) {
+      std::cerr << "ERROR: CPU state differs at cycle "
+                << interpreter.cpu.GetCycleCount() << std::hex
+                << "\n  JIT:         PC 0x" << jit_state.pc << " A 0x"
+                << static_cast<int>(jit_state.a) << " X 0x"
+                << static_cast<int>(jit_state.x) << " Y 0x"
+                << static_cast<int>(jit_state.y) << " P 0x"
+                << static_cast<int>(jit_state.status.status)
+                << "\n  interpreter: PC 0x" << state.pc << " A 0x"
+                << static_cast<int>(state.a) << " X 0x"
+                << static_cast<int>(state.x) << " Y 0x"
+                << static_cast<int>(state.y) << " P 0x"
+                << static_cast<int>(state.status.status) << std::dec << "\n";
+      return 1;
+    }
+    for (u32 address = 0; address < Kilobytes(64); ++address) {
+      const auto a = static_cast<u16>(address);
+      if (jit.memory.Read(a) != interpreter.memory.Read(a)) {
+        std::cerr << "ERROR: Memory differs at 0x" << std::hex << address
+                  << " at cycle " << std::dec
+                  << interpreter.cpu.GetCycleCount() << "\n";
+        return 1;
+      }
+    }
+
+    // Both trapped in the same place
+    if (QNes::CPU_Testing::GetInstructionCycle(interpreter.cpu) == 0) {
+      const u16 pc = state.pc;
+      interpreter.cpu.StepInstruction();
+      jit.cpu.StepInstruction();
+      if (interpreter.cpu.GetState().pc == pc) {
+        std::cout << "No difference in " << interpreter.cpu.GetCycleCount()
+                  << " cycles, trapped at PC 0x" << std::hex << pc << std::dec
+                  << "\n";
+        return 0;
+      }
+    }
+  }
+  std::cout << "No difference in " << max_cycles << " cycles\n";
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const std::string mode = argc > 1 ? argv[1] : "";
+  const bool benchmark = mode == "--benchmark";
+  const bool differential = mode == "--differential";
+
   std::cout << "Klaus 6502 Functional Test Runner\n";
   std::cout << "==================================\n\n";
 
@@ -68,128 +287,44 @@ int main() {
 
   std::cout << "Binary size: " << size << " bytes\n\n";
 
-  // Create CPU and Memory
-  QNes::Memory memory(Kilobytes(64));
-  memory.Clear();
-
-  // Load binary data
+  // The image has to fit in the 64KB address space
   if (binary_data.size() > Kilobytes(64)) {
     std::cerr << "ERROR: Binary file too large to fit in memory\n";
     return 1;
   }
-  memory.Initialize(binary_data);
-
-  // Set up reset vector to point to test start (0x0400)
-  constexpr u16 test_start = 0x0400;
-  memory.Write(0xFFFC, QNes::U16Low(test_start));
-  memory.Write(0xFFFD, QNes::U16High(test_start));
 
-  QNes::RAMBus bus(&memory);
-  QNes::CPU cpu(&bus);
-
-  std::cout << "Initializing CPU...\n";
-
-  // Reset the CPU
-  QNes::CPU_Testing::ZeroInterruptCycle(cpu);
-  cpu.Reset();
-
-  // Execute reset sequence (5 cycles)
-  for (int i = 0; i < 5; ++i) {
-    cpu.Step();
+  if (benchmark) {
+    return RunDispatchBenchmark(binary_data);
   }
-
-  auto initial_state = cpu.GetState();
-  std::cout << "CPU reset complete. PC: 0x" << std::hex << initial_state.pc
-            << std::dec << "\n\n";
-
-  if (initial_state.pc != test_start) {
-    std::cerr << "ERROR: CPU did not reset to test start address (0x"
-              << std::hex << test_start << "). Got: 0x" << initial_state.pc
-              << std::dec << "\n";
-    return 1;
+  if (differential) {
+    return RunDifferential(binary_data);
   }
 
-  std::cout << "Running functional test...\n";
-  std::cout
-      << "This may take a while. The test will loop when it completes.\n\n";
-
-  // Run until we detect a loop (repeating pattern of 2-3 addresses)
-  // jmp * instruction cycles through 2-3 addresses before jumping back
-  constexpr size_t repeat_count = 10;
-  constexpr size_t sequence_size = 3;
-  u16 sequence[sequence_size] = {};
-  constexpr size_t history_size =
-      repeat_count * sequence_size;  // Track enough to detect patterns
-  u16 pc_history[history_size] = {};
-  size_t history_index = 0;  // Current write position in circular buffer
-  size_t history_count = 0;  // Number of entries filled so far
-  constexpr size_t max_cycles = 100000000;  // Safety limit (100M cycles)
-
-  bool test_completed = false;
+  std::cout << "Initializing CPU...\n";
+  const RunResult result =
+      RunFunctionalTest(binary_data, QNes::CPU::Dispatch::THREADED, true, true);
+  const u16 final_pc = result.final_pc;
   u16 success_pcs[3] = {0x336d, 0x336e, 0x336f};
-  u16 final_pc = 0;
-  size_t cycle_count = 0;
-
-  while (cycle_count < max_cycles) {
-    cpu.Step();
-    ++cycle_count;
-
-    auto state = cpu.GetState();
-    u16 current_pc = state.pc;
-
-    pc_history[history_index++] = current_pc;
-    history_index %= history_size;
-    if (history_count >= history_size) {
-      // find the first elements of sequence in pc_history
-      for (size_t i = 0; i < sequence_size; ++i) {
-        sequence[i] = pc_history[i];
-      }
 
-      // check if the next elements of pc_history are the same as sequence
-      bool pattern_found = true;
-      for (size_t i = 1; i < repeat_count; ++i) {
-        for (size_t j = 0; j < sequence_size; ++j) {
-          if (pc_history[(i * sequence_size) + j] != sequence[j]) {
-            pattern_found = false;
-            break;
-          }
-        }
-        if (!pattern_found) {
-          break;
-        }
-      }
-
-      if (pattern_found) {
-        test_completed = true;
-        final_pc = current_pc;
-        break;
-      }
-    } else {
-      ++history_count;
+  if (!result.completed) {
+    if (result.cycles == 0) {
+      return 1;
     }
-
-    // Progress reporting every 1M cycles
-    if (cycle_count % 1000000 == 0) {
-      std::cout << "Cycles: " << cycle_count / 1000000 << "M, PC: 0x"
-                << std::hex << current_pc << std::dec << "\n";
-    }
-  }
-
-  if (!test_completed) {
-    std::cerr << "\nERROR: Test did not complete within " << max_cycles
+    std::cerr << "\nERROR: Test did not complete within " << result.cycles
               << " cycles\n";
-    auto final_state = cpu.GetState();
-    std::cerr << "Final PC: 0x" << std::hex << final_state.pc << std::dec
-              << "\n";
+    std::cerr << "Final PC: 0x" << std::hex << result.final_state.pc
+              << std::dec << "\n";
     return 1;
   }
 
   // Determine test result based on final PC
   std::cout << "\nTest completed!\n";
-  std::cout << "Total cycles: " << cycle_count << "\n";
+  std::cout << "Total cycles: " << result.cycles << "\n";
+  std::cout << "Emulated speed: " << (result.cycles / result.seconds) / 1e6
+            << " MHz\n";
   std::cout << "Final PC: 0x" << std::hex << final_pc << std::dec << "\n";
 
-  auto final_state = cpu.GetState();
+  const auto &final_state = result.final_state;
   std::cout << "\nFinal CPU State:\n";
   std::cout << "  PC: 0x" << std::hex << final_state.pc << std::dec << "\n";
   std::cout << "  SP: 0x" << std::hex << static_cast<int>(final_state.sp)